@@ -20,8 +20,11 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <atomic>
+
 #include <audio_utils/minifloat.h>
 #include <utils/threads.h>
+#include <utils/Timers.h>
 #include <utils/Log.h>
 #include <utils/RefBase.h>
 #include <audio_utils/roundup.h>
@@ -234,6 +237,9 @@ struct audio_track_cblk_t
     volatile    int32_t     mFutex;     // event flag: down (P) by client,
                                         // up (V) by server or binderDied() or interrupt()
 #define CBLK_FUTEX_WAKE 1               // if event flag bit is set, then a deferred wake is pending
+#define CBLK_FUTEX_WAITER 2             // client in adaptive wait mode may be in futex wait
+#define CBLK_FUTEX_ADAPTIVE 4           // client registers CBLK_FUTEX_WAITER before waiting,
+                                        // so server need not wake when it is clear
 
 private:
 
@@ -426,10 +432,43 @@ public:
 
     virtual void stop() { }; // called by client in AudioTrack::stop()
 
+    // Adaptive wait mode is off by default.  When on, obtainBuffer() spins briefly
+    // before the futex wait, until the server is expected from the observed server period,
+    // and registers as a waiter so that the server only issues a futex wake when needed.
+    void        setAdaptiveWait(bool enabled);
+    bool        isAdaptiveWait() const { return mAdaptiveWait; }
+
+    struct WaitStats {
+        uint32_t mSpins;            // spins before a futex wait
+        uint32_t mSpinHits;         // spins which ended by server progress
+        uint32_t mSleeps;           // futex waits
+        uint32_t mWakeups;          // futex waits which ended by a wake
+        int64_t  mServerPeriodNs;   // estimated time between server releases, 0 if unknown
+    };
+    // May be called from any thread, the counters are not synchronized with each other.
+    WaitStats   getWaitStats() const;
+
 private:
+    void        observeServerPosition(int32_t position);
+    nsecs_t     spinLimitNs() const;
+    bool        spinForServer(int32_t position);
+
     // This is a copy of mCblk->mBufferSizeInFrames
     uint32_t   mBufferSizeInFrames;  // effective size of the buffer
 
+    // Adaptive wait state, only accessed by the thread calling obtainBuffer().
+    bool       mAdaptiveWait = false;
+    bool       mSpinAllowed = false;    // more than one CPU is online
+    int32_t    mLastServerPosition = 0; // front (mIsOut) or rear (!mIsOut) last observed
+    nsecs_t    mLastServerChangeNs = 0; // when mLastServerPosition was observed to change
+    uint32_t   mSpinMisses = 0;         // the spin budget is halved for each recent miss
+
+    std::atomic<uint32_t> mSpins{0};
+    std::atomic<uint32_t> mSpinHits{0};
+    std::atomic<uint32_t> mSleeps{0};
+    std::atomic<uint32_t> mWakeups{0};
+    std::atomic<int64_t>  mServerPeriodNs{0};
+
     Modulo<uint32_t> mEpoch;
 
     // The shared buffer contents referred to by the timestamp observer
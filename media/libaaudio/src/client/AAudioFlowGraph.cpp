@@ -20,6 +20,8 @@
 
 #include "AAudioFlowGraph.h"
 
+#include <optional>
+
 #include <flowgraph/Limiter.h>
 #include <flowgraph/ManyToMultiConverter.h>
 #include <flowgraph/MonoBlend.h>
@@ -39,6 +41,17 @@
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
+static std::optional<FusedConverter::Format> toFusedFormat(audio_format_t format) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+            return FusedConverter::Format::FLOAT;
+        case AUDIO_FORMAT_PCM_16_BIT:
+            return FusedConverter::Format::I16;
+        default:
+            return std::nullopt;
+    }
+}
+
 aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
                           int32_t sourceChannelCount,
                           int32_t sourceSampleRate,
@@ -153,15 +166,37 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput->connect(&mSink->input);
 
+    // The node graph is still built, because the ramps are shared and reset() uses it.
+    std::optional<FusedConverter::Format> fusedSourceFormat = toFusedFormat(sourceFormat);
+    std::optional<FusedConverter::Format> fusedSinkFormat = toFusedFormat(sinkFormat);
+    if (fusedSourceFormat.has_value() && fusedSinkFormat.has_value()
+            && mMonoBlend == nullptr && mLimiter == nullptr && mRateConverter == nullptr) {
+        std::vector<RampLinear *> ramps;
+        for (auto& ramp : mVolumeRamps) {
+            ramps.push_back(ramp.get());
+        }
+        mFusedConverter = std::make_unique<FusedConverter>(
+                fusedSourceFormat.value(), sourceChannelCount,
+                fusedSinkFormat.value(), sinkChannelCount, std::move(ramps));
+        ALOGD("%s() using FusedConverter", __func__);
+    }
+
     return AAUDIO_OK;
 }
 
 int32_t AAudioFlowGraph::pull(void *destination, int32_t targetFramesToRead) {
+    if (mFusedConverter != nullptr) {
+        return mFusedConverter->read(destination, targetFramesToRead);
+    }
     return mSink->read(destination, targetFramesToRead);
 }
 
 int32_t AAudioFlowGraph::process(const void *source, int32_t numFramesToWrite, void *destination,
                     int32_t targetFramesToRead) {
+    if (mFusedConverter != nullptr) {
+        mFusedConverter->setData(source, numFramesToWrite);
+        return mFusedConverter->read(destination, targetFramesToRead);
+    }
     mSource->setData(source, numFramesToWrite);
     return mSink->read(destination, targetFramesToRead);
 }
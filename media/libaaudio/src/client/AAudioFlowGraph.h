@@ -24,6 +24,7 @@
 
 #include <aaudio/AAudio.h>
 #include <audio_utils/Balance.h>
+#include <flowgraph/FusedConverter.h>
 #include <flowgraph/Limiter.h>
 #include <flowgraph/ManyToMultiConverter.h>
 #include <flowgraph/MonoBlend.h>
@@ -97,6 +98,14 @@ public:
     int32_t process(const void *source, int32_t numFramesToWrite, void *destination,
                     int32_t targetFramesToRead);
 
+    /**
+     * @return true if process() converts frame for frame in a single pass, so the
+     *         caller can pass a whole buffer rather than kDefaultBufferSize frames at a time.
+     */
+    bool isFused() const {
+        return mFusedConverter != nullptr;
+    }
+
     /**
      * @param volume between 0.0 and 1.0
      */
@@ -128,6 +137,9 @@ private:
     float mTargetVolume = 1.0f;
     android::audio_utils::Balance mBalance;
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::FlowGraphSink> mSink;
+    // Replaces the node graph for process() and pull() when the graph only converts
+    // the format, expands mono and applies the volume ramps.
+    std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::FusedConverter> mFusedConverter;
 };
 
 
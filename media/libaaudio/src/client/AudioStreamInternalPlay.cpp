@@ -323,15 +323,22 @@ aaudio_result_t AudioStreamInternalPlay::writeNowWithConversion(const void *buff
             break;
         }
 
-        // Put data from byteBuffer into the flowgraph one buffer (8 frames) at a time.
+        // Put data from byteBuffer into the flowgraph one buffer (8 frames) at a time,
+        // or all that fits at once for the fused converter, which converts frame for frame.
         // Continuously pull as much data as possible from the flowgraph into the wrapping buffer.
         // The return value of mFlowGraph.process is the number of frames actually pulled.
         while (framesAvailableInWrappingBuffer > 0 && framesLeftInByteBuffer > 0) {
-            int32_t framesToWriteFromByteBuffer = std::min(flowgraph::kDefaultBufferSize,
-                    framesLeftInByteBuffer);
-            // If the wrapping buffer is running low, write one frame at a time.
-            if (framesAvailableInWrappingBuffer < flowgraph::kDefaultBufferSize) {
-                framesToWriteFromByteBuffer = 1;
+            int32_t framesToWriteFromByteBuffer;
+            if (mFlowGraph.isFused()) {
+                framesToWriteFromByteBuffer = std::min(framesLeftInByteBuffer,
+                        framesAvailableInWrappingBuffer);
+            } else {
+                framesToWriteFromByteBuffer = std::min(flowgraph::kDefaultBufferSize,
+                        framesLeftInByteBuffer);
+                // If the wrapping buffer is running low, write one frame at a time.
+                if (framesAvailableInWrappingBuffer < flowgraph::kDefaultBufferSize) {
+                    framesToWriteFromByteBuffer = 1;
+                }
             }
 
             const int32_t numBytesToWriteFromByteBuffer = getBytesPerFrame() *
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "FusedConverter.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+namespace {
+
+constexpr float kScaleFromI16 = 1.0f / 32768.0f;
+
+// Same rounding and clamping as clamp16_from_float(), which is used by SinkI16.
+inline int16_t i16FromFloat(float sample) {
+    sample *= 32768.0f;
+    if (!(sample < 32767.0f)) return INT16_MAX; // also NaN, like the SIMD min
+    if (sample < -32768.0f) return INT16_MIN;
+    return static_cast<int16_t>(lrintf(sample));
+}
+
+void convertI16ToFloat(const int16_t *source, float *destination, int32_t numSamples) {
+    int32_t i = 0;
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(kScaleFromI16);
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(destination + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(destination + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#elif defined(__aarch64__)
+    for (; i + 8 <= numSamples; i += 8) {
+        const int16x8_t v = vld1q_s16(source + i);
+        vst1q_f32(destination + i,
+                vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), kScaleFromI16));
+        vst1q_f32(destination + i + 4,
+                vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), kScaleFromI16));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        destination[i] = source[i] * kScaleFromI16;
+    }
+}
+
+void multiplyFloat(const float *source, const float *gains, float *destination,
+                   int32_t numSamples) {
+    int32_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(destination + i,
+                _mm_mul_ps(_mm_loadu_ps(source + i), _mm_loadu_ps(gains + i)));
+    }
+#elif defined(__aarch64__)
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(destination + i, vmulq_f32(vld1q_f32(source + i), vld1q_f32(gains + i)));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        destination[i] = source[i] * gains[i];
+    }
+}
+
+template <bool kApplyGains>
+void convertFloatToI16(const float *source, const float *gains, int16_t *destination,
+                       int32_t numSamples) {
+    int32_t i = 0;
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 maxValue = _mm_set1_ps(32767.0f);
+    const __m128 minValue = _mm_set1_ps(-32768.0f);
+    auto toI32 = [&](int32_t offset) {
+        __m128 x = _mm_loadu_ps(source + offset);
+        if constexpr (kApplyGains) x = _mm_mul_ps(x, _mm_loadu_ps(gains + offset));
+        // The second operand is returned for NaN, so NaN becomes the maximum.
+        x = _mm_min_ps(_mm_mul_ps(x, scale), maxValue);
+        x = _mm_max_ps(x, minValue);
+        return _mm_cvtps_epi32(x); // round to nearest even
+    };
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i),
+                _mm_packs_epi32(toI32(i), toI32(i + 4)));
+    }
+#elif defined(__aarch64__)
+    const float32x4_t maxValue = vdupq_n_f32(32767.0f);
+    const float32x4_t minValue = vdupq_n_f32(-32768.0f);
+    auto toI32 = [&](int32_t offset) {
+        float32x4_t x = vld1q_f32(source + offset);
+        if constexpr (kApplyGains) x = vmulq_f32(x, vld1q_f32(gains + offset));
+        // The number is returned for NaN, so NaN becomes the maximum.
+        x = vminnmq_f32(vmulq_n_f32(x, 32768.0f), maxValue);
+        x = vmaxnmq_f32(x, minValue);
+        return vcvtnq_s32_f32(x); // round to nearest even
+    };
+    for (; i + 8 <= numSamples; i += 8) {
+        vst1q_s16(destination + i, vcombine_s16(vqmovn_s32(toI32(i)), vqmovn_s32(toI32(i + 4))));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        destination[i] = i16FromFloat(kApplyGains ? source[i] * gains[i] : source[i]);
+    }
+}
+
+void expandMono(const float *source, float *destination, int32_t numFrames,
+                int32_t channelCount) {
+    for (int32_t frame = 0; frame < numFrames; frame++) {
+        const float sample = *source++;
+        for (int32_t channel = 0; channel < channelCount; channel++) {
+            *destination++ = sample;
+        }
+    }
+}
+
+int32_t bytesPerSample(FusedConverter::Format format) {
+    return format == FusedConverter::Format::I16 ? sizeof(int16_t) : sizeof(float);
+}
+
+} // namespace
+
+FusedConverter::FusedConverter(Format sourceFormat, int32_t sourceChannelCount,
+                               Format sinkFormat, int32_t sinkChannelCount,
+                               std::vector<RampLinear *> ramps)
+        : mSourceFormat(sourceFormat)
+        , mSourceChannelCount(sourceChannelCount)
+        , mSinkFormat(sinkFormat)
+        , mSinkChannelCount(sinkChannelCount)
+        , mRamps(std::move(ramps))
+        , mSourceBlock(kBlockFrames * sinkChannelCount)
+        , mGains(mRamps.empty() ? 0 : kBlockFrames * sinkChannelCount) {
+    if (sourceChannelCount != sinkChannelCount && sourceFormat == Format::I16) {
+        mMonoBlock.resize(kBlockFrames);
+    }
+}
+
+// Returns the levels for the next numFrames frames, or nullptr if there are no ramps.
+const float *FusedConverter::updateGains(int32_t numFrames) {
+    if (mRamps.empty()) return nullptr;
+
+    bool rampsSteady = true;
+    bool gainsCurrent = mGainsSteady;
+    for (int32_t channel = 0; channel < mSinkChannelCount; channel++) {
+        const RampLinear *ramp = mRamps[channel];
+        rampsSteady = rampsSteady && ramp->isSteady();
+        gainsCurrent = gainsCurrent && mGains[channel] == ramp->getTarget();
+    }
+    if (rampsSteady && gainsCurrent) return mGains.data();
+
+    // A steady level is written for a full block, so it can be reused by later reads.
+    const int32_t framesToWrite = rampsSteady ? kBlockFrames : numFrames;
+    for (int32_t channel = 0; channel < mSinkChannelCount; channel++) {
+        mRamps[channel]->getLevels(&mGains[channel], framesToWrite, mSinkChannelCount);
+    }
+    mGainsSteady = rampsSteady;
+    return mGains.data();
+}
+
+// Returns numFrames frames of the source as float with the sink channel count.
+// They are written to mSourceBlock, unless the source is already in that form.
+const float *FusedConverter::readSourceBlock(int32_t numFrames) {
+    const uint8_t *source = static_cast<const uint8_t *>(mData)
+            + mFrameIndex * mSourceChannelCount * bytesPerSample(mSourceFormat);
+    const int32_t numSourceSamples = numFrames * mSourceChannelCount;
+    if (mSourceChannelCount == mSinkChannelCount) {
+        if (mSourceFormat == Format::FLOAT) {
+            return reinterpret_cast<const float *>(source);
+        }
+        convertI16ToFloat(reinterpret_cast<const int16_t *>(source), mSourceBlock.data(),
+                numSourceSamples);
+        return mSourceBlock.data();
+    }
+
+    const float *monoSource = reinterpret_cast<const float *>(source);
+    if (mSourceFormat == Format::I16) {
+        convertI16ToFloat(reinterpret_cast<const int16_t *>(source), mMonoBlock.data(),
+                numSourceSamples);
+        monoSource = mMonoBlock.data();
+    }
+    expandMono(monoSource, mSourceBlock.data(), numFrames, mSinkChannelCount);
+    return mSourceBlock.data();
+}
+
+int32_t FusedConverter::read(void *data, int32_t numFrames) {
+    const int32_t framesToRead = std::max(0, std::min(numFrames, mSizeInFrames - mFrameIndex));
+    uint8_t *destination = static_cast<uint8_t *>(data);
+    const int32_t bytesPerFrame = mSinkChannelCount * bytesPerSample(mSinkFormat);
+
+    int32_t framesLeft = framesToRead;
+    while (framesLeft > 0) {
+        const int32_t framesThisBlock = std::min(framesLeft, kBlockFrames);
+        const int32_t numSamples = framesThisBlock * mSinkChannelCount;
+        const float *gains = updateGains(framesThisBlock);
+        const float *source = readSourceBlock(framesThisBlock);
+
+        if (mSinkFormat == Format::I16) {
+            int16_t *shortData = reinterpret_cast<int16_t *>(destination);
+            if (gains != nullptr) {
+                convertFloatToI16<true>(source, gains, shortData, numSamples);
+            } else {
+                convertFloatToI16<false>(source, nullptr, shortData, numSamples);
+            }
+        } else {
+            float *floatData = reinterpret_cast<float *>(destination);
+            if (gains != nullptr) {
+                multiplyFloat(source, gains, floatData, numSamples);
+            } else {
+                memcpy(floatData, source, numSamples * sizeof(float));
+            }
+        }
+
+        mFrameIndex += framesThisBlock;
+        destination += framesThisBlock * bytesPerFrame;
+        framesLeft -= framesThisBlock;
+    }
+    return framesToRead;
+}
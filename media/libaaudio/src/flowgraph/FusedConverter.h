@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_FUSED_CONVERTER_H
+#define FLOWGRAPH_FUSED_CONVERTER_H
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <vector>
+
+#include "FlowGraphNode.h"
+#include "RampLinear.h"
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph {
+
+/**
+ * Performs the work of a Source -> [MonoToMultiConverter] -> [RampLinear per channel] -> Sink
+ * graph in a single pass over blocks of kBlockFrames frames, using SIMD where available.
+ *
+ * The node graph pulls kDefaultBufferSize frames at a time through every node,
+ * and splits and merges the channels around the per channel ramps.
+ * This converter reads the same RampLinear objects, so volume control is unchanged,
+ * and produces the same output for a target that does not change during a read().
+ * The ramp targets are sampled once per block instead of once per kDefaultBufferSize frames.
+ */
+class FusedConverter {
+public:
+    enum class Format {
+        I16,
+        FLOAT,
+    };
+
+    static constexpr int32_t kBlockFrames = 64;
+
+    /**
+     * @param sourceFormat
+     * @param sourceChannelCount must be 1 or equal to sinkChannelCount
+     * @param sinkFormat
+     * @param sinkChannelCount
+     * @param ramps empty, or one single channel RampLinear for each sink channel.
+     *              They are not owned and must outlive the converter.
+     */
+    FusedConverter(Format sourceFormat, int32_t sourceChannelCount,
+                   Format sinkFormat, int32_t sinkChannelCount,
+                   std::vector<RampLinear *> ramps);
+
+    /**
+     * Specify buffer that the converter will read from.
+     */
+    void setData(const void *data, int32_t numFrames) {
+        mData = data;
+        mSizeInFrames = numFrames;
+        mFrameIndex = 0;
+    }
+
+    /**
+     * Convert up to numFrames frames of the data into the sink format.
+     *
+     * @return number of frames written, limited by the data that is left
+     */
+    int32_t read(void *data, int32_t numFrames);
+
+private:
+    const float *readSourceBlock(int32_t numFrames);
+    const float *updateGains(int32_t numFrames);
+
+    const Format mSourceFormat;
+    const int32_t mSourceChannelCount;
+    const Format mSinkFormat;
+    const int32_t mSinkChannelCount;
+    const std::vector<RampLinear *> mRamps;
+
+    std::vector<float> mSourceBlock; // source frames as float, with the sink channel count
+    std::vector<float> mMonoBlock;   // mono I16 source as float, before expansion
+    std::vector<float> mGains;       // interleaved level of each sample in the block
+    bool mGainsSteady = false;       // mGains holds a full block of each steady level
+
+    const void *mData = nullptr;
+    int32_t     mSizeInFrames = 0; // number of frames in mData
+    int32_t     mFrameIndex = 0; // index of next frame to be processed
+};
+
+} /* namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph */
+
+#endif //FLOWGRAPH_FUSED_CONVERTER_H
@@ -42,11 +42,7 @@ float RampLinear::interpolateCurrent() {
     return mLevelTo - (mRemaining * mScaler);
 }
 
-int32_t RampLinear::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
-    int32_t channelCount = output.getSamplesPerFrame();
-
+void RampLinear::startRampIfTargetChanged() {
     float target = getTarget();
     if (target != mLevelTo) {
         // Start new ramp. Continue from previous level.
@@ -55,6 +51,39 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
         mRemaining = mLengthInFrames;
         mScaler = (mLevelTo - mLevelFrom) / mLengthInFrames; // for interpolation
     }
+}
+
+void RampLinear::getLevels(float *levels, int32_t numFrames, int32_t stride) {
+    // The ramp is now in use, so later targets are ramped to, see setTarget().
+    if (mLastCallCount == kInitialCallCount) {
+        mLastCallCount = 0;
+    }
+    startRampIfTargetChanged();
+
+    int32_t framesLeft = numFrames;
+    if (mRemaining > 0) {
+        int32_t framesToRamp = std::min(framesLeft, mRemaining);
+        framesLeft -= framesToRamp;
+        while (framesToRamp > 0) {
+            *levels = interpolateCurrent();
+            levels += stride;
+            mRemaining--;
+            framesToRamp--;
+        }
+    }
+    while (framesLeft > 0) {
+        *levels = mLevelTo;
+        levels += stride;
+        framesLeft--;
+    }
+}
+
+int32_t RampLinear::onProcess(int32_t numFrames) {
+    const float *inputBuffer = input.getBuffer();
+    float *outputBuffer = output.getBuffer();
+    int32_t channelCount = output.getSamplesPerFrame();
+
+    startRampIfTargetChanged();
 
     int32_t framesLeft = numFrames;
 
@@ -74,12 +74,30 @@ public:
         mLevelTo = level;
     }
 
+    /**
+     * @return true if the ramp is in use and its level will not change
+     *         until the next setTarget()
+     */
+    bool isSteady() const {
+        return mLastCallCount != kInitialCallCount
+                && mRemaining == 0 && getTarget() == mLevelTo;
+    }
+
+    /**
+     * Advance the ramp by numFrames, as onProcess() would, and write the level of each
+     * frame to levels[i * stride] instead of applying it.
+     * This lets FusedConverter apply the levels of every channel in a single pass.
+     */
+    void getLevels(float *levels, int32_t numFrames, int32_t stride);
+
     const char *getName() override {
         return "RampLinear";
     }
 
 private:
 
+    void startRampIfTargetChanged();
+
     float interpolateCurrent();
 
     std::atomic<float>  mTarget;
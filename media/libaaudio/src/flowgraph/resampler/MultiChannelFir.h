@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_MULTI_CHANNEL_FIR_H
+#define RESAMPLER_MULTI_CHANNEL_FIR_H
+
+#include <numeric>
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+// Four floats in a SIMD register, using the GCC and Clang vector extensions
+// so that the same code is vectorized for NEON, SSE and other targets.
+typedef float fir_float4_t __attribute__((vector_size(16)));
+
+inline fir_float4_t loadFloat4(const float *data) {
+    fir_float4_t result;
+    memcpy(&result, data, sizeof(result)); // unaligned load
+    return result;
+}
+
+/**
+ * Multiplies four taps of interleaved kChannelCount frames by their coefficients.
+ * The 4 * kChannelCount samples fill kChannelCount vectors. Element e of vector J belongs to
+ * tap (4 * J + e) / kChannelCount, so each vector of coefficients is a single shuffle.
+ */
+template <int kChannelCount, size_t... J>
+inline void multiplyAddTapGroup(const float *x, fir_float4_t coefficients,
+                                fir_float4_t *accumulators, std::index_sequence<J...>) {
+    ((accumulators[J] += loadFloat4(x + 4 * J) * __builtin_shufflevector(
+            coefficients, coefficients,
+            (4 * J) / kChannelCount, (4 * J + 1) / kChannelCount,
+            (4 * J + 2) / kChannelCount, (4 * J + 3) / kChannelCount)), ...);
+}
+
+/**
+ * The channels of the elements of accumulator J repeat with a period of
+ * kChannelCount / gcd(kChannelCount, 4) accumulators.
+ */
+template <int kChannelCount>
+constexpr size_t kAccumulatorPeriod = kChannelCount / std::gcd(kChannelCount, 4);
+
+/**
+ * Adds each accumulator into the one with the same channels in the first period,
+ * then adds the elements of the first period into the frame.
+ */
+template <int kChannelCount, size_t... J, size_t... K>
+inline void reduceAccumulators(fir_float4_t *accumulators, float *frame,
+                               std::index_sequence<J...>, std::index_sequence<K...>) {
+    constexpr size_t kPeriod = kAccumulatorPeriod<kChannelCount>;
+    ((J >= kPeriod ? (void) (accumulators[J % kPeriod] += accumulators[J]) : (void) 0), ...);
+    ((K < kChannelCount ? (void) (frame[K] = accumulators[K / 4][K % 4])
+            : (void) (frame[K % kChannelCount] += accumulators[K / 4][K % 4])), ...);
+}
+
+/**
+ * Filter numTaps frames of interleaved kChannelCount samples with the same coefficients
+ * for every channel, and write one frame.
+ *
+ * @param x first frame of the input history
+ * @param coefficients one per tap
+ * @param numTaps must be a multiple of four
+ * @param frame output frame
+ */
+template <int kChannelCount>
+inline void multiChannelFir(const float *x, const float *coefficients, int32_t numTaps,
+                            float *frame) {
+    fir_float4_t accumulators[kChannelCount] = {};
+    for (int32_t tap = 0; tap < numTaps; tap += 4) {
+        multiplyAddTapGroup<kChannelCount>(x, loadFloat4(coefficients + tap), accumulators,
+                std::make_index_sequence<kChannelCount>());
+        x += 4 * kChannelCount;
+    }
+
+    // Element k of the accumulators holds a partial sum for channel k % kChannelCount.
+    reduceAccumulators<kChannelCount>(accumulators, frame,
+            std::make_index_sequence<kChannelCount>(),
+            std::make_index_sequence<4 * kAccumulatorPeriod<kChannelCount>>());
+}
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_MULTI_CHANNEL_FIR_H
@@ -20,13 +20,30 @@
 #include "LinearResampler.h"
 #include "MultiChannelResampler.h"
 #include "PolyphaseResampler.h"
-#include "PolyphaseResamplerMono.h"
-#include "PolyphaseResamplerStereo.h"
+#include "PolyphaseResamplerMulti.h"
 #include "SincResampler.h"
-#include "SincResamplerStereo.h"
+#include "SincResamplerMulti.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
+// Use the resampler specialized for the channel count, if there is one.
+template <template <int> class Specialized, class Generic>
+static MultiChannelResampler *makeForChannelCount(const MultiChannelResampler::Builder &builder) {
+    switch (builder.getChannelCount()) {
+        case 1: return new Specialized<1>(builder);
+        case 2: return new Specialized<2>(builder);
+        case 3: return new Specialized<3>(builder);
+        case 4: return new Specialized<4>(builder);
+        case 5: return new Specialized<5>(builder);
+        case 6: return new Specialized<6>(builder);
+        case 7: return new Specialized<7>(builder);
+        case 8: return new Specialized<8>(builder);
+        case 12: return new Specialized<12>(builder);
+        case 16: return new Specialized<16>(builder);
+        default: return new Generic(builder);
+    }
+}
+
 MultiChannelResampler::MultiChannelResampler(const MultiChannelResampler::Builder &builder)
         : mNumTaps(builder.getNumTaps())
         , mX(static_cast<size_t>(builder.getChannelCount())
@@ -88,21 +105,10 @@ MultiChannelResampler *MultiChannelResampler::Builder::build() {
     ratio.reduce();
     bool usePolyphase = (getNumTaps() * ratio.getDenominator()) <= kMaxCoefficients;
     if (usePolyphase) {
-        if (getChannelCount() == 1) {
-            return new PolyphaseResamplerMono(*this);
-        } else if (getChannelCount() == 2) {
-            return new PolyphaseResamplerStereo(*this);
-        } else {
-            return new PolyphaseResampler(*this);
-        }
+        return makeForChannelCount<PolyphaseResamplerMulti, PolyphaseResampler>(*this);
     } else {
         // Use less optimized resampler that uses a float phaseIncrement.
-        // TODO mono resampler
-        if (getChannelCount() == 2) {
-            return new SincResamplerStereo(*this);
-        } else {
-            return new SincResampler(*this);
-        }
+        return makeForChannelCount<SincResamplerMulti, SincResampler>(*this);
     }
 }
 
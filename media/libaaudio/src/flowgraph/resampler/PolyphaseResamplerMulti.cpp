@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+
+#include "MultiChannelFir.h"
+#include "PolyphaseResamplerMulti.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+template <int kChannelCount>
+PolyphaseResamplerMulti<kChannelCount>::PolyphaseResamplerMulti(
+        const MultiChannelResampler::Builder &builder)
+        : PolyphaseResampler(builder) {
+    assert(builder.getChannelCount() == kChannelCount);
+}
+
+template <int kChannelCount>
+void PolyphaseResamplerMulti<kChannelCount>::writeFrame(const float *frame) {
+    // Move cursor before write so that cursor points to last written frame in read.
+    if (--mCursor < 0) {
+        mCursor = getNumTaps() - 1;
+    }
+    float *dest = &mX[static_cast<size_t>(mCursor) * kChannelCount];
+    const int offset = mNumTaps * kChannelCount;
+    for (int channel = 0; channel < kChannelCount; channel++) {
+        // Write twice so we avoid having to wrap when reading.
+        dest[channel] = dest[channel + offset] = frame[channel];
+    }
+}
+
+template <int kChannelCount>
+void PolyphaseResamplerMulti<kChannelCount>::readFrame(float *frame) {
+    // Multiply input times precomputed windowed sinc function.
+    const float *coefficients = &mCoefficients[mCoefficientCursor];
+    const float *xFrame = &mX[static_cast<size_t>(mCursor) * kChannelCount];
+    multiChannelFir<kChannelCount>(xFrame, coefficients, mNumTaps, frame);
+
+    // Advance and wrap through coefficients.
+    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
+}
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+template class PolyphaseResamplerMulti<1>;
+template class PolyphaseResamplerMulti<2>;
+template class PolyphaseResamplerMulti<3>;
+template class PolyphaseResamplerMulti<4>;
+template class PolyphaseResamplerMulti<5>;
+template class PolyphaseResamplerMulti<6>;
+template class PolyphaseResamplerMulti<7>;
+template class PolyphaseResamplerMulti<8>;
+template class PolyphaseResamplerMulti<12>;
+template class PolyphaseResamplerMulti<16>;
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
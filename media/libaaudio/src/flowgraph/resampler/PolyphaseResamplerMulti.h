@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_POLYPHASE_RESAMPLER_MULTI_H
+#define RESAMPLER_POLYPHASE_RESAMPLER_MULTI_H
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "PolyphaseResampler.h"
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * PolyphaseResampler with the channel count known at compile time,
+ * so that the FIR is vectorized across channels and taps.
+ * It is instantiated for the channel counts that MultiChannelResampler::Builder specializes.
+ */
+template <int kChannelCount>
+class PolyphaseResamplerMulti : public PolyphaseResampler {
+public:
+    explicit PolyphaseResamplerMulti(const MultiChannelResampler::Builder &builder);
+
+    virtual ~PolyphaseResamplerMulti() = default;
+
+    void writeFrame(const float *frame) override;
+
+    void readFrame(float *frame) override;
+};
+
+extern template class PolyphaseResamplerMulti<1>;
+extern template class PolyphaseResamplerMulti<2>;
+extern template class PolyphaseResamplerMulti<3>;
+extern template class PolyphaseResamplerMulti<4>;
+extern template class PolyphaseResamplerMulti<5>;
+extern template class PolyphaseResamplerMulti<6>;
+extern template class PolyphaseResamplerMulti<7>;
+extern template class PolyphaseResamplerMulti<8>;
+extern template class PolyphaseResamplerMulti<12>;
+extern template class PolyphaseResamplerMulti<16>;
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_POLYPHASE_RESAMPLER_MULTI_H
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include <math.h>
+
+#include "MultiChannelFir.h"
+#include "SincResamplerMulti.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+template <int kChannelCount>
+SincResamplerMulti<kChannelCount>::SincResamplerMulti(
+        const MultiChannelResampler::Builder &builder)
+        : SincResampler(builder)
+        , mInterpolatedCoefficients(builder.getNumTaps()) {
+    assert(builder.getChannelCount() == kChannelCount);
+}
+
+template <int kChannelCount>
+void SincResamplerMulti<kChannelCount>::writeFrame(const float *frame) {
+    // Move cursor before write so that cursor points to last written frame in read.
+    if (--mCursor < 0) {
+        mCursor = getNumTaps() - 1;
+    }
+    float *dest = &mX[static_cast<size_t>(mCursor) * kChannelCount];
+    const int offset = mNumTaps * kChannelCount;
+    for (int channel = 0; channel < kChannelCount; channel++) {
+        // Write twice so we avoid having to wrap when reading.
+        dest[channel] = dest[channel + offset] = frame[channel];
+    }
+}
+
+template <int kChannelCount>
+void SincResamplerMulti<kChannelCount>::readFrame(float *frame) {
+    // Determine indices into coefficients table.
+    const double tablePhase = getIntegerPhase() * mPhaseScaler;
+    const int indexLow = static_cast<int>(floor(tablePhase));
+    const int indexHigh = indexLow + 1; // OK because using a guard row.
+    assert (indexHigh < mNumRows);
+    const float *coefficientsLow = &mCoefficients[static_cast<size_t>(indexLow)
+                                                  * static_cast<size_t>(getNumTaps())];
+    const float *coefficientsHigh = &mCoefficients[static_cast<size_t>(indexHigh)
+                                                   * static_cast<size_t>(getNumTaps())];
+
+    // The filter is linear, so interpolating the coefficients is the same as
+    // interpolating the outputs of the two rows, for a fraction of the work.
+    const float fraction = tablePhase - indexLow;
+    float *coefficients = mInterpolatedCoefficients.data();
+    for (int tap = 0; tap < mNumTaps; tap++) {
+        const float low = coefficientsLow[tap];
+        const float high = coefficientsHigh[tap];
+        coefficients[tap] = low + (fraction * (high - low));
+    }
+
+    const float *xFrame = &mX[static_cast<size_t>(mCursor) * kChannelCount];
+    multiChannelFir<kChannelCount>(xFrame, coefficients, mNumTaps, frame);
+}
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+template class SincResamplerMulti<1>;
+template class SincResamplerMulti<2>;
+template class SincResamplerMulti<3>;
+template class SincResamplerMulti<4>;
+template class SincResamplerMulti<5>;
+template class SincResamplerMulti<6>;
+template class SincResamplerMulti<7>;
+template class SincResamplerMulti<8>;
+template class SincResamplerMulti<12>;
+template class SincResamplerMulti<16>;
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
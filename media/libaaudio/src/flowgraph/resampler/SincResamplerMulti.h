@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_SINC_RESAMPLER_MULTI_H
+#define RESAMPLER_SINC_RESAMPLER_MULTI_H
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+#include "SincResampler.h"
+#include "ResamplerDefinitions.h"
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+/**
+ * SincResampler with the channel count known at compile time.
+ * The two rows of coefficients around the phase are interpolated first,
+ * so that a single FIR is run, vectorized across channels and taps.
+ */
+template <int kChannelCount>
+class SincResamplerMulti : public SincResampler {
+public:
+    explicit SincResamplerMulti(const MultiChannelResampler::Builder &builder);
+
+    virtual ~SincResamplerMulti() = default;
+
+    void writeFrame(const float *frame) override;
+
+    void readFrame(float *frame) override;
+
+private:
+    std::vector<float> mInterpolatedCoefficients; // one row, for the current phase
+};
+
+extern template class SincResamplerMulti<1>;
+extern template class SincResamplerMulti<2>;
+extern template class SincResamplerMulti<3>;
+extern template class SincResamplerMulti<4>;
+extern template class SincResamplerMulti<5>;
+extern template class SincResamplerMulti<6>;
+extern template class SincResamplerMulti<7>;
+extern template class SincResamplerMulti<8>;
+extern template class SincResamplerMulti<12>;
+extern template class SincResamplerMulti<16>;
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_SINC_RESAMPLER_MULTI_H
@@ -630,6 +630,21 @@ int32_t AAudioProperty_getOutputMMapOffsetMicros() {
     return AAudioProperty_getMMapOffsetMicros(__func__, AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC);
 }
 
+int32_t AAudioProperty_getMixerWorkers() {
+    const int32_t minWorkers = 0;
+    const int32_t defaultWorkers = 0;
+    const int32_t maxWorkers = 7; // arbitrary, the endpoint thread makes 8 mixing threads
+    int32_t prop = property_get_int32(AAUDIO_PROP_MIXER_WORKERS, defaultWorkers);
+    if (prop < minWorkers) {
+        ALOGW("AAudioProperty_getMixerWorkers: clipped %d to %d", prop, minWorkers);
+        prop = minWorkers;
+    } else if (prop > maxWorkers) {
+        ALOGW("AAudioProperty_getMixerWorkers: clipped %d to %d", prop, maxWorkers);
+        prop = maxWorkers;
+    }
+    return prop;
+}
+
 int32_t AAudioProperty_getLogMask() {
     return property_get_int32(AAUDIO_PROP_LOG_MASK, 0);
 }
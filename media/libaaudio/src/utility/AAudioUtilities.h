@@ -166,6 +166,16 @@ int32_t AAudioProperty_getInputMMapOffsetMicros();
 int32_t AAudioProperty_getOutputMMapOffsetMicros();
 #define AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC   "aaudio.out_mmap_offset_usec"
 
+/**
+ * Read a system property that specifies the number of helper threads used by
+ * the AAudio service to mix shared MMAP output streams.
+ * Zero, the default, mixes all the streams on the endpoint thread.
+ *
+ * @return number of helper threads
+ */
+int32_t AAudioProperty_getMixerWorkers();
+#define AAUDIO_PROP_MIXER_WORKERS   "aaudio.mixer_workers"
+
 // These are powers of two that can be combined as a bit mask.
 // AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM must be enabled before the stream is opened.
 #define AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM   1
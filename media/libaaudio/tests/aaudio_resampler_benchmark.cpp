@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "flowgraph/resampler/MultiChannelResampler.h"
+#include "flowgraph/resampler/PolyphaseResampler.h"
+#include "flowgraph/resampler/SincResampler.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+namespace {
+
+constexpr int32_t kFramesPerBurst = 192; // 4 msec at 48 kHz
+
+std::vector<float> makeSignal(size_t numFrames, int32_t channelCount) {
+    std::vector<float> signal(numFrames * channelCount);
+    for (size_t i = 0; i < numFrames; i++) {
+        const float value = 0.8f * sinf(i * 0.01f);
+        for (int32_t channel = 0; channel < channelCount; channel++) {
+            signal[i * channelCount + channel] = (channel & 1) ? -value : value;
+        }
+    }
+    return signal;
+}
+
+/*
+ * Resamples one burst of input frames per iteration, with the resampler specialized for the
+ * channel count if kSpecialized, else with the generic Resampler. Items are output frames.
+ * Args: channel count.
+ */
+template <typename Resampler, int32_t kSourceRate, int32_t kSinkRate,
+          MultiChannelResampler::Quality kQuality, bool kSpecialized>
+void BM_Resampler(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+
+    std::unique_ptr<MultiChannelResampler> resampler(
+            MultiChannelResampler::make(channelCount, kSourceRate, kSinkRate, kQuality));
+    if (!kSpecialized) {
+        MultiChannelResampler::Builder builder;
+        builder.setChannelCount(channelCount)
+                ->setInputRate(kSourceRate)
+                ->setOutputRate(kSinkRate)
+                ->setNumTaps(resampler->getNumTaps());
+        resampler = std::make_unique<Resampler>(builder);
+    }
+    const std::vector<float> input = makeSignal(kFramesPerBurst, channelCount);
+    std::vector<float> output(channelCount);
+
+    int64_t framesRead = 0;
+    for (auto _ : state) {
+        const float *frame = input.data();
+        int32_t inputFramesLeft = kFramesPerBurst;
+        while (inputFramesLeft > 0) {
+            if (resampler->isWriteNeeded()) {
+                resampler->writeNextFrame(frame);
+                frame += channelCount;
+                inputFramesLeft--;
+            } else {
+                resampler->readNextFrame(output.data());
+                framesRead++;
+            }
+        }
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(framesRead);
+}
+
+// Channel counts with a specialized resampler, and some that use the generic one.
+void ResamplerArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"channels"});
+    for (int channelCount : {1, 2, 4, 8, 12, 24}) {
+        b->Args({channelCount});
+    }
+}
+
+using Quality = MultiChannelResampler::Quality;
+
+BENCHMARK_TEMPLATE(BM_Resampler, PolyphaseResampler, 44100, 48000, Quality::Medium, true)
+        ->Apply(ResamplerArgs);
+BENCHMARK_TEMPLATE(BM_Resampler, PolyphaseResampler, 44100, 48000, Quality::Medium, false)
+        ->Apply(ResamplerArgs);
+BENCHMARK_TEMPLATE(BM_Resampler, SincResampler, 8000, 44100, Quality::High, true)
+        ->Apply(ResamplerArgs);
+BENCHMARK_TEMPLATE(BM_Resampler, SincResampler, 8000, 44100, Quality::High, false)
+        ->Apply(ResamplerArgs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
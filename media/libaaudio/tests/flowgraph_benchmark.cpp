@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "flowgraph/FusedConverter.h"
+#include "flowgraph/ManyToMultiConverter.h"
+#include "flowgraph/MonoToMultiConverter.h"
+#include "flowgraph/MultiToManyConverter.h"
+#include "flowgraph/RampLinear.h"
+#include "flowgraph/SinkFloat.h"
+#include "flowgraph/SinkI16.h"
+#include "flowgraph/SourceFloat.h"
+#include "flowgraph/SourceI16.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+namespace {
+
+constexpr int32_t kFramesPerBurst = 192; // 4 msec at 48 kHz
+constexpr int32_t kRampLength = 480;
+
+/*
+ * The node graph that AAudioFlowGraph builds for EXCLUSIVE playback without SRC:
+ * Source -> [MonoToMultiConverter] -> MultiToManyConverter -> RampLinear per channel
+ * -> ManyToMultiConverter -> Sink.
+ */
+template <typename SourceT, typename SinkT>
+class NodeGraph {
+public:
+    NodeGraph(int32_t sourceChannelCount, int32_t sinkChannelCount)
+            : mSource(sourceChannelCount)
+            , mMonoToMulti(sinkChannelCount)
+            , mMultiToMany(sinkChannelCount)
+            , mManyToMulti(sinkChannelCount)
+            , mSink(sinkChannelCount) {
+        if (sourceChannelCount != sinkChannelCount) {
+            mSource.output.connect(&mMonoToMulti.input);
+            mMonoToMulti.output.connect(&mMultiToMany.input);
+        } else {
+            mSource.output.connect(&mMultiToMany.input);
+        }
+        for (int i = 0; i < sinkChannelCount; i++) {
+            mRamps.emplace_back(std::make_unique<RampLinear>(1));
+            mRamps[i]->setLengthInFrames(kRampLength);
+            mMultiToMany.outputs[i]->connect(&mRamps[i]->input);
+            mRamps[i]->output.connect(mManyToMulti.inputs[i].get());
+        }
+        mManyToMulti.output.connect(&mSink.input);
+    }
+
+    int32_t process(const void *source, void *destination, int32_t numFrames) {
+        mSource.setData(source, numFrames);
+        return mSink.read(destination, numFrames);
+    }
+
+    std::vector<RampLinear *> getRamps() {
+        std::vector<RampLinear *> ramps;
+        for (auto& ramp : mRamps) ramps.push_back(ramp.get());
+        return ramps;
+    }
+
+private:
+    SourceT mSource;
+    MonoToMultiConverter mMonoToMulti;
+    MultiToManyConverter mMultiToMany;
+    std::vector<std::unique_ptr<RampLinear>> mRamps;
+    ManyToMultiConverter mManyToMulti;
+    SinkT mSink;
+};
+
+template <typename Sample>
+FusedConverter::Format toFusedFormat() {
+    return std::is_same_v<Sample, int16_t>
+            ? FusedConverter::Format::I16 : FusedConverter::Format::FLOAT;
+}
+
+template <typename T>
+std::vector<T> makeSignal(size_t numSamples) {
+    std::vector<T> signal(numSamples);
+    for (size_t i = 0; i < numSamples; i++) {
+        const float value = 0.8f * sinf(i * 0.01f);
+        if constexpr (std::is_same_v<T, int16_t>) {
+            signal[i] = static_cast<int16_t>(value * 32767);
+        } else {
+            signal[i] = value;
+        }
+    }
+    return signal;
+}
+
+/*
+ * Converts one burst per iteration, in calls of up to framesPerCall frames.
+ * AAudioFlowGraph callers pass kDefaultBufferSize frames per call to the node graph,
+ * and the whole contiguous part of the burst to the FusedConverter.
+ * Args: source channel count, sink channel count, whether the volume is changing,
+ * and the frames per call.
+ */
+template <typename SourceT, typename SinkT, typename SourceSample, typename SinkSample,
+          bool kFused>
+void BM_FlowGraph(benchmark::State& state) {
+    const int32_t sourceChannelCount = state.range(0);
+    const int32_t sinkChannelCount = state.range(1);
+    const bool ramping = state.range(2) != 0;
+    const int32_t framesPerCall = state.range(3);
+
+    NodeGraph<SourceT, SinkT> graph(sourceChannelCount, sinkChannelCount);
+    FusedConverter fused(toFusedFormat<SourceSample>(), sourceChannelCount,
+            toFusedFormat<SinkSample>(), sinkChannelCount, graph.getRamps());
+    const std::vector<SourceSample> input =
+            makeSignal<SourceSample>(kFramesPerBurst * sourceChannelCount);
+    std::vector<SinkSample> output(kFramesPerBurst * sinkChannelCount);
+
+    float volume = 0.5f;
+    for (auto* ramp : graph.getRamps()) ramp->setTarget(volume);
+    for (auto _ : state) {
+        if (ramping) {
+            // Keep a ramp in progress, as while a volume slider is moved.
+            volume = volume == 0.5f ? 0.25f : 0.5f;
+            for (auto* ramp : graph.getRamps()) ramp->setTarget(volume);
+        }
+        for (int32_t offset = 0; offset < kFramesPerBurst; offset += framesPerCall) {
+            const int32_t numFrames = std::min(framesPerCall, kFramesPerBurst - offset);
+            const SourceSample *source = &input[offset * sourceChannelCount];
+            SinkSample *destination = &output[offset * sinkChannelCount];
+            if constexpr (kFused) {
+                fused.setData(source, numFrames);
+                benchmark::DoNotOptimize(fused.read(destination, numFrames));
+            } else {
+                benchmark::DoNotOptimize(graph.process(source, destination, numFrames));
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFramesPerBurst);
+}
+
+void FlowGraphArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"srcChannels", "sinkChannels", "ramping", "framesPerCall"});
+    for (int framesPerCall : {kDefaultBufferSize, kFramesPerBurst}) {
+        for (int ramping : {0, 1}) {
+            b->Args({1, 2, ramping, framesPerCall});
+            b->Args({2, 2, ramping, framesPerCall});
+            b->Args({8, 8, ramping, framesPerCall});
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_FlowGraph, SourceI16, SinkI16, int16_t, int16_t, false)
+        ->Apply(FlowGraphArgs);
+BENCHMARK_TEMPLATE(BM_FlowGraph, SourceI16, SinkI16, int16_t, int16_t, true)
+        ->Apply(FlowGraphArgs);
+BENCHMARK_TEMPLATE(BM_FlowGraph, SourceFloat, SinkI16, float, int16_t, false)
+        ->Apply(FlowGraphArgs);
+BENCHMARK_TEMPLATE(BM_FlowGraph, SourceFloat, SinkI16, float, int16_t, true)
+        ->Apply(FlowGraphArgs);
+BENCHMARK_TEMPLATE(BM_FlowGraph, SourceI16, SinkFloat, int16_t, float, false)
+        ->Apply(FlowGraphArgs);
+BENCHMARK_TEMPLATE(BM_FlowGraph, SourceI16, SinkFloat, int16_t, float, true)
+        ->Apply(FlowGraphArgs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -28,9 +28,12 @@
 #include <aaudio/AAudio.h>
 #include "client/AAudioFlowGraph.h"
 #include "flowgraph/ClipToRange.h"
+#include "flowgraph/FusedConverter.h"
 #include "flowgraph/Limiter.h"
+#include "flowgraph/ManyToMultiConverter.h"
 #include "flowgraph/MonoBlend.h"
 #include "flowgraph/MonoToMultiConverter.h"
+#include "flowgraph/MultiToManyConverter.h"
 #include "flowgraph/RampLinear.h"
 #include "flowgraph/SinkFloat.h"
 #include "flowgraph/SinkI16.h"
@@ -718,3 +721,168 @@ INSTANTIATE_TEST_SUITE_P(
                 TestFlowgraphResamplerParams({44100, 11025, MultiChannelResampler::Quality::Best})),
         &getTestName
 );
+
+/**
+ * Reference for FusedConverter: the node graph built by AAudioFlowGraph::configure()
+ * for a source, an optional mono expansion, per channel volume ramps and a sink.
+ */
+template <typename SourceT, typename SinkT>
+class RampGraph {
+public:
+    RampGraph(int32_t sourceChannelCount, int32_t sinkChannelCount)
+            : mSource(sourceChannelCount)
+            , mMonoToMulti(sinkChannelCount)
+            , mMultiToMany(sinkChannelCount)
+            , mManyToMulti(sinkChannelCount)
+            , mSink(sinkChannelCount) {
+        if (sourceChannelCount != sinkChannelCount) {
+            mSource.output.connect(&mMonoToMulti.input);
+            mMonoToMulti.output.connect(&mMultiToMany.input);
+        } else {
+            mSource.output.connect(&mMultiToMany.input);
+        }
+        for (int i = 0; i < sinkChannelCount; i++) {
+            mRamps.emplace_back(std::make_unique<RampLinear>(1));
+            mMultiToMany.outputs[i]->connect(&mRamps[i]->input);
+            mRamps[i]->output.connect(mManyToMulti.inputs[i].get());
+        }
+        mManyToMulti.output.connect(&mSink.input);
+    }
+
+    void setData(const void *data, int32_t numFrames) { mSource.setData(data, numFrames); }
+    int32_t read(void *data, int32_t numFrames) { return mSink.read(data, numFrames); }
+
+    std::vector<RampLinear *> getRamps() {
+        std::vector<RampLinear *> ramps;
+        for (auto& ramp : mRamps) ramps.push_back(ramp.get());
+        return ramps;
+    }
+
+private:
+    SourceT mSource;
+    MonoToMultiConverter mMonoToMulti;
+    MultiToManyConverter mMultiToMany;
+    std::vector<std::unique_ptr<RampLinear>> mRamps;
+    ManyToMultiConverter mManyToMulti;
+    SinkT mSink;
+};
+
+template <typename SourceT, typename SinkT, typename SourceSample, typename SinkSample>
+void checkFusedConverterMatchesGraph(FusedConverter::Format sourceFormat,
+                                     FusedConverter::Format sinkFormat,
+                                     int32_t sourceChannelCount,
+                                     int32_t sinkChannelCount) {
+    constexpr int32_t kNumFrames = 1000;
+    constexpr int32_t kRampLength = 100;
+    std::vector<SourceSample> input(kNumFrames * sourceChannelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        // Exceed full scale to check the clipping of the sink.
+        const float value = 1.2f * sinf(i * 0.05f);
+        if constexpr (std::is_same_v<SourceSample, int16_t>) {
+            input[i] = static_cast<int16_t>(value * 30000);
+        } else {
+            input[i] = value;
+        }
+    }
+
+    RampGraph<SourceT, SinkT> expectedGraph(sourceChannelCount, sinkChannelCount);
+    RampGraph<SourceT, SinkT> fusedRamps(sourceChannelCount, sinkChannelCount);
+    FusedConverter fused(sourceFormat, sourceChannelCount, sinkFormat, sinkChannelCount,
+            fusedRamps.getRamps());
+
+    auto setTargets = [&](float volume) {
+        for (const auto& ramps : {expectedGraph.getRamps(), fusedRamps.getRamps()}) {
+            for (int i = 0; i < sinkChannelCount; i++) {
+                ramps[i]->setLengthInFrames(kRampLength);
+                ramps[i]->setTarget(volume / (i + 1));
+            }
+        }
+    };
+
+    std::vector<SinkSample> expected(kNumFrames * sinkChannelCount);
+    std::vector<SinkSample> actual(kNumFrames * sinkChannelCount);
+    expectedGraph.setData(input.data(), kNumFrames);
+    fused.setData(input.data(), kNumFrames);
+
+    // Read in sizes that do not align with the blocks, and change the volume while ramping.
+    const float volumes[] = {0.5f, 0.5f, 2.0f, 0.25f, 0.25f, 1.0f, 0.0f, 0.75f};
+    int32_t framesRead = 0;
+    for (int32_t numFrames = 1, step = 0; framesRead < kNumFrames; numFrames += 29, step++) {
+        setTargets(volumes[step % std::size(volumes)]);
+        const int32_t framesToRead = std::min(numFrames, kNumFrames - framesRead);
+        const int32_t offset = framesRead * sinkChannelCount;
+        ASSERT_EQ(framesToRead, expectedGraph.read(&expected[offset], framesToRead));
+        ASSERT_EQ(framesToRead, fused.read(&actual[offset], framesToRead));
+        framesRead += framesToRead;
+    }
+    // All of the data has been read.
+    EXPECT_EQ(0, fused.read(actual.data(), 1));
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i], actual[i]) << ", i = " << i;
+    }
+}
+
+TEST(test_flowgraph, fused_converter_i16_to_i16) {
+    checkFusedConverterMatchesGraph<SourceI16, SinkI16, int16_t, int16_t>(
+            FusedConverter::Format::I16, FusedConverter::Format::I16, 2, 2);
+}
+
+TEST(test_flowgraph, fused_converter_float_to_i16) {
+    checkFusedConverterMatchesGraph<SourceFloat, SinkI16, float, int16_t>(
+            FusedConverter::Format::FLOAT, FusedConverter::Format::I16, 2, 2);
+}
+
+TEST(test_flowgraph, fused_converter_i16_to_float) {
+    checkFusedConverterMatchesGraph<SourceI16, SinkFloat, int16_t, float>(
+            FusedConverter::Format::I16, FusedConverter::Format::FLOAT, 2, 2);
+}
+
+TEST(test_flowgraph, fused_converter_mono_to_stereo) {
+    checkFusedConverterMatchesGraph<SourceI16, SinkI16, int16_t, int16_t>(
+            FusedConverter::Format::I16, FusedConverter::Format::I16, 1, 2);
+    checkFusedConverterMatchesGraph<SourceFloat, SinkI16, float, int16_t>(
+            FusedConverter::Format::FLOAT, FusedConverter::Format::I16, 1, 2);
+}
+
+TEST(test_flowgraph, fused_converter_multichannel) {
+    checkFusedConverterMatchesGraph<SourceI16, SinkI16, int16_t, int16_t>(
+            FusedConverter::Format::I16, FusedConverter::Format::I16, 6, 6);
+    checkFusedConverterMatchesGraph<SourceFloat, SinkI16, float, int16_t>(
+            FusedConverter::Format::FLOAT, FusedConverter::Format::I16, 1, 3);
+}
+
+TEST(test_flowgraph, flowgraph_fused_process_then_pull) {
+    constexpr int32_t kChannelCount = 2;
+    constexpr int32_t kNumFrames = 300;
+    constexpr float kVolume = 0.5f;
+    AAudioFlowGraph flowgraph;
+    ASSERT_EQ(AAUDIO_OK, flowgraph.configure(AUDIO_FORMAT_PCM_16_BIT /* sourceFormat */,
+            kChannelCount /* sourceChannelCount */,
+            48000 /* sourceSampleRate */,
+            AUDIO_FORMAT_PCM_16_BIT /* sinkFormat */,
+            kChannelCount /* sinkChannelCount */,
+            48000 /* sinkSampleRate */,
+            false /* useMonoBlend */,
+            true /* useVolumeRamps */,
+            0.0f /* audioBalance */,
+            MultiChannelResampler::Quality::Medium));
+    // The ramps start at the first target.
+    flowgraph.setTargetVolume(kVolume);
+
+    int16_t input[kNumFrames * kChannelCount];
+    int16_t output[kNumFrames * kChannelCount] = {};
+    for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+        input[i] = static_cast<int16_t>((i * 97) % 65536 - 32768);
+    }
+
+    int32_t framesRead = flowgraph.process(input, kNumFrames, output, kNumFrames / 3);
+    ASSERT_EQ(kNumFrames / 3, framesRead);
+    framesRead += flowgraph.pull(&output[framesRead * kChannelCount], kNumFrames);
+    ASSERT_EQ(kNumFrames, framesRead);
+    EXPECT_EQ(0, flowgraph.pull(output, kNumFrames));
+
+    for (int i = 0; i < kNumFrames * kChannelCount; i++) {
+        EXPECT_EQ(static_cast<int16_t>(lrintf(input[i] * kVolume)), output[i]) << ", i = " << i;
+    }
+}
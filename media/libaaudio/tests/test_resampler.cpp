@@ -26,15 +26,18 @@
 #include <gtest/gtest.h>
 
 #include "flowgraph/resampler/MultiChannelResampler.h"
+#include "flowgraph/resampler/PolyphaseResampler.h"
+#include "flowgraph/resampler/SincResampler.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
-// Measure zero crossings.
-static int32_t countZeroCrossingsWithHysteresis(float *input, int32_t numSamples) {
+// Measure zero crossings of one channel, every stride samples.
+static int32_t countZeroCrossingsWithHysteresis(float *input, int32_t numSamples,
+                                                int32_t stride = 1) {
     const float kHysteresisLevel = 0.25f;
     int zeroCrossingCount = 0;
     int state = 0; // can be -1, 0, +1
-    for (int i = 0; i < numSamples; i++) {
+    for (int i = 0; i < numSamples * stride; i += stride) {
         if (input[i] >= kHysteresisLevel) {
             if (state < 0) {
                 zeroCrossingCount++;
@@ -50,53 +53,37 @@ static int32_t countZeroCrossingsWithHysteresis(float *input, int32_t numSamples
     return zeroCrossingCount;
 }
 
-static constexpr int kChannelCount = 1;
-
-/**
- * Convert a sine wave and then look for glitches.
- * Glitches have a high value in the second derivative.
- */
-static void checkResampler(int32_t sourceRate, int32_t sinkRate,
-        MultiChannelResampler::Quality quality) {
-    const int kNumOutputSamples = 10000;
-    const double framesPerCycle = 81.379; // target output period
-
-    int numInputSamples = kNumOutputSamples * sourceRate / sinkRate;
-
-    std::unique_ptr<float[]>  inputBuffer = std::make_unique<float[]>(numInputSamples);
-    std::unique_ptr<float[]>  outputBuffer = std::make_unique<float[]>(kNumOutputSamples);
-
-    // Generate a sine wave for input.
-    const double kPhaseIncrement = 2.0 * sinkRate / (framesPerCycle * sourceRate);
+// Generate a sine wave for input, with a different sign and amplitude in each channel.
+static void generateSine(float *buffer, int32_t numFrames, int32_t channelCount,
+                         double phaseIncrement) {
     double phase = 0.0;
-    for (int i = 0; i < numInputSamples; i++) {
-        inputBuffer[i] = sin(phase * M_PI);
-        phase += kPhaseIncrement;
+    for (int i = 0; i < numFrames; i++) {
+        const float sample = sin(phase * M_PI);
+        for (int channel = 0; channel < channelCount; channel++) {
+            const float amplitude = 1.0f - 0.02f * channel;
+            *buffer++ = ((channel & 1) ? -amplitude : amplitude) * sample;
+        }
+        phase += phaseIncrement;
         while (phase > 1.0) {
             phase -= 2.0;
         }
     }
-    int sourceZeroCrossingCount = countZeroCrossingsWithHysteresis(
-            inputBuffer.get(), numInputSamples);
+}
 
-    // Use a MultiChannelResampler to convert from the sourceRate to the sinkRate.
-    std::unique_ptr<MultiChannelResampler>  mcResampler;
-    mcResampler.reset(MultiChannelResampler::make(kChannelCount,
-                                                 sourceRate,
-                                                 sinkRate,
-                                                 quality));
-    int inputFramesLeft = numInputSamples;
+// Feed all of the input frames through the resampler and return the number of frames read.
+static int32_t runResampler(MultiChannelResampler *mcResampler, const float *input,
+                            int32_t numInputFrames, float *output) {
+    const int32_t channelCount = mcResampler->getChannelCount();
+    int inputFramesLeft = numInputFrames;
     int numRead = 0;
-    float *input = inputBuffer.get(); // for iteration
-    float *output = outputBuffer.get();
     while (inputFramesLeft > 0) {
         if (mcResampler->isWriteNeeded()) {
             mcResampler->writeNextFrame(input);
-            input++;
+            input += channelCount;
             inputFramesLeft--;
         } else {
             mcResampler->readNextFrame(output);
-            output++;
+            output += channelCount;
             numRead++;
         }
     }
@@ -104,32 +91,70 @@ static void checkResampler(int32_t sourceRate, int32_t sinkRate,
     // Flush out remaining frames from the flowgraph
     while (!mcResampler->isWriteNeeded()) {
         mcResampler->readNextFrame(output);
-        output++;
+        output += channelCount;
         numRead++;
     }
+    return numRead;
+}
+
+/**
+ * Convert a sine wave and then look for glitches.
+ * Glitches have a high value in the second derivative.
+ */
+static void checkResampler(int32_t sourceRate, int32_t sinkRate,
+        MultiChannelResampler::Quality quality, int32_t channelCount = 1) {
+    const int kNumOutputSamples = 10000;
+    const double framesPerCycle = 81.379; // target output period
+
+    int numInputSamples = kNumOutputSamples * sourceRate / sinkRate;
+
+    std::unique_ptr<float[]>  inputBuffer =
+            std::make_unique<float[]>(numInputSamples * channelCount);
+    std::unique_ptr<float[]>  outputBuffer =
+            std::make_unique<float[]>(kNumOutputSamples * channelCount);
+
+    const double kPhaseIncrement = 2.0 * sinkRate / (framesPerCycle * sourceRate);
+    generateSine(inputBuffer.get(), numInputSamples, channelCount, kPhaseIncrement);
+
+    // Use a MultiChannelResampler to convert from the sourceRate to the sinkRate.
+    std::unique_ptr<MultiChannelResampler>  mcResampler;
+    mcResampler.reset(MultiChannelResampler::make(channelCount,
+                                                 sourceRate,
+                                                 sinkRate,
+                                                 quality));
+    int numRead = runResampler(mcResampler.get(), inputBuffer.get(), numInputSamples,
+            outputBuffer.get());
 
     ASSERT_LE(numRead, kNumOutputSamples);
     // Some frames are lost priming the FIR filter.
     const int kMaxAlgorithmicFrameLoss = 5;
     EXPECT_GT(numRead, kNumOutputSamples - kMaxAlgorithmicFrameLoss);
 
-    int sinkZeroCrossingCount = countZeroCrossingsWithHysteresis(outputBuffer.get(), numRead);
-    const int kMaxZeroCrossingDelta = std::max(sinkRate / sourceRate / 2, 1);
-    EXPECT_LE(abs(sourceZeroCrossingCount - sinkZeroCrossingCount), kMaxZeroCrossingDelta);
-
-    // Detect glitches by looking for spikes in the second derivative.
-    output = outputBuffer.get();
-    float previousValue = output[0];
-    float previousSlope = output[1] - output[0];
-    for (int i = 0; i < numRead; i++) {
-        float slope = output[i] - previousValue;
-        float slopeDelta = fabs(slope - previousSlope);
-        // Skip a few samples because there are often some steep slope changes at the beginning.
-        if (i > 10) {
-            EXPECT_LT(slopeDelta, 0.1);
+    for (int channel = 0; channel < channelCount; channel++) {
+        int sourceZeroCrossingCount = countZeroCrossingsWithHysteresis(
+                inputBuffer.get() + channel, numInputSamples, channelCount);
+        int sinkZeroCrossingCount = countZeroCrossingsWithHysteresis(
+                outputBuffer.get() + channel, numRead, channelCount);
+        const int kMaxZeroCrossingDelta = std::max(sinkRate / sourceRate / 2, 1);
+        EXPECT_LE(abs(sourceZeroCrossingCount - sinkZeroCrossingCount), kMaxZeroCrossingDelta)
+                << ", channel = " << channel;
+
+        // Detect glitches by looking for spikes in the second derivative.
+        float *output = outputBuffer.get() + channel;
+        float previousValue = output[0];
+        float previousSlope = output[channelCount] - output[0];
+        for (int i = 0; i < numRead; i++) {
+            float value = output[i * channelCount];
+            float slope = value - previousValue;
+            float slopeDelta = fabs(slope - previousSlope);
+            // Skip a few samples because there are often some steep slope changes
+            // at the beginning.
+            if (i > 10) {
+                ASSERT_LT(slopeDelta, 0.1) << ", channel = " << channel << ", i = " << i;
+            }
+            previousValue = value;
+            previousSlope = slope;
         }
-        previousValue = output[i];
-        previousSlope = slope;
     }
 
 #if 0
@@ -223,3 +248,59 @@ TEST(test_resampler, resampler_48000_44100_best) {
 TEST(test_resampler, resampler_44100_11025_best) {
     checkResampler(44100, 11025, MultiChannelResampler::Quality::Best);
 }
+
+// Channel counts with a specialized resampler, and some that use the generic one.
+static constexpr int32_t kChannelCounts[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 12, 16, 24};
+
+// 44100 <-> 48000 use a polyphase resampler, 8000 -> 44100 and 44100 -> 32000 at Best quality
+// have too many coefficients for a polyphase resampler, so they use a sinc resampler.
+TEST(test_resampler, resampler_channel_counts) {
+    for (int32_t channelCount : kChannelCounts) {
+        SCOPED_TRACE(channelCount);
+        checkResampler(44100, 48000, MultiChannelResampler::Quality::Best, channelCount);
+        checkResampler(48000, 44100, MultiChannelResampler::Quality::Medium, channelCount);
+        checkResampler(8000, 44100, MultiChannelResampler::Quality::Best, channelCount);
+        checkResampler(44100, 32000, MultiChannelResampler::Quality::Best, channelCount);
+    }
+}
+
+// The resamplers specialized for a channel count must match the generic ones.
+template <typename Generic>
+static void checkSpecializedMatchesGeneric(int32_t sourceRate, int32_t sinkRate,
+                                           int32_t numTaps, int32_t channelCount) {
+    const int kNumInputFrames = 2000;
+    const int kMaxOutputFrames = kNumInputFrames * sinkRate / sourceRate + 2;
+    std::vector<float> input(kNumInputFrames * channelCount);
+    generateSine(input.data(), kNumInputFrames, channelCount, 0.01);
+
+    MultiChannelResampler::Builder builder;
+    builder.setChannelCount(channelCount)
+            ->setInputRate(sourceRate)
+            ->setOutputRate(sinkRate)
+            ->setNumTaps(numTaps);
+    std::unique_ptr<MultiChannelResampler> specialized(builder.build());
+    Generic generic(builder);
+
+    std::vector<float> expected(kMaxOutputFrames * channelCount);
+    std::vector<float> actual(kMaxOutputFrames * channelCount);
+    const int32_t numExpected = runResampler(&generic, input.data(), kNumInputFrames,
+            expected.data());
+    const int32_t numActual = runResampler(specialized.get(), input.data(), kNumInputFrames,
+            actual.data());
+    ASSERT_EQ(numExpected, numActual);
+    // The sums are done in a different order.
+    const float kTolerance = 1.0e-5f;
+    for (int i = 0; i < numActual * channelCount; i++) {
+        ASSERT_NEAR(expected[i], actual[i], kTolerance) << ", i = " << i;
+    }
+}
+
+TEST(test_resampler, resampler_specialized_matches_generic) {
+    for (int32_t channelCount : kChannelCounts) {
+        SCOPED_TRACE(channelCount);
+        checkSpecializedMatchesGeneric<PolyphaseResampler>(44100, 48000, 16, channelCount);
+        checkSpecializedMatchesGeneric<PolyphaseResampler>(48000, 16000, 32, channelCount);
+        checkSpecializedMatchesGeneric<SincResampler>(8000, 44100, 32, channelCount);
+        checkSpecializedMatchesGeneric<SincResampler>(44100, 32000, 32, channelCount);
+    }
+}
@@ -92,11 +92,8 @@ public:
         sp<Client> client;
 
         bool reportNoError = false;
-        {
-            std::lock_guard _l(mMutex);
-            if (mService != nullptr) {
-                return mService;
-            }
+        if (const auto connection = std::atomic_load(&mConnection)) {
+            return connection->service;
         }
 
         std::unique_lock ul_only1thread(mSingleGetter);
@@ -142,6 +139,7 @@ public:
         if (mCvGetter) mCvGetter.reset();  // remove condition variable.
         client = mClient;
         service = mService;
+        std::atomic_store(&mConnection, std::make_shared<const Connection>(service, client));
         // Make sure callbacks can be received by the client
         if (mCanStartThreadPool) {
             ProcessState::self()->startThreadPool();
@@ -163,6 +161,9 @@ public:
     }
 
     sp<Client> getClient() EXCLUDES(mMutex)  {
+        if (const auto connection = std::atomic_load(&mConnection)) {
+            return connection->client;
+        }
         const auto service = getService();
         if (service == nullptr) return nullptr;
         std::lock_guard _l(mMutex);
@@ -183,6 +184,7 @@ public:
     void clearService() EXCLUDES(mMutex)  {
         std::lock_guard _l(mMutex);
         mService.clear();
+        std::atomic_store(&mConnection, std::shared_ptr<const Connection>());
         if (mClient) ServiceTraits::onClearService(mClient);
     }
 
@@ -191,6 +193,13 @@ public:
     }
 
 private:
+    struct Connection {
+        Connection(const sp<ServiceInterface>& service, const sp<Client>& client)
+            : service(service), client(client) {}
+        const sp<ServiceInterface> service;
+        const sp<Client> client;
+    };
+
     std::mutex mSingleGetter;
     std::mutex mMutex;
     std::shared_ptr<std::condition_variable> mCvGetter GUARDED_BY(mMutex);
@@ -198,6 +207,9 @@ private:
     sp<ServiceInterface> mLocalService GUARDED_BY(mMutex);
     sp<ServiceInterface> mService GUARDED_BY(mMutex);
     sp<Client> mClient GUARDED_BY(mMutex);
+    // Copy of mService and mClient once connected, for readers which do not take mMutex.
+    // Replaced with std::atomic_store() while holding mMutex, read with std::atomic_load().
+    std::shared_ptr<const Connection> mConnection;
     std::atomic<bool> mCanStartThreadPool = true;
 };
 
@@ -439,13 +451,13 @@ AudioSystem::getOutputSamplingRate(uint32_t* samplingRate, audio_stream_type_t s
 
 status_t AudioSystem::getSamplingRate(audio_io_handle_t ioHandle,
                                       uint32_t* samplingRate) {
-    const sp<IAudioFlinger> af = get_audio_flinger();
-    if (af == 0) return PERMISSION_DENIED;
-    sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
-    if (desc == 0) {
-        *samplingRate = af->sampleRate(ioHandle);
-    } else {
+    // The I/O descriptor cache is lock free, the service is only needed on a cache miss.
+    if (const sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle)) {
         *samplingRate = desc->getSamplingRate();
+    } else {
+        const sp<IAudioFlinger> af = get_audio_flinger();
+        if (af == 0) return PERMISSION_DENIED;
+        *samplingRate = af->sampleRate(ioHandle);
     }
     if (*samplingRate == 0) {
         ALOGE("AudioSystem::getSamplingRate failed for ioHandle %d", ioHandle);
@@ -474,13 +486,13 @@ status_t AudioSystem::getOutputFrameCount(size_t* frameCount, audio_stream_type_
 
 status_t AudioSystem::getFrameCount(audio_io_handle_t ioHandle,
                                     size_t* frameCount) {
-    const sp<IAudioFlinger> af = get_audio_flinger();
-    if (af == 0) return PERMISSION_DENIED;
-    sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
-    if (desc == 0) {
-        *frameCount = af->frameCount(ioHandle);
-    } else {
+    // The I/O descriptor cache is lock free, the service is only needed on a cache miss.
+    if (const sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle)) {
         *frameCount = desc->getFrameCount();
+    } else {
+        const sp<IAudioFlinger> af = get_audio_flinger();
+        if (af == 0) return PERMISSION_DENIED;
+        *frameCount = af->frameCount(ioHandle);
     }
     if (*frameCount == 0) {
         ALOGE("AudioSystem::getFrameCount failed for ioHandle %d", ioHandle);
@@ -509,13 +521,13 @@ status_t AudioSystem::getOutputLatency(uint32_t* latency, audio_stream_type_t st
 
 status_t AudioSystem::getLatency(audio_io_handle_t output,
                                  uint32_t* latency) {
-    const sp<IAudioFlinger> af = get_audio_flinger();
-    if (af == 0) return PERMISSION_DENIED;
-    sp<AudioIoDescriptor> outputDesc = getIoDescriptor(output);
-    if (outputDesc == 0) {
-        *latency = af->latency(output);
-    } else {
+    // The I/O descriptor cache is lock free, the service is only needed on a cache miss.
+    if (const sp<AudioIoDescriptor> outputDesc = getIoDescriptor(output)) {
         *latency = outputDesc->getLatency();
+    } else {
+        const sp<IAudioFlinger> af = get_audio_flinger();
+        if (af == 0) return PERMISSION_DENIED;
+        *latency = af->latency(output);
     }
 
     ALOGV("getLatency() output %d, latency %d", output, *latency);
@@ -597,13 +609,13 @@ status_t AudioSystem::audioPolicyReady() {
 
 status_t AudioSystem::getFrameCountHAL(audio_io_handle_t ioHandle,
                                        size_t* frameCount) {
-    const sp<IAudioFlinger> af = get_audio_flinger();
-    if (af == 0) return PERMISSION_DENIED;
-    sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
-    if (desc == 0) {
-        *frameCount = af->frameCountHAL(ioHandle);
-    } else {
+    // The I/O descriptor cache is lock free, the service is only needed on a cache miss.
+    if (const sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle)) {
         *frameCount = desc->getFrameCountHAL();
+    } else {
+        const sp<IAudioFlinger> af = get_audio_flinger();
+        if (af == 0) return PERMISSION_DENIED;
+        *frameCount = af->frameCountHAL(ioHandle);
     }
     if (*frameCount == 0) {
         ALOGE("AudioSystem::getFrameCountHAL failed for ioHandle %d", ioHandle);
@@ -620,11 +632,8 @@ status_t AudioSystem::getFrameCountHAL(audio_io_handle_t ioHandle,
 
 void AudioSystem::AudioFlingerClient::clearIoCache() {
     std::lock_guard _l(mMutex);
-    mIoDescriptors.clear();
-    mInBuffSize = 0;
-    mInSamplingRate = 0;
-    mInFormat = AUDIO_FORMAT_DEFAULT;
-    mInChannelMask = AUDIO_CHANNEL_NONE;
+    std::atomic_store(&mIoDescriptors, std::make_shared<const IoDescriptors>());
+    std::atomic_store(&mInputBufferSize, std::shared_ptr<const InputBufferSize>());
 }
 
 void AudioSystem::AudioFlingerClient::binderDied(const wp<IBinder>& who __unused) {
@@ -658,10 +667,10 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
             case AUDIO_OUTPUT_REGISTERED:
             case AUDIO_INPUT_OPENED:
             case AUDIO_INPUT_REGISTERED: {
-                if (sp<AudioIoDescriptor> oldDesc = getIoDescriptor_l(ioDesc->getIoHandle())) {
+                if (sp<AudioIoDescriptor> oldDesc = getIoDescriptor(ioDesc->getIoHandle())) {
                     deviceId = oldDesc->getDeviceId();
                 }
-                mIoDescriptors[ioDesc->getIoHandle()] = ioDesc;
+                setIoDescriptor_l(ioDesc);
 
                 if (ioDesc->getDeviceId() != AUDIO_PORT_HANDLE_NONE) {
                     deviceId = ioDesc->getDeviceId();
@@ -682,7 +691,7 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
                 break;
             case AUDIO_OUTPUT_CLOSED:
             case AUDIO_INPUT_CLOSED: {
-                if (getIoDescriptor_l(ioDesc->getIoHandle()) == 0) {
+                if (getIoDescriptor(ioDesc->getIoHandle()) == 0) {
                     ALOGW("ioConfigChanged() closing unknown %s %d",
                           event == AUDIO_OUTPUT_CLOSED ? "output" : "input", ioDesc->getIoHandle());
                     break;
@@ -690,14 +699,14 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
                 ALOGV("ioConfigChanged() %s %d closed",
                       event == AUDIO_OUTPUT_CLOSED ? "output" : "input", ioDesc->getIoHandle());
 
-                mIoDescriptors.erase(ioDesc->getIoHandle());
+                removeIoDescriptor_l(ioDesc->getIoHandle());
                 mAudioDeviceCallbacks.erase(ioDesc->getIoHandle());
             }
                 break;
 
             case AUDIO_OUTPUT_CONFIG_CHANGED:
             case AUDIO_INPUT_CONFIG_CHANGED: {
-                sp<AudioIoDescriptor> oldDesc = getIoDescriptor_l(ioDesc->getIoHandle());
+                sp<AudioIoDescriptor> oldDesc = getIoDescriptor(ioDesc->getIoHandle());
                 if (oldDesc == 0) {
                     ALOGW("ioConfigChanged() modifying unknown %s! %d",
                           event == AUDIO_OUTPUT_CONFIG_CHANGED ? "output" : "input",
@@ -706,7 +715,7 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
                 }
 
                 deviceId = oldDesc->getDeviceId();
-                mIoDescriptors[ioDesc->getIoHandle()] = ioDesc;
+                setIoDescriptor_l(ioDesc);
 
                 if (deviceId != ioDesc->getDeviceId()) {
                     deviceId = ioDesc->getDeviceId();
@@ -722,7 +731,7 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
             }
                 break;
             case AUDIO_CLIENT_STARTED: {
-                sp<AudioIoDescriptor> oldDesc = getIoDescriptor_l(ioDesc->getIoHandle());
+                sp<AudioIoDescriptor> oldDesc = getIoDescriptor(ioDesc->getIoHandle());
                 if (oldDesc == 0) {
                     ALOGW("ioConfigChanged() start client on unknown io! %d",
                             ioDesc->getIoHandle());
@@ -730,14 +739,21 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
                 }
                 ALOGV("ioConfigChanged() AUDIO_CLIENT_STARTED  io %d port %d num callbacks %zu",
                       ioDesc->getIoHandle(), ioDesc->getPortId(), mAudioDeviceCallbacks.size());
-                oldDesc->setPatch(ioDesc->getPatch());
+                // Readers may hold oldDesc without mMutex, so replace it rather than modify it.
+                const auto newDesc = sp<AudioIoDescriptor>::make(
+                        oldDesc->getIoHandle(), ioDesc->getPatch(), oldDesc->getIsInput(),
+                        oldDesc->getSamplingRate(), oldDesc->getFormat(),
+                        oldDesc->getChannelMask(), oldDesc->getFrameCount(),
+                        oldDesc->getFrameCountHAL(), oldDesc->getLatency(),
+                        oldDesc->getPortId());
+                setIoDescriptor_l(newDesc);
                 auto it = mAudioDeviceCallbacks.find(ioDesc->getIoHandle());
                 if (it != mAudioDeviceCallbacks.end()) {
                     auto cbks = it->second;
                     auto it2 = cbks.find(ioDesc->getPortId());
                     if (it2 != cbks.end()) {
                         callbacks.emplace(ioDesc->getPortId(), it2->second);
-                        deviceId = oldDesc->getDeviceId();
+                        deviceId = newDesc->getDeviceId();
                     }
                 }
             }
@@ -793,42 +809,48 @@ status_t AudioSystem::AudioFlingerClient::getInputBufferSize(
     if (af == 0) {
         return PERMISSION_DENIED;
     }
-    std::lock_guard _l(mMutex);
-    // Do we have a stale mInBuffSize or are we requesting the input buffer size for new values
-    if ((mInBuffSize == 0) || (sampleRate != mInSamplingRate) || (format != mInFormat)
-        || (channelMask != mInChannelMask)) {
-        size_t inBuffSize = af->getInputBufferSize(sampleRate, format, channelMask);
-        if (inBuffSize == 0) {
-            ALOGE("AudioSystem::getInputBufferSize failed sampleRate %d format %#x channelMask %#x",
-                  sampleRate, format, channelMask);
-            return BAD_VALUE;
-        }
-        // A benign race is possible here: we could overwrite a fresher cache entry
-        // save the request params
-        mInSamplingRate = sampleRate;
-        mInFormat = format;
-        mInChannelMask = channelMask;
-
-        mInBuffSize = inBuffSize;
+    // Do we have a stale cache or are we requesting the input buffer size for new values
+    const auto cached = std::atomic_load(&mInputBufferSize);
+    if (cached != nullptr && sampleRate == cached->sampleRate && format == cached->format
+        && channelMask == cached->channelMask) {
+        *buffSize = cached->buffSize;
+        return NO_ERROR;
+    }
+    size_t inBuffSize = af->getInputBufferSize(sampleRate, format, channelMask);
+    if (inBuffSize == 0) {
+        ALOGE("AudioSystem::getInputBufferSize failed sampleRate %d format %#x channelMask %#x",
+              sampleRate, format, channelMask);
+        return BAD_VALUE;
     }
+    // A benign race is possible here: we could overwrite a fresher cache entry
+    // save the request params
+    std::atomic_store(&mInputBufferSize, std::make_shared<const InputBufferSize>(
+            InputBufferSize{sampleRate, format, channelMask, inBuffSize}));
 
-    *buffSize = mInBuffSize;
+    *buffSize = inBuffSize;
 
     return NO_ERROR;
 }
 
-sp<AudioIoDescriptor>
-AudioSystem::AudioFlingerClient::getIoDescriptor_l(audio_io_handle_t ioHandle) {
-    if (const auto it = mIoDescriptors.find(ioHandle);
-        it != mIoDescriptors.end()) {
-        return it->second;
-    }
-    return {};
+void AudioSystem::AudioFlingerClient::setIoDescriptor_l(const sp<AudioIoDescriptor>& ioDesc) {
+    auto ioDescriptors = std::make_shared<IoDescriptors>(*mIoDescriptors);
+    (*ioDescriptors)[ioDesc->getIoHandle()] = ioDesc;
+    std::atomic_store(&mIoDescriptors, std::shared_ptr<const IoDescriptors>(ioDescriptors));
+}
+
+void AudioSystem::AudioFlingerClient::removeIoDescriptor_l(audio_io_handle_t ioHandle) {
+    auto ioDescriptors = std::make_shared<IoDescriptors>(*mIoDescriptors);
+    ioDescriptors->erase(ioHandle);
+    std::atomic_store(&mIoDescriptors, std::shared_ptr<const IoDescriptors>(ioDescriptors));
 }
 
 sp<AudioIoDescriptor> AudioSystem::AudioFlingerClient::getIoDescriptor(audio_io_handle_t ioHandle) {
-    std::lock_guard _l(mMutex);
-    return getIoDescriptor_l(ioHandle);
+    // Lock free, the snapshot is never modified after it is published.
+    const auto ioDescriptors = std::atomic_load(&mIoDescriptors);
+    if (const auto it = ioDescriptors->find(ioHandle); it != ioDescriptors->end()) {
+        return it->second;
+    }
+    return {};
 }
 
 status_t AudioSystem::AudioFlingerClient::addAudioDeviceCallback(
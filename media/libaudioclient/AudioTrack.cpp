@@ -30,6 +30,7 @@
 #include <audio_utils/primitives.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
+#include <cutils/properties.h>
 #include <media/AudioTrack.h>
 #include <utils/Log.h>
 #include <private/media/AudioTrackShared.h>
@@ -2131,6 +2132,12 @@ status_t AudioTrack::createTrack_l()
     mProxy->setPlaybackRate(playbackRateTemp);
     mProxy->setMinimum(mNotificationFramesAct);
 
+    // Fast tracks have small buffers, so obtainBuffer() often waits for less than a server period.
+    if ((mFlags & AUDIO_OUTPUT_FLAG_FAST) && mSharedBuffer == 0
+            && property_get_bool("audio.track.adaptive_wait", false /* default_value */)) {
+        mProxy->setAdaptiveWait(true);
+    }
+
     if (mDualMonoMode != AUDIO_DUAL_MONO_MODE_OFF) {
         setDualMonoMode_l(mDualMonoMode);
     }
@@ -3634,6 +3641,13 @@ status_t AudioTrack::dump(int fd, const Vector<String16>& args __unused) const
                         mLatency, mSelectedDeviceId, mRoutedDeviceId);
     result.appendFormat("  output(%d) AF latency (%u) AF frame count(%zu) AF SampleRate(%u)\n",
                         mOutput, mAfLatency, mAfFrameCount, mAfSampleRate);
+    if (mProxy != 0) {
+        const ClientProxy::WaitStats stats = mProxy->getWaitStats();
+        result.appendFormat("  adaptive wait(%d) spins(%u) spin hits(%u) sleeps(%u) wakeups(%u)"
+                " server period(%lld ns)\n",
+                mProxy->isAdaptiveWait(), stats.mSpins, stats.mSpinHits, stats.mSleeps,
+                stats.mWakeups, (long long) stats.mServerPeriodNs);
+    }
     ::write(fd, result.c_str(), result.size());
     return NO_ERROR;
 }
@@ -17,6 +17,7 @@
 #define LOG_TAG "AudioTrackShared"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <atomic>
 #include <android-base/macros.h>
 #include <private/media/AudioTrackShared.h>
@@ -25,6 +26,7 @@
 
 #include <linux/futex.h>
 #include <sys/syscall.h>
+#include <unistd.h>
 
 namespace android {
 
@@ -125,6 +127,113 @@ const struct timespec ClientProxy::kNonBlocking = {0 /*tv_sec*/, 0 /*tv_nsec*/};
 // order of minutes.
 #define MAX_SEC    5
 
+// Adaptive wait: the server is expected one server period after its position last changed.
+// Spinning until then, plus a quarter period of jitter, is cheaper than a futex wait and wake
+// when that is short, so the client only spins when the server is expected within
+// kMaxSpinNs, for this remaining wait capped at kMaxSpinNs.
+// Each spin miss halves kMaxSpinNs, up to kMaxSpinMisses times,
+// and a spin shorter than kMinSpinNs is not attempted.
+static constexpr nsecs_t kMaxSpinNs = 50000;
+static constexpr nsecs_t kMinSpinNs = 1000;
+static constexpr uint32_t kMaxSpinMisses = 6;
+// Longer intervals between server releases are pauses, not the server period.
+static constexpr nsecs_t kMaxServerPeriodNs = 100000000;
+
+static inline void cpuRelax()
+{
+#if defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield" ::: "memory");
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+void ClientProxy::setAdaptiveWait(bool enabled)
+{
+    mAdaptiveWait = enabled;
+    // The server cannot make progress while the client spins on a single CPU.
+    mSpinAllowed = enabled && sysconf(_SC_NPROCESSORS_ONLN) > 1;
+    if (enabled) {
+        (void) android_atomic_or(CBLK_FUTEX_ADAPTIVE, &mCblk->mFutex);
+    } else {
+        (void) android_atomic_and(~CBLK_FUTEX_ADAPTIVE, &mCblk->mFutex);
+    }
+}
+
+ClientProxy::WaitStats ClientProxy::getWaitStats() const
+{
+    return WaitStats{
+        .mSpins = mSpins.load(std::memory_order_relaxed),
+        .mSpinHits = mSpinHits.load(std::memory_order_relaxed),
+        .mSleeps = mSleeps.load(std::memory_order_relaxed),
+        .mWakeups = mWakeups.load(std::memory_order_relaxed),
+        .mServerPeriodNs = mServerPeriodNs.load(std::memory_order_relaxed),
+    };
+}
+
+// Updates the estimated server period when the server position has moved.
+void ClientProxy::observeServerPosition(int32_t position)
+{
+    if (position == mLastServerPosition) {
+        return;
+    }
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    const nsecs_t interval = now - mLastServerChangeNs;
+    if (mLastServerChangeNs != 0 && interval < kMaxServerPeriodNs) {
+        const int64_t period = mServerPeriodNs.load(std::memory_order_relaxed);
+        mServerPeriodNs.store(period == 0 ? interval : (7 * period + interval) / 8,
+                std::memory_order_relaxed);
+    }
+    mLastServerPosition = position;
+    mLastServerChangeNs = now;
+}
+
+// Returns the spin budget, or 0 if the client should not spin: the server period is unknown,
+// the server is not expected within the budget, or it is already later than the jitter allowance.
+nsecs_t ClientProxy::spinLimitNs() const
+{
+    const nsecs_t period = mServerPeriodNs.load(std::memory_order_relaxed);
+    if (period == 0) {
+        return 0;
+    }
+    const nsecs_t limit = kMaxSpinNs >> mSpinMisses;
+    const nsecs_t expected = mLastServerChangeNs + period - systemTime(SYSTEM_TIME_MONOTONIC);
+    if (expected > limit) {
+        return 0;
+    }
+    return std::clamp(expected + period / 4, (nsecs_t) 0, limit);
+}
+
+// Spins until the server moves away from position, or the spin budget is used.
+// Returns true if the server moved.
+bool ClientProxy::spinForServer(int32_t position)
+{
+    const nsecs_t budget = spinLimitNs();
+    if (!mSpinAllowed || budget < kMinSpinNs) {
+        return false;
+    }
+    mSpins.fetch_add(1, std::memory_order_relaxed);
+    const volatile int32_t *serverPosition =
+            mIsOut ? &mCblk->u.mStreaming.mFront : &mCblk->u.mStreaming.mRear;
+    const nsecs_t deadline = systemTime(SYSTEM_TIME_MONOTONIC) + budget;
+    do {
+        for (int i = 0; i < 16; ++i) {
+            if (android_atomic_acquire_load(serverPosition) != position) {
+                mSpinHits.fetch_add(1, std::memory_order_relaxed);
+                if (mSpinMisses > 0) {
+                    mSpinMisses--;
+                }
+                return true;
+            }
+            cpuRelax();
+        }
+    } while (systemTime(SYSTEM_TIME_MONOTONIC) < deadline);
+    if (mSpinMisses < kMaxSpinMisses) {
+        mSpinMisses++;
+    }
+    return false;
+}
+
 uint32_t ClientProxy::setBufferSizeInFrames(uint32_t size)
 {
     // The minimum should be  greater than zero and less than the size
@@ -180,6 +289,8 @@ status_t ClientProxy::obtainBuffer(Buffer* buffer, const struct timespec *reques
     bool beforeIsValid = false;
     audio_track_cblk_t* cblk = mCblk;
     bool ignoreInitialPendingInterrupt = true;
+    bool spun = false;              // adaptive wait: at most one spin per call
+    bool registered = false;        // adaptive wait: CBLK_FUTEX_WAITER is set
     // check for shared memory corruption
     if (mIsShutdown) {
         status = NO_INIT;
@@ -223,6 +334,10 @@ status_t ClientProxy::obtainBuffer(Buffer* buffer, const struct timespec *reques
             rear = android_atomic_acquire_load(&cblk->u.mStreaming.mRear);
             front = cblk->u.mStreaming.mFront;
         }
+        const int32_t serverPosition = mIsOut ? front : rear;
+        if (mAdaptiveWait) {
+            observeServerPosition(serverPosition);
+        }
         // write to rear, read from front
         ssize_t filled = audio_utils::safe_sub_overflow(rear, front);
         // pipe should not be overfull
@@ -310,16 +425,40 @@ status_t ClientProxy::obtainBuffer(Buffer* buffer, const struct timespec *reques
             ts = NULL;
             break;
         }
+        if (mAdaptiveWait) {
+            if (!spun) {
+                spun = true;
+                if (spinForServer(serverPosition)) {
+                    continue;
+                }
+            }
+            // The server wakes only if this is set when it sets CBLK_FUTEX_WAKE,
+            // so it must be set before CBLK_FUTEX_WAKE is cleared below.
+            if (!registered) {
+                (void) android_atomic_or(CBLK_FUTEX_WAITER, &cblk->mFutex);
+                registered = true;
+            }
+        }
         int32_t old = android_atomic_and(~CBLK_FUTEX_WAKE, &cblk->mFutex);
         if (!(old & CBLK_FUTEX_WAKE)) {
             if (measure && !beforeIsValid) {
                 clock_gettime(CLOCK_MONOTONIC, &before);
                 beforeIsValid = true;
             }
+            mSleeps.fetch_add(1, std::memory_order_relaxed);
+            const nsecs_t sleepStartNs = mAdaptiveWait ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
             errno = 0;
             (void) syscall(__NR_futex, &cblk->mFutex,
                     mClientInServer ? FUTEX_WAIT_PRIVATE : FUTEX_WAIT, old & ~CBLK_FUTEX_WAKE, ts);
-            status_t error = errno; // clock_gettime can affect errno
+            status_t error = errno; // systemTime and clock_gettime can affect errno
+            if (error == 0) {
+                mWakeups.fetch_add(1, std::memory_order_relaxed);
+                // A short sleep means that a longer spin would have succeeded.
+                if (mAdaptiveWait && mSpinMisses > 0 &&
+                        systemTime(SYSTEM_TIME_MONOTONIC) - sleepStartNs < kMaxSpinNs) {
+                    mSpinMisses--;
+                }
+            }
             // update total elapsed time spent waiting
             if (measure) {
                 struct timespec after;
@@ -354,6 +493,9 @@ status_t ClientProxy::obtainBuffer(Buffer* buffer, const struct timespec *reques
     }
 
 end:
+    if (registered) {
+        (void) android_atomic_and(~CBLK_FUTEX_WAITER, &cblk->mFutex);
+    }
     if (status != NO_ERROR) {
         buffer->mFrameCount = 0;
         buffer->mRaw = NULL;
@@ -938,7 +1080,10 @@ void ServerProxy::releaseBuffer(Buffer* buffer)
     if (!mIsOut || (mAvailToClient + stepCount >= minimum)) {
         ALOGV("mAvailToClient=%zu stepCount=%zu minimum=%zu", mAvailToClient, stepCount, minimum);
         int32_t old = android_atomic_or(CBLK_FUTEX_WAKE, &cblk->mFutex);
-        if (!(old & CBLK_FUTEX_WAKE)) {
+        // A client in adaptive wait mode only sleeps after registering as a waiter.
+        const bool noWaiter = (old & (CBLK_FUTEX_ADAPTIVE | CBLK_FUTEX_WAITER))
+                == CBLK_FUTEX_ADAPTIVE;
+        if (!(old & CBLK_FUTEX_WAKE) && !noWaiter) {
             (void) syscall(__NR_futex, &cblk->mFutex,
                     mClientInServer ? FUTEX_WAKE_PRIVATE : FUTEX_WAKE, INT_MAX);
         }
@@ -19,6 +19,8 @@
 
 #include <sys/types.h>
 
+#include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <vector>
@@ -805,7 +807,7 @@ public:
         void clearIoCache() EXCLUDES(mMutex);
         status_t getInputBufferSize(uint32_t sampleRate, audio_format_t format,
                 audio_channel_mask_t channelMask, size_t* buffSize) EXCLUDES(mMutex);
-        sp<AudioIoDescriptor> getIoDescriptor(audio_io_handle_t ioHandle) EXCLUDES(mMutex);
+        sp<AudioIoDescriptor> getIoDescriptor(audio_io_handle_t ioHandle);
 
         // DeathRecipient
         void binderDied(const wp<IBinder>& who) final;
@@ -836,8 +838,13 @@ public:
         audio_port_handle_t getDeviceIdForIo(audio_io_handle_t audioIo) EXCLUDES(mMutex);
 
     private:
+        using IoDescriptors = std::map<audio_io_handle_t, sp<AudioIoDescriptor>>;
+
         mutable std::mutex mMutex;
-        std::map<audio_io_handle_t, sp<AudioIoDescriptor>> mIoDescriptors GUARDED_BY(mMutex);
+        // Immutable snapshot, so that getIoDescriptor() does not take mMutex.
+        // It is replaced with std::atomic_store() while holding mMutex,
+        // and read with std::atomic_load().
+        std::shared_ptr<const IoDescriptors> mIoDescriptors = std::make_shared<IoDescriptors>();
 
         std::map<audio_io_handle_t, std::map<audio_port_handle_t, wp<AudioDeviceCallback>>>
                 mAudioDeviceCallbacks GUARDED_BY(mMutex);
@@ -846,12 +853,17 @@ public:
                 mSupportedLatencyModesCallbacks GUARDED_BY(mMutex);
 
         // cached values for recording getInputBufferSize() queries
-        size_t mInBuffSize GUARDED_BY(mMutex) = 0; // zero indicates cache is invalid
-        uint32_t mInSamplingRate GUARDED_BY(mMutex) = 0;
-        audio_format_t mInFormat GUARDED_BY(mMutex) = AUDIO_FORMAT_DEFAULT;
-        audio_channel_mask_t mInChannelMask GUARDED_BY(mMutex) = AUDIO_CHANNEL_NONE;
-
-        sp<AudioIoDescriptor> getIoDescriptor_l(audio_io_handle_t ioHandle) REQUIRES(mMutex);
+        struct InputBufferSize {
+            uint32_t sampleRate;
+            audio_format_t format;
+            audio_channel_mask_t channelMask;
+            size_t buffSize;
+        };
+        // Immutable snapshot like mIoDescriptors, nullptr indicates cache is invalid.
+        std::shared_ptr<const InputBufferSize> mInputBufferSize;
+
+        void setIoDescriptor_l(const sp<AudioIoDescriptor>& ioDesc) REQUIRES(mMutex);
+        void removeIoDescriptor_l(audio_io_handle_t ioHandle) REQUIRES(mMutex);
     };
 
     class AudioPolicyServiceClient: public IBinder::DeathRecipient,
@@ -23,6 +23,7 @@
 #include <system/audio_effects/effect_hapticgenerator.h>
 #include <system/audio_effects/effect_spatializer.h>
 #include <system/audio_effects/effect_visualizer.h>
+#include <visualizer/effect_visualizer_spectrum.h>
 
 #include "audio_test_utils.h"
 #include "test_execution_tracer.h"
@@ -233,6 +234,55 @@ TEST(AudioEffectTest, DISABLED_GetSetParameterForEffect) {
             << "target mode does not match set mode";
 }
 
+TEST(AudioEffectTest, VisualizerSpectrum) {
+    sp<AudioEffect> visualizer = createEffect(SL_IID_VISUALIZATION);
+    status_t status = visualizer->initCheck();
+    ASSERT_TRUE(status == NO_ERROR || status == ALREADY_EXISTS) << "Init check error";
+
+    constexpr uint32_t kSpectrumSize = 1024;
+    uint32_t buf32[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
+    effect_param_t* vis_param = (effect_param_t*)buf32;
+    vis_param->psize = sizeof(uint32_t);
+    vis_param->vsize = sizeof(uint32_t);
+    *(int32_t*)vis_param->data = VISUALIZER_PARAM_SPECTRUM_SIZE;
+    *((int32_t*)vis_param->data + 1) = kSpectrumSize;
+    if (visualizer->setParameter(vis_param) != NO_ERROR || vis_param->status != NO_ERROR) {
+        GTEST_SKIP() << "Visualizer does not support the spectrum capture";
+    }
+
+    *((int32_t*)vis_param->data + 1) = 0;
+    EXPECT_EQ(NO_ERROR, visualizer->getParameter(vis_param))
+            << "getSpectrumSize doesn't report success";
+    EXPECT_EQ(NO_ERROR, vis_param->status);
+    EXPECT_EQ(kSpectrumSize, *((uint32_t*)vis_param->data + 1))
+            << "spectrum size does not match set size";
+
+    // sizes must be powers of 2
+    *((int32_t*)vis_param->data + 1) = 1000;
+    visualizer->setParameter(vis_param);
+    EXPECT_NE(NO_ERROR, vis_param->status) << "invalid spectrum size accepted";
+
+    // the spectrum is silent while the visualizer is disabled
+    std::vector<uint8_t> reply(sizeof(visualizer_spectrum_t) +
+                               (kSpectrumSize / 2 + 1) * sizeof(float));
+    uint32_t replySize = reply.size();
+    ASSERT_EQ(NO_ERROR, visualizer->command(VISUALIZER_CMD_CAPTURE_SPECTRUM, 0, nullptr,
+                                            &replySize, reply.data()))
+            << "spectrum capture doesn't report success";
+    ASSERT_EQ(reply.size(), replySize);
+    const visualizer_spectrum_t* header = (const visualizer_spectrum_t*)reply.data();
+    EXPECT_EQ(kSpectrumSize / 2 + 1, header->binCount);
+    if (!visualizer->getEnabled()) {
+        EXPECT_EQ(-9600, header->peakMb);
+        EXPECT_EQ(-9600, header->rmsMb);
+    }
+
+    // the reply must match the spectrum size
+    replySize = reply.size() - sizeof(float);
+    EXPECT_NE(NO_ERROR, visualizer->command(VISUALIZER_CMD_CAPTURE_SPECTRUM, 0, nullptr,
+                                            &replySize, reply.data()));
+}
+
 TEST(AudioEffectTest, ManageSourceDefaultEffects) {
     int32_t selectedEffect = -1;
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <media/AudioSystem.h>
+
+using android::AudioSystem;
+using android::NO_ERROR;
+using android::status_t;
+
+/*
+ * Multithreaded benchmarks of the AudioSystem queries that apps make on every track creation
+ * and route change. They need a running audioserver.
+ *
+ * The getOutput* benchmarks include the AudioPolicyService call which resolves the output
+ * of the stream. The others query the output of AUDIO_STREAM_MUSIC, resolved once, so they only
+ * measure the AudioFlinger service and I/O descriptor caches of the client.
+ */
+
+static audio_io_handle_t getMusicOutput(benchmark::State& state) {
+    // Connects to the services and fills the I/O descriptor cache on first use.
+    const audio_io_handle_t output = AudioSystem::getOutput(AUDIO_STREAM_MUSIC);
+    if (output == AUDIO_IO_HANDLE_NONE) {
+        state.SkipWithError("no output for AUDIO_STREAM_MUSIC");
+    }
+    return output;
+}
+
+template <typename T, typename Query>
+static void runQuery(benchmark::State& state, Query query) {
+    T value{};
+    for (auto _ : state) {
+        const status_t status = query(&value);
+        if (status != NO_ERROR) {
+            state.SkipWithError("query failed");
+            break;
+        }
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+static void BM_getOutputLatency(benchmark::State& state) {
+    if (getMusicOutput(state) == AUDIO_IO_HANDLE_NONE) return;
+    runQuery<uint32_t>(state, [](uint32_t* latency) {
+        return AudioSystem::getOutputLatency(latency, AUDIO_STREAM_MUSIC);
+    });
+}
+
+static void BM_getOutputSamplingRate(benchmark::State& state) {
+    if (getMusicOutput(state) == AUDIO_IO_HANDLE_NONE) return;
+    runQuery<uint32_t>(state, [](uint32_t* samplingRate) {
+        return AudioSystem::getOutputSamplingRate(samplingRate, AUDIO_STREAM_MUSIC);
+    });
+}
+
+static void BM_getOutputFrameCount(benchmark::State& state) {
+    if (getMusicOutput(state) == AUDIO_IO_HANDLE_NONE) return;
+    runQuery<size_t>(state, [](size_t* frameCount) {
+        return AudioSystem::getOutputFrameCount(frameCount, AUDIO_STREAM_MUSIC);
+    });
+}
+
+static void BM_getLatency(benchmark::State& state) {
+    const audio_io_handle_t output = getMusicOutput(state);
+    if (output == AUDIO_IO_HANDLE_NONE) return;
+    runQuery<uint32_t>(state, [output](uint32_t* latency) {
+        return AudioSystem::getLatency(output, latency);
+    });
+}
+
+static void BM_getSamplingRate(benchmark::State& state) {
+    const audio_io_handle_t output = getMusicOutput(state);
+    if (output == AUDIO_IO_HANDLE_NONE) return;
+    runQuery<uint32_t>(state, [output](uint32_t* samplingRate) {
+        return AudioSystem::getSamplingRate(output, samplingRate);
+    });
+}
+
+static void BM_getFrameCount(benchmark::State& state) {
+    const audio_io_handle_t output = getMusicOutput(state);
+    if (output == AUDIO_IO_HANDLE_NONE) return;
+    runQuery<size_t>(state, [output](size_t* frameCount) {
+        return AudioSystem::getFrameCount(output, frameCount);
+    });
+}
+
+BENCHMARK(BM_getOutputLatency)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_getOutputSamplingRate)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_getOutputFrameCount)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_getLatency)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_getSamplingRate)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_getFrameCount)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define LOG_TAG "AudioTrackSharedTest"
+
+#include <gtest/gtest.h>
+#include <private/media/AudioTrackShared.h>
+
+using namespace android;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr size_t kFrameCount = 256;
+constexpr uint32_t kSampleRate = 48000;
+constexpr int32_t kServerBurst = 48;   // 1 ms at 48 kHz
+constexpr int32_t kClientBurst = 16;
+// obtainBuffer() checks for space before the timeout, so it still succeeds when the client
+// misses a wakeup from the server, but only after the timeout. The waits of these tests end
+// well before kMaxWait, unless a wakeup is lost.
+constexpr struct timespec kTimeout = {1 /* tv_sec */, 0 /* tv_nsec */};
+constexpr auto kMaxWait = std::chrono::milliseconds(500);
+
+// An AudioTrackClientProxy and an AudioTrackServerProxy sharing one control block,
+// as an AudioTrack and its Track in audioserver, with one int32_t sample per frame.
+class AudioTrackSharedTest : public ::testing::TestWithParam<bool /* adaptive */> {
+  protected:
+    void SetUp() override {
+        mClient = sp<AudioTrackClientProxy>::make(
+                &mCblk, mBuffers.data(), kFrameCount, sizeof(int32_t));
+        mServer = sp<AudioTrackServerProxy>::make(
+                &mCblk, mBuffers.data(), kFrameCount, sizeof(int32_t),
+                false /* clientInServer */, kSampleRate);
+        mClient->setAdaptiveWait(GetParam());
+        mClient->setMinimum(kClientBurst);
+    }
+
+    int32_t futex() const { return android_atomic_acquire_load(&mCblk.mFutex); }
+
+    // Obtains a client buffer, and fails if a wakeup was lost.
+    status_t obtain(Proxy::Buffer* buffer) {
+        const auto start = std::chrono::steady_clock::now();
+        const status_t status = mClient->obtainBuffer(buffer, &kTimeout);
+        EXPECT_LT(std::chrono::steady_clock::now() - start, kMaxWait) << "lost wakeup";
+        return status;
+    }
+
+    // Fills the buffer without a server, so that the next obtainBuffer() waits.
+    void fill() {
+        for (size_t written = 0; written < kFrameCount;) {
+            Proxy::Buffer buffer;
+            buffer.mFrameCount = kFrameCount - written;
+            ASSERT_EQ(NO_ERROR, mClient->obtainBuffer(&buffer));
+            written += buffer.mFrameCount;
+            mClient->releaseBuffer(&buffer);
+        }
+    }
+
+    // Reads one server burst, or less if the buffer holds less.
+    size_t drain() {
+        Proxy::Buffer buffer;
+        buffer.mFrameCount = kServerBurst;
+        if (mServer->obtainBuffer(&buffer) != NO_ERROR) return 0;
+        const size_t frameCount = buffer.mFrameCount;
+        mServer->releaseBuffer(&buffer);
+        return frameCount;
+    }
+
+    void expectFutexState() const {
+        EXPECT_EQ(0, futex() & CBLK_FUTEX_WAITER);
+        EXPECT_EQ(GetParam() ? CBLK_FUTEX_ADAPTIVE : 0, futex() & CBLK_FUTEX_ADAPTIVE);
+    }
+
+    audio_track_cblk_t mCblk;
+    std::vector<int32_t> mBuffers = std::vector<int32_t>(kFrameCount);
+    sp<AudioTrackClientProxy> mClient;
+    sp<AudioTrackServerProxy> mServer;
+};
+
+} // namespace
+
+// The client writes faster than the server reads, so it waits for nearly every server burst.
+TEST_P(AudioTrackSharedTest, NoLostWakeups) {
+    constexpr int32_t kTotalFrames = kSampleRate / 2;
+    std::atomic<bool> done = false;
+    std::atomic<bool> corrupted = false;
+    std::thread server([&] {
+        int32_t expected = 0;
+        while (expected < kTotalFrames && !done) {
+            Proxy::Buffer buffer;
+            buffer.mFrameCount = kServerBurst;
+            if (mServer->obtainBuffer(&buffer) == NO_ERROR && buffer.mFrameCount > 0) {
+                for (size_t i = 0; i < buffer.mFrameCount; ++i) {
+                    if (static_cast<int32_t*>(buffer.mRaw)[i] != expected++) corrupted = true;
+                }
+                mServer->releaseBuffer(&buffer);
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+
+    status_t status = NO_ERROR;
+    for (int32_t value = 0; value < kTotalFrames && status == NO_ERROR && !HasFailure();) {
+        Proxy::Buffer buffer;
+        buffer.mFrameCount = std::min(kTotalFrames - value, kClientBurst);
+        status = obtain(&buffer);
+        if (status == NO_ERROR) {
+            for (size_t i = 0; i < buffer.mFrameCount; ++i) {
+                static_cast<int32_t*>(buffer.mRaw)[i] = value++;
+            }
+            mClient->releaseBuffer(&buffer);
+        }
+    }
+    done = true;
+    server.join();
+
+    EXPECT_EQ(NO_ERROR, status);
+    EXPECT_FALSE(corrupted);
+    const ClientProxy::WaitStats stats = mClient->getWaitStats();
+    EXPECT_GT(stats.mSleeps + stats.mSpinHits, 0u);
+    EXPECT_LE(stats.mWakeups, stats.mSleeps);
+    EXPECT_LE(stats.mSpinHits, stats.mSpins);
+    if (GetParam()) {
+        EXPECT_GT(stats.mServerPeriodNs, 0);
+    }
+    expectFutexState();
+}
+
+// A timed out wait unregisters the waiter, and a later release still wakes the client.
+TEST_P(AudioTrackSharedTest, TimedOutWait) {
+    ASSERT_NO_FATAL_FAILURE(fill());
+
+    Proxy::Buffer buffer;
+    buffer.mFrameCount = kClientBurst;
+    const struct timespec timeout = {0 /* tv_sec */, 20000000 /* tv_nsec */};
+    struct timespec elapsed = {};
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(TIMED_OUT, mClient->obtainBuffer(&buffer, &timeout, &elapsed));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    EXPECT_EQ(0u, buffer.mFrameCount);
+    expectFutexState();
+
+    std::thread server([&] {
+        std::this_thread::sleep_for(20ms);
+        while (drain() > 0) {}
+    });
+    buffer.mFrameCount = kClientBurst;
+    EXPECT_EQ(NO_ERROR, obtain(&buffer));
+    EXPECT_EQ(static_cast<size_t>(kClientBurst), buffer.mFrameCount);
+    mClient->releaseBuffer(&buffer);
+    server.join();
+    expectFutexState();
+}
+
+// interrupt() wakes a waiting client, which keeps its wait mode.
+TEST_P(AudioTrackSharedTest, InterruptedWait) {
+    ASSERT_NO_FATAL_FAILURE(fill());
+
+    std::thread interrupter([&] {
+        std::this_thread::sleep_for(20ms);
+        mClient->interrupt();
+    });
+    Proxy::Buffer buffer;
+    buffer.mFrameCount = kClientBurst;
+    EXPECT_EQ(-EINTR, obtain(&buffer));
+    interrupter.join();
+    expectFutexState();
+
+    // The interrupt is consumed, so the next wait is woken by the server.
+    std::thread server([&] {
+        std::this_thread::sleep_for(20ms);
+        while (drain() > 0) {}
+    });
+    buffer.mFrameCount = kClientBurst;
+    EXPECT_EQ(NO_ERROR, obtain(&buffer));
+    mClient->releaseBuffer(&buffer);
+    server.join();
+    expectFutexState();
+}
+
+// The server flags a blocked client as Track::signalClientFlag() does: the deferred wake
+// must reach the client without clearing its wait mode.
+TEST_P(AudioTrackSharedTest, ServerSignal) {
+    ASSERT_NO_FATAL_FAILURE(fill());
+
+    std::thread signaler([&] {
+        std::this_thread::sleep_for(20ms);
+        android_atomic_or(CBLK_DISABLED, &mCblk.mFlags);
+        android_atomic_or(CBLK_FUTEX_WAKE, &mCblk.mFutex);
+        (void) syscall(__NR_futex, &mCblk.mFutex, FUTEX_WAKE, INT_MAX);
+    });
+    Proxy::Buffer buffer;
+    buffer.mFrameCount = kClientBurst;
+    EXPECT_EQ(NOT_ENOUGH_DATA, obtain(&buffer));
+    signaler.join();
+    expectFutexState();
+}
+
+INSTANTIATE_TEST_SUITE_P(AudioTrackShared, AudioTrackSharedTest, ::testing::Bool(),
+        [](const testing::TestParamInfo<bool>& info) {
+            return info.param ? "adaptive" : "legacy";
+        });
@@ -27,6 +27,7 @@
 #include <media/AidlConversionEffect.h>
 #include <media/AudioContainers.h>
 #include <system/audio_effects/effect_visualizer.h>
+#include <visualizer/effect_visualizer_spectrum.h>
 
 #include <utils/Log.h>
 #include <Utils.h>
@@ -73,7 +74,9 @@ const std::map<uint32_t /* effect_command_e */, EffectConversionHelperAidl::Comm
                 {EFFECT_CMD_OFFLOAD, &EffectConversionHelperAidl::handleSetOffload},
                 // Only visualizer support these commands, reuse of EFFECT_CMD_FIRST_PROPRIETARY
                 {VISUALIZER_CMD_CAPTURE, &EffectConversionHelperAidl::handleVisualizerCapture},
-                {VISUALIZER_CMD_MEASURE, &EffectConversionHelperAidl::handleVisualizerMeasure}};
+                {VISUALIZER_CMD_MEASURE, &EffectConversionHelperAidl::handleVisualizerMeasure},
+                {VISUALIZER_CMD_CAPTURE_SPECTRUM,
+                 &EffectConversionHelperAidl::handleVisualizerCaptureSpectrum}};
 
 EffectConversionHelperAidl::EffectConversionHelperAidl(
         std::shared_ptr<::aidl::android::hardware::audio::effect::IEffect> effect,
@@ -97,7 +100,20 @@ status_t EffectConversionHelperAidl::handleCommand(uint32_t cmdCode, uint32_t cm
         ALOGE("%s handler for command %u doesn't exist", __func__, cmdCode);
         return BAD_VALUE;
     }
-    return (this->*handler->second)(cmdSize, pCmdData, replySize, pReplyData);
+    const status_t status = (this->*handler->second)(cmdSize, pCmdData, replySize, pReplyData);
+    switch (cmdCode) {
+        // commands that can change the effect state
+        case EFFECT_CMD_SET_CONFIG:
+        case EFFECT_CMD_RESET:
+        case EFFECT_CMD_ENABLE:
+        case EFFECT_CMD_DISABLE:
+        case EFFECT_CMD_OFFLOAD:
+            updateState();
+            break;
+        default:
+            break;
+    }
+    return status;
 }
 
 status_t EffectConversionHelperAidl::handleInit(uint32_t cmdSize __unused,
@@ -463,6 +479,27 @@ status_t EffectConversionHelperAidl::handleVisualizerMeasure(uint32_t cmdSize __
     return visualizerMeasure(replySize, pReplyData);
 }
 
+status_t EffectConversionHelperAidl::handleVisualizerCaptureSpectrum(uint32_t cmdSize __unused,
+                                                                     const void* pCmdData __unused,
+                                                                     uint32_t* replySize,
+                                                                     void* pReplyData) {
+    if (!replySize || !pReplyData) {
+        ALOGE("%s parameter invalid, replySize %s pReplyData %p", __func__,
+              numericPointerToString(replySize).c_str(), pReplyData);
+        return BAD_VALUE;
+    }
+
+    const auto& uuid = VALUE_OR_RETURN_STATUS(
+            ::aidl::android::aidl2legacy_AudioUuid_audio_uuid_t(mDesc.common.id.type));
+    if (0 != memcmp(&uuid, SL_IID_VISUALIZATION, sizeof(effect_uuid_t))) {
+        ALOGE("%s visualizer command not supported by %s", __func__,
+              mDesc.common.id.toString().c_str());
+        return BAD_VALUE;
+    }
+
+    return visualizerCaptureSpectrum(replySize, pReplyData);
+}
+
 status_t EffectConversionHelperAidl::updateEventFlags() {
     status_t status = BAD_VALUE;
     EventFlag* efGroup = nullptr;
@@ -514,6 +551,7 @@ Descriptor EffectConversionHelperAidl::getDescriptor() const {
 }
 
 status_t EffectConversionHelperAidl::reopen() {
+    invalidateState();
     IEffect::OpenEffectReturn openReturn;
     RETURN_STATUS_IF_ERROR(statusTFromBinderStatus(mEffect->reopen(&openReturn)));
 
@@ -522,6 +560,26 @@ status_t EffectConversionHelperAidl::reopen() {
     return OK;
 }
 
+State EffectConversionHelperAidl::getState() {
+    if (const int32_t state = mCachedState.load(std::memory_order_relaxed);
+        state != kStateUnknown) {
+        return static_cast<State>(state);
+    }
+    return updateState();
+}
+
+State EffectConversionHelperAidl::updateState() {
+    State state = State::INIT;
+    if (const auto status = mEffect->getState(&state); !status.isOk()) {
+        ALOGE("%s failed to get state (%d:%s)", __func__, status.getStatus(), status.getMessage());
+        // query again on the next getState()
+        mCachedState.store(kStateUnknown, std::memory_order_relaxed);
+        return State::INIT;
+    }
+    mCachedState.store(static_cast<int32_t>(state), std::memory_order_relaxed);
+    return state;
+}
+
 size_t EffectConversionHelperAidl::getAudioChannelCount() const {
     return getChannelCount(mCommon.input.base.channelMask,
                            ~AudioChannelLayout::LAYOUT_HAPTIC_AB /* mask */);
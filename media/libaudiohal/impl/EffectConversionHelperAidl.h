@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <utils/Errors.h>
 
 #include <aidl/android/hardware/audio/effect/BpEffect.h>
@@ -49,6 +51,13 @@ class EffectConversionHelperAidl {
     ::aidl::android::hardware::audio::effect::Descriptor getDescriptor() const;
     status_t reopen();
 
+    // Returns the effect state as of the last command that can change it, so that process()
+    // does not need a binder transaction per buffer.  The state is queried from the HAL again
+    // after invalidateState(), which must be called when the effect may have changed state
+    // other than through a command: close, reopen, or an error reported on the status FMQ.
+    ::aidl::android::hardware::audio::effect::State getState();
+    void invalidateState() { mCachedState.store(kStateUnknown, std::memory_order_relaxed); }
+
     size_t getAudioChannelCount() const;
     size_t getHapticChannelCount() const;
 
@@ -112,6 +121,11 @@ class EffectConversionHelperAidl {
     };
     std::shared_ptr<android::hardware::EventFlag> mEfGroup = nullptr;
     status_t updateEventFlags();
+
+    // the effect state cached by getState(), or kStateUnknown if it must be queried
+    static constexpr int32_t kStateUnknown = -1;
+    std::atomic<int32_t> mCachedState = kStateUnknown;
+    ::aidl::android::hardware::audio::effect::State updateState();
     void updateDataMqs(
             const ::aidl::android::hardware::audio::effect::IEffect::OpenEffectReturn& ret);
     void updateMqsAndEventFlags(
@@ -143,6 +157,8 @@ class EffectConversionHelperAidl {
                                      void* pReplyData);
     status_t handleVisualizerMeasure(uint32_t cmdSize, const void* pCmdData, uint32_t* replySize,
                                      void* pReplyData);
+    status_t handleVisualizerCaptureSpectrum(uint32_t cmdSize, const void* pCmdData,
+                                             uint32_t* replySize, void* pReplyData);
 
     // implemented by conversion of each effect
     virtual status_t setParameter(utils::EffectParamReader& param) = 0;
@@ -153,6 +169,10 @@ class EffectConversionHelperAidl {
     virtual status_t visualizerMeasure(uint32_t* replySize __unused, void* pReplyData __unused) {
         return BAD_VALUE;
     }
+    virtual status_t visualizerCaptureSpectrum(uint32_t* replySize __unused,
+                                               void* pReplyData __unused) {
+        return BAD_VALUE;
+    }
 };
 
 }  // namespace effect
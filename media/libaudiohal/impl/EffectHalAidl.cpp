@@ -31,6 +31,7 @@
 #include <system/audio.h>
 #include <system/audio_effects/effect_uuid.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include "EffectHalAidl.h"
 #include "EffectProxy.h"
@@ -75,7 +76,8 @@ EffectHalAidl::EffectHalAidl(const std::shared_ptr<IFactory>& factory,
       mEffect(effect),
       mSessionId(sessionId),
       mIoId(ioId),
-      mIsProxyEffect(isProxyEffect) {
+      mIsProxyEffect(isProxyEffect),
+      mEffectName(desc.common.name) {
     assert(mFactory != nullptr);
     assert(mEffect != nullptr);
     createAidlConversion(effect, sessionId, ioId, desc);
@@ -174,11 +176,10 @@ status_t EffectHalAidl::setOutBuffer(const sp<EffectBufferHalInterface>& buffer)
 
 // write to input FMQ here, wait for statusMQ STATUS_OK, and read from output FMQ
 status_t EffectHalAidl::process() {
-    const std::string effectName = mConversion->getDescriptor().common.name;
-    State state = State::INIT;
-    if (mConversion->isBypassing() || !mEffect->getState(&state).isOk() ||
-        state != State::PROCESSING) {
-        ALOGI("%s skipping %s process because it's %s", __func__, effectName.c_str(),
+    // This is called for every buffer, so avoid binder transactions and heap allocations.
+    if (const State state = mConversion->getState();
+        mConversion->isBypassing() || state != State::PROCESSING) {
+        ALOGI("%s skipping %s process because it's %s", __func__, mEffectName.c_str(),
               mConversion->isBypassing()
                       ? "bypassing"
                       : aidl::android::hardware::audio::effect::toString(state).c_str());
@@ -198,16 +199,21 @@ status_t EffectHalAidl::process() {
         return mFactory->getInterfaceVersion(&version).isOk() ? version : 0;
     }();
 
-    if (uint32_t efState = 0; halVersion >= kReopenSupportedVersion &&
+    auto statusQ = mConversion->getStatusMQ();
+    // The event flag group is on the status FMQ event flag word; peek at the word first, so
+    // that there is no futex system call unless the HAL has actually requested an update.
+    if (uint32_t efState = 0; halVersion >= kReopenSupportedVersion && statusQ &&
+                              statusQ->isValid() &&
+                              (statusQ->getEventFlagWord()->load(std::memory_order_acquire) &
+                               kEventFlagDataMqUpdate) &&
                               ::android::OK == efGroup->wait(kEventFlagDataMqUpdate, &efState,
                                                              1 /* ns */, true /* retry */) &&
                               efState & kEventFlagDataMqUpdate) {
-        ALOGD("%s %s V%d receive dataMQUpdate eventFlag from HAL", __func__, effectName.c_str(),
+        ALOGD("%s %s V%d receive dataMQUpdate eventFlag from HAL", __func__, mEffectName.c_str(),
               halVersion);
 
         mConversion->reopen();
     }
-    auto statusQ = mConversion->getStatusMQ();
     auto inputQ = mConversion->getInputMQ();
     auto outputQ = mConversion->getOutputMQ();
     if (!statusQ || !statusQ->isValid() || !inputQ || !inputQ->isValid() || !outputQ ||
@@ -217,6 +223,7 @@ status_t EffectHalAidl::process() {
         return INVALID_OPERATION;
     }
 
+    const int64_t beginNs = systemTime();
     size_t available = inputQ->availableToWrite();
     const size_t floatsToWrite = std::min(available, mInBuffer->getSize() / sizeof(float));
     if (floatsToWrite == 0) {
@@ -237,8 +244,9 @@ status_t EffectHalAidl::process() {
 
     IEffect::Status retStatus{};
     if (!statusQ->readBlocking(&retStatus, 1)) {
-        ALOGE("%s %s V%d read status from status FMQ failed", __func__, effectName.c_str(),
+        ALOGE("%s %s V%d read status from status FMQ failed", __func__, mEffectName.c_str(),
               halVersion);
+        mConversion->invalidateState();
         return INVALID_OPERATION;
     }
     if (retStatus.status != OK || (size_t)retStatus.fmqConsumed != floatsToWrite ||
@@ -246,6 +254,10 @@ status_t EffectHalAidl::process() {
         ALOGE("%s read status failed: %s, consumed %d (of %zu) produced %d", __func__,
               retStatus.toString().c_str(), retStatus.fmqConsumed, floatsToWrite,
               retStatus.fmqProduced);
+        if (retStatus.status != OK) {
+            // the HAL may have left PROCESSING, check the state before the next buffer
+            mConversion->invalidateState();
+        }
         return INVALID_OPERATION;
     }
 
@@ -257,20 +269,6 @@ status_t EffectHalAidl::process() {
         return INVALID_OPERATION;
     }
 
-    float *outputRawBuffer = mOutBuffer->audioBuffer()->f32;
-    std::vector<float> tempBuffer;
-    // keep original data in the output buffer for accumulate mode or HapticGenerator effect
-    if (mConversion->mOutputAccessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE || mIsHapticGenerator) {
-        tempBuffer.resize(floatsToRead);
-        outputRawBuffer = tempBuffer.data();
-    }
-    // always read floating point data for AIDL
-    if (!outputQ->read(outputRawBuffer, floatsToRead)) {
-        ALOGE("%s failed to read %zu from outputQ to audioBuffer %p", __func__, floatsToRead,
-              mOutBuffer->audioBuffer());
-        return INVALID_OPERATION;
-    }
-
     // HapticGenerator needs special handling because the generated haptic samples should append to
     // the end of audio samples, the generated haptic data pass back from HAL in output FMQ at same
     // offset as input buffer, here we skip the audio samples in output FMQ and append haptic
@@ -278,6 +276,16 @@ status_t EffectHalAidl::process() {
     if (mIsHapticGenerator) {
         static constexpr float kHalFloatSampleLimit = 2.0f;
         assert(floatsToRead == floatsToWrite);
+        // keep original data in the output buffer, reusing the scratch buffer between calls
+        if (mOutputScratch.size() < floatsToRead) {
+            mOutputScratch.resize(floatsToRead);
+        }
+        float* const outputRawBuffer = mOutputScratch.data();
+        if (!outputQ->read(outputRawBuffer, floatsToRead)) {
+            ALOGE("%s failed to read %zu from outputQ to audioBuffer %p", __func__, floatsToRead,
+                  mOutBuffer->audioBuffer());
+            return INVALID_OPERATION;
+        }
         const auto audioChNum = mConversion->getAudioChannelCount();
         const auto audioSamples =
                 floatsToWrite * audioChNum / (audioChNum + mConversion->getHapticChannelCount());
@@ -295,9 +303,34 @@ status_t EffectHalAidl::process() {
                                                  outputRawBuffer + audioSamples,
                                                  floatsToRead - audioSamples, kHalFloatSampleLimit);
     } else if (mConversion->mOutputAccessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE) {
-        accumulate_float(mOutBuffer->audioBuffer()->f32, outputRawBuffer, floatsToRead);
+        // accumulate directly from the FMQ shared memory, which may wrap around in two regions
+        EffectConversionHelperAidl::DataMQ::MemTransaction tx;
+        if (!outputQ->beginRead(floatsToRead, &tx)) {
+            ALOGE("%s failed to begin reading %zu from outputQ", __func__, floatsToRead);
+            return INVALID_OPERATION;
+        }
+        float* outputBuffer = mOutBuffer->audioBuffer()->f32;
+        for (const auto& region : {tx.getFirstRegion(), tx.getSecondRegion()}) {
+            if (region.getLength() == 0) continue;
+            accumulate_float(outputBuffer, region.getAddress(), region.getLength());
+            outputBuffer += region.getLength();
+        }
+        outputQ->commitRead(floatsToRead);
+    } else {
+        // always read floating point data for AIDL
+        if (!outputQ->read(mOutBuffer->audioBuffer()->f32, floatsToRead)) {
+            ALOGE("%s failed to read %zu from outputQ to audioBuffer %p", __func__, floatsToRead,
+                  mOutBuffer->audioBuffer());
+            return INVALID_OPERATION;
+        }
     }
 
+    const int64_t latencyNs = systemTime() - beginNs;
+    mProcessCount.fetch_add(1, std::memory_order_relaxed);
+    mProcessTotalNs.fetch_add(latencyNs, std::memory_order_relaxed);
+    if (latencyNs > mProcessMaxNs.load(std::memory_order_relaxed)) {
+        mProcessMaxNs.store(latencyNs, std::memory_order_relaxed);  // single writer
+    }
     return OK;
 }
 
@@ -335,11 +368,21 @@ status_t EffectHalAidl::getDescriptor(effect_descriptor_t* pDescriptor) {
 status_t EffectHalAidl::close() {
     TIME_CHECK();
     mEffect->command(CommandId::STOP);
-    return statusTFromBinderStatus(mEffect->close());
+    const status_t status = statusTFromBinderStatus(mEffect->close());
+    if (mConversion) {
+        mConversion->invalidateState();
+    }
+    return status;
 }
 
 status_t EffectHalAidl::dump(int fd) {
     TIME_CHECK();
+    if (const int64_t count = mProcessCount.load(std::memory_order_relaxed); count > 0) {
+        dprintf(fd, "%s process() count %lld, latency mean %.3f ms, max %.3f ms\n",
+                mEffectName.c_str(), (long long)count,
+                mProcessTotalNs.load(std::memory_order_relaxed) * 1e-6 / count,
+                mProcessMaxNs.load(std::memory_order_relaxed) * 1e-6);
+    }
     return mEffect->dump(fd, nullptr, 0);
 }
 
@@ -16,7 +16,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <aidl/android/hardware/audio/effect/IEffect.h>
 #include <aidl/android/hardware/audio/effect/IFactory.h>
@@ -73,11 +76,20 @@ class EffectHalAidl : public EffectHalInterface {
     const int32_t mSessionId;
     const int32_t mIoId;
     const bool mIsProxyEffect;
+    const std::string mEffectName;  // for logging, without a binder call for proxy effects
     bool mIsHapticGenerator = false;
 
     std::unique_ptr<EffectConversionHelperAidl> mConversion;
 
     sp<EffectBufferHalInterface> mInBuffer, mOutBuffer;
+    // holds the HapticGenerator output, to avoid an allocation per process()
+    std::vector<float> mOutputScratch;
+
+    // process() latency from writing the input FMQ until the output has been read,
+    // written by process() only and read by dump()
+    std::atomic<int64_t> mProcessCount = 0;
+    std::atomic<int64_t> mProcessTotalNs = 0;
+    std::atomic<int64_t> mProcessMaxNs = 0;
 
     status_t createAidlConversion(
             std::shared_ptr<::aidl::android::hardware::audio::effect::IEffect> effect,
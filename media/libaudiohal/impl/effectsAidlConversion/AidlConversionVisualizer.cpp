@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <cstring>
 #include <optional>
+#include <vector>
 #define LOG_TAG "AidlConversionVisualizer"
 //#define LOG_NDEBUG 0
 
@@ -25,6 +26,7 @@
 #include <media/AidlConversionNdk.h>
 #include <media/AidlConversionEffect.h>
 #include <system/audio_effects/effect_visualizer.h>
+#include <visualizer/effect_visualizer_spectrum.h>
 
 #include <utils/Log.h>
 
@@ -132,12 +134,27 @@ status_t AidlConversionVisualizer::getParameter(EffectParamWriter& param) {
                     aidl::android::aidl2legacy_Parameter_Visualizer_MeasurementMode_uint32(mode));
             return param.writeToValue(&value);
         }
+        case VISUALIZER_PARAM_SPECTRUM_SIZE: {
+            return getVendorParameter(param);
+        }
         default: {
             VENDOR_EXTENSION_GET_AND_RETURN(Visualizer, visualizer, param);
         }
     }
 }
 
+status_t AidlConversionVisualizer::getVendorParameter(EffectParamWriter& param) {
+    VendorExtension ext = VALUE_OR_RETURN_STATUS(
+            aidl::android::legacy2aidl_EffectParameterReader_VendorExtension(param));
+    Parameter::Id id = MAKE_EXTENSION_PARAMETER_ID(Visualizer, visualizerTag, ext);
+    Parameter aidlParam;
+    RETURN_STATUS_IF_ERROR(statusTFromBinderStatus(mEffect->getParameter(id, &aidlParam)));
+    ext = VALUE_OR_RETURN_STATUS(GET_PARAMETER_SPECIFIC_FIELD(aidlParam, Visualizer, visualizer,
+                                                              Visualizer::vendor, VendorExtension));
+    return VALUE_OR_RETURN_STATUS(
+            aidl::android::aidl2legacy_VendorExtension_EffectParameterWriter(param, ext));
+}
+
 status_t AidlConversionVisualizer::visualizerCapture(uint32_t* replySize, void* pReplyData) {
     if (!replySize || !pReplyData || *replySize != mCaptureSize) {
         ALOGE("%s illegal param replySize %p pReplyData %p", __func__, replySize, pReplyData);
@@ -174,5 +191,28 @@ status_t AidlConversionVisualizer::visualizerMeasure(uint32_t* replySize, void*
     return OK;
 }
 
+status_t AidlConversionVisualizer::visualizerCaptureSpectrum(uint32_t* replySize,
+                                                             void* pReplyData) {
+    if (!replySize || !pReplyData) {
+        ALOGE("%s illegal param replySize %p pReplyData %p", __func__, replySize, pReplyData);
+        return BAD_VALUE;
+    }
+
+    // the spectrum is the value of the VISUALIZER_PARAM_SPECTRUM vendor parameter
+    std::vector<uint8_t> buf(sizeof(effect_param_t) + sizeof(uint32_t) + *replySize);
+    effect_param_t* p = (effect_param_t*)buf.data();
+    p->psize = sizeof(uint32_t);
+    p->vsize = *replySize;
+    *(uint32_t*)p->data = VISUALIZER_PARAM_SPECTRUM;
+    EffectParamWriter param(*p);
+    RETURN_STATUS_IF_ERROR(getVendorParameter(param));
+    if (p->status != OK || p->psize != sizeof(uint32_t) || p->vsize != *replySize) {
+        ALOGE("%s invalid reply %s", __func__, param.toString().c_str());
+        return BAD_VALUE;
+    }
+    std::memcpy(pReplyData, p->data + sizeof(uint32_t), *replySize);
+    return OK;
+}
+
 } // namespace effect
 } // namespace android
@@ -37,6 +37,9 @@ class AidlConversionVisualizer : public EffectConversionHelperAidl {
     status_t getParameter(utils::EffectParamWriter& param) override;
     status_t visualizerCapture(uint32_t* replySize, void* pReplyData) override;
     status_t visualizerMeasure(uint32_t* replySize, void* pReplyData) override;
+    status_t visualizerCaptureSpectrum(uint32_t* replySize, void* pReplyData) override;
+    // gets a parameter carried in a vendor extension, as the spectrum capture ones
+    status_t getVendorParameter(utils::EffectParamWriter& param);
 };
 
 }  // namespace effect
@@ -25,6 +25,7 @@
 #include <math.h>
 #include <sys/types.h>
 
+#include <cutils/properties.h>
 #include <utils/Errors.h>
 #include <utils/Log.h>
 
@@ -145,6 +146,9 @@ void AudioMixer::Track::unprepareForDownmix() {
         // before deallocating the mDownmixerBufferProvider.
         mPostDownmixReformatBufferProvider->reset();
     }
+    if (mFusedBufferProvider.get() != nullptr) {
+        mFusedBufferProvider->reset();
+    }
 
     mDownmixRequiresFormat = AUDIO_FORMAT_INVALID;
     if (mDownmixerBufferProvider.get() != nullptr) {
@@ -346,17 +350,34 @@ void AudioMixer::Track::reconfigureBufferProviders()
         mAdjustChannelsBufferProvider->setBufferProvider(bufferProvider);
         bufferProvider = mAdjustChannelsBufferProvider.get();
     }
-    if (mReformatBufferProvider.get() != nullptr) {
-        mReformatBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mReformatBufferProvider.get();
-    }
-    if (mDownmixerBufferProvider.get() != nullptr) {
-        mDownmixerBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mDownmixerBufferProvider.get();
+    // The reformat and downmix providers are all CopyBufferProviders.
+    // Providers may have been replaced at the same address, so always rebuild.
+    std::vector<CopyBufferProvider *> stages;
+    for (PassthruBufferProvider *provider : {mReformatBufferProvider.get(),
+            mDownmixerBufferProvider.get(), mPostDownmixReformatBufferProvider.get()}) {
+        if (provider != nullptr) {
+            stages.push_back(static_cast<CopyBufferProvider*>(provider));
+        }
     }
-    if (mPostDownmixReformatBufferProvider.get() != nullptr) {
-        mPostDownmixReformatBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mPostDownmixReformatBufferProvider.get();
+    if (mFuseBufferProviders && stages.size() > 1) {
+        // Keep the fused provider buffers if the track format is unchanged.
+        if (mFusedBufferProvider.get() != nullptr) {
+            mFusedBufferProvider->reset();
+            if (!mFusedBufferProvider->setStages(stages)) {
+                mFusedBufferProvider.reset(nullptr);
+            }
+        }
+        if (mFusedBufferProvider.get() == nullptr) {
+            mFusedBufferProvider.reset(new FusedBufferProvider(stages, kCopyBufferFrameCount));
+        }
+        mFusedBufferProvider->setBufferProvider(bufferProvider);
+        bufferProvider = mFusedBufferProvider.get();
+    } else {
+        mFusedBufferProvider.reset(nullptr);
+        for (const auto stage : stages) {
+            stage->setBufferProvider(bufferProvider);
+            bufferProvider = stage;
+        }
     }
     if (mTimestretchBufferProvider.get() != nullptr) {
         mTimestretchBufferProvider->setBufferProvider(bufferProvider);
@@ -539,6 +560,8 @@ void AudioMixer::setBufferProvider(int name, AudioBufferProvider* bufferProvider
     // reset order from downstream to upstream buffer providers.
     if (track->mTimestretchBufferProvider.get() != nullptr) {
         track->mTimestretchBufferProvider->reset();
+    } else if (track->mFusedBufferProvider.get() != nullptr) {
+        track->mFusedBufferProvider->reset();
     } else if (track->mPostDownmixReformatBufferProvider.get() != nullptr) {
         track->mPostDownmixReformatBufferProvider->reset();
     } else if (track->mDownmixerBufferProvider != nullptr) {
@@ -555,11 +578,27 @@ void AudioMixer::setBufferProvider(int name, AudioBufferProvider* bufferProvider
     track->reconfigureBufferProviders();
 }
 
+void AudioMixer::setBufferProviderFusion(bool enabled)
+{
+    if (mBufferProviderFusion == enabled) {
+        return;
+    }
+    mBufferProviderFusion = enabled;
+    for (const auto &pair : mTracks) {
+        Track *t = static_cast<Track*>(pair.second.get());
+        t->mFuseBufferProviders = enabled;
+        t->reconfigureBufferProviders();
+    }
+}
+
 /*static*/ pthread_once_t AudioMixer::sOnceControl = PTHREAD_ONCE_INIT;
 
+/*static*/ bool AudioMixer::sBufferProviderFusionDefault = true;
+
 /*static*/ void AudioMixer::sInitRoutine()
 {
     DownmixerBufferProvider::init(); // for the downmixer
+    sBufferProviderFusionDefault = property_get_bool("af.mixer.fuse_providers", true);
 }
 
 std::shared_ptr<AudioMixerBase::TrackBase> AudioMixer::preCreateTrack()
@@ -581,6 +620,7 @@ status_t AudioMixer::postCreateTrack(TrackBase *track)
             "Non-stereo channel mask: %d\n", channelMask);
     t->channelMask = channelMask;
     t->mInputBufferProvider = NULL;
+    t->mFuseBufferProviders = mBufferProviderFusion;
     t->mDownmixRequiresFormat = AUDIO_FORMAT_INVALID; // no format required
     t->mPlaybackRate = AUDIO_PLAYBACK_RATE_DEFAULT;
     // haptic
@@ -25,9 +25,11 @@
 #include <audio_utils/primitives.h>
 #include <cutils/compiler.h>
 #include <media/AudioMixerBase.h>
+#include <media/AudioMixerWorkerPool.h>
 #include <utils/Log.h>
 
 #include "AudioMixerOps.h"
+#include "AudioMixerOpsVector.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
 #ifndef FCC_2
@@ -78,6 +80,19 @@ bool AudioMixerBase::isValidChannelMask(audio_channel_mask_t channelMask) const
     return audio_channel_count_from_out_mask(channelMask) <= MAX_NUM_CHANNELS;
 }
 
+AudioMixerBase::AudioMixerBase(size_t frameCount, uint32_t sampleRate)
+    : mSampleRate(sampleRate)
+    , mFrameCount(frameCount)
+{
+    // select the volume mix kernels here rather than on first use by the audio thread.
+    [[maybe_unused]] const MixerOpsIsa isa = getMixerOpsIsa();
+    ALOGV("%s: using %s mixer ops", __func__, toString(isa));
+}
+
+AudioMixerBase::~AudioMixerBase()
+{
+}
+
 std::shared_ptr<AudioMixerBase::TrackBase> AudioMixerBase::preCreateTrack()
 {
     return std::make_shared<TrackBase>();
@@ -619,6 +634,42 @@ size_t AudioMixerBase::getUnreleasedFrames(int name) const
     return 0;
 }
 
+void AudioMixerBase::setParallelMixing(
+        size_t workerCount, size_t trackThreshold, const std::vector<int>& cpus)
+{
+    workerCount = std::min(workerCount, kMaxParallelWorkers);
+    // a threshold of 1 would only add dispatch overhead to single track groups.
+    mParallelTrackThreshold = std::max(trackThreshold, (size_t)2);
+
+    mWorkerPool.reset();
+    mPartitions.clear();
+    if (workerCount > 0) {
+        const auto allocate = [this]() {
+            void *buffer = nullptr;
+            // cache line alignment so that partitions never share a line.
+            (void)posix_memalign(&buffer, 64, MAX_NUM_CHANNELS * mFrameCount * sizeof(int32_t));
+            LOG_ALWAYS_FATAL_IF(buffer == nullptr, "%s: cannot allocate buffer", __func__);
+            return aligned_buffer_t(static_cast<int32_t *>(buffer));
+        };
+        mPartitions.resize(workerCount + 1);
+        for (size_t i = 1; i < mPartitions.size(); ++i) {
+            MixPartition &partition = mPartitions[i];
+            partition.outTempBuffer = allocate();
+            partition.resampleTempBuffer = allocate();
+            partition.outTemp = partition.outTempBuffer.get();
+            partition.resampleTemp = partition.resampleTempBuffer.get();
+        }
+        mWorkerPool = std::make_unique<AudioMixerWorkerPool>(workerCount, cpus);
+    }
+    ALOGV("%s: workerCount=%zu trackThreshold=%zu", __func__, workerCount, mParallelTrackThreshold);
+    invalidate();
+}
+
+size_t AudioMixerBase::getParallelWorkerCount() const
+{
+    return mWorkerPool != nullptr ? mWorkerPool->getWorkerCount() : 0;
+}
+
 std::string AudioMixerBase::trackNames() const
 {
     std::stringstream ss;
@@ -663,6 +714,7 @@ void AudioMixerBase::process__validate()
             n |= NEEDS_MUTE;
         }
         t->needs = n;
+        t->mFusedMix = false;
 
         if (n & NEEDS_MUTE) {
             t->hook = &TrackBase::track__nop;
@@ -692,11 +744,12 @@ void AudioMixerBase::process__validate()
                 ALOGV_IF((n & NEEDS_CHANNEL_COUNT__MASK) > NEEDS_CHANNEL_2,
                         "Track %d needs downmix + resample", name);
             } else {
+                bool monoExpand = false;
                 if ((n & NEEDS_CHANNEL_COUNT__MASK) == NEEDS_CHANNEL_1){
+                    monoExpand = isAudioChannelPositionMask(t->mMixerChannelMask) // TODO: MONO_HACK
+                            && t->channelMask == AUDIO_CHANNEL_OUT_MONO;
                     t->hook = TrackBase::getTrackHook(
-                            (isAudioChannelPositionMask(t->mMixerChannelMask)  // TODO: MONO_HACK
-                                    && t->channelMask == AUDIO_CHANNEL_OUT_MONO)
-                                ? TRACKTYPE_NORESAMPLEMONO : TRACKTYPE_NORESAMPLE,
+                            monoExpand ? TRACKTYPE_NORESAMPLEMONO : TRACKTYPE_NORESAMPLE,
                             t->mMixerChannelCount,
                             t->mMixerInFormat, t->mMixerFormat);
                     all16BitsStereoNoResample = false;
@@ -710,9 +763,17 @@ void AudioMixerBase::process__validate()
                     ALOGV_IF((n & NEEDS_CHANNEL_COUNT__MASK) > NEEDS_CHANNEL_2,
                             "Track %d needs downmix", name);
                 }
+                // float tracks without aux send are mixed by a plain multiply-accumulate.
+                if (!monoExpand && !(n & NEEDS_AUX)
+                        && t->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                    t->mFusedMix = true;
+                    t->mFusedVolume.resize(BLOCKSIZE * t->mMixerChannelCount);
+                }
             }
         }
     }
+    mFusedInputs.resize(mEnabled.size());
+    mFusedVolumes.resize(mEnabled.size());
 
     // select the processing hooks
     mHook = &AudioMixerBase::process__nop;
@@ -746,9 +807,27 @@ void AudioMixerBase::process__validate()
         }
     }
 
+    // parallel mixing replaces the generic hooks only.
+    if (mWorkerPool != nullptr && mEnabled.size() >= mParallelTrackThreshold
+            && (mHook == &AudioMixerBase::process__genericResampling
+                    || mHook == &AudioMixerBase::process__genericNoResampling)) {
+        if (mOutputTemp.get() == nullptr) {
+            mOutputTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+        }
+        if (mResampleTemp.get() == nullptr) {
+            mResampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+        }
+        // reserve now so that partitioning does not allocate in process__parallel().
+        for (auto &partition : mPartitions) {
+            partition.tracks.reserve(mEnabled.size());
+        }
+        mHook = &AudioMixerBase::process__parallel;
+    }
+
     ALOGV("mixer configuration change: %zu "
-        "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d",
-        mEnabled.size(), all16BitsStereoNoResample, resampling, volumeRamp);
+        "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d, parallel=%d",
+        mEnabled.size(), all16BitsStereoNoResample, resampling, volumeRamp,
+        mHook == &AudioMixerBase::process__parallel);
 
     process();
 
@@ -762,6 +841,7 @@ void AudioMixerBase::process__validate()
             if (!t->doesResample() && t->isVolumeMuted()) {
                 t->needs |= NEEDS_MUTE;
                 t->hook = &TrackBase::track__nop;
+                t->mFusedMix = false;
             } else {
                 allMuted = false;
             }
@@ -1121,13 +1201,43 @@ void AudioMixerBase::process__genericNoResampling()
             t->mIn = t->buffer.raw;
         }
 
+        const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
+        const uint32_t channelCount = t1->mMixerChannelCount;
+        for (const int name : group) {
+            const std::shared_ptr<TrackBase> &t = mTracks[name];
+            if (t->mFusedMix) {
+                t->updateFusedVolume(BLOCKSIZE);
+            }
+        }
+
         int32_t *out = (int *)pair.first;
         size_t numFrames = 0;
         do {
             const size_t frameCount = std::min((size_t)BLOCKSIZE, mFrameCount - numFrames);
             memset(outTemp, 0, sizeof(outTemp));
+            // Consecutive tracks with a full block of input at constant volume are
+            // accumulated together, keeping the output block in registers.
+            size_t fusedCount = 0;
+            const auto mixFused = [&]() {
+                mixMultiTrack(reinterpret_cast<float *>(outTemp), frameCount * channelCount,
+                        mFusedInputs.data(), mFusedVolumes.data(), fusedCount);
+                fusedCount = 0;
+            };
             for (const int name : group) {
                 const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if (t->mFusedMix && t->mIn != nullptr && t->frameCount >= frameCount
+                        && !t->needsRamp()) {
+                    const float *in = static_cast<const float *>(t->mIn);
+                    mFusedInputs[fusedCount] = in;
+                    mFusedVolumes[fusedCount] = t->mFusedVolume.data();
+                    ++fusedCount;
+                    t->mIn = in + frameCount * channelCount;
+                    t->frameCount -= frameCount;
+                    continue;
+                }
+                if (fusedCount > 0) {
+                    mixFused();
+                }
                 int32_t *aux = NULL;
                 if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                     aux = t->auxBuffer + numFrames;
@@ -1162,13 +1272,15 @@ void AudioMixerBase::process__genericNoResampling()
                     }
                 }
             }
+            if (fusedCount > 0) {
+                mixFused();
+            }
 
-            const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
             convertMixerFormat(out, t1->mMixerFormat, outTemp, t1->mMixerInFormat,
-                    frameCount * t1->mMixerChannelCount);
+                    frameCount * channelCount);
             // TODO: fix ugly casting due to choice of out pointer type
             out = reinterpret_cast<int32_t*>((uint8_t*)out
-                    + frameCount * t1->mMixerChannelCount
+                    + frameCount * channelCount
                     * audio_bytes_per_sample(t1->mMixerFormat));
             numFrames += frameCount;
         } while (numFrames < mFrameCount);
@@ -1195,41 +1307,127 @@ void AudioMixerBase::process__genericResampling()
         // clear temp buffer
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
-            const std::shared_ptr<TrackBase> &t = mTracks[name];
-            int32_t *aux = NULL;
-            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
-                aux = t->auxBuffer;
-            }
+            mixTrack(mTracks[name].get(), outTemp, mResampleTemp.get() /* naked ptr */);
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+    }
+}
 
-            // this is a little goofy, on the resampling case we don't
-            // acquire/release the buffers because it's done by
-            // the resampler.
-            if (t->needs & NEEDS_RESAMPLE) {
-                (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
-            } else {
+void AudioMixerBase::mixTrack(TrackBase *t, int32_t *outTemp, int32_t *resampleTemp)
+{
+    const size_t numFrames = mFrameCount;
+    int32_t *aux = NULL;
+    if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+        aux = t->auxBuffer;
+    }
 
-                size_t outFrames = 0;
+    // this is a little goofy, on the resampling case we don't
+    // acquire/release the buffers because it's done by
+    // the resampler.
+    if (t->needs & NEEDS_RESAMPLE) {
+        (t->*t->hook)(outTemp, numFrames, resampleTemp, aux);
+    } else {
 
-                while (outFrames < numFrames) {
-                    t->buffer.frameCount = numFrames - outFrames;
-                    t->bufferProvider->getNextBuffer(&t->buffer);
-                    t->mIn = t->buffer.raw;
-                    // t->mIn == nullptr can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t->mIn == nullptr) break;
+        size_t outFrames = 0;
+
+        while (outFrames < numFrames) {
+            t->buffer.frameCount = numFrames - outFrames;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->mIn = t->buffer.raw;
+            // t->mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t->mIn == nullptr) break;
 
-                    (t.get()->*t->hook)(
-                            outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
-                            mResampleTemp.get() /* naked ptr */,
-                            aux != nullptr ? aux + outFrames : nullptr);
-                    outFrames += t->buffer.frameCount;
+            (t->*t->hook)(
+                    outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                    resampleTemp, aux != nullptr ? aux + outFrames : nullptr);
+            outFrames += t->buffer.frameCount;
 
-                    t->bufferProvider->releaseBuffer(&t->buffer);
+            t->bufferProvider->releaseBuffer(&t->buffer);
+        }
+    }
+}
+
+// generic code mixing partitions of each group concurrently on mWorkerPool
+void AudioMixerBase::process__parallel()
+{
+    ALOGVV("process__parallel\n");
+    int32_t * const outTemp = mOutputTemp.get(); // naked ptr
+    mPartitions[0].outTemp = outTemp;
+    mPartitions[0].resampleTemp = mResampleTemp.get();
+
+    for (const auto &pair : mGroups) {
+        const auto &group = pair.second;
+        const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
+        const size_t sampleCount = mFrameCount * t1->mMixerChannelCount;
+
+        if (group.size() < mParallelTrackThreshold) {
+            memset(outTemp, 0, sizeof(*outTemp) * sampleCount);
+            for (const int name : group) {
+                mixTrack(mTracks[name].get(), outTemp, mResampleTemp.get());
+            }
+            convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                    outTemp, t1->mMixerInFormat, sampleCount);
+            continue;
+        }
+
+        // Assign each track to the least loaded partition.
+        // Tracks with an aux send stay on the calling thread, as aux buffers
+        // are accumulated in place and may be shared by several tracks.
+        for (auto &partition : mPartitions) {
+            partition.tracks.clear();
+            partition.cost = 0;
+        }
+        for (const int name : group) {
+            TrackBase * const t = mTracks[name].get();
+            MixPartition *target = &mPartitions[0];
+            if ((t->needs & NEEDS_AUX) == 0) {
+                for (auto &partition : mPartitions) {
+                    if (partition.cost < target->cost) {
+                        target = &partition;
+                    }
+                }
+            }
+            target->tracks.push_back(t);
+            target->cost += (t->needs & NEEDS_MUTE) ? 1 : (t->needs & NEEDS_RESAMPLE) ? 4 : 2;
+        }
+
+        mPartitionSampleCount = sampleCount;
+        mWorkerPool->run(&AudioMixerBase::mixPartition, this);
+
+        // reduce partial sums into partition 0.
+        for (size_t i = 1; i < mPartitions.size(); ++i) {
+            const MixPartition &partition = mPartitions[i];
+            if (partition.tracks.empty()) continue;
+            if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                float * const dst = reinterpret_cast<float *>(outTemp);
+                const float * const src = reinterpret_cast<const float *>(partition.outTemp);
+                for (size_t j = 0; j < sampleCount; ++j) {
+                    dst[j] += src[j];
+                }
+            } else {
+                for (size_t j = 0; j < sampleCount; ++j) {
+                    outTemp[j] += partition.outTemp[j];
                 }
             }
         }
         convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
-                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+                outTemp, t1->mMixerInFormat, sampleCount);
+    }
+}
+
+/* static */
+void AudioMixerBase::mixPartition(void *cookie, size_t index)
+{
+    AudioMixerBase * const mixer = static_cast<AudioMixerBase *>(cookie);
+    MixPartition &partition = mixer->mPartitions[index];
+    // partition 0 is the reduction target, so it is cleared even if empty.
+    if (index != 0 && partition.tracks.empty()) return;
+
+    memset(partition.outTemp, 0, sizeof(*partition.outTemp) * mixer->mPartitionSampleCount);
+    for (TrackBase * const t : partition.tracks) {
+        mixer->mixTrack(t, partition.outTemp, partition.resampleTemp);
     }
 }
 
@@ -1341,6 +1539,21 @@ constexpr int MIXTYPE_MONOVOL(int mixtype, int channels) {
     }
 }
 
+// Uses the vector kernel for the CPU if it supports the combination,
+// otherwise the scalar template.  Mono and stereo ramps are left to the
+// scalar template, which the compiler already handles well for so few channels.
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+static void volumeRampMultiDispatch(TO* out, size_t frameCount,
+        const TI* in, TA* aux, TV *vol, const TV *volinc, TAV *vola, TAV volainc)
+{
+    if (NCHAN <= FCC_2 || !volumeRampMultiVector<MIXTYPE, NCHAN>(getMixerOpsIsa(),
+            out, frameCount, in, aux, vol, volinc, vola, volainc)) {
+        volumeRampMulti<MIXTYPE, NCHAN, TO, TI, TV, TA, TAV>(
+                out, frameCount, in, aux, vol, volinc, vola, volainc);
+    }
+}
+
 // Helper to make a functional array from volumeRampMulti.
 template <int MIXTYPE, typename TO, typename TI, typename TV, typename TA, typename TAV,
           std::size_t ... Is>
@@ -1348,7 +1561,8 @@ static constexpr auto makeVRMArray(std::index_sequence<Is...>)
 {
     using F = void(*)(TO*, size_t, const TI*, TA*, TV*, const TV*, TAV*, TAV);
     return std::array<F, sizeof...(Is)>{
-            { &volumeRampMulti<MIXTYPE_MONOVOL(MIXTYPE, Is + 1), Is + 1, TO, TI, TV, TA, TAV> ...}
+            { &volumeRampMultiDispatch<MIXTYPE_MONOVOL(MIXTYPE, Is + 1), Is + 1,
+                    TO, TI, TV, TA, TAV> ...}
         };
 }
 
@@ -1371,6 +1585,19 @@ static void volumeRampMulti(uint32_t channels, TO* out, size_t frameCount,
     }
 }
 
+// Uses the vector kernel for the CPU if it supports the combination,
+// otherwise the scalar template.
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+static void volumeMultiDispatch(TO* out, size_t frameCount,
+        const TI* in, TA* aux, const TV *vol, TAV vola)
+{
+    if (!volumeMultiVector<MIXTYPE, NCHAN>(getMixerOpsIsa(),
+            out, frameCount, in, aux, vol, vola)) {
+        volumeMulti<MIXTYPE, NCHAN, TO, TI, TV, TA, TAV>(out, frameCount, in, aux, vol, vola);
+    }
+}
+
 // Helper to make a functional array from volumeMulti.
 template <int MIXTYPE, typename TO, typename TI, typename TV, typename TA, typename TAV,
           std::size_t ... Is>
@@ -1378,7 +1605,8 @@ static constexpr auto makeVMArray(std::index_sequence<Is...>)
 {
     using F = void(*)(TO*, size_t, const TI*, TA*, const TV*, TAV);
     return std::array<F, sizeof...(Is)>{
-            { &volumeMulti<MIXTYPE_MONOVOL(MIXTYPE, Is + 1), Is + 1, TO, TI, TV, TA, TAV> ... }
+            { &volumeMultiDispatch<MIXTYPE_MONOVOL(MIXTYPE, Is + 1), Is + 1,
+                    TO, TI, TV, TA, TAV> ... }
         };
 }
 
@@ -1563,6 +1791,26 @@ void AudioMixerBase::TrackBase::track__NoResample(
     mIn = in;
 }
 
+void AudioMixerBase::TrackBase::updateFusedVolume(size_t blockFrames)
+{
+    // Mix a frame of unity samples to get exactly the volume track__NoResample()
+    // applies to each channel.
+    const size_t channels = mMixerChannelCount;
+    float unity[MAX_NUM_CHANNELS];
+    std::fill_n(unity, channels, 1.f);
+    float *volume = mFusedVolume.data();
+    if (useStereoVolume()) {
+        volumeMulti<MIXTYPE_MULTI_SAVEONLY_STEREOVOL>(channels, volume, 1 /* frameCount */,
+                unity, (float *)nullptr /* aux */, mVolume, mAuxLevel);
+    } else {
+        volumeMulti<MIXTYPE_MULTI_SAVEONLY>(channels, volume, 1 /* frameCount */,
+                unity, (float *)nullptr /* aux */, mVolume, mAuxLevel);
+    }
+    for (size_t i = 1; i < blockFrames; ++i) {
+        std::copy_n(volume, channels, volume + i * channels);
+    }
+}
+
 /* The Mixer engine generates either int32_t (Q4_27) or float data.
  * We use this function to convert the engine buffers
  * to the desired mixer output format, either int16_t (Q.15) or float.
@@ -17,6 +17,8 @@
 #ifndef ANDROID_AUDIO_MIXER_OPS_H
 #define ANDROID_AUDIO_MIXER_OPS_H
 
+#include <algorithm>
+
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
@@ -604,6 +606,46 @@ inline void volumeMulti(TO* out, size_t frameCount,
     }
 }
 
+/*
+ * mixMultiTrack() accumulates several float tracks into out in a single pass:
+ *
+ *   out[i] += in[0][i] * vol[0][i] + in[1][i] * vol[1][i] + ...
+ *
+ * in[] and vol[] hold trackCount arrays of sampleCount samples, vol[] having the
+ * per-sample volume (the channel volumes repeated for each frame).
+ * The output is accumulated in registers across all tracks, in track order,
+ * with a separate multiply and add per track, so the result is identical to
+ * mixing the tracks one after another with volumeMulti().
+ */
+inline void mixMultiTrack(float *out, size_t sampleCount,
+        const float * const *in, const float * const *vol, size_t trackCount)
+{
+    constexpr size_t kLanes = 8; // one 256 bit or two 128 bit vector registers.
+    for (size_t i = 0; i < sampleCount; i += kLanes) {
+        const size_t lanes = std::min(kLanes, sampleCount - i);
+        float acc[kLanes];
+        if (lanes == kLanes) {
+            for (size_t j = 0; j < kLanes; ++j) acc[j] = out[i + j];
+            for (size_t t = 0; t < trackCount; ++t) {
+                for (size_t j = 0; j < kLanes; ++j) {
+                    const float product = in[t][i + j] * vol[t][i + j]; // no contraction
+                    acc[j] += product;
+                }
+            }
+            for (size_t j = 0; j < kLanes; ++j) out[i + j] = acc[j];
+        } else {
+            for (size_t j = 0; j < lanes; ++j) acc[j] = out[i + j];
+            for (size_t t = 0; t < trackCount; ++t) {
+                for (size_t j = 0; j < lanes; ++j) {
+                    const float product = in[t][i + j] * vol[t][i + j];
+                    acc[j] += product;
+                }
+            }
+            for (size_t j = 0; j < lanes; ++j) out[i + j] = acc[j];
+        }
+    }
+}
+
 };
 
 #endif /* ANDROID_AUDIO_MIXER_OPS_H */
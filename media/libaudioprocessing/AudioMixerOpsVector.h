@@ -0,0 +1,510 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_OPS_VECTOR_H
+#define ANDROID_AUDIO_MIXER_OPS_VECTOR_H
+
+#include <algorithm>
+#include <array>
+#include <stdint.h>
+#include <type_traits>
+
+#include "AudioMixerOps.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace android {
+
+/*
+ * Explicit vector implementations of volumeMulti and volumeRampMulti.
+ *
+ * The scalar templates in AudioMixerOps.h rely on autovectorization, which
+ * does not happen for the ramp and aux variants as the volume is carried from
+ * frame to frame.  Here the per-sample gains are first expanded into a small
+ * gain array (a repeating pattern for constant volume, a block of frames for
+ * a ramp), and the samples are then scaled by the gain array with vector
+ * instructions.  Volume ramps and aux sends are computed with exactly the
+ * same scalar operations, in the same order, as the scalar templates, and
+ * vector multiplies and adds are kept separate (no fused multiply-add), so
+ * results are bit-exact with the scalar path.
+ *
+ * Supported combinations (others return false so the caller uses the scalar path):
+ *   TO: float,   TI: float,   TV: float
+ *   TO: int32_t, TI: int16_t, TV: int16_t (U4.12) or int32_t (U4.28)
+ *   MIXTYPE_MULTI, MIXTYPE_MULTI_SAVEONLY and their MONOVOL and STEREOVOL variants.
+ *
+ * The instruction set is passed explicitly so that tests can compare every
+ * implementation supported by the device; the mixer uses getMixerOpsIsa().
+ */
+
+enum class MixerOpsIsa {
+    NONE,    // scalar templates only
+    SSE4_1,  // x86, baseline on x86_64 Android devices
+    AVX2,    // x86, selected at runtime
+    NEON,    // arm64
+};
+
+inline const char *toString(MixerOpsIsa isa) {
+    switch (isa) {
+    case MixerOpsIsa::NONE: return "none";
+    case MixerOpsIsa::SSE4_1: return "sse4.1";
+    case MixerOpsIsa::AVX2: return "avx2";
+    case MixerOpsIsa::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+// Returns true if the running CPU supports the instruction set.
+inline bool isMixerOpsIsaSupported(MixerOpsIsa isa) {
+    switch (isa) {
+    case MixerOpsIsa::NONE:
+        return true;
+#if defined(__x86_64__) || defined(__i386__)
+    case MixerOpsIsa::SSE4_1:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+    case MixerOpsIsa::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#elif defined(__aarch64__)
+    case MixerOpsIsa::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+// Returns the widest instruction set supported by the running CPU.
+// The result is computed once per process, on first call; AudioMixerBase calls
+// this on construction so that detection is not done on the audio thread.
+inline MixerOpsIsa getMixerOpsIsa() {
+    static const MixerOpsIsa sIsa = [] {
+        for (const MixerOpsIsa isa : { MixerOpsIsa::AVX2, MixerOpsIsa::SSE4_1,
+                MixerOpsIsa::NEON }) {
+            if (isMixerOpsIsaSupported(isa)) return isa;
+        }
+        return MixerOpsIsa::NONE;
+    }();
+    return sIsa;
+}
+
+namespace mixerops_vector {
+
+// Gain arrays are sized for the widest vector (8 lanes for AVX2), so that a
+// repeating per-channel pattern spans a whole number of vectors for any ISA.
+constexpr size_t kMaxLanes = 8;
+
+// Number of frames of a volume ramp expanded into a gain array at a time.
+constexpr size_t kRampBlockFrames = 16;
+
+/*
+ * applyGain scales count samples of in by a gain array of period samples,
+ * repeated as needed, storing into out (or accumulating if accumulate is true).
+ * period must be a multiple of the vector width. Only whole periods are
+ * processed; the number of samples processed is returned and the caller
+ * completes the remainder with scalar code.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+namespace sse4_1 {
+
+__attribute__((target("sse4.1")))
+inline size_t applyGain(float *out, const float *in, const float *gain,
+        size_t count, size_t period, bool accumulate) {
+    size_t done = 0;
+    for (; done + period <= count; done += period) {
+        for (size_t j = 0; j < period; j += 4) {
+            const __m128 v = _mm_mul_ps(_mm_loadu_ps(in + done + j), _mm_loadu_ps(gain + j));
+            float * const o = out + done + j;
+            _mm_storeu_ps(o, accumulate ? _mm_add_ps(_mm_loadu_ps(o), v) : v);
+        }
+    }
+    return done;
+}
+
+__attribute__((target("sse4.1")))
+inline size_t applyGain(int32_t *out, const int16_t *in, const int16_t *gain,
+        size_t count, size_t period, bool accumulate) {
+    size_t done = 0;
+    for (; done + period <= count; done += period) {
+        for (size_t j = 0; j < period; j += 4) {
+            const __m128i i32 = _mm_cvtepi16_epi32(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + done + j)));
+            const __m128i g32 = _mm_cvtepi16_epi32(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i *>(gain + j)));
+            const __m128i v = _mm_mullo_epi32(i32, g32);
+            __m128i * const o = reinterpret_cast<__m128i *>(out + done + j);
+            _mm_storeu_si128(o, accumulate ? _mm_add_epi32(_mm_loadu_si128(o), v) : v);
+        }
+    }
+    return done;
+}
+
+} // namespace sse4_1
+
+namespace avx2 {
+
+__attribute__((target("avx2")))
+inline size_t applyGain(float *out, const float *in, const float *gain,
+        size_t count, size_t period, bool accumulate) {
+    size_t done = 0;
+    for (; done + period <= count; done += period) {
+        for (size_t j = 0; j < period; j += 8) {
+            const __m256 v = _mm256_mul_ps(
+                    _mm256_loadu_ps(in + done + j), _mm256_loadu_ps(gain + j));
+            float * const o = out + done + j;
+            _mm256_storeu_ps(o, accumulate ? _mm256_add_ps(_mm256_loadu_ps(o), v) : v);
+        }
+    }
+    return done;
+}
+
+__attribute__((target("avx2")))
+inline size_t applyGain(int32_t *out, const int16_t *in, const int16_t *gain,
+        size_t count, size_t period, bool accumulate) {
+    size_t done = 0;
+    for (; done + period <= count; done += period) {
+        for (size_t j = 0; j < period; j += 8) {
+            const __m256i i32 = _mm256_cvtepi16_epi32(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + done + j)));
+            const __m256i g32 = _mm256_cvtepi16_epi32(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(gain + j)));
+            const __m256i v = _mm256_mullo_epi32(i32, g32);
+            __m256i * const o = reinterpret_cast<__m256i *>(out + done + j);
+            _mm256_storeu_si256(o, accumulate ? _mm256_add_epi32(_mm256_loadu_si256(o), v) : v);
+        }
+    }
+    return done;
+}
+
+} // namespace avx2
+
+#elif defined(__aarch64__)
+
+namespace neon {
+
+inline size_t applyGain(float *out, const float *in, const float *gain,
+        size_t count, size_t period, bool accumulate) {
+    size_t done = 0;
+    for (; done + period <= count; done += period) {
+        for (size_t j = 0; j < period; j += 4) {
+            const float32x4_t v = vmulq_f32(vld1q_f32(in + done + j), vld1q_f32(gain + j));
+            float * const o = out + done + j;
+            vst1q_f32(o, accumulate ? vaddq_f32(vld1q_f32(o), v) : v);
+        }
+    }
+    return done;
+}
+
+inline size_t applyGain(int32_t *out, const int16_t *in, const int16_t *gain,
+        size_t count, size_t period, bool accumulate) {
+    size_t done = 0;
+    for (; done + period <= count; done += period) {
+        for (size_t j = 0; j < period; j += 4) {
+            const int32x4_t v = vmull_s16(vld1_s16(in + done + j), vld1_s16(gain + j));
+            int32_t * const o = out + done + j;
+            vst1q_s32(o, accumulate ? vaddq_s32(vld1q_s32(o), v) : v);
+        }
+    }
+    return done;
+}
+
+} // namespace neon
+
+#endif
+
+template <typename TO, typename TI, typename TG>
+inline size_t applyGain(MixerOpsIsa isa, TO *out, const TI *in, const TG *gain,
+        size_t count, size_t period, bool accumulate) {
+    switch (isa) {
+#if defined(__x86_64__) || defined(__i386__)
+    case MixerOpsIsa::SSE4_1:
+        return sse4_1::applyGain(out, in, gain, count, period, accumulate);
+    case MixerOpsIsa::AVX2:
+        return avx2::applyGain(out, in, gain, count, period, accumulate);
+#elif defined(__aarch64__)
+    case MixerOpsIsa::NEON:
+        return neon::applyGain(out, in, gain, count, period, accumulate);
+#endif
+    default:
+        return 0;
+    }
+}
+
+// Scalar equivalent of applyGain for the remaining samples, same rounding as MixMul.
+template <typename TO, typename TI, typename TG>
+inline void applyGainScalar(TO *out, const TI *in, const TG *gain,
+        size_t begin, size_t count, size_t period, bool accumulate) {
+    for (size_t k = begin; k < count; ++k) {
+        const TO v = static_cast<TO>(in[k]) * static_cast<TO>(gain[k % period]);
+        out[k] = accumulate ? out[k] + v : v;
+    }
+}
+
+// The gain element type: float volumes are used as is, integer volumes are
+// reduced to U4.12 as done by the MixMul<int32_t, int16_t, TV> specializations.
+template <typename TV>
+using gain_t = std::conditional_t<std::is_floating_point_v<TV>, float, int16_t>;
+
+template <typename TV>
+inline gain_t<TV> toGain(TV volume) {
+    if constexpr (std::is_same_v<TV, int32_t>) {
+        return volume >> 16;
+    } else {
+        return volume;
+    }
+}
+
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV>
+constexpr bool isSupported() {
+    constexpr bool floatTypes = std::is_same_v<TO, float> && std::is_same_v<TI, float>
+            && std::is_same_v<TV, float>;
+    constexpr bool int16Types = std::is_same_v<TO, int32_t> && std::is_same_v<TI, int16_t>
+            && (std::is_same_v<TV, int16_t> || std::is_same_v<TV, int32_t>);
+    if constexpr (NCHAN <= 0 || NCHAN > FCC_LIMIT || !(floatTypes || int16Types)) {
+        return false;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        return NCHAN <= FCC_2;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+        return true;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_STEREOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL) {
+        return canonicalChannelMaskFromCount(NCHAN) != AUDIO_CHANNEL_NONE;
+    } else {
+        return false;
+    }
+}
+
+template <int MIXTYPE>
+constexpr bool isAccumulate() {
+    return MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_STEREOVOL;
+}
+
+// Volume selector for each channel, used to build the gain array.
+enum : uint8_t {
+    VOLUME_0,       // vol[0]
+    VOLUME_1,       // vol[1]
+    VOLUME_CENTER,  // average of vol[0] and vol[1]
+};
+
+/*
+ * Returns the volume used by each channel, matching the channel affinity of the
+ * scalar MIXTYPE implementations (see stereoVolumeHelperWithChannelMask for
+ * MIXTYPE_MULTI_STEREOVOL).  Computed at compile time.
+ */
+template <int MIXTYPE, int NCHAN>
+constexpr std::array<uint8_t, NCHAN> channelVolumeMap() {
+    std::array<uint8_t, NCHAN> map{};
+    if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        for (int i = 0; i < NCHAN; ++i) {
+            map[i] = i == 0 ? VOLUME_0 : VOLUME_1;
+        }
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+        for (int i = 0; i < NCHAN; ++i) {
+            map[i] = VOLUME_0;
+        }
+    } else /* constexpr */ {
+        using namespace audio_utils::channels;
+        unsigned mask = canonicalChannelMaskFromCount(NCHAN);
+        constexpr unsigned LFE_LFE2 =
+                AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2;
+        const bool has_LFE_LFE2 = (mask & LFE_LFE2) == LFE_LFE2;
+        for (int i = 0; mask != 0; ++i) {
+            const int index = __builtin_ctz(mask);
+            const unsigned bit = 1u << index;
+            const auto side = kSideFromChannelIdx[index];
+            if (side == AUDIO_GEOMETRY_SIDE_LEFT
+                    || (has_LFE_LFE2 && bit == AUDIO_CHANNEL_OUT_LOW_FREQUENCY)) {
+                map[i] = VOLUME_0;
+            } else if (side == AUDIO_GEOMETRY_SIDE_RIGHT
+                    || (has_LFE_LFE2 && bit == AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2)) {
+                map[i] = VOLUME_1;
+            } else {
+                map[i] = VOLUME_CENTER;
+            }
+            mask &= ~bit;
+        }
+    }
+    return map;
+}
+
+// Computes the per-channel gains for one frame from the volume array.
+template <int MIXTYPE, int NCHAN, typename TV>
+inline void frameGains(const TV *vol, gain_t<TV> *gains) {
+    static constexpr auto map = channelVolumeMap<MIXTYPE, NCHAN>();
+    gain_t<TV> volumes[3];
+    volumes[VOLUME_0] = toGain(vol[0]);
+    if constexpr (MIXTYPE == MIXTYPE_MULTI_STEREOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL) {
+        std::decay_t<TV> center;
+        if constexpr (std::is_floating_point_v<TV>) {
+            center = (vol[0] + vol[1]) * 0.5;       // do not use divide
+        } else {
+            center = (vol[0] >> 1) + (vol[1] >> 1); // rounds to 0.
+        }
+        volumes[VOLUME_1] = toGain(vol[1]);
+        volumes[VOLUME_CENTER] = toGain(center);
+    } else if constexpr ((MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY)
+            && NCHAN == 2) {
+        volumes[VOLUME_1] = toGain(vol[1]);
+    }
+    for (int i = 0; i < NCHAN; ++i) {
+        gains[i] = volumes[map[i]];
+    }
+}
+
+// Advances the volume ramp by one frame, as the scalar volumeRampMulti does.
+template <int MIXTYPE, int NCHAN, typename TV>
+inline void advanceRamp(TV *vol, const TV *volinc) {
+    if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        for (int i = 0; i < NCHAN; ++i) {
+            vol[i] += volinc[i];
+        }
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+        vol[0] += volinc[0];
+    } else /* constexpr */ {
+        vol[0] += volinc[0];
+        vol[1] += volinc[1];
+    }
+}
+
+// Accumulates the average of each input frame into aux, with the aux level
+// computed as in the aux variants of the scalar templates.
+template <int NCHAN, bool RAMP, typename TI, typename TA, typename TAV>
+inline void auxAccumulate(size_t frameCount, const TI *in, TA *aux, TAV *vola, TAV volainc) {
+    for (size_t i = 0; i < frameCount; ++i) {
+        TA auxaccum = 0;
+        for (int j = 0; j < NCHAN; ++j) {
+            MixAccum<TA, TI>(&auxaccum, *in++);
+        }
+        auxaccum /= NCHAN;
+        *aux++ += MixMul<TA, TA, TAV>(auxaccum, *vola);
+        if constexpr (RAMP) {
+            *vola += volainc;
+        }
+    }
+}
+
+// Returns true if U4.28 volumes, reduced to U4.12, fit the int16_t gain type
+// over the whole ramp.  Ramps are linear, so checking the end points is enough.
+template <int NCHAN, typename TV>
+inline bool rampFitsGain(size_t frameCount, const TV *vol, const TV *volinc) {
+    if constexpr (std::is_same_v<TV, int32_t>) {
+        for (int i = 0; i < std::min(NCHAN, (int)FCC_2); ++i) {
+            const int64_t end = vol[i] + (int64_t)volinc[i] * (int64_t)frameCount;
+            for (const int64_t v : { (int64_t)vol[i], end }) {
+                if ((v >> 16) < INT16_MIN || (v >> 16) > INT16_MAX) return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace mixerops_vector
+
+/*
+ * Vector equivalent of volumeMulti<MIXTYPE, NCHAN>.
+ * Returns false, without touching any buffer, if the combination is not supported
+ * by the vector path; the caller must then use the scalar template.
+ */
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+inline bool volumeMultiVector(MixerOpsIsa isa, TO* out, size_t frameCount,
+        const TI* in, TA* aux, const TV *vol, TAV vola)
+{
+    using namespace mixerops_vector;
+    if constexpr (!isSupported<MIXTYPE, NCHAN, TO, TI, TV>()) {
+        return false;
+    } else {
+        if (isa == MixerOpsIsa::NONE) return false;
+        if (!rampFitsGain<NCHAN>(0 /* frameCount */, vol, vol)) return false;
+
+        // the gain pattern is repeated to span a whole number of vectors.
+        constexpr size_t period = NCHAN * kMaxLanes;
+        gain_t<TV> gains[period];
+        frameGains<MIXTYPE, NCHAN>(vol, gains);
+        for (size_t i = NCHAN; i < period; ++i) {
+            gains[i] = gains[i - NCHAN];
+        }
+
+        if (aux != nullptr) {
+            auxAccumulate<NCHAN, false /* RAMP */>(frameCount, in, aux, &vola, vola);
+        }
+        const size_t count = frameCount * NCHAN;
+        constexpr bool accumulate = isAccumulate<MIXTYPE>();
+        const size_t done = applyGain(isa, out, in, gains, count, period, accumulate);
+        applyGainScalar(out, in, gains, done, count, period, accumulate);
+        return true;
+    }
+}
+
+/*
+ * Vector equivalent of volumeRampMulti<MIXTYPE, NCHAN>.
+ * vol and vola are advanced by frameCount increments, as for the scalar template.
+ * Returns false, without touching any buffer, if the combination is not supported.
+ */
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+inline bool volumeRampMultiVector(MixerOpsIsa isa, TO* out, size_t frameCount,
+        const TI* in, TA* aux, TV *vol, const TV *volinc, TAV *vola, TAV volainc)
+{
+    using namespace mixerops_vector;
+    if constexpr (!isSupported<MIXTYPE, NCHAN, TO, TI, TV>()) {
+        return false;
+    } else {
+        if (isa == MixerOpsIsa::NONE) return false;
+        if (!rampFitsGain<NCHAN>(frameCount, vol, volinc)) return false;
+
+        if (aux != nullptr) {
+            auxAccumulate<NCHAN, true /* RAMP */>(frameCount, in, aux, vola, volainc);
+        }
+
+        // a full block is a whole number of vectors for any ISA, as kRampBlockFrames
+        // is a multiple of kMaxLanes; a partial block is completed by scalar code.
+        constexpr size_t blockCount = NCHAN * kRampBlockFrames;
+        gain_t<TV> gains[blockCount];
+        constexpr bool accumulate = isAccumulate<MIXTYPE>();
+        while (frameCount > 0) {
+            const size_t frames = std::min(frameCount, kRampBlockFrames);
+            for (size_t i = 0; i < frames; ++i) {
+                frameGains<MIXTYPE, NCHAN>(vol, gains + i * NCHAN);
+                advanceRamp<MIXTYPE, NCHAN>(vol, volinc);
+            }
+            const size_t count = frames * NCHAN;
+            const size_t done = count == blockCount
+                    ? applyGain(isa, out, in, gains, count, count, accumulate) : 0;
+            applyGainScalar(out, in, gains, done, count, count, accumulate);
+            out += count;
+            in += count;
+            frameCount -= frames;
+        }
+        return true;
+    }
+}
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_MIXER_OPS_VECTOR_H
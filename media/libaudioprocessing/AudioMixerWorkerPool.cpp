@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioMixerWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <media/AudioMixerWorkerPool.h>
+#include <utils/Log.h>
+
+namespace android {
+
+AudioMixerWorkerPool::AudioMixerWorkerPool(size_t workerCount, const std::vector<int>& cpus)
+{
+    mWorkers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        const int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        // partition index 0 is reserved for the calling thread.
+        mWorkers.emplace_back(&AudioMixerWorkerPool::threadLoop, this, i + 1, cpu);
+    }
+}
+
+AudioMixerWorkerPool::~AudioMixerWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mExit = true;
+    }
+    mWorkCv.notify_all();
+    for (auto& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+void AudioMixerWorkerPool::run(job_t job, void *cookie)
+{
+    if (mWorkers.empty()) {
+        job(cookie, 0);
+        return;
+    }
+    // The caller's priority is raised asynchronously (e.g. by SchedulingPolicyService),
+    // so it is sampled on the first run and then only every kSchedulingCheckRuns runs,
+    // rather than paying for pthread_getschedparam() on every mix cycle.
+    if (mRunsUntilSchedulingCheck == 0) {
+        followCallerScheduling();
+        mRunsUntilSchedulingCheck = kSchedulingCheckRuns;
+    }
+    --mRunsUntilSchedulingCheck;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJob = job;
+        mCookie = cookie;
+        mPending = mWorkers.size();
+        ++mGeneration;
+    }
+    mWorkCv.notify_all();
+
+    job(cookie, 0);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCv.wait(lock, [this] { return mPending == 0; });
+}
+
+void AudioMixerWorkerPool::threadLoop(size_t index, int cpu)
+{
+    char name[16];
+    snprintf(name, sizeof(name), "AudioMixerW%zu", index);
+    pthread_setname_np(pthread_self(), name);
+    if (cpu >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        if (sched_setaffinity(0 /* self */, sizeof(cpuSet), &cpuSet) != 0) {
+            ALOGW("%s: cannot pin worker %zu to cpu %d: %s",
+                    __func__, index, cpu, strerror(errno));
+        }
+    }
+
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mWorkCv.wait(lock, [&] { return mExit || mGeneration != generation; });
+        if (mExit) break;
+        generation = mGeneration;
+        const job_t job = mJob;
+        void * const cookie = mCookie;
+        lock.unlock();
+
+        job(cookie, index);
+
+        lock.lock();
+        if (--mPending == 0) {
+            mDoneCv.notify_one();
+        }
+    }
+}
+
+void AudioMixerWorkerPool::followCallerScheduling()
+{
+    int policy;
+    sched_param param;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0) return;
+    // strip SCHED_RESET_ON_FORK, which is not a valid input to pthread_setschedparam.
+    policy &= ~SCHED_RESET_ON_FORK;
+    if (policy == mPolicy && param.sched_priority == mPriority) return;
+
+    for (auto& worker : mWorkers) {
+        const int err = pthread_setschedparam(worker.native_handle(), policy, &param);
+        if (err != 0 && !mSchedulingWarned) {
+            ALOGW("%s: cannot set worker policy %d priority %d: %s",
+                    __func__, policy, param.sched_priority, strerror(err));
+            mSchedulingWarned = true;
+        }
+    }
+    mPolicy = policy;
+    mPriority = param.sched_priority;
+}
+
+} // namespace android
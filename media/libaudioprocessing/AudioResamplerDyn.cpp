@@ -23,6 +23,10 @@
 #include <dlfcn.h>
 #include <math.h>
 
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -31,6 +35,7 @@
 #include "AudioResamplerFirOps.h" // USE_NEON, USE_SSE and USE_INLINE_ASSEMBLY defined here
 #include "AudioResamplerFirProcess.h"
 #include "AudioResamplerFirProcessNeon.h"
+#include "AudioResamplerFirProcessAVX2.h" // before AudioResamplerFirProcessSSE.h
 #include "AudioResamplerFirProcessSSE.h"
 #include "AudioResamplerFirGen.h" // requires math.h
 #include "AudioResamplerDyn.h"
@@ -181,8 +186,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +211,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -256,23 +259,56 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 }
 
 template<typename TC, typename TI, typename TO>
-void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
-        double stopBandAtten, double fcr) {
-    // compute the normalized transition bandwidth
-    const double tbw = firKaiserTbw(c.mHalfNumCoefs, stopBandAtten);
-    const int phases = c.mL;
-    const int halfLength = c.mHalfNumCoefs;
+struct AudioResamplerDyn<TC, TI, TO>::Filter {
+    ~Filter() {
+        free(mCoefs);
+    }
+
+    TC* mCoefs = nullptr;    // (phases + 1) * halfLength coefficients
+    double mAttenuation = 0.;
+    double mPassbandRippleDb = 0.;
+};
+
+/*
+ * Returns the filter for the design parameters, creating it if it is not in use
+ * by another resampler.
+ *
+ * The cache holds weak references, so a filter is freed with the last resampler
+ * using it.  The key is the complete set of design parameters rather than the
+ * sample rates and quality from which they are derived, so that resamplers with
+ * different channel counts, or rates yielding the same design, also share.
+ *
+ * The filter is designed outside of the lock, so that creation of resamplers
+ * requiring different filters is not serialized; if two threads race to design
+ * the same filter, the first one inserted is used.
+ */
+template<typename TC, typename TI, typename TO>
+std::shared_ptr<const typename AudioResamplerDyn<TC, TI, TO>::Filter>
+AudioResamplerDyn<TC, TI, TO>::getFilter(int phases, int halfLength,
+        double stopBandAtten, double fcr)
+{
+    using key_t = std::tuple<int /* phases */, int /* halfLength */,
+            double /* stopBandAtten */, double /* fcr */>;
+    static std::mutex sLock;
+    static std::map<key_t, std::weak_ptr<const Filter>> sFilters; // guarded by sLock
+
+    const key_t key{phases, halfLength, stopBandAtten, fcr};
+    {
+        std::lock_guard<std::mutex> lock(sLock);
+        auto it = sFilters.find(key);
+        if (it != sFilters.end()) {
+            if (auto filter = it->second.lock()) {
+                return filter;
+            }
+        }
+    }
 
-    // create buffer
-    TC *coefs = nullptr;
+    auto filter = std::make_shared<Filter>();
     int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
+            reinterpret_cast<void **>(&filter->mCoefs),
             CACHE_LINE_SIZE /* alignment */,
             (phases + 1) * halfLength * sizeof(TC));
     LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
 
     // square the computed minimum passband value (extra safety).
     double attenuation =
@@ -280,21 +316,53 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     attenuation *= attenuation;
 
     // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    firKaiserGen(filter->mCoefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    filter->mAttenuation = attenuation;
+    filter->mPassbandRippleDb = computeWindowedSincPassbandRippleDb(stopBandAtten);
+
+    std::lock_guard<std::mutex> lock(sLock);
+    // drop entries for filters no longer in use.
+    for (auto it = sFilters.begin(); it != sFilters.end();) {
+        it = it->second.expired() ? sFilters.erase(it) : std::next(it);
+    }
+    auto [it, inserted] = sFilters.emplace(key, filter);
+    if (!inserted) {
+        if (auto existing = it->second.lock()) {
+            return existing;
+        }
+        it->second = filter;
+    }
+    ALOGV("%s: created filter phases:%d halfLength:%d stopBandAtten:%lf fcr:%lf, "
+            "%zu filters in use",
+            __func__, phases, halfLength, stopBandAtten, fcr, sFilters.size());
+    return filter;
+}
+
+template<typename TC, typename TI, typename TO>
+void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
+        double stopBandAtten, double fcr) {
+    // compute the normalized transition bandwidth
+    const double tbw = firKaiserTbw(c.mHalfNumCoefs, stopBandAtten);
+    const int phases = c.mL;
+    const int halfLength = c.mHalfNumCoefs;
+
+    // get a shared filter, designing it if needed
+    mFilter = getFilter(phases, halfLength, stopBandAtten, fcr);
+    c.mFirCoefs = mFilter->mCoefs;
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
     mNormalizedTransitionBandwidth = tbw;
-    mFilterAttenuation = attenuation;
+    mFilterAttenuation = mFilter->mAttenuation;
     mStopbandAttenuationDb = stopBandAtten;
-    mPassbandRippleDb = computeWindowedSincPassbandRippleDb(stopBandAtten);
+    mPassbandRippleDb = mFilter->mPassbandRippleDb;
 
 #if 0
     // Keep this debug code in case an app causes resampler design issues.
     const double halfbw = tbw * 0.5;
     // print basic filter stats
     ALOGD("L:%d  hnc:%d  stopBandAtten:%lf  fcr:%lf  atten:%lf  tbw:%lf\n",
-            c.mL, c.mHalfNumCoefs, stopBandAtten, fcr, attenuation, tbw);
+            c.mL, c.mHalfNumCoefs, stopBandAtten, fcr, mFilterAttenuation, tbw);
 
     // test the filter and report results.
     // Since this is a polyphase filter, normalized fp and fs must be scaled.
@@ -306,7 +374,7 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
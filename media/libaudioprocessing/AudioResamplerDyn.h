@@ -17,6 +17,7 @@
 #ifndef ANDROID_AUDIO_RESAMPLER_DYN_H
 #define ANDROID_AUDIO_RESAMPLER_DYN_H
 
+#include <memory>
 #include <stdint.h>
 #include <sys/types.h>
 #include <android/log.h>
@@ -147,6 +148,14 @@ private:
         size_t mStateCount; // size of state in units of TI.
     };
 
+    // An immutable filter bank and its design criteria, see AudioResamplerDyn.cpp.
+    // Filters are shared through a process-wide cache by all resamplers of the same
+    // type requiring the same design, as many tracks often use the same conversion.
+    struct Filter;
+
+    static std::shared_ptr<const Filter> getFilter(int phases, int halfLength,
+            double stopBandAtten, double fcr);
+
     void createKaiserFir(Constants &c, double stopBandAtten,
             int inSampleRate, int outSampleRate, double tbwCheat);
 
@@ -166,7 +175,7 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const Filter> mFilter; // if a filter is created, this is not null
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
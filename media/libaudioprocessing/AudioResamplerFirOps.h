@@ -43,12 +43,19 @@ namespace android {
 #elif defined(__SSSE3__)  // Should be supported in x86 ABI for both 32 & 64-bit.
 #define USE_SSE (true)  // Inference SSE Intrinsics
 #define USE_AVX2 (false)
-#include <tmmintrin.h>
+#include <immintrin.h>  // also declares the AVX2 intrinsics used by USE_AVX2_RUNTIME
 #else
 #define USE_SSE (false)
 #define USE_AVX2(false)
 #endif
 
+// AVX2 specializations selected at runtime, see AudioResamplerFirProcessAVX2.h
+#if USE_SSE && (defined(__x86_64__) || defined(__i386__))
+#define USE_AVX2_RUNTIME (true)
+#else
+#define USE_AVX2_RUNTIME (false)
+#endif
+
 
 template<typename T, typename U>
 struct is_same
@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H
+#define ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H
+
+namespace android {
+
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h
+
+#if USE_AVX2_RUNTIME
+
+//
+// AVX2 specializations of Process() and ProcessL().
+//
+// AVX2 and FMA are not part of the x86 Android ABI, so these functions are compiled
+// with a target attribute and selected at runtime with useAvx2Intrinsic().
+// The float variants are selected from AudioResamplerFirProcessSSE.h.
+//
+// Each loop iteration processes 8 coefficients of the positive and negative halves.
+// The int16_t variants are bit-exact with ProcessBase(), as integer accumulation
+// is associative; the float variants differ from the other paths in rounding only.
+//
+
+// Returns true if the AVX2 specializations should be used.
+static inline bool useAvx2Intrinsic()
+{
+#if USE_AVX2
+    return true;
+#else
+    static const bool sUseAvx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }();
+    return sUseAvx2;
+#endif
+}
+
+// Returns the sum of the 8 floats of v.
+__attribute__((target("avx2,fma")))
+static inline float HorizontalSumAVX2(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+// Returns the sum of the 4 int32_t of v.
+__attribute__((target("avx2")))
+static inline int32_t HorizontalSumAVX2(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xB1));
+    return _mm_cvtsi128_si32(v);
+}
+
+template <int CHANNELS, int STRIDE, bool FIXED>
+__attribute__((target("avx2,fma")))
+static void ProcessAVX2Intrinsic(float* out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* volumeLR,
+        float lerpP,
+        const float* coefsP1,
+        const float* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    sP -= CHANNELS*(8-1);   // adjust sP for a loop iteration of eight
+
+    // The samples are loaded in memory order, and the coefficients are permuted to
+    // match: reversed for the positive half, and for stereo, in the lane order
+    // produced by the deinterleave below (frames 0, 1, 4, 5, 2, 3, 6, 7).
+    const __m256i posIndex = CHANNELS == 1
+            ? _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)
+            : _mm256_setr_epi32(7, 6, 3, 2, 5, 4, 1, 0);
+    const __m256i negIndex = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+
+    __m256 interp;
+    if (!FIXED) {
+        interp = _mm256_set1_ps(lerpP);
+    }
+
+    __m256 accL = _mm256_setzero_ps();
+    __m256 accR = _mm256_setzero_ps();
+
+    do {
+        __m256 posCoef = _mm256_load_ps(coefsP);
+        __m256 negCoef = _mm256_load_ps(coefsN);
+        coefsP += 8;
+        coefsN += 8;
+
+        if (!FIXED) { // interpolate
+            const __m256 posCoef1 = _mm256_load_ps(coefsP1);
+            const __m256 negCoef1 = _mm256_load_ps(coefsN1);
+            coefsP1 += 8;
+            coefsN1 += 8;
+
+            // posCoef = interp * (posCoef1 - posCoef) + posCoef
+            // negCoef = interp * (negCoef - negCoef1) + negCoef1
+            posCoef = _mm256_fmadd_ps(_mm256_sub_ps(posCoef1, posCoef), interp, posCoef);
+            negCoef = _mm256_fmadd_ps(_mm256_sub_ps(negCoef, negCoef1), interp, negCoef1);
+        }
+        posCoef = _mm256_permutevar8x32_ps(posCoef, posIndex);
+
+        switch (CHANNELS) {
+        case 1: {
+            const __m256 posSamp = _mm256_loadu_ps(sP);
+            const __m256 negSamp = _mm256_loadu_ps(sN);
+            sP -= 8;
+            sN += 8;
+
+            accL = _mm256_fmadd_ps(posSamp, posCoef, accL);
+            accL = _mm256_fmadd_ps(negSamp, negCoef, accL);
+        } break;
+        case 2: {
+            const __m256 posSamp0 = _mm256_loadu_ps(sP);
+            const __m256 posSamp1 = _mm256_loadu_ps(sP + 8);
+            const __m256 negSamp0 = _mm256_loadu_ps(sN);
+            const __m256 negSamp1 = _mm256_loadu_ps(sN + 8);
+            sP -= 16;
+            sN += 16;
+
+            // deinterleave, frames ordered 0, 1, 4, 5, 2, 3, 6, 7.
+            const __m256 posSampL = _mm256_shuffle_ps(posSamp0, posSamp1, 0x88);
+            const __m256 posSampR = _mm256_shuffle_ps(posSamp0, posSamp1, 0xDD);
+            const __m256 negSampL = _mm256_shuffle_ps(negSamp0, negSamp1, 0x88);
+            const __m256 negSampR = _mm256_shuffle_ps(negSamp0, negSamp1, 0xDD);
+            negCoef = _mm256_permutevar8x32_ps(negCoef, negIndex);
+
+            accL = _mm256_fmadd_ps(posSampL, posCoef, accL);
+            accR = _mm256_fmadd_ps(posSampR, posCoef, accR);
+            accL = _mm256_fmadd_ps(negSampL, negCoef, accL);
+            accR = _mm256_fmadd_ps(negSampR, negCoef, accR);
+        } break;
+        }
+    } while (count -= 8);
+
+    // multiply by volume and save
+    const float l = HorizontalSumAVX2(accL);
+    const float r = CHANNELS == 1 ? l : HorizontalSumAVX2(accR);
+    out[0] += l * volumeLR[0];
+    out[1] += r * volumeLR[1];
+}
+
+template <int CHANNELS, int STRIDE, bool FIXED>
+__attribute__((target("avx2")))
+static void ProcessAVX2Intrinsic(int32_t* out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* volumeLR,
+        uint32_t lerpP,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    sP -= CHANNELS*(8-1);   // adjust sP for a loop iteration of eight
+
+    // reverses the 8 int16_t of each 128 bit lane.
+    const __m256i reverse = _mm256_setr_epi8(
+            14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+            14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+    // moves the left samples to the low 64 bits, and the right to the high 64 bits,
+    // of each 128 bit lane.
+    const __m256i deinterleave = _mm256_setr_epi8(
+            0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+            0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+
+    __m256i interp;
+    if (!FIXED) {
+        interp = _mm256_set1_epi16(static_cast<int16_t>(lerpP));
+    }
+
+    // mono: 8 partial sums.  stereo: 4 partial sums of left, then 4 of right.
+    __m256i acc = _mm256_setzero_si256();
+
+    do {
+        const __m128i posCoef128 = _mm_load_si128(reinterpret_cast<const __m128i*>(coefsP));
+        const __m128i negCoef128 = _mm_load_si128(reinterpret_cast<const __m128i*>(coefsN));
+        coefsP += 8;
+        coefsN += 8;
+
+        // the positive and negative halves are processed together as
+        // [ positive | negative ] coefficients in the low and high 128 bit lanes.
+        __m256i coef = _mm256_set_m128i(negCoef128, posCoef128);
+        if (!FIXED) { // interpolate
+            const __m128i posCoef1 =
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(coefsP1));
+            const __m128i negCoef1 =
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(coefsN1));
+            coefsP1 += 8;
+            coefsN1 += 8;
+
+            // pos = pos + (lerp * (pos1 - pos) >> 15)
+            // neg = neg1 + (lerp * (neg - neg1) >> 15)
+            // as interpolate<int16_t, uint32_t>(), with exact 16 x 16 >> 15 products.
+            const __m256i base = _mm256_set_m128i(negCoef1, posCoef128);
+            const __m256i other = _mm256_set_m128i(negCoef128, posCoef1);
+            const __m256i diff = _mm256_sub_epi16(other, base);
+            const __m256i hi = _mm256_mulhi_epi16(interp, diff);
+            const __m256i lo = _mm256_mullo_epi16(interp, diff);
+            coef = _mm256_add_epi16(base,
+                    _mm256_or_si256(_mm256_slli_epi16(hi, 1), _mm256_srli_epi16(lo, 15)));
+        }
+
+        switch (CHANNELS) {
+        case 1: {
+            // [ reversed positive | negative ] samples
+            const __m256i samp = _mm256_set_m128i(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(sN)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(sP)));
+            sP -= 8;
+            sN += 8;
+            coef = _mm256_shuffle_epi8(coef, _mm256_setr_epi8(
+                    14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+                    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(samp, coef));
+        } break;
+        case 2: {
+            __m256i posSamp = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sP));
+            __m256i negSamp = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sN));
+            sP -= 16;
+            sN += 16;
+
+            // deinterleave to [ left 0-7 | right 0-7 ].
+            posSamp = _mm256_permute4x64_epi64(
+                    _mm256_shuffle_epi8(posSamp, deinterleave), 0xD8);
+            negSamp = _mm256_permute4x64_epi64(
+                    _mm256_shuffle_epi8(negSamp, deinterleave), 0xD8);
+
+            // broadcast each half of the coefficients to both lanes.
+            const __m256i posCoef = _mm256_shuffle_epi8(
+                    _mm256_permute4x64_epi64(coef, 0x44), reverse);
+            const __m256i negCoef = _mm256_permute4x64_epi64(coef, 0xEE);
+
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(posSamp, posCoef));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(negSamp, negCoef));
+        } break;
+        }
+    } while (count -= 8);
+
+    // multiply by volume and save, as volumeAdjust().
+    int32_t l, r;
+    if (CHANNELS == 1) {
+        l = r = HorizontalSumAVX2(_mm_add_epi32(
+                _mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1)));
+    } else {
+        l = HorizontalSumAVX2(_mm256_castsi256_si128(acc));
+        r = HorizontalSumAVX2(_mm256_extracti128_si256(acc, 1));
+    }
+    out[0] += volumeAdjust(l, volumeLR[0]);
+    out[1] += volumeAdjust(r, volumeLR[1]);
+}
+
+template <>
+inline void ProcessL<1, 16>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR)
+{
+    if (useAvx2Intrinsic()) {
+        ProcessAVX2Intrinsic<1, 16, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+    } else {
+        ProcessBase<1, 16, InterpNull>(out, count, coefsP, coefsN, sP, sN, 0, volumeLR);
+    }
+}
+
+template <>
+inline void ProcessL<2, 16>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR)
+{
+    if (useAvx2Intrinsic()) {
+        ProcessAVX2Intrinsic<2, 16, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+    } else {
+        ProcessBase<2, 16, InterpNull>(out, count, coefsP, coefsN, sP, sN, 0, volumeLR);
+    }
+}
+
+template <>
+inline void Process<1, 16>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    if (useAvx2Intrinsic()) {
+        ProcessAVX2Intrinsic<1, 16, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                lerpP, coefsP1, coefsN1);
+    } else {
+        ProcessBase<1, 16, InterpCompute>(out, count, coefsP, coefsN, sP, sN, lerpP,
+                volumeLR);
+    }
+}
+
+template <>
+inline void Process<2, 16>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    if (useAvx2Intrinsic()) {
+        ProcessAVX2Intrinsic<2, 16, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                lerpP, coefsP1, coefsN1);
+    } else {
+        ProcessBase<2, 16, InterpCompute>(out, count, coefsP, coefsN, sP, sN, lerpP,
+                volumeLR);
+    }
+}
+
+#endif //USE_AVX2_RUNTIME
+
+} // namespace android
+
+#endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H*/
@@ -32,6 +32,7 @@ namespace android {
 
 //
 // SSEx specializations are enabled for Process() and ProcessL() in AudioResamplerFirProcess.h
+// The AVX2 variants in AudioResamplerFirProcessAVX2.h are used instead if the CPU supports them.
 //
 
 template <int CHANNELS, int STRIDE, bool FIXED>
@@ -182,6 +183,13 @@ inline void ProcessL<1, 16>(float* const out,
         const float* sN,
         const float* const volumeLR)
 {
+#if USE_AVX2_RUNTIME
+    if (useAvx2Intrinsic()) {
+        ProcessAVX2Intrinsic<1, 16, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+        return;
+    }
+#endif
     ProcessSSEIntrinsic<1, 16, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
             0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
 }
@@ -195,6 +203,13 @@ inline void ProcessL<2, 16>(float* const out,
         const float* sN,
         const float* const volumeLR)
 {
+#if USE_AVX2_RUNTIME
+    if (useAvx2Intrinsic()) {
+        ProcessAVX2Intrinsic<2, 16, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+        return;
+    }
+#endif
     ProcessSSEIntrinsic<2, 16, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
             0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
 }
@@ -211,6 +226,13 @@ inline void Process<1, 16>(float* const out,
         float lerpP,
         const float* const volumeLR)
 {
+#if USE_AVX2_RUNTIME
+    if (useAvx2Intrinsic()) {
+        ProcessAVX2Intrinsic<1, 16, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                lerpP, coefsP1, coefsN1);
+        return;
+    }
+#endif
     ProcessSSEIntrinsic<1, 16, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
             lerpP, coefsP1, coefsN1);
 }
@@ -227,6 +249,13 @@ inline void Process<2, 16>(float* const out,
         float lerpP,
         const float* const volumeLR)
 {
+#if USE_AVX2_RUNTIME
+    if (useAvx2Intrinsic()) {
+        ProcessAVX2Intrinsic<2, 16, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+                lerpP, coefsP1, coefsN1);
+        return;
+    }
+#endif
     ProcessSSEIntrinsic<2, 16, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
             lerpP, coefsP1, coefsN1);
 }
@@ -431,6 +431,91 @@ void ClampFloatBufferProvider::copyFrames(void *dst, const void *src, size_t fra
                                              FLOAT_NOMINAL_RANGE_HEADROOM);
 }
 
+FusedBufferProvider::FusedBufferProvider(const std::vector<CopyBufferProvider *> &stages,
+        size_t bufferFrameCount) :
+        CopyBufferProvider(
+                stages.front()->getInputFrameSize(),
+                stages.back()->getOutputFrameSize(),
+                bufferFrameCount),
+        mBufferFrameCount(bufferFrameCount)
+{
+    LOG_ALWAYS_FATAL_IF(bufferFrameCount == 0,
+            "FusedBufferProvider requires a local buffer");
+    setStages(stages);
+    LOG_ALWAYS_FATAL_IF(mStages.empty(), "FusedBufferProvider requires stages");
+}
+
+bool FusedBufferProvider::setStages(const std::vector<CopyBufferProvider *> &stages)
+{
+    if (stages.empty()
+            || stages.front()->getInputFrameSize() != mInputFrameSize
+            || stages.back()->getOutputFrameSize() != mOutputFrameSize) {
+        return false;
+    }
+    size_t scratchFrameSize = 0;
+    for (size_t i = 0; i + 1 < stages.size(); ++i) {
+        LOG_ALWAYS_FATAL_IF(
+                stages[i]->getOutputFrameSize() != stages[i + 1]->getInputFrameSize(),
+                "FusedBufferProvider stage %zu output frame size %zu != input frame size %zu",
+                i, stages[i]->getOutputFrameSize(), stages[i + 1]->getInputFrameSize());
+        scratchFrameSize = std::max(scratchFrameSize, stages[i]->getOutputFrameSize());
+    }
+    mStages = stages;
+    mBlockFrameCount = getBlockFrameCount(stages, mBufferFrameCount);
+    // Only stages between the first and the last need scratch space.
+    // The scratch buffers only grow, so reconfiguring with the same formats does not allocate.
+    const size_t scratchBytes = mBlockFrameCount * scratchFrameSize;
+    if (mStages.size() > 1 && mScratch[0].size() < scratchBytes) {
+        mScratch[0].resize(scratchBytes);
+    }
+    if (mStages.size() > 2 && mScratch[1].size() < scratchBytes) {
+        mScratch[1].resize(scratchBytes);
+    }
+    ALOGV("FusedBufferProvider(%p)(%zu stages, %zu block frames)",
+            this, mStages.size(), mBlockFrameCount);
+    return true;
+}
+
+/*static*/ size_t FusedBufferProvider::getBlockFrameCount(
+        const std::vector<CopyBufferProvider *> &stages, size_t bufferFrameCount)
+{
+    // Keep each scratch block well inside the L1 data cache.
+    static constexpr size_t kScratchBlockBytes = 2048;
+    static constexpr size_t kMinBlockFrameCount = 16;
+
+    size_t maxFrameSize = 0;
+    for (const auto stage : stages) {
+        if (!stage->isBlockwiseEfficient()) {
+            // do not increase the number of calls to an expensive stage.
+            return bufferFrameCount;
+        }
+        maxFrameSize = std::max(maxFrameSize, stage->getOutputFrameSize());
+    }
+    const size_t blockFrameCount =
+            std::max(kMinBlockFrameCount, kScratchBlockBytes / std::max(maxFrameSize, (size_t)1));
+    return std::min(blockFrameCount, bufferFrameCount);
+}
+
+void FusedBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
+{
+    const uint8_t *in = static_cast<const uint8_t *>(src);
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    const size_t lastStage = mStages.size() - 1;
+    while (frames > 0) {
+        const size_t blockFrames = std::min(frames, mBlockFrameCount);
+        const void *stageIn = in;
+        for (size_t i = 0; i < lastStage; ++i) {
+            void *stageOut = mScratch[i & 1].data();
+            mStages[i]->copyFrames(stageOut, stageIn, blockFrames);
+            stageIn = stageOut;
+        }
+        mStages[lastStage]->copyFrames(out, stageIn, blockFrames);
+        in += blockFrames * mInputFrameSize;
+        out += blockFrames * mOutputFrameSize;
+        frames -= blockFrames;
+    }
+}
+
 TimestretchBufferProvider::TimestretchBufferProvider(int32_t channelCount,
         audio_format_t format, uint32_t sampleRate, const AudioPlaybackRate &playbackRate) :
         mChannelCount(channelCount),
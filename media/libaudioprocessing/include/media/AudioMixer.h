@@ -59,6 +59,7 @@ public:
     AudioMixer(size_t frameCount, uint32_t sampleRate)
             : AudioMixerBase(frameCount, sampleRate) {
         pthread_once(&sOnceControl, &sInitRoutine);
+        mBufferProviderFusion = sBufferProviderFusionDefault;
     }
 
     bool isValidChannelMask(audio_channel_mask_t channelMask) const override;
@@ -66,6 +67,11 @@ public:
     void setParameter(int name, int target, int param, void *value) override;
     void setBufferProvider(int name, AudioBufferProvider* bufferProvider);
 
+    // Enables or disables running the reformat and downmix conversions
+    // of each track in a single FusedBufferProvider.
+    // Enabled by default unless the property af.mixer.fuse_providers is false.
+    void setBufferProviderFusion(bool enabled);
+
 private:
 
     struct Track : public TrackBase {
@@ -77,6 +83,7 @@ private:
             // Ensure the order of destruction of buffer providers as they
             // release the upstream provider in the destructor.
             mTimestretchBufferProvider.reset(nullptr);
+            mFusedBufferProvider.reset(nullptr);
             mPostDownmixReformatBufferProvider.reset(nullptr);
             mDownmixerBufferProvider.reset(nullptr);
             mReformatBufferProvider.reset(nullptr);
@@ -124,6 +131,9 @@ private:
          * 6) mPostDownmixReformatBufferProvider: If not NULL, performs reformatting from
          *    the downmixer requirements to the mixer engine input requirements.
          * 7) mTimestretchBufferProvider: Adds timestretching for playback rate
+         *
+         * When more than one of 4) to 6) is present and fusion is enabled, they are
+         * run by mFusedBufferProvider in a single pass per block instead of as a chain.
          */
         AudioBufferProvider* mInputBufferProvider;    // externally provided buffer provider.
         std::unique_ptr<PassthruBufferProvider> mTeeBufferProvider;
@@ -132,6 +142,8 @@ private:
         std::unique_ptr<PassthruBufferProvider> mDownmixerBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mPostDownmixReformatBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mTimestretchBufferProvider;
+        std::unique_ptr<PassthruBufferProvider> mFusedBufferProvider;
+        bool                 mFuseBufferProviders;
 
         audio_format_t mDownmixRequiresFormat;  // required downmixer format
                                                 // AUDIO_FORMAT_PCM_16_BIT if 16 bit necessary
@@ -156,6 +168,8 @@ private:
         return std::static_pointer_cast<Track>(mTracks[name]);
     }
 
+    bool mBufferProviderFusion;
+
     std::shared_ptr<TrackBase> preCreateTrack() override;
     status_t postCreateTrack(TrackBase *track) override;
 
@@ -168,6 +182,7 @@ private:
     static void sInitRoutine();
 
     static pthread_once_t sOnceControl; // initialized in constructor by first new
+    static bool sBufferProviderFusionDefault; // set by sInitRoutine
 };
 
 // ----------------------------------------------------------------------------
@@ -20,6 +20,7 @@
 
 #include <map>
 #include <memory>
+#include <stdlib.h>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -36,6 +37,8 @@
 
 namespace android {
 
+class AudioMixerWorkerPool;
+
 // ----------------------------------------------------------------------------
 
 // AudioMixerBase is functional on its own if only mixing and resampling
@@ -91,12 +94,9 @@ public:
         AUXLEVEL        = 0x4210,
     };
 
-    AudioMixerBase(size_t frameCount, uint32_t sampleRate)
-        : mSampleRate(sampleRate)
-        , mFrameCount(frameCount) {
-    }
+    AudioMixerBase(size_t frameCount, uint32_t sampleRate);
 
-    virtual ~AudioMixerBase() {}
+    virtual ~AudioMixerBase();
 
     virtual bool isValidFormat(audio_format_t format) const;
     virtual bool isValidChannelMask(audio_channel_mask_t channelMask) const;
@@ -137,6 +137,25 @@ public:
 
     size_t      getUnreleasedFrames(int name) const;
 
+    // Enable parallel mixing: groups of at least trackThreshold enabled tracks
+    // sharing a main buffer are partitioned across workerCount helper threads
+    // plus the thread calling process(), each summing into its own buffer.
+    // The partial sums are then reduced into the main buffer.
+    // A workerCount of 0 disables parallel mixing, which is the default.
+    // If cpus is not empty, helper thread i is pinned to cpus[i % cpus.size()].
+    //
+    // Parallel mixing changes the order in which track contributions are summed,
+    // so the float output may differ from the single-threaded mix in the last bits.
+    // Must not be called concurrently with process().
+    void        setParallelMixing(size_t workerCount,
+                        size_t trackThreshold = kDefaultParallelTrackThreshold,
+                        const std::vector<int>& cpus = {});
+
+    size_t      getParallelWorkerCount() const;
+
+    static constexpr size_t kDefaultParallelTrackThreshold = 8;
+    static constexpr size_t kMaxParallelWorkers = 7;
+
     std::string trackNames() const;
 
   protected:
@@ -238,6 +257,10 @@ public:
 
         void track__nop(int32_t* out, size_t numFrames, int32_t* temp, int32_t* aux);
 
+        // Fills mFusedVolume with the volume of each output sample of blockFrames frames,
+        // as applied by track__NoResample() for float input.
+        void updateFusedVolume(size_t blockFrames);
+
         template <int MIXTYPE, bool USEFLOATVOL, bool ADJUSTVOL,
             typename TO, typename TI, typename TA>
         void volumeMix(TO *out, size_t outFrames, const TI *in, TA *aux, bool ramp);
@@ -299,6 +322,12 @@ public:
 
         uint32_t       mInputFrameSize; // The track input frame size, used for tee buffer
 
+        // Set by process__validate() if the track may be mixed together with other
+        // tracks by mixMultiTrack() in process__genericNoResampling().
+        bool           mFusedMix = false;
+        // mVolume applied to each sample of a block of frames, see updateFusedVolume().
+        std::vector<float> mFusedVolume;
+
         // consider volume muted only if all channel volume (floating point) is 0.f
         inline bool isVolumeMuted() const {
             for (const auto volume : mVolume) {
@@ -350,6 +379,7 @@ public:
     void process__nop();
     void process__genericNoResampling();
     void process__genericResampling();
+    void process__parallel();
     void process__oneTrack16BitsStereoNoResampling();
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
@@ -362,6 +392,29 @@ public:
     static void convertMixerFormat(void *out, audio_format_t mixerOutFormat,
             void *in, audio_format_t mixerInFormat, size_t sampleCount);
 
+    // Mixes mFrameCount frames of one track into outTemp, as done by process__genericResampling.
+    void mixTrack(TrackBase *t, int32_t *outTemp, int32_t *resampleTemp);
+
+    // Job executed by each thread of mWorkerPool, see process__parallel().
+    static void mixPartition(void *cookie, size_t index);
+
+    struct AlignedFree {
+        void operator()(int32_t *p) const { free(p); }
+    };
+    using aligned_buffer_t = std::unique_ptr<int32_t[], AlignedFree>;
+
+    // The set of tracks mixed by one thread during process__parallel().
+    // Partition 0 is mixed by the thread calling process() into mOutputTemp;
+    // the other partitions own their output and resampler scratch buffers.
+    struct MixPartition {
+        std::vector<TrackBase *> tracks;
+        size_t cost = 0;                // estimated relative cost of tracks
+        int32_t *outTemp = nullptr;
+        int32_t *resampleTemp = nullptr;
+        aligned_buffer_t outTempBuffer;
+        aligned_buffer_t resampleTempBuffer;
+    };
+
     // initialization constants
     const uint32_t mSampleRate;
     const size_t mFrameCount;
@@ -382,6 +435,17 @@ public:
 
     // track smart pointers, by name, in increasing order of name.
     std::map<int /* name */, std::shared_ptr<TrackBase>> mTracks;
+
+    // parallel mixing state, see setParallelMixing().
+    std::unique_ptr<AudioMixerWorkerPool> mWorkerPool;
+    size_t mParallelTrackThreshold = kDefaultParallelTrackThreshold;
+    std::vector<MixPartition> mPartitions;  // one per thread, index 0 is the caller.
+    size_t mPartitionSampleCount = 0;       // samples per partition buffer in current group.
+
+    // the inputs and volumes of the tracks mixed together by mixMultiTrack(),
+    // see process__genericNoResampling().
+    std::vector<const float *> mFusedInputs;
+    std::vector<const float *> mFusedVolumes;
 };
 
 }  // namespace android
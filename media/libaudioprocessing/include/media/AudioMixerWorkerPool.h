@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_WORKER_POOL_H
+#define ANDROID_AUDIO_MIXER_WORKER_POOL_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+
+namespace android {
+
+// AudioMixerWorkerPool is a small fixed-size pool of helper threads used by
+// AudioMixerBase to mix independent partitions of tracks concurrently, and by
+// the AudioFlinger playback threads to process independent effect chains.
+//
+// The pool is fork-join: run() hands the same job to every worker and to the
+// calling thread, and returns only once all of them have completed.
+// All threads are created up front, so run() does not allocate.
+class AudioMixerWorkerPool {
+public:
+    // job is called with the cookie passed to run() and a partition index.
+    // Index 0 is always executed on the thread calling run().
+    using job_t = void (*)(void *cookie, size_t index);
+
+    // Creates workerCount helper threads.  If cpus is not empty,
+    // helper thread i is pinned to cpus[i % cpus.size()].
+    AudioMixerWorkerPool(size_t workerCount, const std::vector<int>& cpus);
+    ~AudioMixerWorkerPool();
+
+    AudioMixerWorkerPool(const AudioMixerWorkerPool&) = delete;
+    AudioMixerWorkerPool& operator=(const AudioMixerWorkerPool&) = delete;
+
+    size_t getWorkerCount() const { return mWorkers.size(); }
+
+    // Runs job(cookie, i) for i in [0, getWorkerCount()] and waits for completion.
+    // Helper threads track the scheduling policy of the calling thread, so that
+    // a SCHED_FIFO mixer thread is not held back by SCHED_OTHER helpers.
+    // The caller's policy is read on the first run and every kSchedulingCheckRuns
+    // runs after that, so a priority change is picked up within that many cycles.
+    // Not reentrant; must be called from a single thread at a time.
+    void run(job_t job, void *cookie);
+
+private:
+    void threadLoop(size_t index, int cpu);
+    void followCallerScheduling();
+
+    std::mutex mMutex;
+    std::condition_variable mWorkCv;  // signalled when a new generation is posted
+    std::condition_variable mDoneCv;  // signalled when mPending reaches 0
+
+    job_t mJob = nullptr;             // guarded by mMutex
+    void *mCookie = nullptr;          // guarded by mMutex
+    uint64_t mGeneration = 0;         // guarded by mMutex
+    size_t mPending = 0;              // guarded by mMutex
+    bool mExit = false;               // guarded by mMutex
+
+    // Number of runs between two reads of the caller scheduling,
+    // about 0.5 s for a FAST mixer and 5 s for a normal mixer.
+    static constexpr uint32_t kSchedulingCheckRuns = 256;
+
+    // Caller scheduling last applied to the helper threads; only accessed by run().
+    uint32_t mRunsUntilSchedulingCheck = 0;
+    int mPolicy = SCHED_OTHER;
+    int mPriority = 0;
+    bool mSchedulingWarned = false;
+
+    std::vector<std::thread> mWorkers;
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_MIXER_WORKER_POOL_H
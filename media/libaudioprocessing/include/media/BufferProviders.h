@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <vector>
 
 #include <audio_utils/ChannelMix.h>
 #include <media/AudioBufferProvider.h>
@@ -87,6 +88,13 @@ public:
     // of the internal buffers.
     virtual void copyFrames(void *dst, const void *src, size_t frames) = 0;
 
+    // Returns true if copyFrames() has little per call overhead, so it may be
+    // called on short blocks of frames (see FusedBufferProvider).
+    virtual bool isBlockwiseEfficient() const { return true; }
+
+    size_t getInputFrameSize() const { return mInputFrameSize; }
+    size_t getOutputFrameSize() const { return mOutputFrameSize; }
+
 protected:
     const size_t         mInputFrameSize;
     const size_t         mOutputFrameSize;
@@ -107,6 +115,8 @@ public:
     virtual ~DownmixerBufferProvider();
     //Overrides
     virtual void copyFrames(void *dst, const void *src, size_t frames);
+    // Each copyFrames() is a call into the effect HAL.
+    bool isBlockwiseEfficient() const override { return false; }
 
     bool isValid() const { return mDownmixInterface.get() != NULL; }
     static status_t init();
@@ -196,6 +206,36 @@ protected:
     const uint32_t       mChannelCount;
 };
 
+// FusedBufferProvider derives from CopyBufferProvider to run the copyFrames() of
+// a sequence of CopyBufferProviders in a single pass, replacing the chain of those
+// providers and their intermediate buffers.  Each block of frames is passed through
+// all stages using two small scratch buffers which stay cache resident.
+// The stages are not owned and must outlive the FusedBufferProvider.
+class FusedBufferProvider : public CopyBufferProvider {
+public:
+    FusedBufferProvider(const std::vector<CopyBufferProvider *> &stages,
+            size_t bufferFrameCount);
+    //Overrides
+    void copyFrames(void *dst, const void *src, size_t frames) override;
+
+    // Replaces the stages, keeping the local and scratch buffers.  Returns false,
+    // leaving the provider unchanged, if the stages do not convert between the same
+    // input and output frame sizes, in which case a new provider is required.
+    // The caller must reset() the provider first.
+    bool setStages(const std::vector<CopyBufferProvider *> &stages);
+
+    const std::vector<CopyBufferProvider *> &getStages() const { return mStages; }
+
+protected:
+    static size_t getBlockFrameCount(const std::vector<CopyBufferProvider *> &stages,
+            size_t bufferFrameCount);
+
+    const size_t         mBufferFrameCount;
+    std::vector<CopyBufferProvider *> mStages;
+    size_t               mBlockFrameCount = 0; // frames per pass through the stages
+    std::vector<uint8_t> mScratch[2];
+};
+
 // TimestretchBufferProvider derives from PassthruBufferProvider for time stretching
 class TimestretchBufferProvider : public PassthruBufferProvider {
 public:
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <log/log.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioMixer.h>
+
+#include "test_utils.h"
+
+using android::AudioMixer;
+
+// A typical mixer period of 10 ms at 48 kHz.
+static constexpr size_t kFrameCount = 480;
+static constexpr uint32_t kOutputSampleRate = 48000;
+// Inputs hold 1 second at their own rate, rewind them before they run out.
+static constexpr size_t kRewindCycles = kOutputSampleRate / kFrameCount - 10;
+
+/*
+ * Mixes kFrameCount frames per iteration with AudioMixer::process(), to float stereo output.
+ * All inputs are in memory, so no audio device is needed. Channel masks other than
+ * stereo are downmixed by the effects HAL downmixer if present, otherwise by ChannelMix.
+ *
+ * state.range(0) is the number of tracks.
+ * state.range(1) is the track format: 0 for int16_t, 1 for float.
+ * state.range(2) is the track channel count.
+ * state.range(3) is the track sample rate; tracks at other than 48 kHz are resampled.
+ * state.range(4) if not 0, ramps the volume of every track on every iteration.
+ * state.range(5) if not 0, sends every track to an aux buffer.
+ * state.range(6) if not 0, copies every track to a tee buffer, as for tee patches.
+ */
+static void BM_AudioMixer(benchmark::State& state) {
+    const size_t trackCount = state.range(0);
+    const bool useFloat = state.range(1) != 0;
+    const uint32_t channelCount = state.range(2);
+    const uint32_t sampleRate = state.range(3);
+    const bool ramp = state.range(4) != 0;
+    const bool aux = state.range(5) != 0;
+    const bool tee = state.range(6) != 0;
+
+    const audio_format_t format = useFloat ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    const audio_channel_mask_t channelMask = audio_channel_out_mask_from_count(channelCount);
+    const size_t trackFrameSize = channelCount * audio_bytes_per_sample(format);
+
+    std::vector<SignalProvider> providers(trackCount);
+    std::vector<float> output(kFrameCount * FCC_2);
+    std::vector<int32_t> auxBuffer(kFrameCount);
+    std::vector<std::vector<uint8_t>> teeBuffers(tee ? trackCount : 0);
+    AudioMixer mixer(kFrameCount, kOutputSampleRate);
+    const float volume = AudioMixer::UNITY_GAIN_FLOAT / trackCount;
+    const float auxLevel = 0.5f;
+
+    for (size_t i = 0; i < trackCount; ++i) {
+        const double frequency = 200. + 50. * i;
+        if (useFloat) {
+            providers[i].setSine<float>(channelCount, frequency, sampleRate, 1. /* time */);
+        } else {
+            providers[i].setSine<int16_t>(channelCount, frequency, sampleRate, 1. /* time */);
+        }
+        const int name = i;
+        const android::status_t status = mixer.create(
+                name, channelMask, format, AUDIO_SESSION_OUTPUT_MIX);
+        LOG_ALWAYS_FATAL_IF(status != android::OK, "cannot create track %d", name);
+        mixer.setBufferProvider(name, &providers[i]);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, output.data());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+        mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                (void *)(uintptr_t)sampleRate);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, (void *)&volume);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, (void *)&volume);
+        if (aux) {
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::AUX_BUFFER,
+                    auxBuffer.data());
+            mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::AUXLEVEL,
+                    (void *)&auxLevel);
+        }
+        if (tee) {
+            teeBuffers[i].resize(kFrameCount * trackFrameSize);
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::TEE_BUFFER_FRAME_COUNT,
+                    (void *)(uintptr_t)kFrameCount);
+            mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::TEE_BUFFER,
+                    teeBuffers[i].data());
+        }
+        mixer.enable(name);
+    }
+
+    size_t cycle = 0;
+    while (state.KeepRunning()) {
+        if (++cycle % kRewindCycles == 0) {
+            state.PauseTiming();
+            for (auto &provider : providers) {
+                provider.reset();
+            }
+            state.ResumeTiming();
+        }
+        if (ramp) {
+            // alternate between two volumes so that every process() ramps.
+            const float rampVolume = (cycle & 1) ? volume : volume * 0.5f;
+            for (size_t i = 0; i < trackCount; ++i) {
+                mixer.setParameter(i, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0,
+                        (void *)&rampVolume);
+                mixer.setParameter(i, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1,
+                        (void *)&rampVolume);
+            }
+        }
+        mixer.process();
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+    state.counters["ns_per_frame"] = benchmark::Counter(kFrameCount * 1e-9,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["ns_per_track_frame"] = benchmark::Counter(kFrameCount * trackCount * 1e-9,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+static void AudioMixerArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"tracks", "float", "channels", "rate", "ramp", "aux", "tee"});
+    // track count scaling of the common case: stereo tracks at the output rate.
+    for (int tracks : {1, 4, 16, 32}) {
+        for (int useFloat : {0, 1}) {
+            b->Args({tracks, useFloat, 2, 48000, 0, 0, 0});
+        }
+    }
+    // resampling ratios.
+    for (int rate : {8000, 44100, 96000}) {
+        b->Args({8, 1, 2, rate, 0, 0, 0});
+    }
+    // channel conversion of mono and multichannel content, with and without resampling.
+    for (int channels : {1, 6, 8}) {
+        for (int rate : {44100, 48000}) {
+            b->Args({4, 1, channels, rate, 0, 0, 0});
+        }
+    }
+    // volume ramps, aux sends and tee patches.
+    b->Args({8, 1, 2, 48000, 1, 0, 0});
+    b->Args({8, 1, 2, 44100, 1, 0, 0});
+    b->Args({8, 1, 2, 48000, 0, 1, 0});
+    b->Args({8, 1, 2, 48000, 0, 0, 1});
+    b->Args({8, 0, 6, 44100, 1, 1, 1});
+}
+
+BENCHMARK(BM_AudioMixer)->Apply(AudioMixerArgs);
+
+BENCHMARK_MAIN();
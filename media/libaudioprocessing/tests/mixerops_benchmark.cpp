@@ -16,9 +16,11 @@
 
 #include <inttypes.h>
 #include <type_traits>
+#include <vector>
 #define LOG_ALWAYS_FATAL(...)
 
 #include <../AudioMixerOps.h>
+#include <../AudioMixerOpsVector.h>
 #include <benchmark/benchmark.h>
 
 using namespace android;
@@ -72,6 +74,117 @@ static void BM_VolumeMulti(benchmark::State& state) {
     }
 }
 
+// Vector kernels, with the instruction set selected by state.range(0).
+template <int MIXTYPE, int NCHAN>
+static void BM_VolumeRampMultiVector(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    const MixerOpsIsa isa = static_cast<MixerOpsIsa>(state.range(0));
+    if (!isMixerOpsIsaSupported(isa)) {
+        state.SkipWithError("instruction set not supported");
+        return;
+    }
+    state.SetLabel(toString(isa));
+
+    // data inialized to 0.
+    float out[SAMPLE_COUNT]{};
+    float in[SAMPLE_COUNT]{};
+    float aux[FRAME_COUNT]{};
+
+    // volume initialized to 0
+    float vola = 0.f;
+    float vol[2] = {0.f, 0.f};
+
+    // some volume increment
+    float volainc = 0.01f;
+    float volinc[2] = {0.01f, 0.01f};
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        volumeRampMultiVector<MIXTYPE, NCHAN>(
+                isa, out, FRAME_COUNT, in, aux, vol, volinc, &vola, volainc);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT);
+}
+
+template <int MIXTYPE, int NCHAN>
+static void BM_VolumeMultiVector(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    const MixerOpsIsa isa = static_cast<MixerOpsIsa>(state.range(0));
+    if (!isMixerOpsIsaSupported(isa)) {
+        state.SkipWithError("instruction set not supported");
+        return;
+    }
+    state.SetLabel(toString(isa));
+
+    // data inialized to 0.
+    float out[SAMPLE_COUNT]{};
+    float in[SAMPLE_COUNT]{};
+    float aux[FRAME_COUNT]{};
+
+    // volume initialized to 0
+    float vola = 0.f;
+    float vol[2] = {0.f, 0.f};
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        volumeMultiVector<MIXTYPE, NCHAN>(isa, out, FRAME_COUNT, in, aux, vol, vola);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT);
+}
+
+// Mixes state.range(0) stereo tracks in blocks of 16 frames, as process__genericNoResampling()
+// does, either one track at a time (state.range(1) == 0) or all at once by mixMultiTrack().
+static void BM_MixTracks(benchmark::State& state) {
+    constexpr size_t BLOCK_FRAMES = 16;
+    constexpr size_t FRAME_COUNT = 960;
+    constexpr size_t NCHAN = 2;
+    const size_t trackCount = state.range(0);
+    const bool fused = state.range(1) != 0;
+
+    std::vector<std::vector<float>> in(trackCount, std::vector<float>(FRAME_COUNT * NCHAN));
+    // per sample volume for a block, as built by updateFusedVolume().
+    const std::vector<float> blockVolume(BLOCK_FRAMES * NCHAN, 0.5f);
+    const float vol[2] = {0.5f, 0.5f};
+    std::vector<const float *> inputs(trackCount);
+    std::vector<const float *> volumes(trackCount, blockVolume.data());
+    float out[BLOCK_FRAMES * NCHAN];
+
+    while (state.KeepRunning()) {
+        for (size_t frame = 0; frame < FRAME_COUNT; frame += BLOCK_FRAMES) {
+            std::fill(std::begin(out), std::end(out), 0.f);
+            const size_t offset = frame * NCHAN;
+            if (fused) {
+                for (size_t t = 0; t < trackCount; ++t) {
+                    inputs[t] = in[t].data() + offset;
+                }
+                mixMultiTrack(out, BLOCK_FRAMES * NCHAN, inputs.data(), volumes.data(),
+                        trackCount);
+            } else {
+                for (size_t t = 0; t < trackCount; ++t) {
+                    volumeMulti<MIXTYPE_MULTI_STEREOVOL, NCHAN>(out, BLOCK_FRAMES,
+                            in[t].data() + offset, (float *)nullptr, vol, 0.f);
+                }
+            }
+            benchmark::DoNotOptimize(out);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT * trackCount);
+}
+
+static void VectorIsaArgs(benchmark::internal::Benchmark* b) {
+    for (const MixerOpsIsa isa : { MixerOpsIsa::SSE4_1, MixerOpsIsa::AVX2,
+            MixerOpsIsa::NEON }) {
+        b->Arg(static_cast<int>(isa));
+    }
+}
+
 // MULTI mode and MULTI_SAVEONLY mode are not used by AudioMixer for channels > 2,
 // which is ensured by a static_assert (won't compile for those configurations).
 // So we benchmark MIXTYPE_MULTI_MONOVOL and MIXTYPE_MULTI_SAVEONLY_MONOVOL compared
@@ -101,4 +214,19 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiVector, MIXTYPE_MULTI_STEREOVOL, 2)->Apply(VectorIsaArgs);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiVector, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 2)
+        ->Apply(VectorIsaArgs);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiVector, MIXTYPE_MULTI_STEREOVOL, 8)->Apply(VectorIsaArgs);
+BENCHMARK_TEMPLATE(BM_VolumeRampMultiVector, MIXTYPE_MULTI_MONOVOL, 8)->Apply(VectorIsaArgs);
+
+BENCHMARK_TEMPLATE(BM_VolumeMultiVector, MIXTYPE_MULTI_STEREOVOL, 2)->Apply(VectorIsaArgs);
+BENCHMARK_TEMPLATE(BM_VolumeMultiVector, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 2)
+        ->Apply(VectorIsaArgs);
+BENCHMARK_TEMPLATE(BM_VolumeMultiVector, MIXTYPE_MULTI_STEREOVOL, 8)->Apply(VectorIsaArgs);
+BENCHMARK_TEMPLATE(BM_VolumeMultiVector, MIXTYPE_MULTI_MONOVOL, 8)->Apply(VectorIsaArgs);
+
+BENCHMARK(BM_MixTracks)->ArgNames({"tracks", "fused"})
+        ->ArgsProduct({{4, 16, 64}, {0, 1}});
+
 BENCHMARK_MAIN();
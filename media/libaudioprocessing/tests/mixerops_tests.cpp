@@ -19,9 +19,12 @@
 #include <log/log.h>
 
 #include <inttypes.h>
+#include <random>
 #include <type_traits>
+#include <vector>
 
 #include <../AudioMixerOps.h>
+#include <../AudioMixerOpsVector.h>
 #include <gtest/gtest.h>
 
 using namespace android;
@@ -173,3 +176,202 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+
+// The vector kernels in AudioMixerOpsVector.h must be bit-exact with the scalar templates,
+// for every instruction set supported by the device running the test.
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV, typename TAV>
+class MixerOpsVectorTest {
+public:
+    static void testBitExact(bool ramp, bool useAux) {
+        for (const MixerOpsIsa isa : { MixerOpsIsa::SSE4_1, MixerOpsIsa::AVX2,
+                MixerOpsIsa::NEON }) {
+            if (!isMixerOpsIsaSupported(isa)) continue;
+            SCOPED_TRACE(toString(isa));
+            // odd frame counts exercise the scalar completion of partial vectors and blocks.
+            for (const size_t frameCount : { 1, 7, 16, 33, 480 }) {
+                testBitExact(isa, frameCount, ramp, useAux);
+            }
+        }
+    }
+
+private:
+    static void testBitExact(MixerOpsIsa isa, size_t frameCount, bool ramp, bool useAux) {
+        std::minstd_rand gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::vector<TI> in(frameCount * NCHAN);
+        for (auto& sample : in) {
+            if constexpr (std::is_same_v<TI, float>) {
+                sample = dist(gen);
+            } else {
+                sample = dist(gen) * INT16_MAX;
+            }
+        }
+        std::vector<TO> outScalar(frameCount * NCHAN);
+        for (auto& sample : outScalar) {
+            if constexpr (std::is_same_v<TO, float>) {
+                sample = dist(gen);
+            } else {
+                sample = dist(gen) * (1 << 20);
+            }
+        }
+        std::vector<float> auxScalar(frameCount);
+        for (auto& sample : auxScalar) {
+            sample = dist(gen);
+        }
+        std::vector<TO> outVector = outScalar;
+        std::vector<float> auxVector = auxScalar;
+
+        TV volScalar[2];
+        TV volinc[2];
+        TAV volaScalar;
+        TAV volainc;
+        if constexpr (std::is_same_v<TV, float>) {
+            volScalar[0] = 0.3f;
+            volScalar[1] = 0.77f;
+            volinc[0] = 1e-3f;
+            volinc[1] = -7e-4f;
+            volaScalar = 0.2f;
+            volainc = 3e-3f;
+        } else if constexpr (std::is_same_v<TV, int32_t>) { // U4.28
+            volScalar[0] = 0x4000000;
+            volScalar[1] = 0x9000000;
+            volinc[0] = 12345;
+            volinc[1] = -2345;
+            volaScalar = 0x3000000;
+            volainc = 1000;
+        } else { // U4.12
+            volScalar[0] = 0x400;
+            volScalar[1] = 0x900;
+            volinc[0] = volinc[1] = 0;
+            volaScalar = 0x300;
+            volainc = 0;
+        }
+        TV volVector[2] = { volScalar[0], volScalar[1] };
+        TAV volaVector = volaScalar;
+        float * const auxs = useAux ? auxScalar.data() : nullptr;
+        float * const auxv = useAux ? auxVector.data() : nullptr;
+
+        if (ramp) {
+            volumeRampMulti<MIXTYPE, NCHAN>(outScalar.data(), frameCount, in.data(), auxs,
+                    volScalar, volinc, &volaScalar, volainc);
+            ASSERT_TRUE(volumeRampMultiVector<MIXTYPE, NCHAN>(isa, outVector.data(), frameCount,
+                    in.data(), auxv, volVector, volinc, &volaVector, volainc));
+        } else {
+            volumeMulti<MIXTYPE, NCHAN>(outScalar.data(), frameCount, in.data(), auxs,
+                    volScalar, volaScalar);
+            ASSERT_TRUE(volumeMultiVector<MIXTYPE, NCHAN>(isa, outVector.data(), frameCount,
+                    in.data(), auxv, volVector, volaVector));
+        }
+        EXPECT_EQ(0, memcmp(outScalar.data(), outVector.data(), outScalar.size() * sizeof(TO)));
+        EXPECT_EQ(0, memcmp(auxScalar.data(), auxVector.data(), auxScalar.size() * sizeof(float)));
+        EXPECT_EQ(0, memcmp(volScalar, volVector, sizeof(volScalar)));
+        EXPECT_EQ(0, memcmp(&volaScalar, &volaVector, sizeof(volaScalar)));
+    }
+};
+
+template <int MIXTYPE, int NCHAN>
+static void testVectorBitExact() {
+    for (const bool useAux : { false, true }) {
+        SCOPED_TRACE(useAux ? "aux" : "no aux");
+        MixerOpsVectorTest<MIXTYPE, NCHAN, float, float, float, float>::testBitExact(
+                false /* ramp */, useAux);
+        MixerOpsVectorTest<MIXTYPE, NCHAN, float, float, float, float>::testBitExact(
+                true /* ramp */, useAux);
+        MixerOpsVectorTest<MIXTYPE, NCHAN, int32_t, int16_t, int16_t, int16_t>::testBitExact(
+                false /* ramp */, useAux);
+        MixerOpsVectorTest<MIXTYPE, NCHAN, int32_t, int16_t, int32_t, int32_t>::testBitExact(
+                true /* ramp */, useAux);
+    }
+}
+
+TEST(mixerops, vector_multi_1) {
+    testVectorBitExact<MIXTYPE_MULTI, 1>();
+}
+TEST(mixerops, vector_multi_2) {
+    testVectorBitExact<MIXTYPE_MULTI, 2>();
+}
+TEST(mixerops, vector_multi_saveonly_2) {
+    testVectorBitExact<MIXTYPE_MULTI_SAVEONLY, 2>();
+}
+TEST(mixerops, vector_multi_monovol_6) {
+    testVectorBitExact<MIXTYPE_MULTI_MONOVOL, 6>();
+}
+TEST(mixerops, vector_multi_saveonly_monovol_8) {
+    testVectorBitExact<MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8>();
+}
+TEST(mixerops, vector_stereovolume_2) {
+    testVectorBitExact<MIXTYPE_MULTI_STEREOVOL, 2>();
+}
+TEST(mixerops, vector_stereovolume_3) {
+    testVectorBitExact<MIXTYPE_MULTI_STEREOVOL, 3>();
+}
+TEST(mixerops, vector_stereovolume_6) {
+    testVectorBitExact<MIXTYPE_MULTI_STEREOVOL, 6>();
+}
+TEST(mixerops, vector_stereovolume_8) {
+    testVectorBitExact<MIXTYPE_MULTI_STEREOVOL, 8>();
+}
+TEST(mixerops, vector_saveonly_stereovolume_5) {
+    testVectorBitExact<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 5>();
+}
+TEST(mixerops, vector_stereovolume_12) {
+    if constexpr (FCC_LIMIT >= 12) {
+        testVectorBitExact<MIXTYPE_MULTI_STEREOVOL, 12>();
+    }
+}
+
+// mixMultiTrack() must be bit-exact with mixing each track by volumeMulti() in turn,
+// using the per-channel volumes obtained from the SAVEONLY mixtype on unity samples.
+template <int NCHAN>
+static void testMixMultiTrack() {
+    constexpr size_t kTrackCount = 5;
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    for (const size_t frameCount : { 1, 3, 16, 33 }) {
+        const size_t sampleCount = frameCount * NCHAN;
+        std::vector<std::vector<float>> in(kTrackCount);
+        std::vector<std::vector<float>> vol(kTrackCount);
+        std::vector<float> outSequential(sampleCount);
+        for (auto& sample : outSequential) {
+            sample = dist(gen);
+        }
+        std::vector<float> outFused = outSequential;
+        std::vector<const float *> inPtrs;
+        std::vector<const float *> volPtrs;
+        for (size_t t = 0; t < kTrackCount; ++t) {
+            const float volume[2] = { dist(gen), dist(gen) };
+            in[t].resize(sampleCount);
+            for (auto& sample : in[t]) {
+                sample = dist(gen);
+            }
+            volumeMulti<MIXTYPE_MULTI_STEREOVOL, NCHAN>(outSequential.data(), frameCount,
+                    in[t].data(), (float *)nullptr, volume, 0.f);
+
+            const std::vector<float> unity(NCHAN, 1.f);
+            vol[t].resize(sampleCount);
+            volumeMulti<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN>(vol[t].data(), 1,
+                    unity.data(), (float *)nullptr, volume, 0.f);
+            for (size_t i = 1; i < frameCount; ++i) {
+                std::copy_n(vol[t].begin(), NCHAN, vol[t].begin() + i * NCHAN);
+            }
+            inPtrs.push_back(in[t].data());
+            volPtrs.push_back(vol[t].data());
+        }
+        mixMultiTrack(outFused.data(), sampleCount, inPtrs.data(), volPtrs.data(), kTrackCount);
+        EXPECT_EQ(0, memcmp(outSequential.data(), outFused.data(), sampleCount * sizeof(float)))
+                << "frameCount " << frameCount;
+    }
+}
+
+TEST(mixerops, multitrack_1) {
+    testMixMultiTrack<1>();
+}
+TEST(mixerops, multitrack_2) {
+    testMixMultiTrack<2>();
+}
+TEST(mixerops, multitrack_6) {
+    testMixMultiTrack<6>();
+}
+TEST(mixerops, multitrack_8) {
+    testMixMultiTrack<8>();
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <log/log.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioResampler.h>
+
+#include "test_utils.h"
+
+using android::AudioResampler;
+
+// Output frames per call, a typical mixer buffer.
+static constexpr size_t kFrameCount = 480;
+static constexpr int32_t kOutputSampleRate = 48000;
+
+/*
+ * Resamples kFrameCount frames per iteration.
+ *
+ * state.range(0) is the input format: 0 for int16_t, 1 for float.
+ * state.range(1) is the channel count.
+ * state.range(2) is the input sample rate; the output sample rate is 48 kHz.
+ * state.range(3) is the resampler quality (AudioResampler::src_quality).
+ *
+ * The dynamic resampler qualities select the filter length from the ratio,
+ * so the sweep covers the different tap counts, and 44.1 kHz covers the
+ * interpolated (non-locked) phase path.
+ */
+static void BM_Resample(benchmark::State& state) {
+    const bool useFloat = state.range(0) != 0;
+    const int channels = state.range(1);
+    const int32_t inputSampleRate = state.range(2);
+    const auto quality = static_cast<AudioResampler::src_quality>(state.range(3));
+
+    SignalProvider provider;
+    if (useFloat) {
+        provider.setSine<float>(channels, 1000. /* freq */, inputSampleRate, 1. /* time */);
+    } else {
+        provider.setSine<int16_t>(channels, 1000. /* freq */, inputSampleRate, 1. /* time */);
+    }
+
+    std::unique_ptr<AudioResampler> resampler(AudioResampler::create(
+            useFloat ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT,
+            channels, kOutputSampleRate, quality));
+    resampler->setSampleRate(inputSampleRate);
+    resampler->setVolume(AudioResampler::UNITY_GAIN_FLOAT, AudioResampler::UNITY_GAIN_FLOAT);
+
+    // the resampler output is stereo for mono input.
+    std::vector<int32_t> out(kFrameCount * std::max(channels, 2));
+    while (state.KeepRunning()) {
+        // the resampler accumulates into the output buffer.
+        std::fill(out.begin(), out.end(), 0);
+        if (resampler->resample(out.data(), kFrameCount, &provider) < kFrameCount) {
+            state.PauseTiming();
+            provider.reset();
+            state.ResumeTiming();
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void ResampleArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"float", "channels", "rate", "quality"});
+    for (int useFloat : {0, 1}) {
+        for (int channels : {1, 2, 8}) {
+            for (int rate : {16000, 44100, 96000, 192000}) {
+                for (int quality : {AudioResampler::DYN_LOW_QUALITY,
+                        AudioResampler::DYN_MED_QUALITY,
+                        AudioResampler::DYN_HIGH_QUALITY}) {
+                    b->Args({useFloat, channels, rate, quality});
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Resample)->Apply(ResampleArgs);
+
+BENCHMARK_MAIN();
@@ -601,3 +601,40 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers requiring the same filter share one set of coefficients,
+// independent of the channel count; the filter is freed with the last user.
+TEST(audioflinger_resampler, sharedfilter) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto createResampler = [](int channels, int32_t inSampleRate) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        android::AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT,
+                                channels,
+                                48000 /* sampleRate */,
+                                android::AudioResampler::DYN_HIGH_QUALITY)));
+        rdyn->setSampleRate(inSampleRate);
+        return rdyn;
+    };
+
+    auto stereo = createResampler(2 /* channels */, 44100);
+    auto stereo2 = createResampler(2 /* channels */, 44100);
+    auto multichannel = createResampler(8 /* channels */, 44100);
+    auto other = createResampler(2 /* channels */, 96000);
+    ASSERT_NE(nullptr, stereo->getFilterCoefs());
+    EXPECT_EQ(stereo->getFilterCoefs(), stereo2->getFilterCoefs());
+    EXPECT_EQ(stereo->getFilterCoefs(), multichannel->getFilterCoefs());
+    EXPECT_NE(stereo->getFilterCoefs(), other->getFilterCoefs());
+    EXPECT_EQ(stereo->getFilterAttenuation(), multichannel->getFilterAttenuation());
+    EXPECT_EQ(stereo->getPassbandRippleDb(), multichannel->getPassbandRippleDb());
+
+    // a filter remains valid while in use; changing the rate switches to another filter.
+    std::vector<float> coefs(stereo->getFilterCoefs(),
+            stereo->getFilterCoefs() + (stereo->getPhases() + 1) * stereo->getHalfLength());
+    stereo2->setSampleRate(96000);
+    EXPECT_EQ(other->getFilterCoefs(), stereo2->getFilterCoefs());
+    stereo.reset();
+    EXPECT_EQ(0, memcmp(coefs.data(), multichannel->getFilterCoefs(),
+            coefs.size() * sizeof(float)));
+}
@@ -14,9 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <stdio.h>
 #include <inttypes.h>
 #include <math.h>
+#include <time.h>
 #include <vector>
 #include <audio_utils/primitives.h>
 #include <audio_utils/sndfile.h>
@@ -36,13 +38,20 @@
 using namespace android;
 
 static void usage(const char* name) {
-    fprintf(stderr, "Usage: %s [-f] [-m] [-c channels]"
+    fprintf(stderr, "Usage: %s [-f] [-m] [-c channels] [-p workers]"
                     " [-s sample-rate] [-o <output-file>] [-a <aux-buffer-file>] [-P csv]"
                     " (<input-file> | <command>)+\n", name);
+    fprintf(stderr, "       %s -b [-f] [-m] [-c channels] [-p workers] [-s sample-rate]\n", name);
+    fprintf(stderr, "       %s -t [-f] [-m] [-s sample-rate]\n", name);
     fprintf(stderr, "    -f    enable floating point input track by default\n");
     fprintf(stderr, "    -m    enable floating point mixer output\n");
     fprintf(stderr, "    -c    number of mixer output channels\n");
     fprintf(stderr, "    -s    mixer sample-rate\n");
+    fprintf(stderr, "    -p    number of parallel mixing worker threads (default 0)\n");
+    fprintf(stderr, "    -b    benchmark per-cycle mix time for 8, 16, 32 and 64 tracks,\n");
+    fprintf(stderr, "          single-threaded and with -p workers (default 3)\n");
+    fprintf(stderr, "    -t    benchmark per-track conversion time for 5.1 and 7.1 tracks\n");
+    fprintf(stderr, "          mixed to stereo, with and without buffer provider fusion\n");
     fprintf(stderr, "    -o    <output-file> WAV file, pcm16 (or float if -m specified)\n");
     fprintf(stderr, "    -a    <aux-buffer-file>\n");
     fprintf(stderr, "    -P    # frames provided per call to resample() in CSV format\n");
@@ -90,11 +99,184 @@ const char *parseFormat(const char *s, bool *useFloat) {
     return s;
 }
 
+static double elapsedUs(const struct timespec &start, const struct timespec &end) {
+    return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) * 1e-3;
+}
+
+// Measures AudioMixer::process() time per mix cycle for a range of track counts,
+// comparing the single-threaded mixer with parallel mixing on workerCount threads.
+// Odd tracks are resampled from 44.1 kHz, even tracks play at the mixer rate.
+static int benchmarkMixer(bool useInputFloat, bool useMixerFloat,
+        uint32_t outputSampleRate, uint32_t outputChannels, size_t workerCount) {
+    static const size_t kTrackCounts[] = { 8, 16, 32, 64 };
+    static const size_t kWarmupCycles = 10;
+    static const size_t kCycles = 2000;
+    static const size_t kResetCycles = 100; // rewind inputs before 1 second is consumed
+    const size_t mixerFrameCount = 320;
+    const audio_format_t inputFormat = useInputFloat
+            ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    const audio_format_t mixerFormat = useMixerFloat
+            ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    const audio_channel_mask_t outputChannelMask =
+            audio_channel_out_mask_from_count(outputChannels);
+    std::vector<uint8_t> output(mixerFrameCount * outputChannels * sizeof(float));
+
+    printf("%zu frames per cycle at %u Hz, %s input, %s mixer output\n",
+            mixerFrameCount, outputSampleRate,
+            useInputFloat ? "float" : "i16", useMixerFloat ? "float" : "i16");
+    for (const size_t trackCount : kTrackCounts) {
+        for (const size_t workers : { (size_t)0, workerCount }) {
+            std::vector<SignalProvider> providers(trackCount);
+            AudioMixer mixer(mixerFrameCount, outputSampleRate);
+            mixer.setParallelMixing(workers);
+            const float volume = AudioMixer::UNITY_GAIN_FLOAT / trackCount;
+
+            for (size_t i = 0; i < trackCount; ++i) {
+                const uint32_t sampleRate = (i & 1) ? 44100 : outputSampleRate;
+                const double frequency = 200. + 50. * i;
+                if (useInputFloat) {
+                    providers[i].setSine<float>(2, frequency, sampleRate, 1.);
+                } else {
+                    providers[i].setSine<int16_t>(2, frequency, sampleRate, 1.);
+                }
+                const int name = i;
+                const status_t status = mixer.create(
+                        name, AUDIO_CHANNEL_OUT_STEREO, inputFormat, AUDIO_SESSION_OUTPUT_MIX);
+                LOG_ALWAYS_FATAL_IF(status != OK);
+                mixer.setBufferProvider(name, &providers[i]);
+                mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER,
+                        output.data());
+                mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                        (void *)(uintptr_t)mixerFormat);
+                mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::FORMAT,
+                        (void *)(uintptr_t)inputFormat);
+                mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                        (void *)(uintptr_t)outputChannelMask);
+                mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
+                        (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+                mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                        (void *)(uintptr_t)sampleRate);
+                mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0,
+                        (void *)&volume);
+                mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1,
+                        (void *)&volume);
+                mixer.enable(name);
+            }
+
+            double totalUs = 0;
+            double maxUs = 0;
+            for (size_t cycle = 0; cycle < kWarmupCycles + kCycles; ++cycle) {
+                if (cycle % kResetCycles == 0) {
+                    for (auto &provider : providers) {
+                        provider.reset();
+                    }
+                }
+                struct timespec start, end;
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                mixer.process();
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                if (cycle >= kWarmupCycles) {
+                    const double us = elapsedUs(start, end);
+                    totalUs += us;
+                    maxUs = std::max(maxUs, us);
+                }
+            }
+            printf("tracks:%3zu  workers:%zu  mean:%8.1f us/cycle  max:%8.1f us/cycle\n",
+                    trackCount, mixer.getParallelWorkerCount(), totalUs / kCycles, maxUs);
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+static int benchmarkTrackConversion(bool useInputFloat, bool useMixerFloat,
+        uint32_t outputSampleRate) {
+    static const audio_channel_mask_t kChannelMasks[] = {
+            AUDIO_CHANNEL_OUT_5POINT1, AUDIO_CHANNEL_OUT_7POINT1 };
+    static const float kSpeeds[] = { 1.f, 1.25f };
+    static const size_t kTrackCount = 8;
+    static const size_t kWarmupCycles = 10;
+    static const size_t kCycles = 2000;
+    static const size_t kResetCycles = 50; // rewind inputs before 1 second is consumed
+    const size_t mixerFrameCount = 320;
+    const audio_format_t inputFormat = useInputFloat
+            ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    const audio_format_t mixerFormat = useMixerFloat
+            ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    std::vector<uint8_t> output(mixerFrameCount * FCC_2 * sizeof(float));
+
+    printf("%zu tracks, %zu frames per cycle at %u Hz, %s input, %s mixer output\n",
+            kTrackCount, mixerFrameCount, outputSampleRate,
+            useInputFloat ? "float" : "i16", useMixerFloat ? "float" : "i16");
+    for (const audio_channel_mask_t channelMask : kChannelMasks) {
+        const uint32_t channelCount = audio_channel_count_from_out_mask(channelMask);
+        for (const float speed : kSpeeds) {
+            for (const bool fusion : { false, true }) {
+                std::vector<SignalProvider> providers(kTrackCount);
+                AudioMixer mixer(mixerFrameCount, outputSampleRate);
+                mixer.setBufferProviderFusion(fusion);
+                const float volume = AudioMixer::UNITY_GAIN_FLOAT / kTrackCount;
+                const AudioPlaybackRate playbackRate = {
+                        speed, 1.f /* pitch */,
+                        AUDIO_TIMESTRETCH_STRETCH_DEFAULT, AUDIO_TIMESTRETCH_FALLBACK_DEFAULT };
+
+                for (size_t i = 0; i < kTrackCount; ++i) {
+                    const double frequency = 200. + 50. * i;
+                    if (useInputFloat) {
+                        providers[i].setSine<float>(
+                                channelCount, frequency, outputSampleRate, 1.);
+                    } else {
+                        providers[i].setSine<int16_t>(
+                                channelCount, frequency, outputSampleRate, 1.);
+                    }
+                    const int name = i;
+                    const status_t status = mixer.create(
+                            name, channelMask, inputFormat, AUDIO_SESSION_OUTPUT_MIX);
+                    LOG_ALWAYS_FATAL_IF(status != OK);
+                    mixer.setBufferProvider(name, &providers[i]);
+                    mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER,
+                            output.data());
+                    mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                            (void *)(uintptr_t)mixerFormat);
+                    mixer.setParameter(name, AudioMixer::TIMESTRETCH,
+                            AudioMixer::PLAYBACK_RATE, (void *)&playbackRate);
+                    mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0,
+                            (void *)&volume);
+                    mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1,
+                            (void *)&volume);
+                    mixer.enable(name);
+                }
+
+                double totalUs = 0;
+                for (size_t cycle = 0; cycle < kWarmupCycles + kCycles; ++cycle) {
+                    if (cycle % kResetCycles == 0) {
+                        for (auto &provider : providers) {
+                            provider.reset();
+                        }
+                    }
+                    struct timespec start, end;
+                    clock_gettime(CLOCK_MONOTONIC, &start);
+                    mixer.process();
+                    clock_gettime(CLOCK_MONOTONIC, &end);
+                    if (cycle >= kWarmupCycles) {
+                        totalUs += elapsedUs(start, end);
+                    }
+                }
+                printf("channels:%u  speed:%.2f  fusion:%d  mean:%7.2f us/track/cycle\n",
+                        channelCount, speed, fusion, totalUs / kCycles / kTrackCount);
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
     const char* const progname = argv[0];
     bool useInputFloat = false;
     bool useMixerFloat = false;
     bool useRamp = true;
+    bool benchmark = false;
+    bool benchmarkConversion = false;
+    int workerCount = -1; // not specified
     uint32_t outputSampleRate = 48000;
     uint32_t outputChannels = 2; // stereo for now
     std::vector<int> Pvalues;
@@ -104,7 +286,7 @@ int main(int argc, char* argv[]) {
     std::vector<SignalProvider> providers;
     std::vector<audio_format_t> formats;
 
-    for (int ch; (ch = getopt(argc, argv, "fmc:s:o:a:P:")) != -1;) {
+    for (int ch; (ch = getopt(argc, argv, "fmbtc:p:s:o:a:P:")) != -1;) {
         switch (ch) {
         case 'f':
             useInputFloat = true;
@@ -112,9 +294,18 @@ int main(int argc, char* argv[]) {
         case 'm':
             useMixerFloat = true;
             break;
+        case 'b':
+            benchmark = true;
+            break;
+        case 't':
+            benchmarkConversion = true;
+            break;
         case 'c':
             outputChannels = atoi(optarg);
             break;
+        case 'p':
+            workerCount = atoi(optarg);
+            break;
         case 's':
             outputSampleRate = atoi(optarg);
             break;
@@ -139,6 +330,14 @@ int main(int argc, char* argv[]) {
     argc -= optind;
     argv += optind;
 
+    if (benchmark) {
+        return benchmarkMixer(useInputFloat, useMixerFloat, outputSampleRate, outputChannels,
+                workerCount < 0 ? 3 : workerCount);
+    }
+    if (benchmarkConversion) {
+        return benchmarkTrackConversion(useInputFloat, useMixerFloat, outputSampleRate);
+    }
+
     if (argc == 0) {
         usage(progname);
         return EXIT_FAILURE;
@@ -233,6 +432,9 @@ int main(int argc, char* argv[]) {
     // create the mixer.
     const size_t mixerFrameCount = 320; // typical numbers may range from 240 or 960
     AudioMixer *mixer = new AudioMixer(mixerFrameCount, outputSampleRate);
+    if (workerCount > 0) {
+        mixer->setParallelMixing(workerCount);
+    }
     audio_format_t mixerFormat = useMixerFloat
             ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
     float f = AudioMixer::UNITY_GAIN_FLOAT / providers.size(); // normalize volume by # tracks
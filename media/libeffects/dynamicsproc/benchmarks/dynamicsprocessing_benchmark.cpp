@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DPFrequency.h"
+
+/*
+ * DPFrequency with all the stages enabled, in ns per frame.
+ * Args: channel count, band count of each of pre EQ, MBC and post EQ, block size.
+ *
+ * The blocks are the ones the effect configures for a preferred frame duration
+ * of 10 ms (512) and 40 ms (2048) at 48 kHz, with half of the block overlapping.
+ *
+ * On an x86-64 host (noisy, single core), block of 512, 4 bands, time_per_frame:
+ * channels   Eigen FFT   RealFft
+ *        1      79 ns      54 ns
+ *        2     151 ns      64 ns
+ *        8     490 ns     370 ns
+ */
+
+constexpr size_t kSampleRate = 48000;
+constexpr size_t kFrameCount = 1024;
+
+static void configureBands(dp_fx::DPFrequency& dp, size_t channelCount, size_t bandCount) {
+    for (size_t ch = 0; ch < channelCount; ch++) {
+        dp_fx::DPChannel* channel = dp.getChannel(ch);
+        channel->setInputGain(-1.f);
+        channel->setOutputGain(1.f);
+        for (dp_fx::DPEq* eq : {channel->getPreEq(), channel->getPostEq()}) {
+            eq->setEnabled(true);
+            for (size_t b = 0; b < bandCount; b++) {
+                // log spaced from 60 Hz to 20 kHz
+                const float cutoff = 60.f * pow(20000.f / 60.f, (b + 1.f) / bandCount);
+                eq->getBand(b)->init(true /* enabled */, cutoff, b % 2 ? -3.f : 3.f);
+            }
+        }
+        dp_fx::DPMbc* mbc = channel->getMbc();
+        mbc->setEnabled(true);
+        for (size_t b = 0; b < bandCount; b++) {
+            const float cutoff = 60.f * pow(20000.f / 60.f, (b + 1.f) / bandCount);
+            mbc->getBand(b)->init(true /* enabled */, cutoff, 3.f /* attackTime */,
+                    80.f /* releaseTime */, 3.f /* ratio */, -24.f /* threshold */,
+                    6.f /* kneeWidth */, -70.f /* noiseGateThreshold */,
+                    2.f /* expanderRatio */, 0.f /* preGain */, 2.f /* postGain */);
+        }
+        dp_fx::DPLimiter* limiter = channel->getLimiter();
+        limiter->init(true /* inUse */, true /* enabled */, 0 /* linkGroup */,
+                1.f /* attackTime */, 60.f /* releaseTime */, 10.f /* ratio */,
+                -3.f /* threshold */, 0.f /* postGain */);
+    }
+}
+
+static void BM_DynamicsProcessing(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    const size_t bandCount = state.range(1);
+    const size_t blockSize = state.range(2);
+
+    dp_fx::DPFrequency dp;
+    dp.init(channelCount, true /* preEqInUse */, bandCount, true /* mbcInUse */, bandCount,
+            true /* postEqInUse */, bandCount, true /* limiterInUse */);
+    configureBands(dp, channelCount, bandCount);
+    dp.configure(blockSize, blockSize / 2, kSampleRate);
+
+    std::minstd_rand gen(channelCount * bandCount);
+    std::uniform_real_distribution<> dis(-0.5f, 0.5f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * channelCount);
+    for (auto& sample : input) {
+        sample = dis(gen);
+    }
+
+    // Fill the buffers, so that every iteration processes blocks.
+    dp.processSamples(input.data(), output.data(), input.size());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+        dp.processSamples(input.data(), output.data(), input.size());
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["time_per_frame"] = benchmark::Counter(
+            state.iterations() * kFrameCount,
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void DynamicsProcessingArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : {1, 2, 8}) {
+        for (int bandCount : {1, 4, 16}) {
+            for (int blockSize : {512, 2048}) {
+                b->Args({channelCount, bandCount, blockSize});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_DynamicsProcessing)->Apply(DynamicsProcessingArgs);
+
+BENCHMARK_MAIN();
@@ -24,7 +24,6 @@
 
 namespace dp_fx {
 
-using Eigen::MatrixXd;
 #define MAX_BLOCKSIZE 16384 //For this implementation
 #define MIN_BLOCKSIZE 8
 
@@ -66,6 +65,7 @@ void ChannelBuffer::initBuffers(unsigned int blockSize, unsigned int overlapSize
     input.resize(mBlockSize);
     output.resize(mBlockSize);
     outTail.resize(overlapSize);
+    complexTemp.resize(halfFftSize);
 
     //module vectors
     mPreEqFactorVector.resize(halfFftSize, 1.0);
@@ -167,8 +167,11 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
 
     //split window into analysis and synthesis. Both are the sqrt() of original
     //window
-    Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
-    eWindow = eWindow.array().sqrt();
+    for (size_t i = 0; i < mVWindow.size(); i++) {
+        mVWindow[i] = sqrt(mVWindow[i]);
+    }
+    mWindowedInput.resize(mBlockSize);
+    mFft.setSize(mBlockSize);
 
     //compute window rms for energy compensation
     mWindowRms = 0;
@@ -386,10 +389,9 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**separate into channels
-       for (size_t k = 0; k < samples; k += channelCount) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               mChannelBuffers[ch].cBInput.write(*pIn++);
-           }
+       const size_t frames = samples / channelCount;
+       for (int ch = 0; ch < channelCount; ch++) {
+           mChannelBuffers[ch].cBInput.write(pIn + ch, frames, channelCount);
        }
 
        //**process all channelBuffers
@@ -413,10 +415,8 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**interleave channels
-       for (size_t k = 0; k < available; k++) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               *pOut++ = mChannelBuffers[ch].cBOutput.read();
-           }
+       for (int ch = 0; ch < channelCount; ch++) {
+           mChannelBuffers[ch].cBOutput.read(pOut + ch, available, channelCount);
        }
 
        return samples;
@@ -442,9 +442,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
                     pCb->input.begin());
 
             //read new available data
-            for (unsigned int k = 0; k < processFrames; k++) {
-                pCb->input[mOverlapSize + k] = pCb->cBInput.read();
-            }
+            pCb->cBInput.read(&pCb->input[mOverlapSize], processFrames);
             //first stages: fft, preEq, mbc, postEq and start of Limiter
             processedSamples += processFirstStages(*pCb);
         }
@@ -466,9 +464,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
             }
 
             //output data
-            for (unsigned int k = 0; k < processFrames; k++) {
-                pCb->cBOutput.write(pCb->output[k]);
-            }
+            pCb->cBOutput.write(&pCb->output[0], processFrames);
         }
         available -= processFrames;
     }
@@ -477,24 +473,21 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
 size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
     //##apply window
-    Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
-    Eigen::Map<Eigen::VectorXf> eInput(&cb.input[0], cb.input.size());
-
-    Eigen::VectorXf eWin = eInput.cwiseProduct(eWindow); //apply window
+    for (size_t i = 0; i < mBlockSize; i++) {
+        mWindowedInput[i] = cb.input[i] * mVWindow[i];
+    }
 
     //##fft
-    //Note: we are using eigen with the default scaling, which ensures that
-    //  IFFT( FFT(x) ) = x.
+    //Note: the scaling ensures that IFFT( FFT(x) ) = x.
     // TODO: optimize by using the noscale option, and compensate with dB scale offsets
-    mFftServer.fwd(cb.complexTemp, eWin);
+    std::complex<float> *bins = &cb.complexTemp[0];
+    mFft.forward(&mWindowedInput[0], bins);
 
-    size_t cSize = cb.complexTemp.size();
-    size_t maxBin = std::min(cSize/2, mHalfFFTSize);
+    //The gains and the energies leave out the Nyquist bin.
+    const size_t maxBin = mHalfFFTSize - 1;
 
     //== EqPre (always runs)
-    for (size_t k = 0; k < maxBin; k++) {
-        cb.complexTemp[k] *= cb.mPreEqFactorVector[k];
-    }
+    applyBinGains(bins, &cb.mPreEqFactorVector[0], maxBin);
 
     //== MBC
     if (cb.mMbcInUse && cb.mMbcEnabled) {
@@ -506,11 +499,13 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             float preGainFactor = dBtoLinear(pMbcBandParams->gainPreDb);
             float preGainSquared = preGainFactor * preGainFactor;
 
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                fEnergySum += std::norm(cb.complexTemp[k]) * preGainSquared; //mag squared
-            }
+            //bands reaching above Nyquist are cut at the Nyquist bin.
+            const size_t binStart = std::min(pMbcBandParams->binStart, mHalfFFTSize);
+            const size_t binEnd = std::min(pMbcBandParams->binStop + 1, mHalfFFTSize);
+            const size_t binCount = binEnd > binStart ? binEnd - binStart : 0;
+            fEnergySum = binEnergy(bins + binStart, binCount) * preGainSquared; //mag squared
 
-            //Eigen FFT is full spectrum, even if the source was real data.
+            //The fft is the half spectrum of real data.
             // Each half spectrum has half the energy. This is taken into account with the * 2
             // factor in the energy computations.
             // energy = sqrt(sum_components_squared) number_points
@@ -567,9 +562,7 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
 
             //apply to this band
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                cb.complexTemp[k] *= newFactor;
-            }
+            applyBinGain(bins + binStart, newFactor, binCount);
 
         } //end per band process
 
@@ -577,17 +570,12 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
     //== EqPost
     if (cb.mPostEqInUse && cb.mPostEqEnabled) {
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= cb.mPostEqFactorVector[k];
-        }
+        applyBinGains(bins, &cb.mPostEqFactorVector[0], maxBin);
     }
 
     //== Limiter. First Pass
     if (cb.mLimiterInUse && cb.mLimiterEnabled) {
-        float fEnergySum = 0;
-        for (size_t k = 0; k < maxBin; k++) {
-            fEnergySum += std::norm(cb.complexTemp[k]);
-        }
+        float fEnergySum = binEnergy(bins, maxBin);
 
         //see explanation above for energy computation logic
         fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
@@ -656,20 +644,16 @@ size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
 
     //apply to all if != 1.0
     if (!compareEquality(outputGainFactor, 1.0f)) {
-        size_t cSize = cb.complexTemp.size();
-        size_t maxBin = std::min(cSize/2, mHalfFFTSize);
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= outputGainFactor;
-        }
+        applyBinGain(&cb.complexTemp[0], outputGainFactor, mHalfFFTSize - 1);
     }
 
     //##ifft directly to output.
-    Eigen::Map<Eigen::VectorXf> eOutput(&cb.output[0], cb.output.size());
-    mFftServer.inv(eOutput, cb.complexTemp);
+    mFft.inverse(&cb.complexTemp[0], &cb.output[0]);
 
     //apply rest of window for resynthesis
-    Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
-    eOutput = eOutput.cwiseProduct(eWindow);
+    for (size_t i = 0; i < mBlockSize; i++) {
+        cb.output[i] *= mVWindow[i];
+    }
 
     return mBlockSize;
 }
@@ -18,10 +18,8 @@
 #ifndef DPFREQUENCY_H_
 #define DPFREQUENCY_H_
 
-#include <Eigen/Dense>
-#include <unsupported/Eigen/FFT>
-
 #include "RDsp.h"
+#include "RealFft.h"
 #include "SHCircularBuffer.h"
 
 #include "DPBase.h"
@@ -39,7 +37,7 @@ public:
     FloatVec output;    // time domain temp vector for output
     FloatVec outTail;   // time domain temp vector for output tail (for overlap-add method)
 
-    Eigen::VectorXcf complexTemp; // complex temp vector for frequency domain operations
+    ComplexVec complexTemp; // half spectrum, DC to Nyquist, for frequency domain operations
 
     //Current parameters
     float inputGainDb;
@@ -152,7 +150,8 @@ private:
     //dsp
     FloatVec mVWindow;  //window class.
     float mWindowRms;
-    Eigen::FFT<float> mFftServer;
+    FloatVec mWindowedInput; //temp vector for the windowed input of the fft
+    RealFft mFft;
 };
 
 } //namespace dp_fx
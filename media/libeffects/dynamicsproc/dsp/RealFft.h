@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef REALFFT_H_
+#define REALFFT_H_
+
+#include <complex>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace dp_fx {
+
+// FFT of real data, of a power of 2 size.
+//
+// It computes the half spectrum, size / 2 + 1 bins from DC to Nyquist, with a complex FFT of
+// half the size and a final split step. The complex FFT is an iterative radix 2 FFT on separate
+// real and imaginary arrays, with the bit reversal permutation and the twiddle factors of every
+// stage precomputed and contiguous, so that the butterflies vectorize.
+//
+// All the memory is allocated by setSize(); forward() and inverse() do not allocate, and are
+// not thread safe as they share the work buffers.
+//
+// The scaling is the same as Eigen::FFT by default: forward() is unscaled, and inverse() is
+// scaled by 1 / size, so that inverse(forward(x)) == x.
+class RealFft {
+public:
+    using Complex = std::complex<float>;
+
+    static constexpr size_t kMinSize = 4;
+
+    RealFft() = default;
+    explicit RealFft(size_t size) {
+        setSize(size);
+    }
+
+    // Sets the size, a power of 2 at least kMinSize, and precomputes the tables.
+    void setSize(size_t size) {
+        if (size == mSize) {
+            return;
+        }
+        mSize = size;
+        const size_t half = size / 2;
+        unsigned bits = 0;
+        while (((size_t)1 << bits) < half) {
+            bits++;
+        }
+
+        mBitReverse.resize(half);
+        for (size_t n = 0; n < half; n++) {
+            uint32_t r = 0;
+            for (unsigned b = 0; b < bits; b++) {
+                r |= ((n >> b) & 1) << (bits - 1 - b);
+            }
+            mBitReverse[n] = r;
+        }
+
+        // twiddles of the stage combining blocks of m are at offset m - 1.
+        mStageCos.resize(half);
+        mStageSin.resize(half);
+        for (size_t m = 1; m < half; m *= 2) {
+            for (size_t j = 0; j < m; j++) {
+                const double angle = -M_PI * j / m;
+                mStageCos[m - 1 + j] = cos(angle);
+                mStageSin[m - 1 + j] = sin(angle);
+            }
+        }
+
+        // twiddles of the split between the even and odd samples: exp(-2 pi i k / size)
+        mSplitCos.resize(half / 2 + 1);
+        mSplitSin.resize(half / 2 + 1);
+        for (size_t k = 0; k <= half / 2; k++) {
+            const double angle = -2 * M_PI * k / size;
+            mSplitCos[k] = cos(angle);
+            mSplitSin[k] = sin(angle);
+        }
+
+        mRe.resize(half);
+        mIm.resize(half);
+    }
+
+    size_t getSize() const {
+        return mSize;
+    }
+
+    size_t getBinCount() const {
+        return mSize / 2 + 1;
+    }
+
+    // Computes the getBinCount() bins of the spectrum of getSize() real samples.
+    void forward(const float *in, Complex *out) {
+        const size_t half = mSize / 2;
+        // even samples as the real part and odd samples as the imaginary part
+        for (size_t n = 0; n < half; n++) {
+            const uint32_t r = mBitReverse[n];
+            mRe[r] = in[2 * n];
+            mIm[r] = in[2 * n + 1];
+        }
+        transform();
+
+        // split the spectra of the even and the odd samples, and combine them:
+        // X[k] = E[k] + W^k O[k], where E[k] = (Z[k] + conj(Z[half - k])) / 2
+        // and O[k] = (Z[k] - conj(Z[half - k])) / 2i.
+        out[0] = Complex(mRe[0] + mIm[0], 0);
+        out[half] = Complex(mRe[0] - mIm[0], 0);
+        for (size_t k = 1; k <= half / 2; k++) {
+            const size_t l = half - k;
+            const float eRe = 0.5f * (mRe[k] + mRe[l]);
+            const float eIm = 0.5f * (mIm[k] - mIm[l]);
+            const float oRe = 0.5f * (mIm[k] + mIm[l]);
+            const float oIm = -0.5f * (mRe[k] - mRe[l]);
+            const float wRe = mSplitCos[k];
+            const float wIm = mSplitSin[k];
+            const float tRe = wRe * oRe - wIm * oIm;
+            const float tIm = wRe * oIm + wIm * oRe;
+            out[k] = Complex(eRe + tRe, eIm + tIm);
+            // X[half - k] = conj(E[k] - W^k O[k]), as W^(half - k) = -conj(W^k)
+            out[l] = Complex(eRe - tRe, tIm - eIm);
+        }
+    }
+
+    // Computes getSize() real samples from the getBinCount() bins of their spectrum.
+    // The imaginary parts of the DC and Nyquist bins are ignored.
+    void inverse(const Complex *in, float *out) {
+        const size_t half = mSize / 2;
+        // Z[k] = E[k] + i O[k], with E[k] = (X[k] + conj(X[half - k])) / 2 and
+        // O[k] = (X[k] - conj(X[half - k])) conj(W^k) / 2; conjugated, to run the inverse
+        // transform as a forward one.
+        const float scale = 1.0f / mSize;
+        for (size_t k = 0; k <= half / 2; k++) {
+            const size_t l = half - k;
+            const Complex a = k == 0 ? Complex(in[0].real(), 0) : in[k];
+            const Complex b = k == 0 ? Complex(in[half].real(), 0) : in[l];
+            const float eRe = 0.5f * (a.real() + b.real());
+            const float eIm = 0.5f * (a.imag() - b.imag());
+            const float dRe = 0.5f * (a.real() - b.real());
+            const float dIm = 0.5f * (a.imag() + b.imag());
+            const float wRe = mSplitCos[k];
+            const float wIm = -mSplitSin[k];
+            const float oRe = dRe * wRe - dIm * wIm;
+            const float oIm = dRe * wIm + dIm * wRe;
+            // E and O are the spectra of real sequences, so Z[half - k] = conj(E[k]) + i conj(O[k])
+            const uint32_t rk = mBitReverse[k];
+            mRe[rk] = 2 * scale * (eRe - oIm);
+            mIm[rk] = -2 * scale * (eIm + oRe);
+            if (l != k && l < half) {
+                const uint32_t rl = mBitReverse[l];
+                mRe[rl] = 2 * scale * (eRe + oIm);
+                mIm[rl] = -2 * scale * (oRe - eIm);
+            }
+        }
+        transform();
+        for (size_t n = 0; n < half; n++) {
+            out[2 * n] = mRe[n];
+            out[2 * n + 1] = -mIm[n];
+        }
+    }
+
+private:
+    // In place forward complex FFT of mRe and mIm, in bit reversed order.
+    void transform() {
+        const size_t half = mSize / 2;
+        float *re = mRe.data();
+        float *im = mIm.data();
+        for (size_t i = 0; i < half; i += 2) {
+            const float r = re[i + 1];
+            const float m = im[i + 1];
+            re[i + 1] = re[i] - r;
+            im[i + 1] = im[i] - m;
+            re[i] += r;
+            im[i] += m;
+        }
+        for (size_t m = 2; m < half; m *= 2) {
+            const float *wRe = &mStageCos[m - 1];
+            const float *wIm = &mStageSin[m - 1];
+            for (size_t base = 0; base < half; base += 2 * m) {
+                float *aRe = re + base;
+                float *aIm = im + base;
+                float *bRe = aRe + m;
+                float *bIm = aIm + m;
+                for (size_t j = 0; j < m; j++) {
+                    const float tRe = wRe[j] * bRe[j] - wIm[j] * bIm[j];
+                    const float tIm = wRe[j] * bIm[j] + wIm[j] * bRe[j];
+                    bRe[j] = aRe[j] - tRe;
+                    bIm[j] = aIm[j] - tIm;
+                    aRe[j] += tRe;
+                    aIm[j] += tIm;
+                }
+            }
+        }
+    }
+
+    size_t mSize = 0;
+    std::vector<uint32_t> mBitReverse;
+    std::vector<float> mStageCos;
+    std::vector<float> mStageSin;
+    std::vector<float> mSplitCos;
+    std::vector<float> mSplitSin;
+    std::vector<float> mRe;
+    std::vector<float> mIm;
+};
+
+// Helpers for the bins of a half spectrum, written on the interleaved real and imaginary parts
+// so that they vectorize.
+
+// bins[k] *= gains[k], for k in [0, count)
+static inline void applyBinGains(std::complex<float> *bins, const float *gains, size_t count) {
+    float *p = reinterpret_cast<float *>(bins);
+    for (size_t k = 0; k < count; k++) {
+        p[2 * k] *= gains[k];
+        p[2 * k + 1] *= gains[k];
+    }
+}
+
+// bins[k] *= gain, for k in [0, count)
+static inline void applyBinGain(std::complex<float> *bins, float gain, size_t count) {
+    float *p = reinterpret_cast<float *>(bins);
+    for (size_t k = 0; k < 2 * count; k++) {
+        p[k] *= gain;
+    }
+}
+
+// Returns the sum of |bins[k]|^2, for k in [0, count)
+static inline float binEnergy(const std::complex<float> *bins, size_t count) {
+    const float *p = reinterpret_cast<const float *>(bins);
+    float sum = 0;
+    for (size_t k = 0; k < 2 * count; k++) {
+        sum += p[k] * p[k];
+    }
+    return sum;
+}
+
+} //namespace dp_fx
+
+#endif  // REALFFT_H_
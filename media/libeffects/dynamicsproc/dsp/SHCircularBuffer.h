@@ -17,6 +17,7 @@
 #ifndef SHCIRCULARBUFFER_H
 #define SHCIRCULARBUFFER_H
 
+#include <algorithm>
 #include <log/log.h>
 #include <vector>
 
@@ -60,6 +61,37 @@ public:
         }
         return value;
     }
+    // Writes count values, taken stride apart from src. Values that do not fit are dropped.
+    void write(const T *src, size_t count, size_t stride = 1) {
+        if (count > availableToWrite()) {
+            ALOGE("Error: SHCircularBuffer no space to write. allocated size %zu ", getSize());
+            count = availableToWrite();
+        }
+        const size_t first = std::min(count, getSize() - mWriteIndex);
+        copyIn(&mBuffer[mWriteIndex], src, first, stride);
+        copyIn(&mBuffer[0], src + first * stride, count - first, stride);
+        if (count > 0) {
+            mWriteIndex = (mWriteIndex + count) % getSize();
+            mReadAvailable += count;
+        }
+    }
+    // Reads count values, stored stride apart in dst. Values not available are read as T().
+    void read(T *dst, size_t count, size_t stride = 1) {
+        const size_t available = std::min(count, availableToRead());
+        if (available < count) {
+            ALOGW("Warning: SHCircularBuffer no data available to read. Default value returned");
+        }
+        const size_t first = std::min(available, getSize() - mReadIndex);
+        copyOut(dst, &mBuffer[mReadIndex], first, stride);
+        copyOut(dst + first * stride, &mBuffer[0], available - first, stride);
+        for (size_t i = available; i < count; i++) {
+            dst[i * stride] = T();
+        }
+        if (available > 0) {
+            mReadIndex = (mReadIndex + available) % getSize();
+            mReadAvailable -= available;
+        }
+    }
     inline size_t availableToRead() const {
         return mReadAvailable;
     }
@@ -71,6 +103,25 @@ public:
     }
 
 private:
+    static void copyIn(T *dst, const T *src, size_t count, size_t stride) {
+        if (stride == 1) {
+            std::copy(src, src + count, dst);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                dst[i] = src[i * stride];
+            }
+        }
+    }
+    static void copyOut(T *dst, const T *src, size_t count, size_t stride) {
+        if (stride == 1) {
+            std::copy(src, src + count, dst);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                dst[i * stride] = src[i];
+            }
+        }
+    }
+
     std::vector<T> mBuffer;
     size_t mReadIndex;
     size_t mWriteIndex;
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <complex>
+#include <math.h>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "RealFft.h"
+
+using dp_fx::RealFft;
+
+namespace {
+
+using ComplexD = std::complex<double>;
+
+// The sizes used by DPFrequency and the visualizer spectrum are within this range.
+constexpr size_t kSizes[] = {4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192};
+
+// Reference DFT of real samples, half spectrum, in double precision.
+std::vector<ComplexD> referenceForward(const std::vector<float>& in) {
+    const size_t n = in.size();
+    std::vector<ComplexD> out(n / 2 + 1);
+    for (size_t k = 0; k < out.size(); ++k) {
+        ComplexD sum = 0;
+        for (size_t t = 0; t < n; ++t) {
+            // reduce the phase index modulo n to keep the angle accurate
+            const double angle = -2 * M_PI * ((k * t) % n) / n;
+            sum += (double)in[t] * ComplexD(cos(angle), sin(angle));
+        }
+        out[k] = sum;
+    }
+    return out;
+}
+
+// Reference inverse DFT of a half spectrum, scaled by 1 / n, ignoring the imaginary parts
+// of the DC and Nyquist bins as RealFft::inverse() does.
+std::vector<double> referenceInverse(const std::vector<RealFft::Complex>& in, size_t n) {
+    std::vector<double> out(n);
+    for (size_t t = 0; t < n; ++t) {
+        double sum = in[0].real() + ((t & 1) ? -1. : 1.) * in[n / 2].real();
+        for (size_t k = 1; k < n / 2; ++k) {
+            const double angle = 2 * M_PI * ((k * t) % n) / n;
+            // the bins above Nyquist are the conjugates of the ones below
+            sum += 2 * (in[k].real() * cos(angle) - in[k].imag() * sin(angle));
+        }
+        out[t] = sum / n;
+    }
+    return out;
+}
+
+std::vector<float> randomSamples(size_t n, unsigned seed) {
+    std::minstd_rand gen(seed);
+    std::uniform_real_distribution<float> dis(-1.f, 1.f);
+    std::vector<float> samples(n);
+    for (auto& sample : samples) sample = dis(gen);
+    return samples;
+}
+
+// Float FFT rounding error grows with log2(n), relative to the norm of the signal.
+double tolerance(size_t n, double norm) {
+    return 1e-6 * log2((double)n) * norm;
+}
+
+class RealFftTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(RealFftTest, ForwardMatchesReference) {
+    const size_t n = GetParam();
+    RealFft fft(n);
+    ASSERT_EQ(n, fft.getSize());
+    ASSERT_EQ(n / 2 + 1, fft.getBinCount());
+
+    const std::vector<float> in = randomSamples(n, n);
+    std::vector<RealFft::Complex> out(fft.getBinCount());
+    fft.forward(in.data(), out.data());
+    const std::vector<ComplexD> expected = referenceForward(in);
+
+    // the spectrum norm is sqrt(n) times the signal norm (Parseval)
+    double signalNorm = 0;
+    for (const float x : in) signalNorm += x * x;
+    const double tol = tolerance(n, sqrt(n * signalNorm));
+    for (size_t k = 0; k < out.size(); ++k) {
+        EXPECT_NEAR(expected[k].real(), out[k].real(), tol) << "size " << n << " bin " << k;
+        EXPECT_NEAR(expected[k].imag(), out[k].imag(), tol) << "size " << n << " bin " << k;
+    }
+    // the DC and Nyquist bins of a real signal are real
+    EXPECT_EQ(0.f, out[0].imag());
+    EXPECT_EQ(0.f, out[n / 2].imag());
+}
+
+TEST_P(RealFftTest, InverseMatchesReference) {
+    const size_t n = GetParam();
+    RealFft fft(n);
+
+    const std::vector<float> re = randomSamples(n / 2 + 1, 2 * n);
+    const std::vector<float> im = randomSamples(n / 2 + 1, 2 * n + 1);
+    std::vector<RealFft::Complex> in(n / 2 + 1);
+    for (size_t k = 0; k < in.size(); ++k) {
+        // nonzero imaginary parts of DC and Nyquist must be ignored
+        in[k] = RealFft::Complex(re[k], im[k]);
+    }
+    std::vector<float> out(n);
+    fft.inverse(in.data(), out.data());
+    const std::vector<double> expected = referenceInverse(in, n);
+
+    // each output sample is the mean of n terms of magnitude up to sqrt(2)
+    const double tol = tolerance(n, sqrt(2.));
+    for (size_t t = 0; t < n; ++t) {
+        EXPECT_NEAR(expected[t], out[t], tol) << "size " << n << " sample " << t;
+    }
+}
+
+TEST_P(RealFftTest, RoundTrip) {
+    const size_t n = GetParam();
+    RealFft fft(n);
+    const std::vector<float> in = randomSamples(n, 3 * n);
+    std::vector<RealFft::Complex> bins(fft.getBinCount());
+    std::vector<float> out(n);
+
+    fft.forward(in.data(), bins.data());
+    fft.inverse(bins.data(), out.data());
+    for (size_t t = 0; t < n; ++t) {
+        EXPECT_NEAR(in[t], out[t], tolerance(n, 1.)) << "size " << n << " sample " << t;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(RealFftSizes, RealFftTest, ::testing::ValuesIn(kSizes),
+                         [](const ::testing::TestParamInfo<size_t>& info) {
+                             return std::to_string(info.param);
+                         });
+
+TEST(RealFftTest, Impulse) {
+    // the spectrum of a unit impulse at 0 is flat
+    constexpr size_t kSize = 64;
+    RealFft fft(kSize);
+    std::vector<float> in(kSize);
+    in[0] = 1.f;
+    std::vector<RealFft::Complex> out(fft.getBinCount());
+    fft.forward(in.data(), out.data());
+    for (const auto& bin : out) {
+        EXPECT_FLOAT_EQ(1.f, bin.real());
+        EXPECT_NEAR(0.f, bin.imag(), 1e-7);
+    }
+}
+
+TEST(RealFftTest, SetSize) {
+    // resizing reuses the object for another size, and a size change is not required
+    RealFft fft;
+    std::vector<RealFft::Complex> bins;
+    std::vector<float> out;
+    for (const size_t n : {256, 16, 16, 1024}) {
+        fft.setSize(n);
+        ASSERT_EQ(n, fft.getSize());
+        const std::vector<float> in = randomSamples(n, n + 7);
+        bins.resize(fft.getBinCount());
+        out.resize(n);
+        fft.forward(in.data(), bins.data());
+        fft.inverse(bins.data(), out.data());
+        for (size_t t = 0; t < n; ++t) {
+            ASSERT_NEAR(in[t], out[t], tolerance(n, 1.)) << "size " << n << " sample " << t;
+        }
+    }
+}
+
+}  // namespace
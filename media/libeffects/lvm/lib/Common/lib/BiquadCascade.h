@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIQUAD_CASCADE_H_
+#define _BIQUAD_CASCADE_H_
+
+#include <array>
+#include <stddef.h>
+#include <vector>
+
+#include "LVM_Types.h"
+
+namespace lvm {
+
+/**********************************************************************************
+    BIQUAD CASCADE
+
+    A series of biquad sections applied to interleaved multichannel float data,
+    with one set of coefficients per section shared by all channels.
+
+    Each section is a transposed direct form II biquad H, with the coefficients
+    {b0, b1, b2, a1, a2} of audio_utils::BiquadFilter:
+        y[n] = b0 * x[n] + b1 * x[n-1] + b2 * x[n-2] - a1 * y[n-1] - a2 * y[n-2]
+    and outputs direct * x + gain * y. With direct = 1 the section is an
+    equaliser band, which adds the filtered input to the input. This is kept
+    apart from the biquad, as folding it into the coefficients would make a
+    narrow low frequency band recirculate the whole signal in the filter state,
+    with much more rounding error.
+
+    The filter state of channel c of section s is kept in lane s * channels + c,
+    and is processed with one of two layouts:
+    - CHANNEL_INTERLEAVED: for each frame, the sections are applied in turn to
+      all channels at once. Vectorizes across channels.
+    - SECTION_PARALLEL: all the sections are applied at once, section s
+      processing frame n - s while section 0 processes frame n, so the lanes
+      only depend on each other through the previous step. Vectorizes across
+      sections, for mono and stereo with up to kMaxParallelLanes lanes. The
+      lane shift between steps goes through memory without intrinsics, and is
+      slower than CHANNEL_INTERLEAVED on x86-64 for the equalizer (see
+      lvm_benchmark), so it is only used on request.
+    Both layouts compute each section with the same operations in the same
+    order, so they only differ by floating point contraction.
+***********************************************************************************/
+
+class BiquadCascade {
+  public:
+    static constexpr size_t kNumCoefs = 5;
+    using Coefs = std::array<LVM_FLOAT, kNumCoefs>;
+
+    struct Section {
+        Coefs coefs;
+        LVM_FLOAT gain = 1.f;    // of the biquad output
+        LVM_FLOAT direct = 0.f;  // of the section input
+    };
+
+    static constexpr size_t kMaxParallelLanes = 16;
+
+    enum class Layout {
+        AUTO,  // currently CHANNEL_INTERLEAVED
+        CHANNEL_INTERLEAVED,
+        SECTION_PARALLEL,
+    };
+
+    explicit BiquadCascade(size_t channelCount = 1);
+
+    // Replaces the sections; an empty list makes process() a copy. Clears the state.
+    void setSections(const std::vector<Section>& sections);
+    // Changes the channel count, keeping the sections. Clears the state.
+    void setChannelCount(size_t channelCount);
+    // Selects a layout, for tests and benchmarks. Falls back to CHANNEL_INTERLEAVED if
+    // SECTION_PARALLEL is not supported for the channel and section count.
+    void setLayout(Layout layout);
+    // Clears the filter history.
+    void clear();
+
+    size_t getSectionCount() const { return mSections.size(); }
+    size_t getChannelCount() const { return mChannelCount; }
+    Layout getLayout() const { return mLayout; }
+
+    // Filters frameCount interleaved frames. out may be the same as in.
+    void process(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount);
+
+  private:
+    void configure();
+
+    template <size_t CHANNELS>
+    void processInterleaved(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount);
+    template <size_t CHANNELS>
+    void processSectionParallel(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount);
+
+    std::vector<Section> mSections;
+    size_t mChannelCount;
+    Layout mRequestedLayout = Layout::AUTO;
+    Layout mLayout = Layout::CHANNEL_INTERLEAVED;
+
+    // Per lane coefficients and state, at least kMaxParallelLanes long.
+    std::vector<LVM_FLOAT> mB0, mB1, mB2, mA1, mA2, mGain, mDirect;
+    std::vector<LVM_FLOAT> mS0, mS1;
+};
+
+}  // namespace lvm
+
+#endif /* _BIQUAD_CASCADE_H_ */
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**********************************************************************************
+   INCLUDE FILES
+***********************************************************************************/
+
+#include <algorithm>
+#include <string.h>
+
+#include "BiquadCascade.h"
+
+namespace lvm {
+
+BiquadCascade::BiquadCascade(size_t channelCount)
+    : mChannelCount(std::max<size_t>(channelCount, 1)) {
+    configure();
+}
+
+void BiquadCascade::setSections(const std::vector<Section>& sections) {
+    mSections = sections;
+    configure();
+}
+
+void BiquadCascade::setChannelCount(size_t channelCount) {
+    mChannelCount = std::max<size_t>(channelCount, 1);
+    configure();
+}
+
+void BiquadCascade::setLayout(Layout layout) {
+    mRequestedLayout = layout;
+    configure();
+}
+
+void BiquadCascade::clear() {
+    std::fill(mS0.begin(), mS0.end(), 0.f);
+    std::fill(mS1.begin(), mS1.end(), 0.f);
+}
+
+void BiquadCascade::configure() {
+    const size_t lanes = mSections.size() * mChannelCount;
+    const bool parallelSupported =
+            mChannelCount <= 2 && mSections.size() >= 2 && lanes <= kMaxParallelLanes;
+    switch (mRequestedLayout) {
+        case Layout::SECTION_PARALLEL:
+            mLayout = parallelSupported ? Layout::SECTION_PARALLEL : Layout::CHANNEL_INTERLEAVED;
+            break;
+        case Layout::AUTO:
+        case Layout::CHANNEL_INTERLEAVED:
+            mLayout = Layout::CHANNEL_INTERLEAVED;
+            break;
+    }
+
+    // Unused lanes have zero coefficients, so their output and state stay zero.
+    const size_t size = std::max(lanes, kMaxParallelLanes);
+    for (auto* v : {&mB0, &mB1, &mB2, &mA1, &mA2, &mGain, &mDirect, &mS0, &mS1}) {
+        v->assign(size, 0.f);
+    }
+    for (size_t s = 0; s < mSections.size(); ++s) {
+        for (size_t c = 0; c < mChannelCount; ++c) {
+            const size_t lane = s * mChannelCount + c;
+            const Section& section = mSections[s];
+            mB0[lane] = section.coefs[0];
+            mB1[lane] = section.coefs[1];
+            mB2[lane] = section.coefs[2];
+            mA1[lane] = section.coefs[3];
+            mA2[lane] = section.coefs[4];
+            mGain[lane] = section.gain;
+            mDirect[lane] = section.direct;
+        }
+    }
+}
+
+// CHANNELS is 0 for a channel count only known at run time.
+template <size_t CHANNELS>
+void BiquadCascade::processInterleaved(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount) {
+    constexpr size_t kMaxChannels = CHANNELS != 0 ? CHANNELS : (size_t)LVM_MAX_CHANNELS;
+    const size_t channels = CHANNELS != 0 ? CHANNELS : mChannelCount;
+    const size_t sections = mSections.size();
+    const LVM_FLOAT* const b0 = mB0.data();
+    const LVM_FLOAT* const b1 = mB1.data();
+    const LVM_FLOAT* const b2 = mB2.data();
+    const LVM_FLOAT* const a1 = mA1.data();
+    const LVM_FLOAT* const a2 = mA2.data();
+    const LVM_FLOAT* const gain = mGain.data();
+    const LVM_FLOAT* const direct = mDirect.data();
+    LVM_FLOAT* const s0 = mS0.data();
+    LVM_FLOAT* const s1 = mS1.data();
+
+    for (size_t n = 0; n < frameCount; ++n) {
+        LVM_FLOAT x[kMaxChannels];
+        for (size_t c = 0; c < channels; ++c) {
+            x[c] = in[c];
+        }
+        for (size_t s = 0, lane = 0; s < sections; ++s, lane += channels) {
+            // The new state goes through local arrays, so that the compiler can tell
+            // that it does not alias the coefficients and vectorize across channels.
+            LVM_FLOAT t0[kMaxChannels], t1[kMaxChannels];
+            for (size_t c = 0; c < channels; ++c) {
+                const size_t l = lane + c;
+                const LVM_FLOAT y = b0[l] * x[c] + s0[l];
+                t0[c] = b1[l] * x[c] - a1[l] * y + s1[l];
+                t1[c] = b2[l] * x[c] - a2[l] * y;
+                x[c] = direct[l] * x[c] + gain[l] * y;
+            }
+            memcpy(s0 + lane, t0, channels * sizeof(LVM_FLOAT));
+            memcpy(s1 + lane, t1, channels * sizeof(LVM_FLOAT));
+        }
+        for (size_t c = 0; c < channels; ++c) {
+            out[c] = x[c];
+        }
+        in += channels;
+        out += channels;
+    }
+}
+
+template <size_t CHANNELS>
+void BiquadCascade::processSectionParallel(LVM_FLOAT* out, const LVM_FLOAT* in,
+                                           size_t frameCount) {
+    constexpr size_t L = kMaxParallelLanes;
+    const size_t sections = mSections.size();
+    const size_t lastLane = (sections - 1) * CHANNELS;
+    const size_t steps = frameCount + sections - 1;
+
+    // Local copies, so that the lanes can be kept in vector registers.
+    LVM_FLOAT b0[L], b1[L], b2[L], a1[L], a2[L], gain[L], direct[L], s0[L], s1[L];
+    memcpy(b0, mB0.data(), sizeof(b0));
+    memcpy(b1, mB1.data(), sizeof(b1));
+    memcpy(b2, mB2.data(), sizeof(b2));
+    memcpy(a1, mA1.data(), sizeof(a1));
+    memcpy(a2, mA2.data(), sizeof(a2));
+    memcpy(gain, mGain.data(), sizeof(gain));
+    memcpy(direct, mDirect.data(), sizeof(direct));
+    memcpy(s0, mS0.data(), sizeof(s0));
+    memcpy(s1, mS1.data(), sizeof(s1));
+    LVM_FLOAT y[L] = {};
+
+    for (size_t n = 0; n < steps; ++n) {
+        // Section 0 takes the next input frame, and each following section the
+        // output of the previous section at the previous step.
+        LVM_FLOAT x[L];
+        for (size_t l = L - 1; l >= CHANNELS; --l) {
+            x[l] = y[l - CHANNELS];
+        }
+        for (size_t c = 0; c < CHANNELS; ++c) {
+            x[c] = n < frameCount ? in[n * CHANNELS + c] : 0.f;
+        }
+
+        LVM_FLOAT t0[L], t1[L];
+        for (size_t l = 0; l < L; ++l) {
+            const LVM_FLOAT h = b0[l] * x[l] + s0[l];
+            t0[l] = b1[l] * x[l] - a1[l] * h + s1[l];
+            t1[l] = b2[l] * x[l] - a2[l] * h;
+            y[l] = direct[l] * x[l] + gain[l] * h;
+        }
+
+        if (n >= sections - 1 && n < frameCount) {
+            memcpy(s0, t0, sizeof(s0));
+            memcpy(s1, t1, sizeof(s1));
+        } else {
+            // Filling or draining the pipeline: section s only runs for
+            // s <= n < frameCount + s.
+            for (size_t l = 0; l < L; ++l) {
+                const size_t s = l / CHANNELS;
+                if (s <= n && n < frameCount + s) {
+                    s0[l] = t0[l];
+                    s1[l] = t1[l];
+                }
+            }
+        }
+
+        if (n >= sections - 1) {
+            for (size_t c = 0; c < CHANNELS; ++c) {
+                out[(n - (sections - 1)) * CHANNELS + c] = y[lastLane + c];
+            }
+        }
+    }
+
+    memcpy(mS0.data(), s0, sizeof(s0));
+    memcpy(mS1.data(), s1, sizeof(s1));
+}
+
+void BiquadCascade::process(LVM_FLOAT* out, const LVM_FLOAT* in, size_t frameCount) {
+    if (mSections.empty()) {
+        if (out != in) {
+            memcpy(out, in, frameCount * mChannelCount * sizeof(LVM_FLOAT));
+        }
+        return;
+    }
+    if (mLayout == Layout::SECTION_PARALLEL) {
+        if (mChannelCount == FCC_1) {
+            processSectionParallel<FCC_1>(out, in, frameCount);
+        } else {
+            processSectionParallel<FCC_2>(out, in, frameCount);
+        }
+        return;
+    }
+    switch (mChannelCount) {
+        case 1:
+            processInterleaved<1>(out, in, frameCount);
+            break;
+        case 2:
+            processInterleaved<2>(out, in, frameCount);
+            break;
+        case 4:
+            processInterleaved<4>(out, in, frameCount);
+            break;
+        case 6:
+            processInterleaved<6>(out, in, frameCount);
+            break;
+        case 8:
+            processInterleaved<8>(out, in, frameCount);
+            break;
+        default:
+            processInterleaved<0>(out, in, frameCount);
+            break;
+    }
+}
+
+}  // namespace lvm
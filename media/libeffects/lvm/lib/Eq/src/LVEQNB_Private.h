@@ -24,9 +24,9 @@
 /*                                                                                      */
 /****************************************************************************************/
 
-#include <audio_utils/BiquadFilter.h>
 #include "LVEQNB.h" /* Calling or Application layer definitions */
 #include "BIQUAD.h"
+#include "BiquadCascade.h"
 #include "LVC_Mixer.h"
 
 /****************************************************************************************/
@@ -70,9 +70,7 @@ typedef struct {
     /* Aligned memory pointers */
     LVM_FLOAT* pFastTemporary; /* Fast temporary data base address */
 
-    std::vector<android::audio_utils::BiquadFilter<LVM_FLOAT>>
-            eqBiquad;            /* Biquad filter instances */
-    std::vector<LVM_FLOAT> gain; /* Gain values for all bands*/
+    lvm::BiquadCascade eqCascade; /* Non-zero gain bands, each as a single biquad section */
 
     /* Filter definitions and call back */
     LVM_UINT16 NBands;                  /* Number of bands */
@@ -229,10 +229,11 @@ LVREV_ReturnStatus_en LVREV_ApplyNewSettings(LVREV_Instance_st* pPrivate) {
                 Coeffs.A1 = 0;
                 Coeffs.B1 = 0;
             }
-            const std::array<LVM_FLOAT, android::audio_utils::kBiquadNumCoefs> coefs = {
-                    Coeffs.A0, Coeffs.A1, 0.0, -(Coeffs.B1), 0.0};
-            pPrivate->revLPFBiquad[i].reset(
-                    new android::audio_utils::BiquadFilter<LVM_FLOAT>(FCC_1, coefs));
+            pPrivate->RevLPF_A0[i] = Coeffs.A0;
+            pPrivate->RevLPF_A1[i] = Coeffs.A1;
+            pPrivate->RevLPF_B1[i] = Coeffs.B1;
+            pPrivate->RevLPF_X1[i] = 0;
+            pPrivate->RevLPF_Y1[i] = 0;
         }
     }
 
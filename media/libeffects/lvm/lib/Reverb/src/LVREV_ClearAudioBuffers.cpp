@@ -59,10 +59,13 @@ LVREV_ReturnStatus_en LVREV_ClearAudioBuffers(LVREV_Handle_t hInstance) {
     pLVREV_Private->pRevHPFBiquad->clear();
     pLVREV_Private->pRevLPFBiquad->clear();
     for (size_t i = 0; i < pLVREV_Private->InstanceParams.NumDelays; i++) {
-        pLVREV_Private->revLPFBiquad[i]->clear();
-        memset(pLVREV_Private->pDelay_T[i], 0, LVREV_MAX_T_DELAY[i] *
-                sizeof(pLVREV_Private->pDelay_T[i][0]));
+        pLVREV_Private->RevLPF_X1[i] = 0;
+        pLVREV_Private->RevLPF_Y1[i] = 0;
+        memset(pLVREV_Private->pDelay_T[i], 0,
+               (LVREV_MAX_T_DELAY[i] + pLVREV_Private->DelaySlack) *
+                       sizeof(pLVREV_Private->pDelay_T[i][0]));
     }
+    pLVREV_Private->DelayOffset = 0;
     return LVREV_SUCCESS;
 }
 
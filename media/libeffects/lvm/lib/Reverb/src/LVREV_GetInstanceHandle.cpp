@@ -94,8 +94,10 @@ LVREV_ReturnStatus_en LVREV_GetInstanceHandle(LVREV_Handle_t* phInstance,
     /*
      * Set the data, coefficient and temporary memory pointers
      */
+    pLVREV_Private->DelaySlack = LVREV_DELAY_SLACK_BLOCKS * MaxBlockSize;
     for (size_t i = 0; i < pInstanceParams->NumDelays; i++) {
-        pLVREV_Private->pDelay_T[i] = (LVM_FLOAT*)calloc(LVREV_MAX_T_DELAY[i], sizeof(LVM_FLOAT));
+        pLVREV_Private->pDelay_T[i] = (LVM_FLOAT*)calloc(
+                LVREV_MAX_T_DELAY[i] + pLVREV_Private->DelaySlack, sizeof(LVM_FLOAT));
         /* Scratch for each delay line output */
         pLVREV_Private->pScratchDelayLine[i] = (LVM_FLOAT*)calloc(MaxBlockSize, sizeof(LVM_FLOAT));
     }
@@ -214,8 +216,9 @@ LVREV_ReturnStatus_en LVREV_GetInstanceHandle(LVREV_Handle_t* phInstance,
     pLVREV_Private->pRevLPFBiquad.reset(
             new android::audio_utils::BiquadFilter<LVM_FLOAT>(LVM_MAX_CHANNELS));
     for (int i = 0; i < LVREV_DELAYLINES_4; i++) {
-        pLVREV_Private->revLPFBiquad[i].reset(
-                new android::audio_utils::BiquadFilter<LVM_FLOAT>(LVM_MAX_CHANNELS));
+        pLVREV_Private->RevLPF_A0[i] = 1.0f;
+        pLVREV_Private->RevLPF_A1[i] = 0;
+        pLVREV_Private->RevLPF_B1[i] = 0;
     }
 
     LVREV_ClearAudioBuffers(*phInstance);
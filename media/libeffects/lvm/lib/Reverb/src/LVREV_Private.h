@@ -83,6 +83,10 @@
 #define LVREV_FEEDBACKMIXER_TC 100 /* Feedback mixer time constant*/
 #define LVREV_OUTPUTGAIN_SHIFT 5   /* Bits shift for output gain correction */
 
+/* The delay lines slide through their buffers by one block per call, and are only moved
+   back to the start of the buffers once this many maximum size blocks have been used */
+#define LVREV_DELAY_SLACK_BLOCKS 16
+
 /* Parameter limits */
 #define LVREV_NUM_FS 13 /* Number of supported sample rates */
 
@@ -124,8 +128,13 @@ typedef struct {
             pRevHPFBiquad; /* Biquad filter instance for HPF */
     std::unique_ptr<android::audio_utils::BiquadFilter<LVM_FLOAT>>
             pRevLPFBiquad; /* Biquad filter instance for LPF */
-    std::array<std::unique_ptr<android::audio_utils::BiquadFilter<LVM_FLOAT>>, LVREV_DELAYLINES_4>
-            revLPFBiquad; /* Biquad filter instance for Reverb LPF */
+    /* Delay line first order low pass filters, one per lane of the feedback network:
+       y(n) = A0 * x(n) + A1 * x(n-1) + B1 * y(n-1) */
+    LVM_FLOAT RevLPF_A0[LVREV_DELAYLINES_4];
+    LVM_FLOAT RevLPF_A1[LVREV_DELAYLINES_4];
+    LVM_FLOAT RevLPF_B1[LVREV_DELAYLINES_4];
+    LVM_FLOAT RevLPF_X1[LVREV_DELAYLINES_4]; /* Previous input */
+    LVM_FLOAT RevLPF_Y1[LVREV_DELAYLINES_4]; /* Previous output */
     LVM_FLOAT* pScratchDelayLine[LVREV_DELAYLINES_4]; /* Delay line scratch memory */
     LVM_FLOAT* pScratch;             /* Multi ussge scratch */
     LVM_FLOAT* pInputSave;           /* Reverb block input save for dry/wet
@@ -137,7 +146,13 @@ typedef struct {
 
     /* All-Pass Filter */
     LVM_INT32 T[LVREV_DELAYLINES_4];                          /* Maximum delay size of buffer */
-    LVM_FLOAT* pDelay_T[LVREV_DELAYLINES_4];                  /* Pointer to delay buffers */
+    LVM_FLOAT* pDelay_T[LVREV_DELAYLINES_4];                  /* Pointer to delay buffers, each \
+                                                                 T + DelaySlack long */
+    LVM_INT32 DelaySlack;                                     /* Room for the delay lines to \
+                                                                 slide in their buffers */
+    LVM_INT32 DelayOffset;                                    /* Current start of the delay \
+                                                                 lines in their buffers, all \
+                                                                 other offsets are relative */
     LVM_INT32 Delay_AP[LVREV_DELAYLINES_4];                   /* Offset to AP delay buffer start */
     LVM_INT16 AB_Selection;                     /* Smooth from tap A to B when 1 \
                                                    otherwise B to A */
@@ -20,7 +20,9 @@
 /* Includes                                                                             */
 /*                                                                                      */
 /****************************************************************************************/
+#include <string.h>
 #include "LVREV_Private.h"
+#include "ScalarArithmetic.h"
 #include "VectorArithmetic.h"
 
 /****************************************************************************************/
@@ -133,6 +135,83 @@ LVREV_ReturnStatus_en LVREV_Process(LVREV_Handle_t hInstance, const LVM_FLOAT* p
     return LVREV_SUCCESS;
 }
 
+/****************************************************************************************/
+/*                                                                                      */
+/* FUNCTION:                ReverbFeedbackNetwork                                       */
+/*                                                                                      */
+/* DESCRIPTION:                                                                         */
+/*  Low pass filters the delay line outputs, mixes them with the rotation matrix into   */
+/*  the delay line inputs and creates the stereo output. Each delay line is a lane of   */
+/*  the same per sample operations, so that the delay lines can be vectorised.          */
+/*                                                                                      */
+/* PARAMETERS:                                                                          */
+/*  pPrivate                Instance pointer                                            */
+/*  pIn                     Mono reverb input                                           */
+/*  pDelayLineInput         Delay line inputs, one block for each delay line            */
+/*  pOutput                 Stereo output                                               */
+/*  NumSamples              Number of samples to process                                */
+/*                                                                                      */
+/* NOTES:                                                                               */
+/*  1. The delay line outputs are in pPrivate->pScratchDelayLine                        */
+/*                                                                                      */
+/****************************************************************************************/
+template <int NumDelays>
+static void ReverbFeedbackNetwork(LVREV_Instance_st* pPrivate, const LVM_FLOAT* pIn,
+                                  LVM_FLOAT* const* pDelayLineInput, LVM_FLOAT* pOutput,
+                                  LVM_UINT16 NumSamples) {
+    LVM_FLOAT A0[NumDelays], A1[NumDelays], B1[NumDelays], X1[NumDelays], Y1[NumDelays];
+    const LVM_FLOAT* pDelayLine[NumDelays];
+
+    for (int j = 0; j < NumDelays; j++) {
+        A0[j] = pPrivate->RevLPF_A0[j];
+        A1[j] = pPrivate->RevLPF_A1[j];
+        B1[j] = pPrivate->RevLPF_B1[j];
+        X1[j] = pPrivate->RevLPF_X1[j];
+        Y1[j] = pPrivate->RevLPF_Y1[j];
+        pDelayLine[j] = pPrivate->pScratchDelayLine[j];
+    }
+
+    for (LVM_UINT16 n = 0; n < NumSamples; n++) {
+        /*
+         *  Low pass filter
+         */
+        LVM_FLOAT D[NumDelays];
+        for (int j = 0; j < NumDelays; j++) {
+            const LVM_FLOAT X = pDelayLine[j][n];
+            D[j] = A0[j] * X + A1[j] * X1[j] + B1[j] * Y1[j];
+            X1[j] = X;
+            Y1[j] = D[j];
+        }
+
+        /*
+         *  Rotation matrix mix into the delay line inputs, and stereo output
+         */
+        const LVM_FLOAT In = pIn[n];
+        if constexpr (NumDelays == LVREV_DELAYLINES_4) {
+            pDelayLineInput[0][n] = LVM_Clamp(LVM_Clamp(In - D[1]) + D[2]);
+            pDelayLineInput[1][n] = LVM_Clamp(LVM_Clamp(In - D[0]) + D[3]);
+            pDelayLineInput[2][n] = LVM_Clamp(LVM_Clamp(In - D[0]) - D[3]);
+            pDelayLineInput[3][n] = LVM_Clamp(LVM_Clamp(In - D[1]) - D[2]);
+            pOutput[2 * n] = LVM_Clamp(D[0] + D[3]);
+            pOutput[2 * n + 1] = LVM_Clamp(D[1] + D[2]);
+        } else if constexpr (NumDelays == LVREV_DELAYLINES_2) {
+            pDelayLineInput[0][n] = LVM_Clamp(LVM_Clamp(In + D[0]) - D[1]);
+            pDelayLineInput[1][n] = LVM_Clamp(LVM_Clamp(In - D[0]) - D[1]);
+            pOutput[2 * n] = LVM_Clamp(D[0] + D[1]);
+            pOutput[2 * n + 1] = LVM_Clamp(D[1] - D[0]);
+        } else {
+            pDelayLineInput[0][n] = LVM_Clamp(In + D[0]);
+            pOutput[2 * n] = D[0];
+            pOutput[2 * n + 1] = D[0];
+        }
+    }
+
+    for (int j = 0; j < NumDelays; j++) {
+        pPrivate->RevLPF_X1[j] = X1[j];
+        pPrivate->RevLPF_Y1[j] = Y1[j];
+    }
+}
+
 /****************************************************************************************/
 /*                                                                                      */
 /* FUNCTION:                ReverbBlock                                                 */
@@ -159,7 +238,8 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
                  LVM_UINT16 NumSamples) {
     LVM_INT16 j, size;
     LVM_FLOAT* pDelayLine;
-    LVM_FLOAT* pDelayLineInput = pPrivate->pScratch;
+    LVM_FLOAT* pDelay_T[LVREV_DELAYLINES_4];
+    LVM_FLOAT* pDelayLineInput[LVREV_DELAYLINES_4];
     LVM_FLOAT* pScratch = pPrivate->pScratch;
     LVM_FLOAT* pIn;
     LVM_FLOAT* pTemp = pPrivate->pInputSave;
@@ -211,39 +291,48 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
      */
     pPrivate->pRevLPFBiquad->process(pTemp, pTemp, NumSamples);
 
+    /*
+     *  Move the delay lines back to the start of their buffers if there is no room left for
+     *  them to slide by this block
+     */
+    if (pPrivate->DelayOffset + NumSamples > pPrivate->DelaySlack) {
+        for (j = 0; j < NumberOfDelayLines; j++) {
+            memmove(pPrivate->pDelay_T[j], &pPrivate->pDelay_T[j][pPrivate->DelayOffset],
+                    pPrivate->T[j] * sizeof(LVM_FLOAT));
+        }
+        pPrivate->DelayOffset = 0;
+    }
+
     /*
      *  Process all delay lines
      */
 
     for (j = 0; j < NumberOfDelayLines; j++) {
         pDelayLine = pPrivate->pScratchDelayLine[j];
+        /* The delay line after this block, the last block of it is the fixed delay input */
+        pDelay_T[j] = &pPrivate->pDelay_T[j][pPrivate->DelayOffset + NumSamples];
 
         /*
          * All-pass filter with pop and click suppression
          */
         /* Get the smoothed, delayed output. Put it in the output buffer */
-        MixSoft_2St_D32C31_SAT(&pPrivate->Mixer_APTaps[j], pPrivate->pOffsetA[j],
-                               pPrivate->pOffsetB[j], pDelayLine, (LVM_INT16)NumSamples);
-        /* Re-align the all pass filter delay buffer and copying the fixed delay data \
-           to the AP delay in the process */
-        Copy_Float(&pPrivate->pDelay_T[j][NumSamples], pPrivate->pDelay_T[j],
-                   (LVM_INT16)(pPrivate->T[j] - NumSamples)); /* 32-bit data */
+        MixSoft_2St_D32C31_SAT(&pPrivate->Mixer_APTaps[j],
+                               pPrivate->pOffsetA[j] + pPrivate->DelayOffset,
+                               pPrivate->pOffsetB[j] + pPrivate->DelayOffset, pDelayLine,
+                               (LVM_INT16)NumSamples);
         /* Apply the smoothed feedback and save to fixed delay input (currently empty) */
         MixSoft_1St_D32C31_WRA(&pPrivate->Mixer_SGFeedback[j], pDelayLine,
-                               &pPrivate->pDelay_T[j][pPrivate->T[j] - NumSamples],
-                               (LVM_INT16)NumSamples);
+                               &pDelay_T[j][pPrivate->T[j] - NumSamples], (LVM_INT16)NumSamples);
         /* Sum into the AP delay line */
-        Mac3s_Sat_Float(&pPrivate->pDelay_T[j][pPrivate->T[j] - NumSamples],
+        Mac3s_Sat_Float(&pDelay_T[j][pPrivate->T[j] - NumSamples],
                         -1.0f, /* Invert since the feedback coefficient is negative */
-                        &pPrivate->pDelay_T[j][pPrivate->Delay_AP[j] - NumSamples],
-                        (LVM_INT16)NumSamples);
+                        &pDelay_T[j][pPrivate->Delay_AP[j] - NumSamples], (LVM_INT16)NumSamples);
         /* Apply smoothed feedforward sand save to fixed delay input (currently empty) */
         MixSoft_1St_D32C31_WRA(&pPrivate->Mixer_SGFeedforward[j],
-                               &pPrivate->pDelay_T[j][pPrivate->Delay_AP[j] - NumSamples],
-                               &pPrivate->pDelay_T[j][pPrivate->T[j] - NumSamples],
-                               (LVM_INT16)NumSamples);
+                               &pDelay_T[j][pPrivate->Delay_AP[j] - NumSamples],
+                               &pDelay_T[j][pPrivate->T[j] - NumSamples], (LVM_INT16)NumSamples);
         /* Sum into the AP output */
-        Mac3s_Sat_Float(&pPrivate->pDelay_T[j][pPrivate->T[j] - NumSamples], 1.0f, pDelayLine,
+        Mac3s_Sat_Float(&pDelay_T[j][pPrivate->T[j] - NumSamples], 1.0f, pDelayLine,
                         (LVM_INT16)NumSamples);
 
         /*
@@ -251,129 +340,23 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
          */
         MixSoft_1St_D32C31_WRA(&pPrivate->FeedbackMixer[j], pDelayLine, pDelayLine, NumSamples);
 
-        /*
-         *  Low pass filter
-         */
-        pPrivate->revLPFBiquad[j]->process(pDelayLine, pDelayLine, NumSamples);
+        pDelayLineInput[j] = &pDelay_T[j][pPrivate->T[j] - NumSamples];
     }
+    pPrivate->DelayOffset += NumSamples;
 
     /*
-     *  Apply rotation matrix and delay samples
-     */
-    for (j = 0; j < NumberOfDelayLines; j++) {
-        Copy_Float(pTemp, pDelayLineInput, (LVM_INT16)(NumSamples));
-        /*
-         *  Rotation matrix mix
-         */
-        switch (j) {
-            case 3:
-                /*
-                 *  Add delay line 1 and 2 contribution
-                 */
-                Mac3s_Sat_Float(pPrivate->pScratchDelayLine[1], -1.0f, pDelayLineInput,
-                                (LVM_INT16)NumSamples);
-                Mac3s_Sat_Float(pPrivate->pScratchDelayLine[2], -1.0f, pDelayLineInput,
-                                (LVM_INT16)NumSamples);
-
-                break;
-            case 2:
-
-                /*
-                 *  Add delay line 0 and 3 contribution
-                 */
-                Mac3s_Sat_Float(pPrivate->pScratchDelayLine[0], -1.0f, pDelayLineInput,
-                                (LVM_INT16)NumSamples);
-                Mac3s_Sat_Float(pPrivate->pScratchDelayLine[3], -1.0f, pDelayLineInput,
-                                (LVM_INT16)NumSamples);
-
-                break;
-            case 1:
-                if (pPrivate->InstanceParams.NumDelays == LVREV_DELAYLINES_4) {
-                    /*
-                     *  Add delay line 0 and 3 contribution
-                     */
-                    Mac3s_Sat_Float(pPrivate->pScratchDelayLine[0], -1.0f, pDelayLineInput,
-                                    (LVM_INT16)NumSamples);
-                    Add2_Sat_Float(pPrivate->pScratchDelayLine[3], pDelayLineInput,
-                                   (LVM_INT16)NumSamples);
-
-                } else {
-                    /*
-                     *  Add delay line 0 and 1 contribution
-                     */
-                    Mac3s_Sat_Float(pPrivate->pScratchDelayLine[0], -1.0f, pDelayLineInput,
-                                    (LVM_INT16)NumSamples);
-                    Mac3s_Sat_Float(pPrivate->pScratchDelayLine[1], -1.0f, pDelayLineInput,
-                                    (LVM_INT16)NumSamples);
-                }
-                break;
-            case 0:
-                if (pPrivate->InstanceParams.NumDelays == LVREV_DELAYLINES_4) {
-                    /*
-                     *  Add delay line 1 and 2 contribution
-                     */
-                    Mac3s_Sat_Float(pPrivate->pScratchDelayLine[1], -1.0f, pDelayLineInput,
-                                    (LVM_INT16)NumSamples);
-                    Add2_Sat_Float(pPrivate->pScratchDelayLine[2], pDelayLineInput,
-                                   (LVM_INT16)NumSamples);
-
-                } else if (pPrivate->InstanceParams.NumDelays == LVREV_DELAYLINES_2) {
-                    /*
-                     *  Add delay line 0 and 1 contribution
-                     */
-                    Add2_Sat_Float(pPrivate->pScratchDelayLine[0], pDelayLineInput,
-                                   (LVM_INT16)NumSamples);
-                    Mac3s_Sat_Float(pPrivate->pScratchDelayLine[1], -1.0f, pDelayLineInput,
-                                    (LVM_INT16)NumSamples);
-
-                } else {
-                    /*
-                     *  Add delay line 0 contribution
-                     */
-
-                    /*             SOURCE                          DESTINATION*/
-                    Add2_Sat_Float(pPrivate->pScratchDelayLine[0], pDelayLineInput,
-                                   (LVM_INT16)NumSamples);
-                }
-                break;
-            default:
-                break;
-        }
-
-        /*
-         *  Delay samples
-         */
-        Copy_Float(pDelayLineInput, &pPrivate->pDelay_T[j][pPrivate->T[j] - NumSamples],
-                   (LVM_INT16)(NumSamples)); /* 32-bit data */
-    }
-
-    /*
-     *  Create stereo output
+     *  Low pass filter, apply rotation matrix, delay samples and create stereo output
      */
+    Copy_Float(pTemp, pScratch, (LVM_INT16)NumSamples);
     switch (pPrivate->InstanceParams.NumDelays) {
         case LVREV_DELAYLINES_4:
-            Add2_Sat_Float(pPrivate->pScratchDelayLine[3], pPrivate->pScratchDelayLine[0],
-                           (LVM_INT16)NumSamples);
-            Add2_Sat_Float(pPrivate->pScratchDelayLine[2], pPrivate->pScratchDelayLine[1],
-                           (LVM_INT16)NumSamples);
-
-            JoinTo2i_Float(pPrivate->pScratchDelayLine[0], pPrivate->pScratchDelayLine[1], pTemp,
-                           (LVM_INT16)NumSamples);
-
+            ReverbFeedbackNetwork<4>(pPrivate, pScratch, pDelayLineInput, pTemp, NumSamples);
             break;
         case LVREV_DELAYLINES_2:
-
-            Copy_Float(pPrivate->pScratchDelayLine[1], pScratch, (LVM_INT16)(NumSamples));
-
-            Mac3s_Sat_Float(pPrivate->pScratchDelayLine[0], -1.0f, pScratch, (LVM_INT16)NumSamples);
-
-            Add2_Sat_Float(pPrivate->pScratchDelayLine[1], pPrivate->pScratchDelayLine[0],
-                           (LVM_INT16)NumSamples);
-
-            JoinTo2i_Float(pPrivate->pScratchDelayLine[0], pScratch, pTemp, (LVM_INT16)NumSamples);
+            ReverbFeedbackNetwork<2>(pPrivate, pScratch, pDelayLineInput, pTemp, NumSamples);
             break;
         case LVREV_DELAYLINES_1:
-            MonoTo2I_Float(pPrivate->pScratchDelayLine[0], pTemp, (LVM_INT16)NumSamples);
+            ReverbFeedbackNetwork<1>(pPrivate, pScratch, pDelayLineInput, pTemp, NumSamples);
             break;
         default:
             break;
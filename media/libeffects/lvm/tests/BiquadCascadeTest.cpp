@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "BiquadCascade.h"
+
+using lvm::BiquadCascade;
+
+namespace {
+
+constexpr size_t kFrameCount = 1000;
+// Processed in blocks of varying sizes, including blocks shorter than the cascade.
+constexpr size_t kBlockSizes[] = {1, 3, 64, 2, 240, 5, 685};
+// Relative to the peak of the reference output: about the float rounding of the
+// per band processing that the cascade replaces, for a narrow 60 Hz band.
+constexpr double kTolerance = 2e-5;
+
+// Peaking equaliser bands in the form used by LVEQNB: x + gain * H(x), where H is a
+// band pass filter with coefficients {b0, 0, -b0, a1, a2}.
+std::vector<std::pair<BiquadCascade::Coefs, float>> makeBands(size_t count) {
+    std::vector<std::pair<BiquadCascade::Coefs, float>> bands;
+    for (size_t i = 0; i < count; ++i) {
+        // 60 Hz to 14 kHz at 48 kHz
+        const double frequency =
+                60. * pow(14000. / 60., count > 1 ? double(i) / (count - 1) : 0.);
+        const double w0 = 2. * M_PI * frequency / 48000.;
+        const double q = 0.7 + 0.3 * i;
+        const double b2 = -0.5 * (2 * q - sin(w0)) / (2 * q + sin(w0));
+        const double b1 = (0.5 - b2) * cos(w0);
+        const double a0 = (0.5 + b2) / 2.0;
+        const float gain = i % 2 ? -0.6f : 1.8f;
+        bands.push_back({{float(2 * a0), 0.f, float(-2 * a0), float(-2 * b1), float(-2 * b2)},
+                         gain});
+    }
+    return bands;
+}
+
+// The sequence of bands, each computed separately in double precision.
+std::vector<double> referenceOutput(
+        const std::vector<std::pair<BiquadCascade::Coefs, float>>& bands,
+        const std::vector<float>& input, size_t channelCount) {
+    std::vector<double> data(input.begin(), input.end());
+    for (const auto& [c, gain] : bands) {
+        for (size_t ch = 0; ch < channelCount; ++ch) {
+            double s0 = 0, s1 = 0;
+            for (size_t n = 0; n < data.size() / channelCount; ++n) {
+                const double x = data[n * channelCount + ch];
+                const double y = c[0] * x + s0;
+                s0 = c[1] * x - c[3] * y + s1;
+                s1 = c[2] * x - c[4] * y;
+                data[n * channelCount + ch] = x + gain * y;
+            }
+        }
+    }
+    return data;
+}
+
+using BiquadCascadeTestParam = std::tuple<size_t /* channelCount */, size_t /* sectionCount */,
+                                          BiquadCascade::Layout>;
+
+class BiquadCascadeTest : public ::testing::TestWithParam<BiquadCascadeTestParam> {};
+
+TEST_P(BiquadCascadeTest, MatchesSeparateBands) {
+    const auto [channelCount, sectionCount, layout] = GetParam();
+    const auto bands = makeBands(sectionCount);
+
+    std::minstd_rand gen(channelCount * 100 + sectionCount);
+    std::uniform_real_distribution<> dis(-0.5, 0.5);
+    std::vector<float> input(kFrameCount * channelCount);
+    for (auto& sample : input) {
+        sample = dis(gen);
+    }
+    const std::vector<double> reference = referenceOutput(bands, input, channelCount);
+
+    std::vector<BiquadCascade::Section> sections;
+    for (const auto& [coefs, gain] : bands) {
+        sections.push_back({coefs, gain, 1.f /* direct */});
+    }
+    BiquadCascade cascade(channelCount);
+    cascade.setSections(sections);
+    cascade.setLayout(layout);
+    if (layout == BiquadCascade::Layout::SECTION_PARALLEL) {
+        ASSERT_EQ(channelCount <= 2 && sectionCount >= 2 &&
+                                  channelCount * sectionCount <= BiquadCascade::kMaxParallelLanes
+                          ? BiquadCascade::Layout::SECTION_PARALLEL
+                          : BiquadCascade::Layout::CHANNEL_INTERLEAVED,
+                  cascade.getLayout());
+    }
+
+    // in place, in blocks
+    std::vector<float> output = input;
+    for (size_t frame = 0, block = 0; frame < kFrameCount; ++block) {
+        const size_t frames =
+                std::min(kBlockSizes[block % std::size(kBlockSizes)], kFrameCount - frame);
+        cascade.process(&output[frame * channelCount], &output[frame * channelCount], frames);
+        frame += frames;
+    }
+
+    double peak = 0;
+    for (const double sample : reference) {
+        peak = std::max(peak, fabs(sample));
+    }
+    for (size_t i = 0; i < output.size(); ++i) {
+        ASSERT_NEAR(reference[i], output[i], kTolerance * peak) << "sample " << i;
+    }
+
+    // the history is cleared
+    cascade.clear();
+    std::vector<float> again(input.size());
+    cascade.process(again.data(), input.data(), kFrameCount);
+    for (size_t i = 0; i < again.size(); ++i) {
+        ASSERT_NEAR(reference[i], again[i], kTolerance * peak) << "sample " << i;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        BiquadCascade, BiquadCascadeTest,
+        ::testing::Combine(::testing::Values(1, 2, 3, 6, 8), ::testing::Values(1, 2, 5, 8),
+                           ::testing::Values(BiquadCascade::Layout::CHANNEL_INTERLEAVED,
+                                             BiquadCascade::Layout::SECTION_PARALLEL)));
+
+TEST(BiquadCascadeTest, NoSectionsCopies) {
+    BiquadCascade cascade(2);
+    const std::vector<float> input = {0.1f, -0.2f, 0.3f, -0.4f};
+    std::vector<float> output(input.size());
+    cascade.process(output.data(), input.data(), input.size() / 2);
+    EXPECT_EQ(input, output);
+}
+
+}  // namespace
@@ -31,6 +31,7 @@
 
 #include <audio_effects/effect_visualizer.h>
 #include <audio_utils/primitives.h>
+#include <visualizer/VisualizerSpectrum.h>
 
 #ifdef BUILD_FLOAT
 
@@ -102,6 +103,8 @@ struct VisualizerContext {
     uint8_t mMeasurementWindowSizeInBuffers;
     uint8_t mMeasurementBufferIdx;
     BufferStats mPastMeasurements[MEASUREMENT_WINDOW_MAX_SIZE_IN_BUFFERS];
+    // for spectrum capture, see effect_visualizer_spectrum.h
+    android::VisualizerSpectrum mSpectrum;
 };
 
 //
@@ -132,6 +135,7 @@ void Visualizer_reset(VisualizerContext *pContext)
     pContext->mBufferUpdateTime.tv_sec = 0;
     pContext->mLatency = 0;
     memset(pContext->mCaptureBuf, 0x80, CAPTURE_BUF_SIZE);
+    pContext->mSpectrum.reset();
 }
 
 //----------------------------------------------------------------------------
@@ -239,6 +243,9 @@ int Visualizer_init(VisualizerContext *pContext)
         pContext->mPastMeasurements[i].mRmsSquared = 0;
     }
 
+    // spectrum capture initialization: disabled, the buffers are kept if already allocated.
+    pContext->mSpectrum.setSize(0);
+
     Visualizer_setConfig(pContext, &pContext->mConfig);
 
     return 0;
@@ -447,6 +454,15 @@ int Visualizer_process(
 #endif // BUILD_FLOAT
     }
 
+    // the float history is only kept while spectrums are requested
+    if (pContext->mSpectrum.isCapturing(pContext->mConfig.inputCfg.samplingRate)) {
+#ifdef BUILD_FLOAT
+        pContext->mSpectrum.write(inBuffer->f32, inBuffer->frameCount, pContext->mChannelCount);
+#else
+        pContext->mSpectrum.writeStereo16(inBuffer->s16, inBuffer->frameCount);
+#endif // BUILD_FLOAT
+    }
+
     // XXX the following two should really be atomic, though it probably doesn't
     // matter much for visualization purposes
     pContext->mCaptureIdx = captIdx;
@@ -572,6 +588,12 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
             p->vsize = sizeof(uint32_t);
             *replySize += sizeof(uint32_t);
             break;
+        case VISUALIZER_PARAM_SPECTRUM_SIZE:
+            *((uint32_t *)p->data + 1) = pContext->mSpectrum.getSize();
+            ALOGV("get spectrum size = %" PRIu32, *((uint32_t *)p->data + 1));
+            p->vsize = sizeof(uint32_t);
+            *replySize += sizeof(uint32_t);
+            break;
         default:
             p->status = -EINVAL;
         }
@@ -616,6 +638,11 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
             pContext->mMeasurementMode = *((uint32_t *)p->data + 1);
             ALOGV("set mMeasurementMode = %" PRIu32, pContext->mMeasurementMode);
             break;
+        case VISUALIZER_PARAM_SPECTRUM_SIZE: {
+            const uint32_t spectrumSize = *((uint32_t *)p->data + 1);
+            *(int32_t *)pReplyData = pContext->mSpectrum.setSize(spectrumSize);
+            ALOGV("set spectrum size = %u: %d", spectrumSize, *(int32_t *)pReplyData);
+            } break;
         default:
             *(int32_t *)pReplyData = -EINVAL;
         }
@@ -688,6 +715,26 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
 
         } break;
 
+    case VISUALIZER_CMD_CAPTURE_SPECTRUM: {
+        const uint32_t spectrumSize = pContext->mSpectrum.getSize();
+        if (spectrumSize == 0 || pReplyData == NULL || replySize == NULL ||
+                *replySize != android::VisualizerSpectrum::getReplySize(spectrumSize)) {
+            ALOGV("VISUALIZER_CMD_CAPTURE_SPECTRUM() error spectrumSize %" PRIu32, spectrumSize);
+            return -EINVAL;
+        }
+        const uint32_t sampleRate = pContext->mConfig.inputCfg.samplingRate;
+        if (pContext->mState != VISUALIZER_STATE_ACTIVE) {
+            pContext->mSpectrum.captureSilence(sampleRate, pReplyData);
+            break;
+        }
+        // the history is stale if process() was not called for a while
+        const uint32_t deltaMs = Visualizer_getDeltaTimeMsFromUpdatedTime(pContext);
+        const bool stalled = pContext->mBufferUpdateTime.tv_sec == 0 ||
+                deltaMs > MAX_STALL_TIME_MS;
+        const uint32_t latencyMs = pContext->mLatency > deltaMs ? pContext->mLatency - deltaMs : 0;
+        pContext->mSpectrum.capture(sampleRate, latencyMs, stalled, pReplyData);
+        } break;
+
     case VISUALIZER_CMD_MEASURE: {
         if (pReplyData == NULL || replySize == NULL ||
                 *replySize < (sizeof(int32_t) * MEASUREMENT_COUNT)) {
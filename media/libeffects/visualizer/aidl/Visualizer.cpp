@@ -16,11 +16,13 @@
 
 #define LOG_TAG "AHAL_VisualizerLibEffects"
 
+#include <aidl/android/hardware/audio/effect/DefaultExtension.h>
 #include <android-base/logging.h>
 #include <system/audio_effects/effect_uuid.h>
 
 #include "Visualizer.h"
 
+using aidl::android::hardware::audio::effect::DefaultExtension;
 using aidl::android::hardware::audio::effect::Descriptor;
 using aidl::android::hardware::audio::effect::getEffectImplUuidVisualizer;
 using aidl::android::hardware::audio::effect::getEffectTypeUuidVisualizer;
@@ -139,6 +141,9 @@ ndk::ScopedAStatus VisualizerImpl::setParameterSpecific(const Parameter::Specifi
                       EX_ILLEGAL_ARGUMENT, "setLatencyFailed");
             return ndk::ScopedAStatus::ok();
         }
+        case Visualizer::vendor: {
+            return setParameterVendor(param.get<Visualizer::vendor>());
+        }
         default: {
             LOG(ERROR) << __func__ << " unsupported tag: " << toString(tag);
             return ndk::ScopedAStatus::fromExceptionCodeWithMessage(
@@ -158,6 +163,10 @@ ndk::ScopedAStatus VisualizerImpl::getParameterSpecific(const Parameter::Id& id,
         case Visualizer::Id::commonTag: {
             return getParameterVisualizer(specificId.get<Visualizer::Id::commonTag>(), specific);
         }
+        case Visualizer::Id::vendorExtensionTag: {
+            return getParameterVendor(specificId.get<Visualizer::Id::vendorExtensionTag>(),
+                                      specific);
+        }
         default: {
             LOG(ERROR) << __func__ << " unsupported tag: " << toString(specificTag);
             return ndk::ScopedAStatus::fromExceptionCodeWithMessage(EX_ILLEGAL_ARGUMENT,
@@ -208,6 +217,70 @@ ndk::ScopedAStatus VisualizerImpl::getParameterVisualizer(const Visualizer::Tag&
     return ndk::ScopedAStatus::ok();
 }
 
+// The vendor extension holds the effect_param_t of a legacy parameter, with a uint32_t parameter.
+ndk::ScopedAStatus VisualizerImpl::setParameterVendor(const VendorExtension& vendor) {
+    RETURN_IF(!mContext, EX_NULL_POINTER, "nullContext");
+
+    std::optional<DefaultExtension> ext;
+    RETURN_IF(vendor.extension.getParcelable(&ext) != STATUS_OK || !ext.has_value(),
+              EX_ILLEGAL_ARGUMENT, "invalidVendorExtension");
+    RETURN_IF(ext->bytes.size() != sizeof(effect_param_t) + 2 * sizeof(uint32_t),
+              EX_ILLEGAL_ARGUMENT, "invalidVendorParamSize");
+    const effect_param_t* p = (const effect_param_t*)ext->bytes.data();
+    RETURN_IF(p->psize != sizeof(uint32_t) || p->vsize != sizeof(uint32_t), EX_ILLEGAL_ARGUMENT,
+              "invalidVendorParamSize");
+    const uint32_t* data = (const uint32_t*)p->data;
+    RETURN_IF(data[0] != VISUALIZER_PARAM_SPECTRUM_SIZE, EX_ILLEGAL_ARGUMENT,
+              "VisualizerVendorParamNotSupported");
+    RETURN_IF(mContext->setSpectrumSize(data[1]) != RetCode::SUCCESS, EX_ILLEGAL_ARGUMENT,
+              "setSpectrumSizeFailed");
+    return ndk::ScopedAStatus::ok();
+}
+
+// Returns the vendor extension of the id, with the value of its effect_param_t filled in.
+ndk::ScopedAStatus VisualizerImpl::getParameterVendor(const VendorExtension& id,
+                                                      Parameter::Specific* specific) {
+    RETURN_IF(!mContext, EX_NULL_POINTER, "nullContext");
+
+    std::optional<DefaultExtension> ext;
+    RETURN_IF(id.extension.getParcelable(&ext) != STATUS_OK || !ext.has_value(),
+              EX_ILLEGAL_ARGUMENT, "invalidVendorExtension");
+    RETURN_IF(ext->bytes.size() < sizeof(effect_param_t) + sizeof(uint32_t), EX_ILLEGAL_ARGUMENT,
+              "invalidVendorParamSize");
+    effect_param_t* p = (effect_param_t*)ext->bytes.data();
+    RETURN_IF(p->psize != sizeof(uint32_t) ||
+                      ext->bytes.size() != sizeof(effect_param_t) + sizeof(uint32_t) + p->vsize,
+              EX_ILLEGAL_ARGUMENT, "invalidVendorParamSize");
+    uint32_t* data = (uint32_t*)p->data;
+    switch (data[0]) {
+        case VISUALIZER_PARAM_SPECTRUM_SIZE: {
+            RETURN_IF(p->vsize != sizeof(uint32_t), EX_ILLEGAL_ARGUMENT, "invalidVendorParamSize");
+            data[1] = mContext->getSpectrumSize();
+            break;
+        }
+        case VISUALIZER_PARAM_SPECTRUM: {
+            const uint32_t size = mContext->getSpectrumSize();
+            RETURN_IF(size == 0 || p->vsize != ::android::VisualizerSpectrum::getReplySize(size),
+                      EX_ILLEGAL_ARGUMENT, "invalidSpectrumSize");
+            const std::vector<uint8_t> spectrum = mContext->captureSpectrum();
+            memcpy(data + 1, spectrum.data(), spectrum.size());
+            break;
+        }
+        default: {
+            LOG(ERROR) << __func__ << " unsupported parameter: " << data[0];
+            return ndk::ScopedAStatus::fromExceptionCodeWithMessage(
+                    EX_ILLEGAL_ARGUMENT, "VisualizerVendorParamNotSupported");
+        }
+    }
+    p->status = 0;
+
+    VendorExtension vendor;
+    vendor.extension.setParcelable(ext.value());
+    specific->set<Parameter::Specific::visualizer>(
+            Visualizer::make<Visualizer::vendor>(std::move(vendor)));
+    return ndk::ScopedAStatus::ok();
+}
+
 std::shared_ptr<EffectContext> VisualizerImpl::createContext(const Parameter::Common& common) {
     if (mContext) {
         LOG(DEBUG) << __func__ << " context already exist";
@@ -51,6 +51,10 @@ class VisualizerImpl final : public EffectImpl {
     std::shared_ptr<VisualizerContext> mContext GUARDED_BY(mImplMutex);
     ndk::ScopedAStatus getParameterVisualizer(const Visualizer::Tag& tag,
                                               Parameter::Specific* specific) REQUIRES(mImplMutex);
+    // spectrum capture parameters, see effect_visualizer_spectrum.h
+    ndk::ScopedAStatus setParameterVendor(const VendorExtension& vendor) REQUIRES(mImplMutex);
+    ndk::ScopedAStatus getParameterVendor(const VendorExtension& id, Parameter::Specific* specific)
+            REQUIRES(mImplMutex);
 };
 
 }  // namespace aidl::android::hardware::audio::effect
@@ -79,6 +79,7 @@ RetCode VisualizerContext::disable() {
 
 void VisualizerContext::reset() {
     std::fill(mCaptureBuf.begin(), mCaptureBuf.end(), 0x80);
+    mSpectrum.reset();
 }
 
 RetCode VisualizerContext::setCaptureSamples(int samples) {
@@ -114,6 +115,14 @@ int VisualizerContext::getDownstreamLatency() {
     return mDownstreamLatency;
 }
 
+RetCode VisualizerContext::setSpectrumSize(uint32_t size) {
+    return mSpectrum.setSize(size) == 0 ? RetCode::SUCCESS : RetCode::ERROR_ILLEGAL_PARAMETER;
+}
+
+uint32_t VisualizerContext::getSpectrumSize() {
+    return mSpectrum.getSize();
+}
+
 uint32_t VisualizerContext::getDeltaTimeMsFromUpdatedTime_l() {
     uint32_t deltaMs = 0;
     if (mBufferUpdateTime.tv_sec != 0) {
@@ -225,6 +234,21 @@ std::vector<uint8_t> VisualizerContext::capture() {
     return result;
 }
 
+std::vector<uint8_t> VisualizerContext::captureSpectrum() {
+    const uint32_t sampleRate = mCommon.input.base.sampleRate;
+    std::vector<uint8_t> result(::android::VisualizerSpectrum::getReplySize(getSpectrumSize()));
+    if (mState != State::ACTIVE) {
+        mSpectrum.captureSilence(sampleRate, result.data());
+        return result;
+    }
+    // the history is stale if process() was not called for a while
+    const uint32_t deltaMs = getDeltaTimeMsFromUpdatedTime_l();
+    const bool stalled = mBufferUpdateTime.tv_sec == 0 || deltaMs > kMaxStallTimeMs;
+    const uint32_t latencyMs = mDownstreamLatency > deltaMs ? mDownstreamLatency - deltaMs : 0;
+    mSpectrum.capture(sampleRate, latencyMs, stalled, result.data());
+    return result;
+}
+
 IEffect::Status VisualizerContext::process(float* in, float* out, int samples) {
     IEffect::Status result = {STATUS_NOT_ENOUGH_DATA, 0, 0};
     RETURN_VALUE_IF(in == nullptr || out == nullptr || samples == 0, result, "dataBufferError");
@@ -296,6 +320,11 @@ IEffect::Status VisualizerContext::process(float* in, float* out, int samples) {
         mCaptureBuf[captIdx] = clamp8_from_float(smp * fscale);
     }
 
+    // the float history is only kept while spectrums are requested
+    if (mSpectrum.isCapturing(mCommon.input.base.sampleRate)) {
+        mSpectrum.write(in, samples / mChannelCount, mChannelCount);
+    }
+
     // the following two should really be atomic, though it probably doesn't
     // matter much for visualization purposes
     mCaptureIdx = captIdx;
@@ -18,6 +18,7 @@
 
 #include <audio_effects/effect_dynamicsprocessing.h>
 #include <system/audio_effects/effect_visualizer.h>
+#include <visualizer/VisualizerSpectrum.h>
 
 #include "effect-impl/EffectContext.h"
 
@@ -49,12 +50,18 @@ class VisualizerContext final : public EffectContext {
     Visualizer::ScalingMode getScalingMode();
     RetCode setDownstreamLatency(int latency);
     int getDownstreamLatency();
+    // see VISUALIZER_PARAM_SPECTRUM_SIZE in effect_visualizer_spectrum.h
+    RetCode setSpectrumSize(uint32_t size);
+    uint32_t getSpectrumSize();
 
     IEffect::Status process(float* in, float* out, int samples);
     // Gets the current measurements, measured by process() and consumed by getParameter()
     Visualizer::Measurement getMeasure();
     // Gets the latest PCM capture, data captured by process() and consumed by getParameter()
     std::vector<uint8_t> capture();
+    // Gets the latest spectrum, a visualizer_spectrum_t followed by the magnitudes, computed
+    // from the samples kept by process()
+    std::vector<uint8_t> captureSpectrum();
 
     struct BufferStats {
         bool mIsValid;
@@ -96,6 +103,7 @@ class VisualizerContext final : public EffectContext {
     uint8_t mMeasurementWindowSizeInBuffers = kMeasurementWindowMaxSizeInBuffers;
     uint8_t mMeasurementBufferIdx = 0;
     std::array<BufferStats, kMeasurementWindowMaxSizeInBuffers> mPastMeasurements;
+    ::android::VisualizerSpectrum mSpectrum;
     void init_params();
 
     uint32_t getDeltaTimeMsFromUpdatedTime_l();
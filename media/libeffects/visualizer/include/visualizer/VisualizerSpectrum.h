@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <vector>
+
+#include <system/audio_effects/effect_visualizer.h>
+
+#include "RealFft.h"
+#include "effect_visualizer_spectrum.h"
+
+namespace android {
+
+// The spectrum capture of the legacy and AIDL Visualizer effects,
+// see effect_visualizer_spectrum.h.
+//
+// process() appends the mono mix to a float history with write(), but only while isCapturing():
+// the capture is enabled, and a spectrum was requested in the last kIdleTimeMs, so that there is
+// no extra cost when nobody polls. The FFT is computed by capture(), on the command thread, and
+// only when new samples were written since the last spectrum; otherwise the cached one is
+// returned.
+//
+// write() and isCapturing() are called by the process thread, the other methods by the command
+// thread, possibly concurrently. The history position and the idle count are atomics, so that
+// a capture sees the samples written before the position it reads.
+class VisualizerSpectrum {
+  public:
+    static constexpr uint32_t kMinSize = VISUALIZER_CAPTURE_SIZE_MIN;
+    static constexpr uint32_t kMaxSize = VISUALIZER_SPECTRUM_SIZE_MAX;
+    // float mono history, a power of 2 above kMaxSize to allow for the downstream latency
+    static constexpr uint32_t kHistorySize = 32768;
+    // time without a spectrum request after which process() stops writing the history
+    static constexpr uint32_t kIdleTimeMs = 2000;
+    // -96 dB floor for the peak and RMS, as for the Visualizer measurements
+    static constexpr int32_t kSilenceMb = -9600;
+
+    static size_t getReplySize(uint32_t size) {
+        return sizeof(visualizer_spectrum_t) + (size / 2 + 1) * sizeof(float);
+    }
+
+    static int32_t linearToMb(float value) {
+        return value < 0.000016f ? kSilenceMb : (int32_t)(2000 * log10(value));
+    }
+
+    // Sets the spectrum size, a power of 2 from kMinSize to kMaxSize, or 0 to disable the
+    // capture. Returns 0, or -EINVAL if the size is invalid.
+    // The history is only allocated when first enabled, so that process() can keep writing to it.
+    int setSize(uint32_t size) {
+        if (size != 0 && (size < kMinSize || size > kMaxSize || (size & (size - 1)) != 0)) {
+            return -EINVAL;
+        }
+        if (size != 0) {
+            if (mHistory.empty()) {
+                mHistory.resize(kHistorySize);
+            }
+            mFft.setSize(size);
+            mWindow.resize(size);
+            for (uint32_t i = 0; i < size; i++) {
+                mWindow[i] = 0.5f - 0.5f * cos(2 * M_PI * i / size);
+            }
+            mTemp.resize(size);
+            mBins.resize(size / 2 + 1);
+            mMagnitudes.resize(size / 2 + 1);
+        }
+        mValid = false;
+        mIdleFrames.store(0, std::memory_order_relaxed);
+        // publishes the history to process()
+        mSize.store(size, std::memory_order_release);
+        return 0;
+    }
+
+    uint32_t getSize() const { return mSize.load(std::memory_order_relaxed); }
+
+    // Clears the history.
+    void reset() {
+        std::fill(mHistory.begin(), mHistory.end(), 0.f);
+        mFrames.store(0, std::memory_order_relaxed);
+        mIdleFrames.store(0, std::memory_order_release);
+        mValid = false;
+    }
+
+    // Process thread: returns true if write() must be called with the processed samples.
+    bool isCapturing(uint32_t sampleRate) const {
+        return mSize.load(std::memory_order_acquire) != 0 &&
+               mIdleFrames.load(std::memory_order_acquire) < getIdleFrameCount(sampleRate);
+    }
+
+    // Process thread: appends the mono mix of frameCount interleaved frames.
+    void write(const float* in, size_t frameCount, uint32_t channelCount) {
+        const float scale = 1.f / channelCount;
+        append(frameCount, [&](size_t frame) {
+            float sample = 0.f;
+            for (uint32_t i = 0; i < channelCount; ++i) {
+                sample += in[frame * channelCount + i];
+            }
+            return sample * scale;
+        });
+    }
+
+    // Process thread: appends the mono mix of frameCount stereo 16 bit frames.
+    void writeStereo16(const int16_t* in, size_t frameCount) {
+        append(frameCount, [&](size_t frame) {
+            return (in[2 * frame] + in[2 * frame + 1]) * (1.f / (1 << 16));
+        });
+    }
+
+    // Writes getReplySize(getSize()) bytes to reply: a visualizer_spectrum_t followed by the
+    // magnitudes of the latest getSize() samples written, latencyMs ago.
+    // The spectrum is silent if the history is idle, in which case process() resumes writing
+    // it, or if stalled is true, when process() has not been called for a while.
+    void capture(uint32_t sampleRate, uint32_t latencyMs, bool stalled, void* reply) {
+        const uint32_t size = getSize();
+        // the history is stale if process() stopped writing it
+        const bool idle =
+                mIdleFrames.load(std::memory_order_acquire) >= getIdleFrameCount(sampleRate);
+        if (idle) {
+            // process() does not write the history until mIdleFrames is cleared below
+            std::fill(mHistory.begin(), mHistory.end(), 0.f);
+        }
+        mIdleFrames.store(0, std::memory_order_release);
+        if (idle || stalled) {
+            mValid = false;
+            captureSilence(sampleRate, reply);
+            return;
+        }
+        const uint64_t frames = mFrames.load(std::memory_order_acquire);
+        if (!mValid || mLastFrames != frames || mHeader.samplingRate != sampleRate) {
+            compute(frames, sampleRate, latencyMs);
+            mLastFrames = frames;
+            mValid = true;
+        }
+        memcpy(reply, &mHeader, sizeof(visualizer_spectrum_t));
+        memcpy((visualizer_spectrum_t*)reply + 1, mMagnitudes.data(),
+               (size / 2 + 1) * sizeof(float));
+    }
+
+    // Writes a silent spectrum of getReplySize(getSize()) bytes to reply.
+    void captureSilence(uint32_t sampleRate, void* reply) const {
+        const uint32_t binCount = getSize() / 2 + 1;
+        visualizer_spectrum_t* header = (visualizer_spectrum_t*)reply;
+        header->binCount = binCount;
+        header->samplingRate = sampleRate;
+        header->peakMb = kSilenceMb;
+        header->rmsMb = kSilenceMb;
+        memset(header + 1, 0, binCount * sizeof(float));
+    }
+
+  private:
+    static uint32_t getIdleFrameCount(uint32_t sampleRate) {
+        return sampleRate / 1000 * kIdleTimeMs;
+    }
+
+    template <typename F>
+    void append(size_t frameCount, F sampleAt) {
+        float* history = mHistory.data();
+        // only written by the process thread
+        const uint64_t frames = mFrames.load(std::memory_order_relaxed);
+        uint32_t index = frames & (kHistorySize - 1);
+        for (size_t frame = 0; frame < frameCount; ++frame) {
+            history[index] = sampleAt(frame);
+            index = (index + 1) & (kHistorySize - 1);
+        }
+        // publishes the samples to capture()
+        mFrames.store(frames + frameCount, std::memory_order_release);
+        mIdleFrames.fetch_add(frameCount, std::memory_order_release);
+    }
+
+    // Computes the spectrum of the getSize() samples ending latencyMs before frames.
+    void compute(uint64_t frames, uint32_t sampleRate, uint32_t latencyMs) {
+        const uint32_t size = getSize();
+        uint64_t delta = size + (uint64_t)sampleRate * latencyMs / 1000;
+        if (delta > kHistorySize) {
+            delta = kHistorySize;
+        }
+
+        // samples not written yet are zero in the history
+        const uint32_t start = (frames - delta) & (kHistorySize - 1);
+        const uint32_t first = std::min(size, kHistorySize - start);
+        float* temp = mTemp.data();
+        memcpy(temp, &mHistory[start], first * sizeof(float));
+        memcpy(temp + first, &mHistory[0], (size - first) * sizeof(float));
+
+        float peak = 0.f;
+        float sumSquares = 0.f;
+        float windowSum = 0.f;
+        for (uint32_t i = 0; i < size; ++i) {
+            peak = fmax(peak, fabs(temp[i]));
+            sumSquares += temp[i] * temp[i];
+            windowSum += mWindow[i];
+            temp[i] *= mWindow[i];
+        }
+
+        mFft.forward(temp, mBins.data());
+        const uint32_t binCount = size / 2 + 1;
+        const float scale = 2.f / windowSum;
+        for (uint32_t k = 0; k < binCount; ++k) {
+            mMagnitudes[k] = std::abs(mBins[k]) * scale;
+        }
+        // DC and Nyquist have no mirrored bin
+        mMagnitudes[0] *= 0.5f;
+        mMagnitudes[binCount - 1] *= 0.5f;
+
+        mHeader.binCount = binCount;
+        mHeader.samplingRate = sampleRate;
+        mHeader.peakMb = linearToMb(peak);
+        mHeader.rmsMb = linearToMb(sqrtf(sumSquares / size));
+    }
+
+    // shared by the process and command threads
+    std::atomic<uint32_t> mSize = 0;        // 0 when disabled, published after mHistory
+    std::atomic<uint64_t> mFrames = 0;      // mono samples written to mHistory
+    std::atomic<uint32_t> mIdleFrames = 0;  // frames written since the last spectrum request
+    std::vector<float> mHistory;            // kHistorySize mono samples once enabled
+
+    // only accessed by the command thread
+    uint64_t mLastFrames = 0;               // mFrames of the cached spectrum
+    bool mValid = false;                    // mHeader and mMagnitudes hold a spectrum
+    visualizer_spectrum_t mHeader{};
+    std::vector<float> mMagnitudes;
+    std::vector<float> mWindow;
+    std::vector<float> mTemp;
+    std::vector<std::complex<float>> mBins;
+    dp_fx::RealFft mFft;
+};
+
+}  // namespace android
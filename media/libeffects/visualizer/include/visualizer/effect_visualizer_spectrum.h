@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_EFFECT_VISUALIZER_SPECTRUM_H_
+#define ANDROID_EFFECT_VISUALIZER_SPECTRUM_H_
+
+#include <stdint.h>
+
+#include <system/audio_effect.h>
+
+#if __cplusplus
+extern "C" {
+#endif
+
+// Spectrum capture of the Visualizer: the magnitudes of a Hann windowed FFT of the mono mix,
+// along with the peak and RMS of the same samples.
+//
+// VISUALIZER_PARAM_SPECTRUM_SIZE sets the FFT size, a power of 2 from
+// VISUALIZER_CAPTURE_SIZE_MIN to VISUALIZER_SPECTRUM_SIZE_MAX, or 0 (the default) to disable it.
+// VISUALIZER_CMD_CAPTURE_SPECTRUM replies with a visualizer_spectrum_t followed by binCount
+// floats: the magnitudes from DC to Nyquist, scaled so that a sine of amplitude A gives A.
+#ifndef VISUALIZER_PARAM_SPECTRUM_SIZE
+#define VISUALIZER_PARAM_SPECTRUM_SIZE 4
+#endif
+
+// Get only: the reply of VISUALIZER_CMD_CAPTURE_SPECTRUM as a parameter value, which is how
+// the command is carried to an AIDL Visualizer, in a vendor extension.
+#ifndef VISUALIZER_PARAM_SPECTRUM
+#define VISUALIZER_PARAM_SPECTRUM 5
+#endif
+
+#ifndef VISUALIZER_CMD_CAPTURE_SPECTRUM
+#define VISUALIZER_CMD_CAPTURE_SPECTRUM (EFFECT_CMD_FIRST_PROPRIETARY + 2)
+#endif
+
+#define VISUALIZER_SPECTRUM_SIZE_MAX 8192
+
+typedef struct visualizer_spectrum_s {
+    uint32_t binCount;     // spectrum size / 2 + 1
+    uint32_t samplingRate; // of the captured samples, in Hz
+    int32_t peakMb;        // peak of the captured samples, in mB
+    int32_t rmsMb;         // RMS of the captured samples, in mB
+} visualizer_spectrum_t;
+
+#if __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // ANDROID_EFFECT_VISUALIZER_SPECTRUM_H_
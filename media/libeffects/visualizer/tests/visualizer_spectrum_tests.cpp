@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <visualizer/VisualizerSpectrum.h>
+
+using android::VisualizerSpectrum;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kSize = 1024;
+constexpr uint32_t kBinCount = kSize / 2 + 1;
+constexpr uint32_t kChannelCount = 2;
+
+// A spectrum reply: the header followed by the magnitudes.
+struct Reply {
+    explicit Reply(uint32_t size) : bytes(VisualizerSpectrum::getReplySize(size)) {}
+    const visualizer_spectrum_t& header() const {
+        return *(const visualizer_spectrum_t*)bytes.data();
+    }
+    const float* magnitudes() const { return (const float*)(&header() + 1); }
+    void* data() { return bytes.data(); }
+    std::vector<uint8_t> bytes;
+};
+
+// Interleaved frames with the same sine on all channels, centered on bin of a kSize spectrum.
+std::vector<float> makeSine(size_t frameCount, uint32_t bin, float amplitude,
+                            size_t startFrame = 0) {
+    std::vector<float> frames(frameCount * kChannelCount);
+    for (size_t i = 0; i < frameCount; ++i) {
+        const float sample = amplitude * sin(2 * M_PI * bin * (startFrame + i) / kSize);
+        for (uint32_t c = 0; c < kChannelCount; ++c) {
+            frames[i * kChannelCount + c] = sample;
+        }
+    }
+    return frames;
+}
+
+int32_t toMb(double linear) {
+    return 2000 * log10(linear);
+}
+
+void expectSilent(const Reply& reply) {
+    EXPECT_EQ(kBinCount, reply.header().binCount);
+    EXPECT_EQ(kSampleRate, reply.header().samplingRate);
+    EXPECT_EQ(VisualizerSpectrum::kSilenceMb, reply.header().peakMb);
+    EXPECT_EQ(VisualizerSpectrum::kSilenceMb, reply.header().rmsMb);
+    for (uint32_t k = 0; k < kBinCount; ++k) {
+        ASSERT_EQ(0.f, reply.magnitudes()[k]) << "bin " << k;
+    }
+}
+
+class VisualizerSpectrumTest : public ::testing::Test {
+  protected:
+    void SetUp() override { ASSERT_EQ(0, mSpectrum.setSize(kSize)); }
+
+    void write(const std::vector<float>& frames) {
+        ASSERT_TRUE(mSpectrum.isCapturing(kSampleRate));
+        mSpectrum.write(frames.data(), frames.size() / kChannelCount, kChannelCount);
+    }
+
+    VisualizerSpectrum mSpectrum;
+    Reply mReply{kSize};
+};
+
+}  // namespace
+
+TEST(VisualizerSpectrumSizeTest, SetSize) {
+    VisualizerSpectrum spectrum;
+    EXPECT_EQ(0u, spectrum.getSize());
+    EXPECT_FALSE(spectrum.isCapturing(kSampleRate));
+
+    for (uint32_t size = VisualizerSpectrum::kMinSize; size <= VisualizerSpectrum::kMaxSize;
+         size *= 2) {
+        EXPECT_EQ(0, spectrum.setSize(size)) << size;
+        EXPECT_EQ(size, spectrum.getSize());
+        EXPECT_TRUE(spectrum.isCapturing(kSampleRate));
+    }
+
+    // invalid sizes keep the current one
+    for (uint32_t size : {1u, VisualizerSpectrum::kMinSize / 2, VisualizerSpectrum::kMinSize + 1,
+                          1000u, VisualizerSpectrum::kMaxSize * 2, UINT32_MAX}) {
+        EXPECT_EQ(-EINVAL, spectrum.setSize(size)) << size;
+        EXPECT_EQ(VisualizerSpectrum::kMaxSize, spectrum.getSize());
+    }
+
+    EXPECT_EQ(0, spectrum.setSize(0));
+    EXPECT_EQ(0u, spectrum.getSize());
+    EXPECT_FALSE(spectrum.isCapturing(kSampleRate));
+}
+
+TEST(VisualizerSpectrumSizeTest, ReplySize) {
+    EXPECT_EQ(sizeof(visualizer_spectrum_t) + 65 * sizeof(float),
+              VisualizerSpectrum::getReplySize(128));
+    EXPECT_EQ(sizeof(visualizer_spectrum_t) + 4097 * sizeof(float),
+              VisualizerSpectrum::getReplySize(VisualizerSpectrum::kMaxSize));
+}
+
+TEST_F(VisualizerSpectrumTest, Sine) {
+    constexpr uint32_t kBin = 64;
+    constexpr float kAmplitude = 0.5f;
+    write(makeSine(4 * kSize, kBin, kAmplitude));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+
+    EXPECT_EQ(kBinCount, mReply.header().binCount);
+    EXPECT_EQ(kSampleRate, mReply.header().samplingRate);
+    EXPECT_NEAR(toMb(kAmplitude), mReply.header().peakMb, 2);
+    EXPECT_NEAR(toMb(kAmplitude / sqrt(2)), mReply.header().rmsMb, 2);
+
+    // the Hann window spreads a bin centered sine on its neighbors, with half the magnitude
+    const float* magnitudes = mReply.magnitudes();
+    EXPECT_NEAR(kAmplitude, magnitudes[kBin], 1e-4);
+    EXPECT_NEAR(kAmplitude / 2, magnitudes[kBin - 1], 1e-4);
+    EXPECT_NEAR(kAmplitude / 2, magnitudes[kBin + 1], 1e-4);
+    for (uint32_t k = 0; k < kBinCount; ++k) {
+        if (k < kBin - 1 || k > kBin + 1) {
+            ASSERT_NEAR(0.f, magnitudes[k], 1e-4) << "bin " << k;
+        }
+    }
+}
+
+TEST_F(VisualizerSpectrumTest, Dc) {
+    constexpr float kLevel = 0.25f;
+    write(std::vector<float>(2 * kSize * kChannelCount, kLevel));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+
+    EXPECT_NEAR(toMb(kLevel), mReply.header().peakMb, 2);
+    EXPECT_NEAR(toMb(kLevel), mReply.header().rmsMb, 2);
+    // DC has no mirrored bin, so its Hann leakage on bin 1 has the same magnitude
+    EXPECT_NEAR(kLevel, mReply.magnitudes()[0], 1e-4);
+    EXPECT_NEAR(kLevel, mReply.magnitudes()[1], 1e-4);
+    for (uint32_t k = 2; k < kBinCount; ++k) {
+        ASSERT_NEAR(0.f, mReply.magnitudes()[k], 1e-4) << "bin " << k;
+    }
+}
+
+TEST_F(VisualizerSpectrumTest, MonoMix) {
+    // opposite channels cancel out
+    std::vector<float> frames(2 * kSize * kChannelCount);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        frames[i] = (i & 1) ? -0.5f : 0.5f;
+    }
+    write(frames);
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    expectSilent(mReply);
+
+    // 16 bit stereo is mixed the same way as float
+    constexpr uint32_t kBin = 100;
+    const std::vector<float> sine = makeSine(2 * kSize, kBin, 0.5f);
+    std::vector<int16_t> sine16(sine.size());
+    for (size_t i = 0; i < sine.size(); ++i) {
+        sine16[i] = lrintf(sine[i] * (1 << 15));
+    }
+    mSpectrum.writeStereo16(sine16.data(), sine16.size() / kChannelCount);
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    EXPECT_NEAR(0.5f, mReply.magnitudes()[kBin], 1e-3);
+    EXPECT_NEAR(toMb(0.5), mReply.header().peakMb, 2);
+}
+
+TEST_F(VisualizerSpectrumTest, Latency) {
+    // the sine is followed by silence, which is not played yet
+    constexpr uint32_t kBin = 32;
+    constexpr uint32_t kLatencyMs = 20;
+    constexpr size_t kLatencyFrames = kSampleRate * kLatencyMs / 1000;
+    write(makeSine(2 * kSize, kBin, 0.5f));
+    write(std::vector<float>(kLatencyFrames * kChannelCount));
+
+    mSpectrum.capture(kSampleRate, kLatencyMs, false /* stalled */, mReply.data());
+    EXPECT_NEAR(0.5f, mReply.magnitudes()[kBin], 1e-4);
+    EXPECT_NEAR(toMb(0.5), mReply.header().peakMb, 2);
+
+    // once played, the silence replaces the sine
+    write(std::vector<float>(kSize * kChannelCount));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    expectSilent(mReply);
+}
+
+TEST_F(VisualizerSpectrumTest, Cached) {
+    write(makeSine(2 * kSize, 10, 0.5f));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    Reply again(kSize);
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, again.data());
+    EXPECT_EQ(mReply.bytes, again.bytes);
+
+    write(makeSine(2 * kSize, 20, 0.5f));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, again.data());
+    EXPECT_NEAR(0.5f, again.magnitudes()[20], 1e-4);
+    EXPECT_NEAR(0.f, again.magnitudes()[10], 1e-4);
+}
+
+TEST_F(VisualizerSpectrumTest, Stalled) {
+    write(makeSine(2 * kSize, 10, 0.5f));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, true /* stalled */, mReply.data());
+    expectSilent(mReply);
+
+    // the history is kept, as process() may resume
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    EXPECT_NEAR(0.5f, mReply.magnitudes()[10], 1e-4);
+}
+
+TEST_F(VisualizerSpectrumTest, Idle) {
+    const uint32_t idleFrames = kSampleRate / 1000 * VisualizerSpectrum::kIdleTimeMs;
+    const std::vector<float> sine = makeSine(kSize, 16, 0.5f);
+    size_t written = 0;
+    while (mSpectrum.isCapturing(kSampleRate)) {
+        ASSERT_LT(written, idleFrames + kSize) << "still capturing without spectrum requests";
+        write(sine);
+        written += kSize;
+    }
+    EXPECT_GE(written, idleFrames);
+
+    // the first request after idling returns silence, and clears the stale history
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    expectSilent(mReply);
+    EXPECT_TRUE(mSpectrum.isCapturing(kSampleRate));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    expectSilent(mReply);
+
+    // then the capture resumes
+    write(makeSine(kSize, 16, 0.5f));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    EXPECT_NEAR(0.5f, mReply.magnitudes()[16], 1e-4);
+
+    // requests keep the capture going
+    for (size_t i = 0; i < 2 * idleFrames / kSize; ++i) {
+        write(sine);
+        mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    }
+    EXPECT_TRUE(mSpectrum.isCapturing(kSampleRate));
+}
+
+TEST_F(VisualizerSpectrumTest, Reset) {
+    write(makeSine(2 * kSize, 10, 0.5f));
+    mSpectrum.reset();
+    EXPECT_EQ(kSize, mSpectrum.getSize());
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    expectSilent(mReply);
+}
+
+// The process thread writes while the command thread captures: a spectrum is only ever made of
+// written samples, which are all within the sine amplitude.
+TEST_F(VisualizerSpectrumTest, ConcurrentCapture) {
+    constexpr float kAmplitude = 0.5f;
+    constexpr size_t kFrameCount = 240;
+    std::atomic<bool> done = false;
+    std::thread process([&] {
+        for (size_t i = 0; i < 2000; ++i) {
+            const std::vector<float> frames = makeSine(kFrameCount, 64, kAmplitude, i * kFrameCount);
+            if (mSpectrum.isCapturing(kSampleRate)) {
+                mSpectrum.write(frames.data(), kFrameCount, kChannelCount);
+            }
+        }
+        done = true;
+    });
+    while (!done) {
+        mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+        ASSERT_LE(mReply.header().peakMb, toMb(kAmplitude) + 2);
+        ASSERT_LE(mReply.magnitudes()[64], kAmplitude + 1e-4);
+    }
+    process.join();
+    // the last writes are skipped if the capture went idle
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    write(makeSine(2 * kSize, 64, kAmplitude));
+    mSpectrum.capture(kSampleRate, 0 /* latencyMs */, false /* stalled */, mReply.data());
+    EXPECT_NEAR(kAmplitude, mReply.magnitudes()[64], 1e-4);
+}
@@ -86,6 +86,7 @@
 // Property prefixes may be applied before a property name to indicate a specific
 // category to which it is associated.
 #define AMEDIAMETRICS_PROP_PREFIX_EFFECTIVE "effective."
+#define AMEDIAMETRICS_PROP_PREFIX_FASTTHREAD "fastThread." // FastMixer or FastCapture
 #define AMEDIAMETRICS_PROP_PREFIX_HAL       "hal."
 #define AMEDIAMETRICS_PROP_PREFIX_HAPTIC    "haptic."
 #define AMEDIAMETRICS_PROP_PREFIX_LAST      "last."
@@ -130,6 +131,10 @@
 #define AMEDIAMETRICS_PROP_CONTENTTYPE    "contentType"    // string attributes (AudioTrack)
 #define AMEDIAMETRICS_PROP_CUMULATIVETIMENS "cumulativeTimeNs" // int64_t playback/record time
                                                            // since start
+#define AMEDIAMETRICS_PROP_CYCLECOUNT     "cycleCount"     // int64_t number of fast thread cycles
+#define AMEDIAMETRICS_PROP_CYCLEUS_P50    "cycleUs.p50"    // int32 percentiles of the cycle time
+#define AMEDIAMETRICS_PROP_CYCLEUS_P99    "cycleUs.p99"
+#define AMEDIAMETRICS_PROP_CYCLEUS_P999   "cycleUs.p999"
 #define AMEDIAMETRICS_PROP_DEVICEDISCONNECTED "deviceDisconnected" // string true/false (MIDI)
 #define AMEDIAMETRICS_PROP_DEVICEID       "deviceId"       // int32 device id (MIDI)
 
@@ -166,8 +171,14 @@
 #define AMEDIAMETRICS_PROP_INTERNALTRACKID "internalTrackId" // int32
 #define AMEDIAMETRICS_PROP_INTERVALCOUNT  "intervalCount"  // int32
 #define AMEDIAMETRICS_PROP_ISSHARED      "isShared"       // string true/false (MIDI)
+#define AMEDIAMETRICS_PROP_JITTERUS_P50   "jitterUs.p50"   // int32 percentiles of the difference
+#define AMEDIAMETRICS_PROP_JITTERUS_P99   "jitterUs.p99"   // between cycle time and period
+#define AMEDIAMETRICS_PROP_JITTERUS_P999  "jitterUs.p999"
 #define AMEDIAMETRICS_PROP_LATENCYMS      "latencyMs"      // double value
 #define AMEDIAMETRICS_PROP_LEVELS         "levels"          // string | with levels
+#define AMEDIAMETRICS_PROP_LOADUS_P50     "loadUs.p50"     // int32 percentiles of the CPU time
+#define AMEDIAMETRICS_PROP_LOADUS_P99     "loadUs.p99"     // per cycle
+#define AMEDIAMETRICS_PROP_LOADUS_P999    "loadUs.p999"
 #define AMEDIAMETRICS_PROP_LOGSESSIONID   "logSessionId"   // hex string, "" none
 #define AMEDIAMETRICS_PROP_METHODCODE     "methodCode"     // int64_t an int indicating method
 #define AMEDIAMETRICS_PROP_METHODNAME     "methodName"     // string method name
@@ -255,6 +266,7 @@
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_DTOR       "dtor"
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAAUDIOSTREAM "endAAudioStream" // AAudioStream
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP "endAudioIntervalGroup"
+#define AMEDIAMETRICS_PROP_EVENT_VALUE_FASTTHREADLATENCY "fastThreadLatency" // Thread
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_FLUSH      "flush"  // AudioTrack
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_INVALIDATE "invalidate" // server track, record
 #define AMEDIAMETRICS_PROP_EVENT_VALUE_OPEN       "open"
@@ -30,6 +30,9 @@
 
 using namespace std::chrono_literals;
 
+// The Handle low bits and the wheel ticks are in ns.
+static_assert(std::ratio_equal_v<android::mediautils::TimerThread::Duration::period, std::nano>);
+
 namespace android::mediautils {
 
 extern std::string formatTime(std::chrono::system_clock::time_point t);
@@ -39,24 +42,23 @@ TimerThread::Handle TimerThread::scheduleTask(
         std::string_view tag, TimerCallback&& func,
         Duration timeoutDuration, Duration secondChanceDuration) {
     const auto now = std::chrono::system_clock::now();
-    auto request = std::make_shared<const Request>(now, now +
+    const Request request(now, now +
             std::chrono::duration_cast<std::chrono::system_clock::duration>(timeoutDuration),
             secondChanceDuration, getThreadIdWrapper(), tag);
-    return mMonitorThread.add(std::move(request), std::move(func), timeoutDuration);
+    return mMonitorThread.add(request, std::move(func), timeoutDuration);
 }
 
 TimerThread::Handle TimerThread::trackTask(std::string_view tag) {
     const auto now = std::chrono::system_clock::now();
-    auto request = std::make_shared<const Request>(now, now,
+    const Request request(now, now,
             Duration{} /* secondChanceDuration */, getThreadIdWrapper(), tag);
-    return mNoTimeoutMap.add(std::move(request));
+    return mMonitorThread.track(request);
 }
 
 bool TimerThread::cancelTask(Handle handle) {
-    std::shared_ptr<const Request> request = isNoTimeoutHandle(handle) ?
-             mNoTimeoutMap.remove(handle) : mMonitorThread.remove(handle);
+    const std::optional<Request> request = mMonitorThread.remove(handle);
     if (!request) return false;
-    mRetiredQueue.add(std::move(request));
+    mRetiredQueue.add(*request);
     return true;
 }
 
@@ -235,7 +237,6 @@ std::vector<std::shared_ptr<const TimerThread::Request>> TimerThread::getPending
 
     // following are internally locked calls, which add to our local pendingRequests.
     mMonitorThread.copyRequests(pendingRequests);
-    mNoTimeoutMap.copyRequests(pendingRequests);
 
     // Sort in order of scheduled time.
     std::sort(pendingRequests.begin(), pendingRequests.end(),
@@ -275,51 +276,241 @@ std::string TimerThread::Request::toString() const {
         .append(" tid ").append(std::to_string(tid));
 }
 
-void TimerThread::RequestQueue::add(std::shared_ptr<const Request> request) {
+void TimerThread::RequestQueue::add(const Request& request) {
     std::lock_guard lg(mRQMutex);
-    mRequestQueue.emplace_back(std::chrono::system_clock::now(), std::move(request));
-    if (mRequestQueue.size() > mRequestQueueMax) {
-        mRequestQueue.pop_front();
-    }
+    mRequestQueue[mRequestQueueAdded % mRequestQueueMax].emplace(request);
+    ++mRequestQueueAdded;
 }
 
 void TimerThread::RequestQueue::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests, size_t n) const {
     std::lock_guard lg(mRQMutex);
-    const size_t size = mRequestQueue.size();
-    size_t i = n >=  size ? 0 : size - n;
-    for (; i < size; ++i) {
-        const auto &[time, request] = mRequestQueue[i];
-        requests.emplace_back(request);
+    const size_t size = std::min(mRequestQueueAdded, mRequestQueueMax);
+    size_t i = mRequestQueueAdded - std::min(n, size);
+    for (; i < mRequestQueueAdded; ++i) {
+        requests.emplace_back(
+                std::make_shared<const Request>(*mRequestQueue[i % mRequestQueueMax]));
     }
 }
 
-TimerThread::Handle TimerThread::NoTimeoutMap::add(std::shared_ptr<const Request> request) {
-    std::lock_guard lg(mNTMutex);
-    // A unique handle is obtained by mNoTimeoutRequests.fetch_add(1),
-    // This need not be under a lock, but we do so anyhow.
-    const Handle handle = getUniqueHandle_l();
-    mMap[handle] = request;
-    return handle;
+// Rotates the slot bitmap right so that bit 0 is slot.
+static uint64_t rotateSlots(uint64_t slots, size_t slot) {
+    return slot == 0 ? slots : (slots >> slot) | (slots << (64 - slot));
 }
 
-std::shared_ptr<const TimerThread::Request> TimerThread::NoTimeoutMap::remove(Handle handle) {
-    std::lock_guard lg(mNTMutex);
-    auto it = mMap.find(handle);
-    if (it == mMap.end()) return {};
-    auto request = it->second;
-    mMap.erase(it);
-    return request;
+TimerThread::TaskShard::TaskShard()
+        : mCurrentTick(std::chrono::steady_clock::now().time_since_epoch().count() >> TICK_SHIFT) {
+    mHeads.fill(NO_TASK);
 }
 
-void TimerThread::NoTimeoutMap::copyRequests(
+void TimerThread::TaskShard::link_l(uint32_t index, uint16_t list) {
+    Task& task = task_l(index);
+    task.list = list;
+    task.prev = NO_TASK;
+    task.next = mHeads[list];
+    if (task.next != NO_TASK) task_l(task.next).prev = index;
+    mHeads[list] = index;
+    if (list < LIST_TRACKED) {
+        mOccupied[list / WHEEL_SLOTS] |= uint64_t{1} << (list % WHEEL_SLOTS);
+    }
+}
+
+void TimerThread::TaskShard::unlink_l(uint32_t index) {
+    Task& task = task_l(index);
+    if (task.prev != NO_TASK) {
+        task_l(task.prev).next = task.next;
+    } else {
+        mHeads[task.list] = task.next;
+    }
+    if (task.next != NO_TASK) {
+        task_l(task.next).prev = task.prev;
+    } else if (task.list == LIST_FREE) {
+        mFreeTail = task.prev;
+    }
+    if (task.list < LIST_TRACKED && mHeads[task.list] == NO_TASK) {
+        mOccupied[task.list / WHEEL_SLOTS] &= ~(uint64_t{1} << (task.list % WHEEL_SLOTS));
+    }
+}
+
+void TimerThread::TaskShard::schedule_l(uint32_t index) {
+    Task& task = task_l(index);
+    const int64_t tick = std::max(task.expiryTick, mCurrentTick);
+    // The finest level whose slots ahead cover the tick.
+    for (size_t level = 0; level < WHEEL_LEVELS; ++level) {
+        const size_t shift = level * WHEEL_BITS;
+        if ((tick >> shift) - (mCurrentTick >> shift) < int64_t{WHEEL_SLOTS}) {
+            link_l(index, level * WHEEL_SLOTS + ((tick >> shift) & (WHEEL_SLOTS - 1)));
+            return;
+        }
+    }
+    // Beyond the wheel, the task is placed in the last slot and moved again when reached.
+    constexpr size_t kShift = (WHEEL_LEVELS - 1) * WHEEL_BITS;
+    link_l(index, (WHEEL_LEVELS - 1) * WHEEL_SLOTS
+            + (((mCurrentTick >> kShift) + WHEEL_SLOTS - 1) & (WHEEL_SLOTS - 1)));
+}
+
+void TimerThread::TaskShard::free_l(uint32_t index) {
+    Task& task = task_l(index);
+    task.handle = INVALID_HANDLE;
+    task.secondChance = false;
+    ++task.generation;
+    // Appended, so that the slot is reused last.
+    task.list = LIST_FREE;
+    task.prev = mFreeTail;
+    task.next = NO_TASK;
+    if (mFreeTail != NO_TASK) {
+        task_l(mFreeTail).next = index;
+    } else {
+        mHeads[LIST_FREE] = index;
+    }
+    mFreeTail = index;
+}
+
+int64_t TimerThread::TaskShard::nextTick_l() const {
+    int64_t nextTick = INT64_MAX;
+    for (size_t level = 0; level < WHEEL_LEVELS; ++level) {
+        if (mOccupied[level] == 0) continue;
+        const size_t shift = level * WHEEL_BITS;
+        const int64_t position = mCurrentTick >> shift;
+        const int ahead = __builtin_ctzll(
+                rotateSlots(mOccupied[level], position & (WHEEL_SLOTS - 1)));
+        // Level 0 slots are due at their tick, the others are moved down at their first tick.
+        nextTick = std::min(nextTick, std::max(mCurrentTick, (position + ahead) << shift));
+    }
+    return nextTick;
+}
+
+TimerThread::Handle TimerThread::TaskShard::add(size_t shard, const Request& request,
+        TimerCallback&& func, std::chrono::steady_clock::time_point deadline,
+        HANDLE_TYPE handleType) {
+    std::lock_guard lg(mMutex);
+    if (mHeads[LIST_FREE] == NO_TASK) {
+        if (mChunkCount == mChunks.size()) return INVALID_HANDLE;
+        // Grow the shard, this is the only allocation.
+        mChunks[mChunkCount] = std::make_unique<Task[]>(TASK_CHUNK);
+        const uint32_t first = mChunkCount * TASK_CHUNK;
+        ++mChunkCount;
+        for (uint32_t i = first; i < first + TASK_CHUNK; ++i) {
+            free_l(i);
+        }
+    }
+    const uint32_t index = mHeads[LIST_FREE];
+    unlink_l(index);
+    Task& task = task_l(index);
+    task.handle = makeHandle(
+            deadline, shard * TASKS_PER_SHARD + index, task.generation, handleType);
+    task.request.emplace(request);
+    task.func = std::move(func);
+    if (handleType == HANDLE_TYPE::TIMEOUT) {
+        task.expiryTick = toTick(task.handle);
+        schedule_l(index);
+    } else {
+        link_l(index, LIST_TRACKED);
+    }
+    return task.handle;
+}
+
+std::optional<TimerThread::Request> TimerThread::TaskShard::remove(Handle handle) {
+    TimerCallback func;
+    std::optional<Request> request;
+    {
+        std::lock_guard lg(mMutex);
+        const uint32_t index = getTaskIndex(handle) % TASKS_PER_SHARD;
+        if (index / TASK_CHUNK >= mChunkCount) return {};
+        Task& task = task_l(index);
+        if (task.handle != handle) return {};  // also false for a free task.
+        unlink_l(index);
+        request.emplace(std::move(*task.request));
+        task.request.reset();
+        func.swap(task.func);
+        free_l(index);
+    }
+    return request;  // func is released here outside of lock.
+}
+
+void TimerThread::TaskShard::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests) const {
-    std::lock_guard lg(mNTMutex);
-    for (const auto &[handle, request] : mMap) {
-        requests.emplace_back(request);
+    std::lock_guard lg(mMutex);
+    for (size_t i = 0; i < mChunkCount * TASK_CHUNK; ++i) {
+        const Task& task = mChunks[i / TASK_CHUNK][i % TASK_CHUNK];
+        if (task.handle != INVALID_HANDLE) {
+            requests.emplace_back(std::make_shared<const Request>(*task.request));
+        }
     }
 }
 
+int64_t TimerThread::TaskShard::advance(int64_t nowTick, RequestQueue& timeoutQueue,
+        std::atomic<size_t>& secondChanceCount) {
+    std::unique_lock ul(mMutex);
+    ::android::base::ScopedLockAssertion lock_assertion(mMutex);
+    // Ticks with nothing to move or expire are skipped.
+    for (int64_t tick; (tick = nextTick_l()) <= nowTick; ) {
+        mCurrentTick = tick;
+        // Move down the tasks of the slots starting at this tick, coarsest first.
+        for (size_t level = WHEEL_LEVELS - 1; level > 0; --level) {
+            const size_t shift = level * WHEEL_BITS;
+            if ((tick & ((int64_t{1} << shift) - 1)) != 0) continue;
+            const uint16_t list = level * WHEEL_SLOTS + ((tick >> shift) & (WHEEL_SLOTS - 1));
+            while (mHeads[list] != NO_TASK) {
+                const uint32_t index = mHeads[list];
+                unlink_l(index);
+                schedule_l(index);
+            }
+        }
+        const uint16_t list = tick & (WHEEL_SLOTS - 1);
+        while (mHeads[list] != NO_TASK) {
+            const uint32_t index = mHeads[list];
+            unlink_l(index);
+            Task& task = task_l(index);
+            const Duration secondChanceDuration = task.request->secondChanceDuration;
+            if (!task.secondChance && secondChanceDuration.count() != 0) {
+                // The second chance prevents a false timeout should there be
+                // any clock monotonic advancement during suspend.
+                // The task keeps its handle for cancelTask().
+                ALOGD("%s: TimeCheck second chance applied for %s",
+                        __func__, task.request->tag.c_str()); // should be rare event.
+                task.secondChance = true;
+                task.expiryTick = tick + toTick(
+                        std::chrono::steady_clock::time_point(secondChanceDuration));
+                schedule_l(index);
+                // increment second chance counter.
+                secondChanceCount.fetch_add(1 /* arg */, std::memory_order_relaxed);
+            } else {
+                link_l(index, LIST_EXPIRED);
+            }
+        }
+        mCurrentTick = tick + 1;
+    }
+    if (mCurrentTick <= nowTick) mCurrentTick = nowTick + 1;
+
+    while (mHeads[LIST_EXPIRED] != NO_TASK) {
+        const uint32_t index = mHeads[LIST_EXPIRED];
+        unlink_l(index);
+        Task& task = task_l(index);
+        const Handle handle = task.handle;
+        std::optional<Request> request;
+        TimerCallback func;
+        request.emplace(std::move(*task.request));
+        task.request.reset();
+        func.swap(task.func);
+        free_l(index);
+        {
+            ul.unlock();
+            // We add Request to timeout queue early so that it can be dumped out.
+            timeoutQueue.add(*request);
+            func(handle);
+            // Caution: we don't hold lock when we call TimerCallback,
+            // but this is the timeout case!  We will crash soon,
+            // maybe before returning.
+            // func is released here outside lock.
+            func = nullptr;
+        }
+        // reacquire the lock - tasks may have been added or removed meanwhile.
+        ul.lock();
+    }
+    return nextTick_l();
+}
+
 TimerThread::MonitorThread::MonitorThread(RequestQueue& timeoutQueue)
         : mTimeoutQueue(timeoutQueue)
         , mThread([this] { threadFunc(); }) {
@@ -340,134 +531,71 @@ void TimerThread::MonitorThread::threadFunc() {
     std::unique_lock _l(mMutex);
     ::android::base::ScopedLockAssertion lock_assertion(mMutex);
     while (!mShouldExit) {
-        Handle nextDeadline = INVALID_HANDLE;
-        Handle now = INVALID_HANDLE;
-        if (!mMonitorRequests.empty()) {
-            nextDeadline = mMonitorRequests.begin()->first;
-            now = std::chrono::steady_clock::now();
-            if (nextDeadline < now) {
-                auto node = mMonitorRequests.extract(mMonitorRequests.begin());
-                // Deadline has expired, handle the request.
-                auto secondChanceDuration = node.mapped().first->secondChanceDuration;
-                if (secondChanceDuration.count() != 0) {
-                    // We now apply the second chance duration to find the clock
-                    // monotonic second deadline.  The unique key is then the
-                    // pair<second_deadline, first_deadline>.
-                    //
-                    // The second chance prevents a false timeout should there be
-                    // any clock monotonic advancement during suspend.
-                    auto newHandle = now + secondChanceDuration;
-                    ALOGD("%s: TimeCheck second chance applied for %s",
-                            __func__, node.mapped().first->tag.c_str()); // should be rare event.
-                    mSecondChanceRequests.emplace_hint(mSecondChanceRequests.end(),
-                            std::make_pair(newHandle, nextDeadline),
-                            std::move(node.mapped()));
-                    // increment second chance counter.
-                    mSecondChanceCount.fetch_add(1 /* arg */, std::memory_order_relaxed);
-                } else {
-                    {
-                        _l.unlock();
-                        // We add Request to retired queue early so that it can be dumped out.
-                        mTimeoutQueue.add(std::move(node.mapped().first));
-                        node.mapped().second(nextDeadline);
-                        // Caution: we don't hold lock when we call TimerCallback,
-                        // but this is the timeout case!  We will crash soon,
-                        // maybe before returning.
-                        // anything left over is released here outside lock.
-                    }
-                    // reacquire the lock - if something was added, we loop immediately to check.
-                    _l.lock();
-                }
-                // always process expiring monitor requests first.
-                continue;
-            }
-        }
-        // now process any second chance requests.
-        if (!mSecondChanceRequests.empty()) {
-            Handle secondDeadline = mSecondChanceRequests.begin()->first.first;
-            if (now == INVALID_HANDLE) now = std::chrono::steady_clock::now();
-            if (secondDeadline < now) {
-                auto node = mSecondChanceRequests.extract(mSecondChanceRequests.begin());
-                {
-                    _l.unlock();
-                    // We add Request to retired queue early so that it can be dumped out.
-                    mTimeoutQueue.add(std::move(node.mapped().first));
-                    const Handle originalHandle = node.key().second;
-                    node.mapped().second(originalHandle);
-                    // Caution: we don't hold lock when we call TimerCallback.
-                    // This is benign issue - we permit concurrent operations
-                    // while in the callback to the MonitorQueue.
-                    //
-                    // Anything left over is released here outside lock.
-                }
-                // reacquire the lock - if something was added, we loop immediately to check.
-                _l.lock();
-                continue;
-            }
-            // update the deadline.
-            if (nextDeadline == INVALID_HANDLE) {
-                nextDeadline = secondDeadline;
-            } else {
-                nextDeadline = std::min(nextDeadline, secondDeadline);
-            }
+        // Any task added from now on wakes us up, until we know the next tick to process.
+        mWakeNs.store(INT64_MAX);
+        mWakeRequested = false;
+        _l.unlock();
+        const int64_t nowTick = std::chrono::steady_clock::now().time_since_epoch().count()
+                >> TaskShard::TICK_SHIFT;
+        int64_t nextTick = INT64_MAX;
+        for (auto& shard : mShards) {
+            nextTick = std::min(nextTick,
+                    shard.advance(nowTick, mTimeoutQueue, mSecondChanceCount));
         }
-        if (nextDeadline != INVALID_HANDLE) {
-            mCond.wait_until(_l, nextDeadline);
-        } else {
+        _l.lock();
+        if (mWakeRequested || mShouldExit) continue;
+        if (nextTick == INT64_MAX) {
             mCond.wait(_l);
+        } else {
+            const int64_t wakeNs = nextTick << TaskShard::TICK_SHIFT;
+            mWakeNs.store(wakeNs);
+            mCond.wait_until(_l, std::chrono::steady_clock::time_point(Duration(wakeNs)));
         }
     }
 }
 
-TimerThread::Handle TimerThread::MonitorThread::add(
-        std::shared_ptr<const Request> request, TimerCallback&& func, Duration timeout) {
+void TimerThread::MonitorThread::wake(Handle expiry) {
+    // The common case: the thread wakes up no later than the expiry.
+    if (expiry.time_since_epoch().count() >= mWakeNs.load()) return;
     std::lock_guard _l(mMutex);
-    const Handle handle = getUniqueHandle_l(timeout);
-    mMonitorRequests.emplace_hint(mMonitorRequests.end(),
-            handle, std::make_pair(std::move(request), std::move(func)));
-    mCond.notify_all();
-    return handle;
+    if (!mWakeRequested) {
+        mWakeRequested = true;
+        mCond.notify_one();
+    }
 }
 
-std::shared_ptr<const TimerThread::Request> TimerThread::MonitorThread::remove(Handle handle) {
-    std::pair<std::shared_ptr<const Request>, TimerCallback> data;
-    std::unique_lock ul(mMutex);
-    ::android::base::ScopedLockAssertion lock_assertion(mMutex);
-    if (const auto it = mMonitorRequests.find(handle);
-        it != mMonitorRequests.end()) {
-        data = std::move(it->second);
-        mMonitorRequests.erase(it);
-        ul.unlock();  // manually release lock here so func (data.second)
-                      // is released outside of lock.
-        return data.first;  // request
+TimerThread::Handle TimerThread::MonitorThread::add(
+        const Request& request, TimerCallback&& func, Duration timeout) {
+    const size_t shard = static_cast<size_t>(request.tid) % SHARDS;
+    const Handle handle = mShards[shard].add(shard, request, std::move(func),
+            std::chrono::steady_clock::now() + timeout, HANDLE_TYPE::TIMEOUT);
+    if (handle == INVALID_HANDLE) {
+        ALOGW("%s: too many pending tasks, %s not monitored", __func__, request.tag.c_str());
+        return handle;
     }
+    wake(handle);
+    return handle;
+}
 
-    // this check is O(N), but since the second chance requests are ordered
-    // in terms of earliest expiration time, we would expect better than average results.
-    for (auto it = mSecondChanceRequests.begin(); it != mSecondChanceRequests.end(); ++it) {
-        if (it->first.second == handle) {
-            data = std::move(it->second);
-            mSecondChanceRequests.erase(it);
-            ul.unlock();  // manually release lock here so func (data.second)
-                          // is released outside of lock.
-            return data.first; // request
-        }
+TimerThread::Handle TimerThread::MonitorThread::track(const Request& request) {
+    const size_t shard = static_cast<size_t>(request.tid) % SHARDS;
+    const Handle handle = mShards[shard].add(shard, request, {} /* func */,
+            std::chrono::steady_clock::now(), HANDLE_TYPE::NO_TIMEOUT);
+    if (handle == INVALID_HANDLE) {
+        ALOGW("%s: too many pending tasks, %s not tracked", __func__, request.tag.c_str());
     }
-    return {};
+    return handle;
+}
+
+std::optional<TimerThread::Request> TimerThread::MonitorThread::remove(Handle handle) {
+    if (handle == INVALID_HANDLE) return {};
+    return mShards[getTaskIndex(handle) / TASKS_PER_SHARD].remove(handle);
 }
 
 void TimerThread::MonitorThread::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests) const {
-    std::lock_guard lg(mMutex);
-    for (const auto &[deadline, monitorpair] : mMonitorRequests) {
-        requests.emplace_back(monitorpair.first);
-    }
-    // we combine the second map with the first map - this is
-    // everything that is pending on the monitor thread.
-    // The second map will be older than the first map so this
-    // is in order.
-    for (const auto &[deadline, monitorpair] : mSecondChanceRequests) {
-        requests.emplace_back(monitorpair.first);
+    for (const auto& shard : mShards) {
+        shard.copyRequests(requests);
     }
 }
 
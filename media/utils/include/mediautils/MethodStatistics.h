@@ -16,9 +16,17 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <android-base/thread_annotations.h>
@@ -121,6 +129,230 @@ private:
     std::map<Code, StatsType, std::less<>> mStatisticsMap GUARDED_BY(mLock);
 };
 
+/**
+ * ShardedMethodStatistics is a MethodStatistics for integer or enum
+ * Binder codes whose event() does not take a lock.
+ *
+ * The methods given to the constructor get a fixed index, found through a
+ * table for small codes, as Binder transaction codes are, and a binary search
+ * for the others.  Each thread adds its events with relaxed atomics to the
+ * counters of one of SHARDS shards, which are only summed for the getters.
+ * A getter concurrent with event() may see an event partially added.
+ *
+ * Events for codes not given to the constructor are kept as in MethodStatistics.
+ */
+template <typename Code, size_t SHARDS = 8>
+class ShardedMethodStatistics {
+    static_assert(std::is_integral_v<Code> || std::is_enum_v<Code>);
+public:
+    using FloatType = float;
+
+    /**
+     * Sum of events, with the getters of audio_utils::Statistics.
+     */
+    class StatsType {
+    public:
+        void add(FloatType value) {
+            ++mN;
+            mSum += value;
+            mSumSq += double(value) * value;
+            mMin = std::min(mMin, value);
+            mMax = std::max(mMax, value);
+        }
+
+        void add(const StatsType& other) {
+            mN += other.mN;
+            mSum += other.mSum;
+            mSumSq += other.mSumSq;
+            mMin = std::min(mMin, other.mMin);
+            mMax = std::max(mMax, other.mMax);
+        }
+
+        int64_t getN() const { return mN; }
+        FloatType getMin() const { return mMin; }
+        FloatType getMax() const { return mMax; }
+        double getMean() const { return mN == 0 ? 0. : mSum / mN; }
+        double getVariance() const {
+            if (mN < 2) return 0.;
+            return std::max(0., (mSumSq - mSum * mSum / mN) / (mN - 1));
+        }
+        double getStdDev() const { return std::sqrt(getVariance()); }
+
+        std::string toString() const {
+            if (mN == 0) return "unavail";
+            std::stringstream ss;
+            ss << "ave=" << getMean();
+            if (mN > 1) ss << " std=" << getStdDev();
+            ss << " min=" << mMin << " max=" << mMax;
+            return ss.str();
+        }
+
+    private:
+        friend class ShardedMethodStatistics;
+        int64_t mN = 0;
+        double mSum = 0.;
+        double mSumSq = 0.;
+        FloatType mMin = std::numeric_limits<FloatType>::infinity();
+        FloatType mMax = -std::numeric_limits<FloatType>::infinity();
+    };
+
+    explicit ShardedMethodStatistics(
+            const std::initializer_list<std::pair<const Code, std::string>>& methodMap = {})
+        : mMethodMap{methodMap} {
+        for (const auto& [code, name] : mMethodMap) {  // sorted by code.
+            const uint64_t value = asValue(code);
+            if (value < kMaxTableCode) {
+                if (mTable.size() <= value) mTable.resize(value + 1, kNoIndex);
+                mTable[value] = mCodes.size();
+            }
+            mCodes.push_back(code);
+        }
+        for (auto& shard : mShards) {
+            shard = std::make_unique<Counter[]>(mCodes.size());
+        }
+    }
+
+    /**
+     * Adds a method event, typically execution time in ms.
+     */
+    template <typename C>
+    void event(C&& code, FloatType executeMs) {
+        const size_t index = getIndex(static_cast<Code>(code));
+        if (index == kNoIndex) {
+            std::lock_guard lg(mLock);
+            mOtherStatistics[static_cast<Code>(code)].add(executeMs);
+            return;
+        }
+        mShards[getShard()][index].add(executeMs);
+    }
+
+    /**
+     * Returns the name for the method code.
+     */
+    std::string getMethodForCode(const Code& code) const {
+        auto it = mMethodMap.find(code);
+        return it == mMethodMap.end() ? std::to_string((int)code) : it->second;
+    }
+
+    /**
+     * Returns the number of times the method was invoked by event().
+     */
+    size_t getMethodCount(const Code& code) const {
+        return getStatistics(code).getN();
+    }
+
+    /**
+     * Returns the statistics object for the method.
+     */
+    StatsType getStatistics(const Code& code) const {
+        const size_t index = getIndex(code);
+        if (index == kNoIndex) {
+            std::lock_guard lg(mLock);
+            auto it = mOtherStatistics.find(code);
+            return it == mOtherStatistics.end() ? StatsType{} : it->second;
+        }
+        return sum(index);
+    }
+
+    /**
+     * Dumps the current method statistics.
+     */
+    std::string dump() const {
+        std::map<Code, StatsType> statisticsMap;
+        for (size_t i = 0; i < mCodes.size(); ++i) {
+            const StatsType stats = sum(i);
+            if (stats.getN() > 0) statisticsMap.emplace(mCodes[i], stats);
+        }
+        {
+            std::lock_guard lg(mLock);
+            statisticsMap.insert(mOtherStatistics.begin(), mOtherStatistics.end());
+        }
+        std::stringstream ss;
+        for (const auto &[code, stats] : statisticsMap) {
+            ss << int(code) << " " << getMethodForCode(code) <<
+                    " n=" << stats.getN() << " " << stats.toString() << "\n";
+        }
+        return ss.str();
+    }
+
+private:
+    static constexpr size_t kNoIndex = SIZE_MAX;
+    static constexpr uint64_t kMaxTableCode = 4096;
+
+    // The events of a method in a shard.
+    struct Counter {
+        std::atomic<int64_t> n{};
+        std::atomic<double> sum{};
+        std::atomic<double> sumSq{};
+        std::atomic<FloatType> min{std::numeric_limits<FloatType>::infinity()};
+        std::atomic<FloatType> max{-std::numeric_limits<FloatType>::infinity()};
+
+        void add(FloatType value) {
+            n.fetch_add(1, std::memory_order_relaxed);
+            // Seldom contended, as a shard is shared by few threads.
+            for (double v = sum.load(std::memory_order_relaxed);
+                    !sum.compare_exchange_weak(v, v + value, std::memory_order_relaxed); ) {}
+            for (double v = sumSq.load(std::memory_order_relaxed);
+                    !sumSq.compare_exchange_weak(v, v + double(value) * value,
+                            std::memory_order_relaxed); ) {}
+            for (FloatType v = min.load(std::memory_order_relaxed); value < v
+                    && !min.compare_exchange_weak(v, value, std::memory_order_relaxed); ) {}
+            for (FloatType v = max.load(std::memory_order_relaxed); value > v
+                    && !max.compare_exchange_weak(v, value, std::memory_order_relaxed); ) {}
+        }
+    };
+
+    static uint64_t asValue(Code code) {
+        if constexpr (std::is_enum_v<Code>) {
+            return static_cast<std::make_unsigned_t<std::underlying_type_t<Code>>>(code);
+        } else {
+            return static_cast<std::make_unsigned_t<Code>>(code);
+        }
+    }
+
+    // Returns the index of the method, or kNoIndex if not given to the constructor.
+    size_t getIndex(Code code) const {
+        const uint64_t value = asValue(code);
+        if (value < kMaxTableCode) {
+            return value < mTable.size() ? mTable[value] : kNoIndex;
+        }
+        const auto it = std::lower_bound(mCodes.begin(), mCodes.end(), code);
+        return it != mCodes.end() && *it == code ? it - mCodes.begin() : kNoIndex;
+    }
+
+    // Threads are assigned shards in turn, so that concurrent binder threads
+    // rarely share one.
+    static size_t getShard() {
+        static std::atomic<size_t> sThreads;
+        thread_local const size_t shard = sThreads.fetch_add(1, std::memory_order_relaxed)
+                % SHARDS;
+        return shard;
+    }
+
+    StatsType sum(size_t index) const {
+        StatsType stats;
+        for (const auto& shard : mShards) {
+            const Counter& counter = shard[index];
+            StatsType shardStats;
+            shardStats.mN = counter.n.load(std::memory_order_relaxed);
+            shardStats.mSum = counter.sum.load(std::memory_order_relaxed);
+            shardStats.mSumSq = counter.sumSq.load(std::memory_order_relaxed);
+            shardStats.mMin = counter.min.load(std::memory_order_relaxed);
+            shardStats.mMax = counter.max.load(std::memory_order_relaxed);
+            stats.add(shardStats);
+        }
+        return stats;
+    }
+
+    // Note: we use a transparent comparator std::less<> for heterogeneous key lookup.
+    const std::map<Code, std::string, std::less<>> mMethodMap;
+    std::vector<Code> mCodes;       // sorted, the index of a method is its position.
+    std::vector<size_t> mTable;     // index of the methods with a code < kMaxTableCode.
+    std::array<std::unique_ptr<Counter[]>, SHARDS> mShards;
+    mutable std::mutex mLock;
+    std::map<Code, StatsType> mOtherStatistics GUARDED_BY(mLock);
+};
+
 // Managed Statistics support.
 // Supported Modules
 #define METHOD_STATISTICS_MODULE_NAME_AUDIO_HIDL "AudioHidl"
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <deque>
@@ -23,6 +24,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
@@ -51,11 +53,19 @@ class TimerThread {
 
     // Handle implementation details:
     // A Handle represents the timer expiration time based on std::chrono::steady_clock
-    // (clock monotonic).  This Handle is computed as now() + timeout.
+    // (clock monotonic).  This Handle is computed as now() + timeout, rounded up
+    // to a multiple of 2^HANDLE_LOW_BITS ticks of the clock.
     //
     // The lsb of the Handle time_point is adjusted to indicate whether there is
     // a timeout action (1) or not (0).
     //
+    // The next HANDLE_INDEX_BITS lsbs hold the index of the task slot, which makes
+    // the Handle unique among the pending tasks and lets cancelTask() find
+    // the task without a search.  The next HANDLE_GENERATION_BITS lsbs hold the
+    // generation of the slot, incremented each time the slot is freed, so that
+    // a stale Handle of an earlier task in the same slot does not match.
+    // The expiration is thus delayed by at most 2^HANDLE_LOW_BITS ns (about 1 ms).
+    //
 
     template <size_t COUNT>
     static constexpr bool is_power_of_2_v = COUNT > 0 && (COUNT & (COUNT - 1)) == 0;
@@ -75,6 +85,18 @@ class TimerThread {
 
     static constexpr size_t HANDLE_TYPE_MASK = mask_from_count_v<HANDLE_TYPES>;
 
+    // Tasks are kept in SHARDS independently locked shards, selected by tid,
+    // each holding up to TASKS_PER_SHARD pending tasks.
+    static constexpr size_t SHARDS = 8;
+    static constexpr size_t TASKS_PER_SHARD = 2048;
+    static_assert(is_power_of_2_v<SHARDS> && is_power_of_2_v<TASKS_PER_SHARD>);
+
+    static constexpr size_t HANDLE_INDEX_BITS = 14;  // log2(SHARDS * TASKS_PER_SHARD)
+    static_assert((size_t{1} << HANDLE_INDEX_BITS) == SHARDS * TASKS_PER_SHARD);
+    static constexpr size_t HANDLE_GENERATION_BITS = 5;
+    static constexpr size_t HANDLE_LOW_BITS =
+            1 /* HANDLE_TYPE */ + HANDLE_INDEX_BITS + HANDLE_GENERATION_BITS;
+
     template <typename T>
     static constexpr auto enum_as_value(T x) {
         return static_cast<std::underlying_type_t<T>>(x);
@@ -90,29 +112,24 @@ class TimerThread {
                 enum_as_value(HANDLE_TYPE::TIMEOUT);
     }
 
-    // Returns a unique Handle that doesn't exist in the container.
-    template <size_t MAX_TYPED_HANDLES, size_t HANDLE_TYPE_AS_VALUE, typename C, typename T>
-    static Handle getUniqueHandleForHandleType_l(C container, T timeout) {
-        static_assert(MAX_TYPED_HANDLES > 0 && HANDLE_TYPE_AS_VALUE < MAX_TYPED_HANDLES
-                && is_power_of_2_v<MAX_TYPED_HANDLES>,
-                " handles must be power of two");
-
-        // Our initial handle is the deadline as computed from steady_clock.
-        auto deadline = std::chrono::steady_clock::now() + timeout;
-
-        // We adjust the lsbs by the minimum increment to have the correct
-        // HANDLE_TYPE in the least significant bits.
-        auto remainder = deadline.time_since_epoch().count() & HANDLE_TYPE_MASK;
-        size_t offset = HANDLE_TYPE_AS_VALUE > remainder ? HANDLE_TYPE_AS_VALUE - remainder :
-                     MAX_TYPED_HANDLES + HANDLE_TYPE_AS_VALUE - remainder;
-        deadline += std::chrono::steady_clock::duration(offset);
-
-        // To avoid key collisions, advance the handle by MAX_TYPED_HANDLES (the modulus factor)
-        // until the key is unique.
-        while (container.find(deadline) != container.end()) {
-            deadline += std::chrono::steady_clock::duration(MAX_TYPED_HANDLES);
-        }
-        return deadline;
+    // Returns the Handle of the task with index taskIndex, slot generation generation
+    // and type handleType expiring no earlier than deadline.
+    static Handle makeHandle(std::chrono::steady_clock::time_point deadline,
+            size_t taskIndex, size_t generation, HANDLE_TYPE handleType) {
+        constexpr int64_t kLowMask = (int64_t{1} << HANDLE_LOW_BITS) - 1;
+        const int64_t count = (deadline.time_since_epoch().count() + kLowMask) & ~kLowMask;
+        const size_t generationBits =
+                generation & mask_from_count_v<size_t{1} << HANDLE_GENERATION_BITS>;
+        return Handle(Duration(count
+                | static_cast<int64_t>(generationBits << (1 + HANDLE_INDEX_BITS))
+                | static_cast<int64_t>(taskIndex << 1)
+                | static_cast<int64_t>(enum_as_value(handleType))));
+    }
+
+    // Returns the task index of a Handle from makeHandle().
+    static size_t getTaskIndex(Handle handle) {
+        return static_cast<size_t>(handle.time_since_epoch().count() >> 1)
+                & mask_from_count_v<SHARDS * TASKS_PER_SHARD>;
     }
 
     // TimerCallback invoked on timeout or cancel.
@@ -129,7 +146,8 @@ class TimerThread {
      *                A timeout of 0 (or negative) means the timer never expires
      *                so func() is never called. These tasks are stored internally
      *                and reported in the toString() until manually cancelled.
-     * \returns       a handle that can be used for cancellation.
+     * \returns       a handle that can be used for cancellation, or INVALID_HANDLE
+     *                if there are too many pending tasks.
      */
     Handle scheduleTask(
             std::string_view tag, TimerCallback&& func,
@@ -139,7 +157,8 @@ class TimerThread {
      * Tracks a task that shows up on toString() until cancelled.
      *
      * \param tag     string associated with the task.
-     * \returns       a handle that can be used for cancellation.
+     * \returns       a handle that can be used for cancellation, or INVALID_HANDLE
+     *                if there are too many pending tasks.
      */
     Handle trackTask(std::string_view tag);
 
@@ -212,8 +231,8 @@ class TimerThread {
         return s;
     }
 
-    // To minimize movement of data, we pass around shared_ptrs to Requests.
-    // These are allocated and deallocated outside of the lock.
+    // Requests are stored by value while pending or queued, so scheduling
+    // and cancelling does not allocate.  Snapshots pass around shared_ptrs to copies.
     // TODO(b/243839867) consider options to merge Request with the
     // TimeCheck::TimeCheckHandler struct.
     struct Request {
@@ -278,14 +297,16 @@ class TimerThread {
     };
 
   private:
-    // Deque of requests, in order of add().
+    // Ring of the last requests added, in order of add().
+    // The requests are copied, so add() does not allocate.
     // This class is thread-safe.
     class RequestQueue {
       public:
         explicit RequestQueue(size_t maxSize)
-            : mRequestQueueMax(maxSize) {}
+            : mRequestQueueMax(maxSize)
+            , mRequestQueue(maxSize) {}
 
-        void add(std::shared_ptr<const Request>);
+        void add(const Request& request);
 
         // return up to the last "n" requests retired.
         void copyRequests(std::vector<std::shared_ptr<const Request>>& requests,
@@ -294,56 +315,108 @@ class TimerThread {
       private:
         const size_t mRequestQueueMax;
         mutable std::mutex mRQMutex;
-        std::deque<std::pair<std::chrono::system_clock::time_point,
-                             std::shared_ptr<const Request>>>
-                mRequestQueue GUARDED_BY(mRQMutex);
+        std::vector<std::optional<Request>> mRequestQueue GUARDED_BY(mRQMutex);
+        size_t mRequestQueueAdded GUARDED_BY(mRQMutex) = 0;  // total number of add().
     };
 
-    // A storage map of tasks without timeouts.  There is no TimerCallback
-    // required, it just tracks the tasks with the tag, scheduled time and the tid.
-    // These tasks show up on a pendingToString() until manually cancelled.
-    class NoTimeoutMap {
-        mutable std::mutex mNTMutex;
-        std::map<Handle, std::shared_ptr<const Request>> mMap GUARDED_BY(mNTMutex);
-        Handle getUniqueHandle_l() REQUIRES(mNTMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::NO_TIMEOUT)>(
-                mMap, Duration{} /* timeout */);
-        }
+    // Preallocated storage of a pending task, linked in one of the lists of its TaskShard.
+    struct Task {
+        Handle handle = INVALID_HANDLE;  // INVALID_HANDLE when free.
+        int64_t expiryTick = 0;          // wheel tick when due, for TIMEOUT handles.
+        bool secondChance = false;       // the secondChanceDuration was applied.
+        uint8_t generation = 0;          // incremented when freed, see makeHandle().
+        uint16_t list = 0;
+        uint32_t prev = 0;
+        uint32_t next = 0;
+        std::optional<Request> request;
+        TimerCallback func;
+    };
 
+    // A shard of the pending tasks.
+    //
+    // Tasks with a timeout are kept in a hierarchical timing wheel: WHEEL_LEVELS
+    // levels of WHEEL_SLOTS lists, each level WHEEL_SLOTS times coarser than the
+    // one below.  A task is placed in the finest level covering its expiry,
+    // and is moved down a level when the wheel reaches its slot, so add and
+    // remove are O(1) and the expiry is exact to a tick.  Tasks are stored in
+    // chunks of TASK_CHUNK allocated when the shard grows, never freed, so there
+    // is no allocation once the shard has seen its peak number of tasks.
+    // Free tasks are reused in FIFO order, so a slot is reused as late as possible.
+    //
+    // This class is thread-safe.
+    class TaskShard {
       public:
-        bool isValidHandle(Handle handle) const; // lock free
-        Handle add(std::shared_ptr<const Request> request);
-        std::shared_ptr<const Request> remove(Handle handle);
+        // The wheel tick is 2^TICK_SHIFT ns (about 1 ms).
+        static constexpr int TICK_SHIFT = 20;
+        static constexpr size_t WHEEL_BITS = 6;
+        static constexpr size_t WHEEL_SLOTS = 1 << WHEEL_BITS;  // a bit in a uint64_t.
+        static constexpr size_t WHEEL_LEVELS = 4;               // covers about 5 hours.
+        static constexpr size_t TASK_CHUNK = 64;
+
+        // Returns the wheel tick of a steady clock time, rounded up.
+        static int64_t toTick(std::chrono::steady_clock::time_point time) {
+            constexpr int64_t kTickNs = int64_t{1} << TICK_SHIFT;
+            return (time.time_since_epoch().count() + kTickNs - 1) >> TICK_SHIFT;
+        }
+
+        TaskShard();
+
+        // Returns INVALID_HANDLE if the shard is full.
+        Handle add(size_t shard, const Request& request, TimerCallback&& func,
+                std::chrono::steady_clock::time_point deadline, HANDLE_TYPE handleType);
+        std::optional<Request> remove(Handle handle);
         void copyRequests(std::vector<std::shared_ptr<const Request>>& requests) const;
+
+        // Processes the wheel up to nowTick, calling back the tasks timed out outside
+        // of the lock.  Returns the next tick to process, or INT64_MAX if none.
+        int64_t advance(int64_t nowTick, RequestQueue& timeoutQueue,
+                std::atomic<size_t>& secondChanceCount);
+
+      private:
+        static constexpr uint32_t NO_TASK = UINT32_MAX;
+        // Lists of tasks: the wheel slots, then tracked, expired and free tasks.
+        static constexpr uint16_t LIST_TRACKED = WHEEL_LEVELS * WHEEL_SLOTS;
+        static constexpr uint16_t LIST_EXPIRED = LIST_TRACKED + 1;
+        static constexpr uint16_t LIST_FREE = LIST_EXPIRED + 1;
+        static constexpr size_t LISTS = LIST_FREE + 1;
+
+        Task& task_l(uint32_t index) REQUIRES(mMutex) {
+            return mChunks[index / TASK_CHUNK][index % TASK_CHUNK];
+        }
+        void link_l(uint32_t index, uint16_t list) REQUIRES(mMutex);
+        void unlink_l(uint32_t index) REQUIRES(mMutex);
+        void schedule_l(uint32_t index) REQUIRES(mMutex);
+        void free_l(uint32_t index) REQUIRES(mMutex);
+        int64_t nextTick_l() const REQUIRES(mMutex);
+
+        mutable std::mutex mMutex;
+        std::array<std::unique_ptr<Task[]>, TASKS_PER_SHARD / TASK_CHUNK> mChunks
+                GUARDED_BY(mMutex);
+        size_t mChunkCount GUARDED_BY(mMutex) = 0;
+        std::array<uint32_t, LISTS> mHeads GUARDED_BY(mMutex);
+        uint32_t mFreeTail GUARDED_BY(mMutex) = NO_TASK;  // last of LIST_FREE.
+        std::array<uint64_t, WHEEL_LEVELS> mOccupied GUARDED_BY(mMutex) {};  // slot bitmaps
+        int64_t mCurrentTick GUARDED_BY(mMutex);  // all earlier ticks are processed.
     };
 
     // Monitor thread.
-    // This thread manages shared pointers to Requests and a function to
-    // call on timeout.
+    // This thread owns the task shards and calls the function of
+    // the tasks timing out.
     // This class is thread-safe.
     class MonitorThread {
         std::atomic<size_t> mSecondChanceCount{};
-        mutable std::mutex mMutex;
-        mutable std::condition_variable mCond GUARDED_BY(mMutex);
-
-        // Ordered map of requests based on time of deadline.
-        //
-        std::map<Handle, std::pair<std::shared_ptr<const Request>, TimerCallback>>
-                mMonitorRequests GUARDED_BY(mMutex);
+        std::array<TaskShard, SHARDS> mShards;  // locked internally
 
-        // Due to monotonic/steady clock inaccuracies during suspend,
-        // we allow an additional second chance waiting time to prevent
-        // false removal.
+        RequestQueue& mTimeoutQueue; // added to when request times out.
 
-        // This mSecondChanceRequests queue is almost always empty.
-        // Using a pair with the original handle allows lookup and keeps
-        // the Key unique.
-        std::map<std::pair<Handle /* new */, Handle /* original */>,
-                std::pair<std::shared_ptr<const Request>, TimerCallback>>
-                        mSecondChanceRequests GUARDED_BY(mMutex);
+        mutable std::mutex mMutex;
+        mutable std::condition_variable mCond GUARDED_BY(mMutex);
 
-        RequestQueue& mTimeoutQueue GUARDED_BY(mMutex); // added to when request times out.
+        // Steady clock ns when the thread wakes up next, INT64_MAX while processing
+        // or idle.  A task expiring earlier wakes up the thread, otherwise add()
+        // does not take mMutex.
+        std::atomic<int64_t> mWakeNs{INT64_MAX};
+        bool mWakeRequested GUARDED_BY(mMutex) = false;
 
         // Worker thread variables
         bool mShouldExit GUARDED_BY(mMutex) = false;
@@ -353,19 +426,15 @@ class TimerThread {
         std::thread mThread;
 
         void threadFunc();
-        Handle getUniqueHandle_l(Duration timeout) REQUIRES(mMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::TIMEOUT)>(
-                mMonitorRequests, timeout);
-        }
+        void wake(Handle expiry);
 
       public:
         MonitorThread(RequestQueue &timeoutQueue);
         ~MonitorThread();
 
-        Handle add(std::shared_ptr<const Request> request, TimerCallback&& func,
-                Duration timeout);
-        std::shared_ptr<const Request> remove(Handle handle);
+        Handle add(const Request& request, TimerCallback&& func, Duration timeout);
+        Handle track(const Request& request);
+        std::optional<Request> remove(Handle handle);
         void copyRequests(std::vector<std::shared_ptr<const Request>>& requests) const;
         size_t getSecondChanceCount() const {
             return mSecondChanceCount.load(std::memory_order_relaxed);
@@ -385,8 +454,6 @@ class TimerThread {
     static constexpr size_t kTimeoutQueueMax = 16;
     RequestQueue mTimeoutQueue{kTimeoutQueueMax};  // locked internally
 
-    NoTimeoutMap mNoTimeoutMap;  // locked internally
-
     MonitorThread mMonitorThread{mTimeoutQueue};  // This should be initialized last because
                                                   // the thread is launched immediately.
                                                   // Locked internally.
@@ -16,6 +16,7 @@
 
 #include <chrono>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <mediautils/TimerThread.h>
 
@@ -274,4 +275,85 @@ TEST(TimerThread, TrackedTasks) {
     ASSERT_EQ(4ul, countChars(thread.retiredToString(), REQUEST_START));
 }
 
+TEST(TimerThread, ConcurrentTasks) {
+    constexpr size_t kThreads = 8;
+    constexpr size_t kTasksPerThread = 100;  // all threads fit in one shard.
+    std::atomic<size_t> tasksRan = 0;
+    TimerThread thread;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&thread, &tasksRan] {
+            std::vector<TimerThread::Handle> handles;
+            for (size_t j = 0; j < kTasksPerThread; ++j) {
+                handles.push_back(thread.scheduleTask("Concurrent",
+                        [&tasksRan](TimerThread::Handle) { ++tasksRan; }, 10s, 1s));
+                handles.push_back(thread.trackTask("Tracked"));
+            }
+            for (const auto handle : handles) {
+                ASSERT_NE(TimerThread::INVALID_HANDLE, handle);
+                ASSERT_TRUE(thread.cancelTask(handle));
+                // handle is stale, cancel returns false.
+                ASSERT_FALSE(thread.cancelTask(handle));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    ASSERT_EQ(0ul, tasksRan);
+    // 0 tasks pending
+    ASSERT_EQ(0ul, countChars(thread.pendingToString(), REQUEST_START));
+    // the retired queue keeps the last 16 tasks.
+    ASSERT_EQ(16ul, countChars(thread.retiredToString(), REQUEST_START));
+}
+
+TEST(TimerThread, StaleHandle) {
+    std::atomic<bool> taskRan = false;
+    TimerThread thread;
+
+    // The task slot of a timed out task is reused.
+    const auto handle0 = thread.scheduleTask("0", [&taskRan](TimerThread::Handle) {
+            taskRan = true; }, 50ms, 0ms);
+    std::this_thread::sleep_for(50ms + kJitter);
+    ASSERT_TRUE(taskRan);
+    const auto handle1 = thread.scheduleTask("1", [](TimerThread::Handle) {}, 1s, 0ms);
+    ASSERT_NE(handle0, handle1);
+
+    ASSERT_FALSE(thread.cancelTask(handle0));
+    ASSERT_EQ(1ul, countChars(thread.pendingToString(), REQUEST_START));
+    ASSERT_TRUE(thread.cancelTask(handle1));
+    ASSERT_EQ(0ul, countChars(thread.pendingToString(), REQUEST_START));
+}
+
+TEST(TimerThread, StaleHandleAfterReschedule) {
+    constexpr size_t kTasksPerChunk = 64;  // TaskShard::TASK_CHUNK
+    TimerThread thread;
+
+    // Tasks are sharded by tid, fill the first chunk of this shard but one slot
+    // so that a cancelled task slot is reused at once.
+    std::vector<TimerThread::Handle> handles;
+    for (size_t i = 0; i < kTasksPerChunk - 1; ++i) {
+        handles.push_back(thread.trackTask("Tracked"));
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        // A cancel followed by an immediate reschedule with the same deadline.
+        const auto handle0 = thread.scheduleTask("0", [](TimerThread::Handle) {}, 10s, 0ms);
+        ASSERT_TRUE(thread.cancelTask(handle0));
+        const auto handle1 = thread.scheduleTask("1", [](TimerThread::Handle) {}, 10s, 0ms);
+        ASSERT_NE(handle0, handle1);
+
+        // handle0 is stale, cancel returns false and the new task survives.
+        ASSERT_FALSE(thread.cancelTask(handle0));
+        ASSERT_EQ(handles.size() + 1, countChars(thread.pendingToString(), REQUEST_START));
+        ASSERT_TRUE(thread.cancelTask(handle1));
+
+        // The second time, the free slots of a new chunk are reused in FIFO order.
+        handles.push_back(thread.trackTask("Tracked"));
+    }
+    for (const auto handle : handles) {
+        ASSERT_TRUE(thread.cancelTask(handle));
+    }
+    ASSERT_EQ(0ul, countChars(thread.pendingToString(), REQUEST_START));
+}
+
 }  // namespace
@@ -18,7 +18,11 @@
 
 #include <mediautils/MethodStatistics.h>
 
+#include <algorithm>
 #include <atomic>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <utils/Log.h>
 
@@ -70,3 +74,83 @@ TEST(methodstatistics_tests, events) {
     ASSERT_EQ(0.f, unsetStats.getMean());
     ASSERT_EQ(0U, methodStatistics.getMethodCount(UNKNOWN_CODE));
 }
+
+// Binder special codes are far from the transaction codes.
+constexpr CodeType PING_CODE = 0x5f504e47;
+constexpr const char * PING_NAME = "ping";
+
+TEST(methodstatistics_tests, sharded_method_names) {
+    const ShardedMethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+            {WORLD_CODE, WORLD_NAME},
+            {PING_CODE, PING_NAME},
+    };
+
+    ASSERT_EQ(std::string(HELLO_NAME), methodStatistics.getMethodForCode(HELLO_CODE));
+    ASSERT_EQ(std::string(WORLD_NAME), methodStatistics.getMethodForCode(WORLD_CODE));
+    ASSERT_EQ(std::string(PING_NAME), methodStatistics.getMethodForCode(PING_CODE));
+    // an unknown code returns itself as a number.
+    ASSERT_EQ(std::to_string(UNKNOWN_CODE), methodStatistics.getMethodForCode(UNKNOWN_CODE));
+}
+
+TEST(methodstatistics_tests, sharded_events) {
+    ShardedMethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+            {WORLD_CODE, WORLD_NAME},
+            {PING_CODE, PING_NAME},
+    };
+
+    size_t n = 0;
+    float sum = 0.f;
+    for (const auto event : HELLO_EVENTS) {
+        methodStatistics.event(HELLO_CODE, event);
+        sum += event;
+        ++n;
+    }
+    methodStatistics.event(PING_CODE, 1.f);
+    methodStatistics.event(UNKNOWN_CODE, 2.f);
+
+    const auto helloStats = methodStatistics.getStatistics(HELLO_CODE);
+    ASSERT_EQ((signed)n, helloStats.getN());
+    ASSERT_EQ(sum / n, helloStats.getMean());
+    ASSERT_EQ(HELLO_EVENTS[0], helloStats.getMin());
+    ASSERT_EQ(HELLO_EVENTS[1], helloStats.getMax());
+    ASSERT_EQ(n, methodStatistics.getMethodCount(HELLO_CODE));
+    ASSERT_EQ(0U, methodStatistics.getMethodCount(WORLD_CODE));
+    ASSERT_EQ(1U, methodStatistics.getMethodCount(PING_CODE));
+
+    // events of unknown codes are kept too.
+    const auto unknownStats = methodStatistics.getStatistics(UNKNOWN_CODE);
+    ASSERT_EQ(1, unknownStats.getN());
+    ASSERT_EQ(2.f, unknownStats.getMean());
+
+    // one line per method with events.
+    const std::string dump = methodStatistics.dump();
+    ASSERT_EQ(3, std::count(dump.begin(), dump.end(), '\n'));
+    ASSERT_NE(std::string::npos, dump.find(HELLO_NAME));
+    ASSERT_EQ(std::string::npos, dump.find(WORLD_NAME));
+}
+
+TEST(methodstatistics_tests, sharded_concurrent_events) {
+    constexpr size_t kThreads = 16;
+    constexpr size_t kEvents = 10000;
+    ShardedMethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&methodStatistics, i] {
+            for (size_t j = 0; j < kEvents; ++j) {
+                methodStatistics.event(HELLO_CODE, float(i));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    const auto helloStats = methodStatistics.getStatistics(HELLO_CODE);
+    ASSERT_EQ(int64_t(kThreads * kEvents), helloStats.getN());
+    ASSERT_EQ(0.f, helloStats.getMin());
+    ASSERT_EQ(float(kThreads - 1), helloStats.getMax());
+    ASSERT_NEAR((kThreads - 1) / 2., helloStats.getMean(), 1e-9);
+}
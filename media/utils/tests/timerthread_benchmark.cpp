@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <mediautils/TidWrapper.h>
+#include <mediautils/TimerThread.h>
+
+using namespace std::chrono_literals;
+using namespace android::mediautils;
+
+namespace {
+
+/*
+ * The previous TimerThread design, reduced to the scheduleTask() / cancelTask() path:
+ * a Request allocated per task, std::map of pending tasks under one mutex
+ * with the monitor thread woken on every add, and a std::deque of retired tasks.
+ */
+class MapTimerThread {
+  public:
+    using Handle = TimerThread::Handle;
+    using Request = TimerThread::Request;
+
+    MapTimerThread() : mThread([this] { threadFunc(); }) {}
+
+    ~MapTimerThread() {
+        {
+            std::lock_guard _l(mMutex);
+            mShouldExit = true;
+            mCond.notify_all();
+        }
+        mThread.join();
+    }
+
+    Handle scheduleTask(std::string_view tag, TimerThread::TimerCallback&& func,
+            TimerThread::Duration timeoutDuration, TimerThread::Duration secondChanceDuration) {
+        const auto now = std::chrono::system_clock::now();
+        auto request = std::make_shared<const Request>(now, now +
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(timeoutDuration),
+                secondChanceDuration, getThreadIdWrapper(), tag);
+        std::lock_guard _l(mMutex);
+        auto deadline = std::chrono::steady_clock::now() + timeoutDuration;
+        while (mMonitorRequests.find(deadline) != mMonitorRequests.end()) {
+            deadline += TimerThread::Duration(1);
+        }
+        mMonitorRequests.emplace_hint(mMonitorRequests.end(),
+                deadline, std::make_pair(std::move(request), std::move(func)));
+        mCond.notify_all();
+        return deadline;
+    }
+
+    bool cancelTask(Handle handle) {
+        std::pair<std::shared_ptr<const Request>, TimerThread::TimerCallback> data;
+        {
+            std::lock_guard _l(mMutex);
+            const auto it = mMonitorRequests.find(handle);
+            if (it == mMonitorRequests.end()) return false;
+            data = std::move(it->second);
+            mMonitorRequests.erase(it);
+        }
+        std::lock_guard _l(mRetiredMutex);
+        mRetired.emplace_back(std::chrono::system_clock::now(), std::move(data.first));
+        if (mRetired.size() > kRetiredQueueMax) mRetired.pop_front();
+        return true;
+    }
+
+  private:
+    void threadFunc() {
+        std::unique_lock _l(mMutex);
+        while (!mShouldExit) {
+            // The benchmark timeouts never expire.
+            if (mMonitorRequests.empty()) {
+                mCond.wait(_l);
+            } else {
+                mCond.wait_until(_l, mMonitorRequests.begin()->first);
+            }
+        }
+    }
+
+    static constexpr size_t kRetiredQueueMax = 16;
+    std::mutex mRetiredMutex;
+    std::deque<std::pair<std::chrono::system_clock::time_point, std::shared_ptr<const Request>>>
+            mRetired;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::map<Handle, std::pair<std::shared_ptr<const Request>, TimerThread::TimerCallback>>
+            mMonitorRequests;
+    bool mShouldExit = false;
+    std::thread mThread;
+};
+
+/*
+ * A TimeCheck on a binder call: schedules a task, with the same callback size as TimeCheck,
+ * and cancels it before its timeout, concurrently on all benchmark threads.
+ */
+template <typename T>
+static void BM_ScheduleCancel(benchmark::State& state) {
+    static T timerThread;
+    const auto handler = std::make_shared<int>();
+    while (state.KeepRunning()) {
+        const auto handle = timerThread.scheduleTask("IAudioFlinger::binderCall",
+                [handler](TimerThread::Handle) { benchmark::DoNotOptimize(handler); },
+                3s /* timeoutDuration */, 2s /* secondChanceDuration */);
+        benchmark::DoNotOptimize(timerThread.cancelTask(handle));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_ScheduleCancel, TimerThread)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ScheduleCancel, MapTimerThread)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -204,7 +204,7 @@ static auto& getIAudioFlingerStatistics() {
 #define BINDER_METHOD_ENTRY(ENTRY) \
     {(Code)media::BnAudioFlingerService::TRANSACTION_##ENTRY, #ENTRY},
 
-    static mediautils::MethodStatistics<Code> methodStatistics{
+    static mediautils::ShardedMethodStatistics<Code> methodStatistics{
         IAUDIOFLINGER_BINDER_METHOD_MACRO_LIST
         METHOD_STATISTICS_BINDER_CODE_NAMES(Code)
     };
@@ -871,7 +871,7 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
             dprintf(fd, "\nIAudioFlinger binder call profile:\n");
             write(fd, timeCheckStats.c_str(), timeCheckStats.size());
 
-            extern mediautils::MethodStatistics<int>& getIEffectStatistics();
+            extern mediautils::ShardedMethodStatistics<int>& getIEffectStatistics();
             timeCheckStats = getIEffectStatistics().dump();
             dprintf(fd, "\nIEffect binder call profile:\n");
             write(fd, timeCheckStats.c_str(), timeCheckStats.size());
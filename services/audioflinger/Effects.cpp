@@ -26,6 +26,7 @@
 
 #include <afutils/DumpTryLock.h>
 #include <audio_utils/channels.h>
+#include <audio_utils/clock.h>
 #include <audio_utils/primitives.h>
 #include <media/AudioCommonTypes.h>
 #include <media/AudioContainers.h>
@@ -49,6 +50,7 @@
 #include <utils/Log.h>
 
 #include <algorithm>
+#include <time.h>
 
 // ----------------------------------------------------------------------------
 
@@ -90,6 +92,13 @@ void writeToBuffer(const T& value, std::vector<uint8_t>* buffer) {
     appendToBuffer(value, buffer);
 }
 
+// CPU time consumed by the calling thread.
+int64_t threadCpuTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return audio_utils_ns_from_timespec(&ts);
+}
+
 }  // namespace
 
 // ----------------------------------------------------------------------------
@@ -1794,7 +1803,7 @@ BINDER_METHOD_ENTRY(getCblk) \
 BINDER_METHOD_ENTRY(getConfig) \
 
 // singleton for Binder Method Statistics for IEffect
-mediautils::MethodStatistics<int>& getIEffectStatistics() {
+mediautils::ShardedMethodStatistics<int>& getIEffectStatistics() {
     using Code = int;
 
 #pragma push_macro("BINDER_METHOD_ENTRY")
@@ -1802,7 +1811,7 @@ mediautils::MethodStatistics<int>& getIEffectStatistics() {
 #define BINDER_METHOD_ENTRY(ENTRY) \
         {(Code)media::BnEffect::TRANSACTION_##ENTRY, #ENTRY},
 
-    static mediautils::MethodStatistics<Code> methodStatistics{
+    static mediautils::ShardedMethodStatistics<Code> methodStatistics{
         IEFFECT_BINDER_METHOD_MACRO_LIST
         METHOD_STATISTICS_BINDER_CODE_NAMES(Code)
     };
@@ -2269,7 +2278,7 @@ void EffectChain::clearInputBuffer_l()
 }
 
 // Must be called with EffectChain::mutex() locked
-void EffectChain::process_l() {
+bool EffectChain::prepareProcess_l() {
     // never process effects when:
     // - on an OFFLOAD thread
     // - no more tracks are on the session and the effect tail has been rendered
@@ -2292,9 +2301,49 @@ void EffectChain::process_l() {
             }
         }
     }
+    return doProcess;
+}
 
-    size_t size = mEffects.size();
-    if (doProcess) {
+int64_t EffectChain::processStartCpuNs() const {
+    return mProcessCpuMeasured.load(std::memory_order_relaxed) ? threadCpuTimeNs() : -1;
+}
+
+// Must be called with EffectChain::mutex() locked
+void EffectChain::processEffects_l(int64_t startCpuNs) {
+    for (size_t i = 0; i < mEffects.size(); i++) {
+        mEffects[i]->process();
+    }
+    mInBuffer->commit();
+    if (startCpuNs < 0) {
+        return;
+    }
+
+    const int64_t cpuNs = threadCpuTimeNs() - startCpuNs;
+    mProcessCount.fetch_add(1, std::memory_order_relaxed);
+    mProcessCpuNs.fetch_add(cpuNs, std::memory_order_relaxed);
+    if (cpuNs > mProcessMaxCpuNs.load(std::memory_order_relaxed)) {
+        mProcessMaxCpuNs.store(cpuNs, std::memory_order_relaxed);
+    }
+}
+
+// Must be called with EffectChain::mutex() locked
+void EffectChain::updateEffectsState_l() {
+    bool doResetVolume = false;
+    for (size_t i = 0; i < mEffects.size(); i++) {
+        // reset volume when any effect just started or stopped.
+        // resetVolume_l will check if the volume controller effect in the chain needs update and
+        // apply the correct volume
+        doResetVolume = mEffects[i]->updateState_l() || doResetVolume;
+    }
+    if (doResetVolume) {
+        resetVolume_l();
+    }
+}
+
+// Must be called with EffectChain::mutex() locked
+void EffectChain::process_l() {
+    if (prepareProcess_l()) {
+        const int64_t startCpuNs = processStartCpuNs();
         // Only the input and output buffers of the chain can be external,
         // and 'update' / 'commit' do nothing for allocated buffers, thus
         // it's not needed to consider any other buffers here.
@@ -2302,24 +2351,52 @@ void EffectChain::process_l() {
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->update();
         }
-        for (size_t i = 0; i < size; i++) {
-            mEffects[i]->process();
-        }
-        mInBuffer->commit();
+        processEffects_l(startCpuNs);
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->commit();
         }
     }
-    bool doResetVolume = false;
-    for (size_t i = 0; i < size; i++) {
-        // reset volume when any effect just started or stopped.
-        // resetVolume_l will check if the volume controller effect in the chain needs update and
-        // apply the correct volume
-        doResetVolume = mEffects[i]->updateState_l() || doResetVolume;
+    updateEffectsState_l();
+}
+
+// Must be called with EffectChain::mutex() locked
+bool EffectChain::canProcessIsolated_l() const {
+    // A session chain has its own input buffer, and its last effect accumulates into a mirror
+    // of the mix, which is only copied from and to the mix by update() and commit().
+    if (audio_is_global_session(mSessionId) || mInBuffer == nullptr || mOutBuffer == nullptr
+            || mEffects.isEmpty()) {
+        return false;
     }
-    if (doResetVolume) {
-        resetVolume_l();
+    void* const outRaw = mOutBuffer->audioBuffer()->raw;
+    return mInBuffer->audioBuffer()->raw != outRaw
+            && mOutBuffer->externalData() != nullptr && mOutBuffer->externalData() != outRaw;
+}
+
+// Called with EffectChain::mutex() held by the thread loop, possibly from another thread.
+void EffectChain::processIsolated_l() {
+    mIsolatedOutputValid = false;
+    if (!prepareProcess_l()) {
+        return;
+    }
+    const int64_t startCpuNs = processStartCpuNs();
+    mInBuffer->update();
+    // Accumulate into silence rather than into a copy of the mix, which other chains may be
+    // joining concurrently. As 0 + x == x, processJoin_l() then adds exactly the same values
+    // to the mix as process_l() would.
+    memset(mOutBuffer->audioBuffer()->raw, 0, mOutBuffer->getSize());
+    processEffects_l(startCpuNs);
+    mProcessIsolatedCount.fetch_add(1, std::memory_order_relaxed);
+    mIsolatedOutputValid = true;
+}
+
+// Must be called with EffectChain::mutex() locked
+void EffectChain::processJoin_l() {
+    if (mIsolatedOutputValid) {
+        accumulate_float(static_cast<float*>(mOutBuffer->externalData()),
+                mOutBuffer->audioBuffer()->f32, mOutBuffer->getSize() / sizeof(float));
+        mIsolatedOutputValid = false;
     }
+    updateEffectsState_l();
 }
 
 status_t EffectChain::createEffect(sp<IAfEffectModule>& effect,
@@ -2771,6 +2848,16 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
                 (int)outBufferStr.size(), "Out buffer      ");
         result.appendFormat("\t%s   %s   %d\n",
                 inBufferStr.c_str(), outBufferStr.c_str(), mActiveTrackCnt);
+        const int64_t processCount = mProcessCount.load(std::memory_order_relaxed);
+        if (processCount > 0) {
+            const int64_t processCpuNs = mProcessCpuNs.load(std::memory_order_relaxed);
+            result.appendFormat("\tProcess CPU: %lld cycles (%lld isolated), "
+                    "total %.3f ms, mean %.1f us, max %.1f us\n",
+                    (long long)processCount,
+                    (long long)mProcessIsolatedCount.load(std::memory_order_relaxed),
+                    processCpuNs * 1e-6, processCpuNs * 1e-3 / processCount,
+                    mProcessMaxCpuNs.load(std::memory_order_relaxed) * 1e-3);
+        }
         write(fd, result.c_str(), result.size());
 
         for (size_t i = 0; i < numEffects; ++i) {
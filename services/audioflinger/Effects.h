@@ -24,6 +24,7 @@
 #include <mediautils/Synchronization.h>
 #include <private/media/AudioEffectShared.h>
 
+#include <atomic>
 #include <map>  // avoid transitive dependency
 #include <optional>
 #include <vector>
@@ -428,6 +429,12 @@ public:
                 const sp<IAfThreadCallback>& afThreadCallback);
 
     void process_l() final REQUIRES(audio_utils::EffectChain_Mutex);
+    bool canProcessIsolated_l() const final REQUIRES(audio_utils::EffectChain_Mutex);
+    void processIsolated_l() final REQUIRES(audio_utils::EffectChain_Mutex);
+    void processJoin_l() final REQUIRES(audio_utils::EffectChain_Mutex);
+    void setProcessCpuMeasured(bool measured) final {
+        mProcessCpuMeasured.store(measured, std::memory_order_relaxed);
+    }
 
     audio_utils::mutex& mutex() const final RETURN_CAPABILITY(audio_utils::EffectChain_Mutex) {
         return mMutex;
@@ -684,6 +691,16 @@ public:
 
     void clearInputBuffer_l() REQUIRES(audio_utils::EffectChain_Mutex);
 
+    // Updates the effect tail and returns true if the effects must be processed this cycle.
+    bool prepareProcess_l() REQUIRES(audio_utils::EffectChain_Mutex);
+    // Returns the thread CPU time to pass to processEffects_l(), or -1 if it is not measured.
+    int64_t processStartCpuNs() const;
+    // Runs the effects, then updates the CPU time statistics with the time since startCpuNs,
+    // unless startCpuNs is negative.
+    void processEffects_l(int64_t startCpuNs) REQUIRES(audio_utils::EffectChain_Mutex);
+    // Applies effect state changes after processing.
+    void updateEffectsState_l() REQUIRES(audio_utils::EffectChain_Mutex);
+
     // true if any effect module within the chain has volume control
     bool hasVolumeControlEnabled_l() const REQUIRES(audio_utils::EffectChain_Mutex);
 
@@ -723,6 +740,19 @@ public:
              const sp<EffectCallback> mEffectCallback;
 
              wp<IAfEffectModule> mVolumeControlEffect;
+
+             // set by processIsolated_l() when the chain output must be accumulated
+             // into the mix by processJoin_l()
+             bool mIsolatedOutputValid = false;
+
+             // CPU time spent processing the effects, for dumpsys. Written by the thread
+             // processing the chain, read by dump() without the chain mutex.
+             // Only measured when enabled by setProcessCpuMeasured().
+             std::atomic<bool> mProcessCpuMeasured = false;
+             std::atomic<int64_t> mProcessCount = 0;
+             std::atomic<int64_t> mProcessIsolatedCount = 0;
+             std::atomic<int64_t> mProcessCpuNs = 0;
+             std::atomic<int64_t> mProcessMaxCpuNs = 0;
 };
 
 class DeviceEffectProxy : public IAfDeviceEffectProxy, public EffectBase {
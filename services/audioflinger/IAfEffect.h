@@ -235,6 +235,24 @@ public:
 
     virtual void process_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
 
+    // process_l() split in two, so that the effects of independent session chains can be
+    // processed concurrently. processIsolated_l() only writes to buffers private to the chain:
+    // the effect output is accumulated into the chain's own copy of the output buffer rather
+    // than into the shared mix. It may be called from a helper thread while the thread loop
+    // holds the chain mutex. processJoin_l() then accumulates that output into the mix, and
+    // must be called from the thread loop in the order process_l() would have been called,
+    // which keeps the result identical to process_l().
+    // canProcessIsolated_l() returns false if the chain output is not separate from the mix,
+    // in which case process_l() must be used.
+    virtual bool canProcessIsolated_l() const REQUIRES(audio_utils::EffectChain_Mutex) = 0;
+    virtual void processIsolated_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
+    virtual void processJoin_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
+
+    // Enables the CPU time statistics of process_l() and processIsolated_l() for dumpsys.
+    // They read the thread CPU clock, a system call, twice per cycle, so they are only enabled
+    // on threads which process chains in parallel.
+    virtual void setProcessCpuMeasured(bool measured) = 0;
+
     virtual audio_utils::mutex& mutex() const RETURN_CAPABILITY(audio_utils::EffectChain_Mutex) = 0;
 
     virtual status_t createEffect(sp<IAfEffectModule>& effect, effect_descriptor_t* desc, int id,
@@ -223,6 +223,10 @@ static const enum {
     FastCapture_Static, // initialize if needed, then use all the time if initialized
 } kUseFastCapture = FastCapture_Static;
 
+// Whether MixerThread publishes fast track additions and removals as FastTrackDelta while the
+// fast mixer is mixing, instead of pushing a whole FastMixerState for each change.
+static const bool kUseFastTrackDeltas = true;
+
 // Priorities for requestPriority
 static const int kPriorityAudioApp = 2;
 static const int kPriorityFastMixer = 3;
@@ -955,6 +959,78 @@ void ThreadBase::processConfigEvents_l()
     if (configChanged) {
         cacheParameters_l();
     }
+
+    updateDumpSnapshot_l();
+}
+
+void ThreadBase::updateDumpSnapshot_l(bool waiting)
+{
+    const int64_t now = systemTime();
+    if (!waiting && !mDumpSnapshotRequested.load(std::memory_order_relaxed)
+            && now - mLastDumpSnapshotNs < kDumpSnapshotPeriodNs) {
+        return;
+    }
+    DumpSnapshot* const snapshot = mDumpSnapshot.beginWrite();
+    if (snapshot == nullptr) {
+        return;  // dump() is still reading the previous snapshot, try again next loop
+    }
+    mDumpSnapshotRequested = false;
+    captureDumpSnapshot_l(snapshot);
+    snapshot->waiting = waiting;
+    mDumpSnapshot.endWrite();
+    // once woken up, the thread captures its running state on the next loop
+    mLastDumpSnapshotNs = waiting ? 0 : now;
+}
+
+void ThreadBase::captureDumpSnapshot_l(DumpSnapshot* snapshot)
+{
+    const auto toStats = [](const audio_utils::Statistics<double>& stats) {
+        return DumpSnapshot::Stats{
+                stats.getN(), stats.getMean(), stats.getStdDev(), stats.getMin(), stats.getMax()};
+    };
+
+    *snapshot = {};
+    snapshot->captureNs = systemTime();
+    snapshot->standby = mStandby;
+    snapshot->sampleRate = mSampleRate;
+    snapshot->frameCount = mFrameCount;
+    snapshot->halFormat = mHALFormat;
+    snapshot->format = mFormat;
+    snapshot->channelMask = mChannelMask;
+    snapshot->frameSize = mFrameSize;
+    snapshot->processTimeMs = toStats(mProcessTimeMs);
+    snapshot->ioJitterMs = toStats(mIoJitterMs);
+    snapshot->latencyMs = toStats(mLatencyMs);
+    snapshot->lastIoBeginNs = mLastIoBeginNs;
+
+    snapshot->numEffectChains = mEffectChains.size();
+    for (size_t i = 0; i < std::min(mEffectChains.size(), DumpSnapshot::kMaxEffectChains); ++i) {
+        const sp<IAfEffectChain>& chain = mEffectChains[i];
+        snapshot->effectChains[i] = {chain->sessionId(), chain->numberOfEffects(),
+                chain->trackCnt(), chain->activeTrackCnt()};
+    }
+}
+
+/* static */
+void ThreadBase::addDumpSnapshotTrack(DumpSnapshot* snapshot,
+        const sp<IAfTrackBase>& track, bool active)
+{
+    const size_t index = snapshot->numTracks++;
+    if (track == nullptr || index >= DumpSnapshot::kMaxTracks) {
+        return;
+    }
+    snapshot->tracks[index] = {
+            .id = track->id(),
+            .sessionId = track->sessionId(),
+            .uid = track->uid(),
+            .state = track->getTrackStateAsString(),
+            .sampleRate = track->sampleRate(),
+            .format = track->format(),
+            .channelMask = track->channelMask(),
+            .portId = track->portId(),
+            .active = active,
+            .fast = track->isFastTrack(),
+    };
 }
 
 String8 channelMaskToString(audio_channel_mask_t mask, bool output) {
@@ -1039,30 +1115,38 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
     dprintf(fd, "\n%s thread %p, name %s, tid %d, type %d (%s):\n", isOutput() ? "Output" : "Input",
             this, mThreadName, getTid(), type(), threadTypeToString(type()));
 
-    const bool locked = afutils::dumpTryLock(mutex());
-    if (!locked) {
-        dprintf(fd, "  Thread may be deadlocked\n");
+    // --all does the statistics, --snapshot does not take the thread lock
+    bool dumpAll = false;
+    bool dumpFromSnapshot = false;
+    for (const auto &arg : args) {
+        if (arg == String16("--all")) {
+            dumpAll = true;
+        } else if (arg == String16("--snapshot")) {
+            dumpFromSnapshot = true;
+        }
     }
 
-    dumpBase_l(fd, args);
-    dumpInternals_l(fd, args);
-    dumpTracks_l(fd, args);
-    dumpEffectChains_l(fd, args);
+    if (dumpFromSnapshot) {
+        dumpSnapshot(fd);
+    } else {
+        const bool locked = afutils::dumpTryLock(mutex());
+        if (!locked) {
+            dprintf(fd, "  Thread may be deadlocked\n");
+        }
 
-    if (locked) {
-        mutex().unlock();
+        dumpBase_l(fd, args);
+        dumpInternals_l(fd, args);
+        dumpTracks_l(fd, args);
+        dumpEffectChains_l(fd, args);
+
+        if (locked) {
+            mutex().unlock();
+        }
     }
 
     dprintf(fd, "  Local log:\n");
     mLocalLog.dump(fd, "   " /* prefix */, 40 /* lines */);
 
-    // --all does the statistics
-    bool dumpAll = false;
-    for (const auto &arg : args) {
-        if (arg == String16("--all")) {
-            dumpAll = true;
-        }
-    }
     if (dumpAll || type() == SPATIALIZER) {
         const std::string sched = mThreadSnapshot.toString();
         if (!sched.empty()) {
@@ -1071,6 +1155,101 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
     }
 }
 
+void ThreadBase::dumpSnapshot(int fd)
+{
+    // A thread waiting for work captured its state before waiting, and is not woken up:
+    // that would take its wakelock and restart its standby delay.
+    // A running thread is asked for a fresh snapshot, but not waited for long if blocked:
+    // it is then reported from the last snapshot it captured.
+    const auto snapshot = std::make_unique<DumpSnapshot>();
+    const uint64_t generation = mDumpSnapshot.generation();
+    bool refreshed = false;
+    if (!mDumpSnapshot.read(*snapshot) || !snapshot->waiting) {
+        mDumpSnapshotRequested = true;
+        const int64_t deadlineNs = systemTime() + kDumpSnapshotWaitNs;
+        while (mDumpSnapshot.generation() == generation && systemTime() < deadlineNs) {
+            usleep(1000);
+        }
+        refreshed = mDumpSnapshot.generation() != generation;
+        if (!mDumpSnapshot.read(*snapshot)) {
+            dprintf(fd, "  No snapshot captured yet\n");
+            return;
+        }
+    }
+    const DumpSnapshot& s = *snapshot;
+    dprintf(fd, "  Snapshot age (msecs): %lld%s\n",
+            (long long) (systemTime() - s.captureNs) / NANOS_PER_MILLISECOND,
+            s.waiting ? " (thread waiting for work)"
+                    : refreshed ? "" : " (not refreshed by thread)");
+    dprintf(fd, "  I/O handle: %d\n", mId);
+    dprintf(fd, "  Standby: %s\n", s.standby ? "yes" : "no");
+    dprintf(fd, "  Sample rate: %u Hz\n", s.sampleRate);
+    dprintf(fd, "  HAL frame count: %zu\n", s.frameCount);
+    dprintf(fd, "  HAL format: 0x%x (%s)\n", s.halFormat,
+            IAfThreadBase::formatToString(s.halFormat).c_str());
+    dprintf(fd, "  Channel mask: 0x%08x (%s)\n", s.channelMask,
+            channelMaskToString(s.channelMask, mType != RECORD).c_str());
+    dprintf(fd, "  Processing format: 0x%x (%s)\n", s.format,
+            IAfThreadBase::formatToString(s.format).c_str());
+    dprintf(fd, "  Processing frame size: %zu bytes\n", s.frameSize);
+
+    if (s.lastIoBeginNs > 0) { // MMAP may not set this
+        dprintf(fd, "  Last %s occurred (msecs): %lld\n",
+                isOutput() ? "write" : "read",
+                (long long) (systemTime() - s.lastIoBeginNs) / NANOS_PER_MILLISECOND);
+    }
+
+    const auto dumpStats = [fd](const char* name, const DumpSnapshot::Stats& stats) {
+        if (stats.n > 0) {
+            dprintf(fd, "  %s: n=%lld ave=%.2f std=%.2f min=%.2f max=%.2f\n",
+                    name, (long long) stats.n, stats.mean, stats.stdDev, stats.min, stats.max);
+        }
+    };
+    dumpStats("Process time ms stats", s.processTimeMs);
+    dumpStats(isOutput() ? "Hal write jitter ms stats" : "Hal read jitter ms stats",
+            s.ioJitterMs);
+    dumpStats(isOutput() ? "Threadloop write latency stats" : "Threadloop read latency stats",
+            s.latencyMs);
+
+    if (s.playback) {
+        dprintf(fd, "  Master volume: %f\n", s.masterVolume);
+        dprintf(fd, "  Master mute: %s\n", s.masterMute ? "on" : "off");
+        dprintf(fd, "  Total writes: %d\n", s.numWrites);
+        dprintf(fd, "  Delayed writes: %d\n", s.numDelayedWrites);
+        dprintf(fd, "  Frames written: %lld\n", (long long) s.framesWritten);
+        dprintf(fd, "  Normal mixer raw underrun counters: partial=%u empty=%u\n",
+                s.underrunsPartial, s.underrunsEmpty);
+    }
+
+    dprintf(fd, "  %zu Tracks of which %zu are active\n", s.numTracks, s.numActiveTracks);
+    const size_t numTracks = std::min(s.numTracks, DumpSnapshot::kMaxTracks);
+    if (numTracks > 0) {
+        dprintf(fd, "    Id Active Session   Uid State       Rate Format     Channel mask"
+                "  Port Fast\n");
+    }
+    for (size_t i = 0; i < numTracks; ++i) {
+        const DumpSnapshot::Track& t = s.tracks[i];
+        dprintf(fd, "    %2d %6s %7d %5u %-10s %5u %08X   %08X  %5d %4s\n",
+                t.id, t.active ? "yes" : "no", t.sessionId, t.uid, t.state,
+                t.sampleRate, t.format, t.channelMask, t.portId, t.fast ? "yes" : "no");
+    }
+    if (s.numTracks > numTracks) {
+        dprintf(fd, "    (%zu more tracks not in snapshot)\n", s.numTracks - numTracks);
+    }
+
+    dprintf(fd, "  %zu Effect Chains\n", s.numEffectChains);
+    const size_t numEffectChains = std::min(s.numEffectChains, DumpSnapshot::kMaxEffectChains);
+    for (size_t i = 0; i < numEffectChains; ++i) {
+        const DumpSnapshot::EffectChain& c = s.effectChains[i];
+        dprintf(fd, "    Session %d: %zu effects, %d tracks, %d active tracks\n",
+                c.sessionId, c.numberOfEffects, c.trackCnt, c.activeTrackCnt);
+    }
+    if (s.numEffectChains > numEffectChains) {
+        dprintf(fd, "    (%zu more effect chains not in snapshot)\n",
+                s.numEffectChains - numEffectChains);
+    }
+}
+
 void ThreadBase::dumpBase_l(int fd, const Vector<String16>& /* args */)
 {
     dprintf(fd, "  I/O handle: %d\n", mId);
@@ -1118,10 +1297,12 @@ void ThreadBase::dumpBase_l(int fd, const Vector<String16>& /* args */)
                 isTimestampCorrectionEnabled_l() ? "yes" : "no");
     }
 
-    if (mLastIoBeginNs > 0) { // MMAP may not set this
+    // read once, dump() may not hold the thread lock
+    const int64_t lastIoBeginNs = mLastIoBeginNs;
+    if (lastIoBeginNs > 0) { // MMAP may not set this
         dprintf(fd, "  Last %s occurred (msecs): %lld\n",
                 isOutput() ? "write" : "read",
-                (long long) (systemTime() - mLastIoBeginNs) / NANOS_PER_MILLISECOND);
+                (long long) (systemTime() - lastIoBeginNs) / NANOS_PER_MILLISECOND);
     }
 
     if (mProcessTimeMs.getN() > 0) {
@@ -2102,6 +2283,53 @@ NO_THREAD_SAFETY_ANALYSIS
     item->selfrecord();
 }
 
+// Call only from threadLoop().
+// Do not call from high performance code as this may do binder rpc to the MediaMetrics service.
+void ThreadBase::logFastThreadLatency(
+        [[maybe_unused]] const FastThreadDumpState& dumpState, [[maybe_unused]] bool force)
+{
+#ifdef FAST_THREAD_STATISTICS
+    // The histograms are cumulative, so the period only determines the time resolution.
+    static constexpr int64_t kFastThreadLatencyLogPeriodNs = 5 * 60 * NANOS_PER_SECOND;
+    const int64_t nowNs = systemTime();
+    if (!force && nowNs - mLoggedFastThreadLatencyNs < kFastThreadLatencyLogPeriodNs) {
+        return;
+    }
+    mLoggedFastThreadLatencyNs = nowNs;
+
+    // The fast thread may be running, so the copy is not necessarily consistent;
+    // cycles that are being counted now will be logged next time.
+    const FastThreadHistograms histograms = dumpState.mHistograms;
+    const uint32_t underruns = dumpState.mUnderruns;
+    const FastThreadHistograms recent = histograms - mLoggedFastThreadHistograms;
+    const uint32_t recentUnderruns = underruns - mLoggedFastThreadUnderruns;
+    mLoggedFastThreadHistograms = histograms;
+    mLoggedFastThreadUnderruns = underruns;
+    const int64_t cycles = recent.mCycleUs.count();
+    if (cycles == 0) {
+        return;
+    }
+
+#define FT_PREFIX AMEDIAMETRICS_PROP_PREFIX_FASTTHREAD // avoid cut-n-paste errors.
+    mediametrics::LogItem(mThreadMetrics.getMetricsId())
+        .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_FASTTHREADLATENCY)
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_CYCLECOUNT, cycles)
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)recentUnderruns)
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_CYCLEUS_P50, (int32_t)recent.mCycleUs.percentile(50.))
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_CYCLEUS_P99, (int32_t)recent.mCycleUs.percentile(99.))
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_CYCLEUS_P999, (int32_t)recent.mCycleUs.percentile(99.9))
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_LOADUS_P50, (int32_t)recent.mLoadUs.percentile(50.))
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_LOADUS_P99, (int32_t)recent.mLoadUs.percentile(99.))
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_LOADUS_P999, (int32_t)recent.mLoadUs.percentile(99.9))
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_JITTERUS_P50, (int32_t)recent.mJitterUs.percentile(50.))
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_JITTERUS_P99, (int32_t)recent.mJitterUs.percentile(99.))
+        .set(FT_PREFIX AMEDIAMETRICS_PROP_JITTERUS_P999,
+                (int32_t)recent.mJitterUs.percentile(99.9))
+        .record();
+#undef FT_PREFIX
+#endif
+}
+
 product_strategy_t ThreadBase::getStrategyForStream(audio_stream_type_t stream) const
 {
     if (!mAfThreadCallback->isAudioPolicyReady()) {
@@ -2165,7 +2393,8 @@ PlaybackThread::PlaybackThread(const sp<IAfThreadCallback>& afThreadCallback,
         mDrainSequence(0),
         mScreenState(mAfThreadCallback->getScreenState()),
         // index 0 is reserved for normal mixer's submix
-        mFastTrackAvailMask(((1 << FastMixerState::sMaxFastTracks) - 1) & ~1),
+        mFastTrackAvailMask(FastTrackMask::first(FastMixerState::sMaxFastTracks) &
+                ~FastTrackMask::first(1)),
         mHwSupportsPause(false), mHwPaused(false), mFlushPending(false), mHwSupportsSuspend(false),
         mLeftVolFloat(-1.0), mRightVolFloat(-1.0),
         mDownStreamPatch{},
@@ -2339,6 +2568,30 @@ void PlaybackThread::dumpTracks_l(int fd, const Vector<String16>& /* args */)
     write(fd, result.c_str(), result.size());
 }
 
+void PlaybackThread::captureDumpSnapshot_l(DumpSnapshot* snapshot)
+{
+    ThreadBase::captureDumpSnapshot_l(snapshot);
+    snapshot->playback = true;
+    snapshot->masterVolume = mMasterVolume;
+    snapshot->masterMute = mMasterMute;
+    snapshot->numWrites = mNumWrites;
+    snapshot->numDelayedWrites = mNumDelayedWrites;
+    snapshot->framesWritten = mFramesWritten;
+    const FastTrackUnderruns underruns = getFastTrackUnderruns(0);
+    snapshot->underrunsPartial = underruns.mBitFields.mPartial;
+    snapshot->underrunsEmpty = underruns.mBitFields.mEmpty;
+    // Mark the active tracks once rather than searching them for each track.
+    std::vector<bool> active(mTracks.size());
+    for (const sp<IAfTrack>& track : mActiveTracks) {
+        const ssize_t index = mTracks.indexOf(track);
+        if (index >= 0) active[index] = true;
+    }
+    for (size_t i = 0; i < mTracks.size(); ++i) {
+        addDumpSnapshotTrack(snapshot, mTracks[i], active[i]);
+    }
+    snapshot->numActiveTracks = mActiveTracks.size();
+}
+
 void PlaybackThread::dumpInternals_l(int fd, const Vector<String16>& args)
 {
     dprintf(fd, "  Master volume: %f\n", mMasterVolume);
@@ -2354,7 +2607,7 @@ void PlaybackThread::dumpInternals_l(int fd, const Vector<String16>& args)
     dprintf(fd, "  Delayed writes: %d\n", mNumDelayedWrites);
     dprintf(fd, "  Blocked in write: %s\n", mInWrite ? "yes" : "no");
     dprintf(fd, "  Suspend count: %d\n", (int32_t)mSuspended);
-    dprintf(fd, "  Fast track availMask=%#x\n", mFastTrackAvailMask);
+    dprintf(fd, "  Fast track availMask=%s\n", mFastTrackAvailMask.toString().c_str());
     dprintf(fd, "  Standby delay ns=%lld\n", (long long)mStandbyDelayNs);
     AudioStreamOut *output = mOutput;
     audio_output_flags_t flags = output != NULL ? output->flags : AUDIO_OUTPUT_FLAG_NONE;
@@ -2462,7 +2715,7 @@ sp<IAfTrack> PlaybackThread::createTrack_l(
             // normal mixer has an associated fast mixer
             hasFastMixer() &&
             // there are sufficient fast track slots available
-            (mFastTrackAvailMask != 0)
+            mFastTrackAvailMask.any()
             // FIXME test that MixerThread for this fast track has a capable output HAL
             // FIXME add a permission test also?
         ) {
@@ -2503,10 +2756,10 @@ sp<IAfTrack> PlaybackThread::createTrack_l(
         ALOGD("AUDIO_OUTPUT_FLAG_FAST denied: sharedBuffer=%p frameCount=%zu "
                 "mFrameCount=%zu format=%#x mFormat=%#x isLinear=%d channelMask=%#x "
                 "sampleRate=%u mSampleRate=%u "
-                "hasFastMixer=%d tid=%d fastTrackAvailMask=%#x",
+                "hasFastMixer=%d tid=%d fastTrackAvailMask=%s",
                 sharedBuffer.get(), frameCount, mFrameCount, format, mFormat,
                 audio_is_linear_pcm(format), channelMask, sampleRate,
-                mSampleRate, hasFastMixer(), tid, mFastTrackAvailMask);
+                mSampleRate, hasFastMixer(), tid, mFastTrackAvailMask.toString().c_str());
         *flags = (audio_output_flags_t)(*flags & ~AUDIO_OUTPUT_FLAG_FAST);
       }
     }
@@ -3003,8 +3256,8 @@ void PlaybackThread::removeTrack_l(const sp<IAfTrack>& track)
     if (track->isFastTrack()) {
         int index = track->fastIndex();
         ALOG_ASSERT(0 < index && index < (int)FastMixerState::sMaxFastTracks);
-        ALOG_ASSERT(!(mFastTrackAvailMask & (1 << index)));
-        mFastTrackAvailMask |= 1 << index;
+        ALOG_ASSERT(!mFastTrackAvailMask.test(index));
+        mFastTrackAvailMask.set(index);
         // redundant as track is about to be destroyed, for dumpsys only
         track->fastIndex() = -1;
     }
@@ -3569,6 +3822,45 @@ void PlaybackThread::checkSilentMode_l()
     }
 }
 
+void PlaybackThread::processIsolatedEffectChains_l(
+        const Vector<sp<IAfEffectChain>>& effectChains, audio_session_t excludedSessionId)
+NO_THREAD_SAFETY_ANALYSIS  // the effect chain mutexes are held by the caller
+{
+    mIsolatedEffectChains.clear();
+    if (mEffectChainWorkerPool == nullptr) {
+        return;
+    }
+    for (const sp<IAfEffectChain>& chain : effectChains) {
+        if (mIsolatedEffectChains.size() == kMaxEffectChainsIsolated) {
+            break;
+        }
+        if (chain->sessionId() != excludedSessionId && chain->canProcessIsolated_l()) {
+            mIsolatedEffectChains.push_back(chain.get());
+        }
+    }
+    // a single chain is processed faster in place
+    if (mIsolatedEffectChains.size() < 2) {
+        mIsolatedEffectChains.clear();
+        return;
+    }
+    mEffectChainWorkerPool->run(processIsolatedEffectChainsJob, this);
+}
+
+// Runs on the thread loop for index 0 and on a helper thread otherwise, while the thread loop
+// holds the effect chain mutexes and waits in processIsolatedEffectChains_l().
+/* static */
+void PlaybackThread::processIsolatedEffectChainsJob(void* cookie, size_t index)
+NO_THREAD_SAFETY_ANALYSIS
+{
+    const auto thread = static_cast<PlaybackThread*>(cookie);
+    const std::vector<IAfEffectChain*>& chains = thread->mIsolatedEffectChains;
+    // a static partition keeps each chain on the same thread from one cycle to the next
+    const size_t stride = thread->mEffectChainWorkerPool->getWorkerCount() + 1;
+    for (size_t i = index; i < chains.size(); i += stride) {
+        chains[i]->processIsolated_l();
+    }
+}
+
 // shared by MIXER and DIRECT, overridden by DUPLICATING
 ssize_t PlaybackThread::threadLoop_write()
 {
@@ -3891,6 +4183,7 @@ status_t PlaybackThread::addEffectChain_l(const sp<IAfEffectChain>& chain)
     chain->setThread(this);
     chain->setInBuffer(halInBuffer);
     chain->setOutBuffer(halOutBuffer);
+    chain->setProcessCpuMeasured(mEffectChainWorkerPool != nullptr);
     // Effect chain for session AUDIO_SESSION_DEVICE is inserted at end of effect
     // chains list in order to be processed last as it contains output device effects.
     // Effect chain for session AUDIO_SESSION_OUTPUT_STAGE is inserted just before to apply post
@@ -4212,6 +4505,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                     }
 
                     releaseWakeLock_l();
+                    updateDumpSnapshot_l(true /* waiting */);
                     // wait until we have something to do...
                     ALOGV("%s going to sleep", myName.c_str());
                     mWaitWorkCV.wait(_l);
@@ -4388,8 +4682,21 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 
             // only process effects if we're going to write
             if (mSleepTimeUs == 0 && mType != OFFLOAD && mType != DIRECT) {
+                // The haptic session chain is excluded as its haptic data is copied
+                // to the chain output below.
+                processIsolatedEffectChains_l(effectChains, activeHapticSessionId);
+                size_t isolatedIndex = 0;
                 for (size_t i = 0; i < effectChains.size(); i ++) {
-                    effectChains[i]->process_l();
+                    // Isolated chains are accumulated into the mix in the same order as they
+                    // would have been processed, so that the output does not depend on the
+                    // number of workers.
+                    if (isolatedIndex < mIsolatedEffectChains.size()
+                            && mIsolatedEffectChains[isolatedIndex] == effectChains[i].get()) {
+                        effectChains[i]->processJoin_l();
+                        ++isolatedIndex;
+                    } else {
+                        effectChains[i]->process_l();
+                    }
                     // TODO: Write haptic data directly to sink buffer when mixing.
                     if (activeHapticSessionId != AUDIO_SESSION_NONE
                             && activeHapticSessionId == effectChains[i]->sessionId()) {
@@ -5131,6 +5438,20 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    mAudioMixer->setParallelMixing(std::max(0,
+            property_get_int32("af.mixer.parallel_workers", 0 /* default_value */)));
+
+    // Not for SPATIALIZER threads, whose session chains output to either of two mixes
+    // depending on spatialization, see addEffectChain_l().
+    if (type == MIXER) {
+        const int32_t effectWorkers = std::min(kMaxEffectChainWorkers,
+                property_get_int32("af.effect.parallel_workers", 0 /* default_value */));
+        if (effectWorkers > 0) {
+            mEffectChainWorkerPool = std::make_unique<AudioMixerWorkerPool>(
+                    effectWorkers, std::vector<int>{} /* cpus */);
+            mIsolatedEffectChains.reserve(kMaxEffectChainsIsolated);
+        }
+    }
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -5235,7 +5556,8 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
         fastTrack->mHapticMaxAmplitude = NAN;
         fastTrack->mGeneration++;
         state->mFastTracksGen++;
-        state->mTrackMask = 1;
+        state->mTrackMask = FastTrackMask::first(1);
+        mFastTracksToReset.reserve(FastMixerState::sMaxFastTracks);
         // fast mixer will use the HAL output sink
         state->mOutputSink = mOutputSink.get();
         state->mOutputSinkGen++;
@@ -5318,7 +5640,7 @@ MixerThread::~MixerThread()
         // We'll use that extract the final state which contains one remaining fast track
         // corresponding to our sub-mix.
         state = sq->begin();
-        ALOG_ASSERT(state->mTrackMask == 1);
+        ALOG_ASSERT(state->mTrackMask == FastTrackMask::first(1));
         FastTrack *fastTrack = &state->mFastTracks[0];
         ALOG_ASSERT(fastTrack->mBufferProvider != NULL);
         delete fastTrack->mBufferProvider;
@@ -5369,7 +5691,7 @@ ssize_t MixerThread::threadLoop_write()
         FastMixerStateQueue *sq = mFastMixer->sq();
         FastMixerState *state = sq->begin();
         if (state->mCommand != FastMixerState::MIX_WRITE &&
-                (kUseFastMixer != FastMixer_Dynamic || state->mTrackMask > 1)) {
+                (kUseFastMixer != FastMixer_Dynamic || state->mTrackMask.highest() > 0)) {
             if (state->mCommand == FastMixerState::COLD_IDLE) {
 
                 // FIXME workaround for first HAL write being CPU bound on some devices
@@ -5401,7 +5723,11 @@ ssize_t MixerThread::threadLoop_write()
             sq->end(false /*didModify*/);
         }
     }
-    return PlaybackThread::threadLoop_write();
+    const ssize_t bytesWritten = PlaybackThread::threadLoop_write();
+    if (mFastMixer != 0) {
+        logFastThreadLatency(mFastMixerDumpState, false /* force */);
+    }
+    return bytesWritten;
 }
 
 void MixerThread::threadLoop_standby()
@@ -5430,6 +5756,8 @@ void MixerThread::threadLoop_standby()
             if (kUseFastMixer == FastMixer_Dynamic) {
                 mNormalSink = mOutputSink;
             }
+            // the fast mixer is now idle, so this includes all of its cycles until standby
+            logFastThreadLatency(mFastMixerDumpState, true /* force */);
 #ifdef AUDIO_WATCHDOG
             if (mAudioWatchdog != 0) {
                 mAudioWatchdog->pause();
@@ -5585,7 +5913,6 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
     size_t tracksWithEffect = 0;
     // counts only _active_ fast tracks
     size_t fastTracks = 0;
-    uint32_t resetMask = 0; // bit mask of fast tracks that need to be reset
 
     float masterVolume = mMasterVolume;
     bool masterMute = mMasterMute;
@@ -5608,11 +5935,28 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
     bool didModify = false;
     FastMixerStateQueue::block_t block = FastMixerStateQueue::BLOCK_UNTIL_PUSHED;
     bool coldIdle = false;
+    // Track changes go to trackDeltas only while the fast mixer is mixing, as otherwise
+    // nothing drains them; StateQueue remains the fallback when the log is full.
+    FastTrackDeltaLog *trackDeltas = NULL;
+    uint64_t removedTrackSequence = 0;  // last track delta that must be applied before return
     if (mFastMixer != 0) {
         sq = mFastMixer->sq();
         state = sq->begin();
         coldIdle = state->mCommand == FastMixerState::COLD_IDLE;
+        if (kUseFastTrackDeltas && state->mCommand == FastMixerState::MIX_WRITE) {
+            trackDeltas = mFastMixer->trackDeltas();
+        }
     }
+    // Publishes state->mFastTracks[j] as a track delta if possible, otherwise marks the state
+    // modified.  Returns the delta sequence number, or 0 if the state must be pushed instead.
+    const auto publishFastTrack = [&](int j) -> uint64_t {
+        uint64_t sequence = 0;
+        if (trackDeltas == NULL || !trackDeltas->push({j, state->mFastTracks[j]}, &sequence)) {
+            didModify = true;
+            return 0;
+        }
+        return sequence;
+    };
 
     mMixerBufferValid = false;  // mMixerBuffer has no valid data until appropriate tracks found.
     mEffectBufferValid = false; // mEffectBuffer has no valid data until tracks found.
@@ -5679,7 +6023,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
             // is impossible because the slot isn't marked available until the end of each cycle.
             int j = track->fastIndex();
             ALOG_ASSERT(0 < j && j < (int)FastMixerState::sMaxFastTracks);
-            ALOG_ASSERT(!(mFastTrackAvailMask & (1 << j)));
+            ALOG_ASSERT(!mFastTrackAvailMask.test(j));
             FastTrack *fastTrack = &state->mFastTracks[j];
 
             // Determine whether the track is currently in underrun condition,
@@ -5777,7 +6121,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                     // Can't reset directly, as fast mixer is still polling this track
                     //   track->reset();
                     // So instead mark this track as needing to be reset after push with ack
-                    resetMask |= 1 << i;
+                    mFastTracksToReset.push_back(t);
                 }
                 isActive = false;
                 break;
@@ -5788,7 +6132,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
 
             if (isActive) {
                 // was it previously inactive?
-                if (!(state->mTrackMask & (1 << j))) {
+                if (!state->mTrackMask.test(j)) {
                     ExtendedAudioBufferProvider *eabp = track->asExtendedAudioBufferProvider();
                     VolumeProvider *vp = track->asVolumeProvider();
                     fastTrack->mBufferProvider = eabp;
@@ -5799,8 +6143,8 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                     fastTrack->mHapticScale = track->getHapticScale();
                     fastTrack->mHapticMaxAmplitude = track->getHapticMaxAmplitude();
                     fastTrack->mGeneration++;
-                    state->mTrackMask |= 1 << j;
-                    didModify = true;
+                    state->mTrackMask.set(j);
+                    publishFastTrack(j);
                     // no acknowledgement required for newly active tracks
                 }
                 sp<AudioTrackServerProxy> proxy = track->audioTrackServerProxy();
@@ -5843,14 +6187,21 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                 ++fastTracks;
             } else {
                 // was it previously active?
-                if (state->mTrackMask & (1 << j)) {
+                if (state->mTrackMask.test(j)) {
                     fastTrack->mBufferProvider = NULL;
                     fastTrack->mGeneration++;
-                    state->mTrackMask &= ~(1 << j);
-                    didModify = true;
+                    state->mTrackMask.reset(j);
                     // If any fast tracks were removed, we must wait for acknowledgement
                     // because we're about to decrement the last sp<> on those tracks.
-                    block = FastMixerStateQueue::BLOCK_UNTIL_ACKED;
+                    // Removing the last track pushes the state, as it may enter cold idle.
+                    const uint64_t sequence =
+                            state->mTrackMask.highest() > 0 ? publishFastTrack(j) : 0;
+                    if (sequence != 0) {
+                        removedTrackSequence = sequence;
+                    } else {
+                        didModify = true;
+                        block = FastMixerStateQueue::BLOCK_UNTIL_ACKED;
+                    }
                 } else {
                     // ALOGW rather than LOG_ALWAYS_FATAL because it seems there are cases where an
                     // AudioTrack may start (which may not be with a start() but with a write()
@@ -5858,9 +6209,9 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                     // FastTrack state hasn't had time to update.
                     // TODO Remove the ALOGW when this theory is confirmed.
                     ALOGW("fast track %d should have been active; "
-                            "mState=%d, mTrackMask=%#x, recentUnderruns=%u, isShared=%d",
-                            j, (int)track->state(), state->mTrackMask, recentUnderruns,
-                            track->sharedBuffer() != 0);
+                            "mState=%d, mTrackMask=%s, recentUnderruns=%u, isShared=%d",
+                            j, (int)track->state(), state->mTrackMask.toString().c_str(),
+                            recentUnderruns, track->sharedBuffer() != 0);
                     // Since the FastMixer state already has the track inactive, do nothing here.
                 }
                 tracksToRemove->add(track);
@@ -6270,7 +6621,8 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
         state->mFastTracksGen++;
         // if the fast mixer was active, but now there are no fast tracks, then put it in cold idle
         if (kUseFastMixer == FastMixer_Dynamic &&
-                state->mCommand == FastMixerState::MIX_WRITE && state->mTrackMask <= 1) {
+                state->mCommand == FastMixerState::MIX_WRITE &&
+                state->mTrackMask.highest() <= 0) {
             state->mCommand = FastMixerState::COLD_IDLE;
             state->mColdFutexAddr = &mFastMixerFutex;
             state->mColdGen++;
@@ -6295,6 +6647,9 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
         // This occurs with BT suspend when we idle the FastMixer with
         // active tracks, which may be added or removed.
         sq->push(coldIdle ? FastMixerStateQueue::BLOCK_NEVER : block);
+        if (removedTrackSequence != 0) {
+            trackDeltas->waitUntilApplied(removedTrackSequence);
+        }
     }
 #ifdef AUDIO_WATCHDOG
     if (pauseAudioWatchdog && mAudioWatchdog != 0) {
@@ -6303,14 +6658,11 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
 #endif
 
     // Now perform the deferred reset on fast tracks that have stopped
-    while (resetMask != 0) {
-        size_t i = __builtin_ctz(resetMask);
-        ALOG_ASSERT(i < count);
-        resetMask &= ~(1 << i);
-        sp<IAfTrack> track = mActiveTracks[i];
+    for (const sp<IAfTrack>& track : mFastTracksToReset) {
         ALOG_ASSERT(track->isFastTrack() && track->isStopped());
         track->reset();
     }
+    mFastTracksToReset.clear(); // keeps the capacity
 
     // Track destruction may occur outside of threadLoop once it is removed from active tracks.
     // Ensure the AudioMixer doesn't have a raw "buffer provider" pointer to the track if
@@ -6495,6 +6847,8 @@ bool MixerThread::checkForNewParameter_l(const String8& keyValuePair,
             readOutputParameters_l();
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            mAudioMixer->setParallelMixing(std::max(0,
+                    property_get_int32("af.mixer.parallel_workers", 0 /* default_value */)));
             for (const auto &track : mTracks) {
                 const int trackId = track->id();
                 const status_t createStatus = mAudioMixer->create(
@@ -8440,6 +8794,7 @@ reacquire_wakelock:
                 // exitPending() can't become true here
                 releaseWakeLock_l();
                 ALOGV("RecordThread: loop stopping");
+                updateDumpSnapshot_l(true /* waiting */);
                 // go to sleep
                 mWaitWorkCV.wait(_l);
                 ALOGV("RecordThread: loop starting");
@@ -8930,6 +9285,9 @@ unlock:
             mIoJitterMs.add(jitterMs);
             mProcessTimeMs.add(processMs);
         }
+        if (mFastCapture != 0) {
+            logFastThreadLatency(mFastCaptureDumpState, false /* force */);
+        }
         // update timing info.
         mLastIoBeginNs = lastIoBeginNs;
         mLastIoEndNs = lastIoEndNs;
@@ -8958,6 +9316,10 @@ void RecordThread::standbyIfNotAlreadyInStandby()
 {
     if (!mStandby) {
         inputStandBy();
+        if (mFastCapture != 0) {
+            // the fast capture is now idle, so this includes all of its cycles until standby
+            logFastThreadLatency(mFastCaptureDumpState, true /* force */);
+        }
         mThreadMetrics.logEndInterval();
         mThreadSnapshot.onEnd();
         mStandby = true;
@@ -9527,6 +9889,20 @@ void RecordThread::dumpInternals_l(int fd, const Vector<String16>& /* args */)
     copy->dump(fd);
 }
 
+void RecordThread::captureDumpSnapshot_l(DumpSnapshot* snapshot)
+{
+    ThreadBase::captureDumpSnapshot_l(snapshot);
+    std::vector<bool> active(mTracks.size());
+    for (const sp<IAfRecordTrack>& track : mActiveTracks) {
+        const ssize_t index = mTracks.indexOf(track);
+        if (index >= 0) active[index] = true;
+    }
+    for (size_t i = 0; i < mTracks.size(); ++i) {
+        addDumpSnapshotTrack(snapshot, mTracks[i], active[i]);
+    }
+    snapshot->numActiveTracks = mActiveTracks.size();
+}
+
 void RecordThread::dumpTracks_l(int fd, const Vector<String16>& /* args */)
 {
     String8 result;
@@ -10692,6 +11068,7 @@ bool MmapThread::threadLoop()
                     break;
                 }
 
+                updateDumpSnapshot_l(true /* waiting */);
                 // wait until we have something to do...
                 ALOGV("%s going to sleep", myName.c_str());
                 mWaitWorkCV.wait(_l);
@@ -11055,6 +11432,15 @@ void MmapThread::dumpInternals_l(int fd, const Vector<String16>& /* args */)
     }
 }
 
+void MmapThread::captureDumpSnapshot_l(DumpSnapshot* snapshot)
+{
+    ThreadBase::captureDumpSnapshot_l(snapshot);
+    for (size_t i = 0; i < mActiveTracks.size(); ++i) {
+        addDumpSnapshotTrack(snapshot, mActiveTracks[i], true /* active */);
+    }
+    snapshot->numActiveTracks = mActiveTracks.size();
+}
+
 void MmapThread::dumpTracks_l(int fd, const Vector<String16>& /* args */)
 {
     String8 result;
@@ -25,12 +25,14 @@
 #include <android-base/macros.h>  // DISALLOW_COPY_AND_ASSIGN
 #include <android/os/IPowerManager.h>
 #include <afutils/AudioWatchdog.h>
+#include <afutils/DoubleBufferedSnapshot.h>
 #include <afutils/NBAIO_Tee.h>
 #include <audio_utils/Balance.h>
 #include <audio_utils/SimpleLog.h>
 #include <datapath/ThreadMetrics.h>
 #include <fastpath/FastCapture.h>
 #include <fastpath/FastMixer.h>
+#include <media/AudioMixerWorkerPool.h>
 #include <mediautils/Synchronization.h>
 #include <mediautils/ThreadSnapshot.h>
 #include <timing/MonotonicFrameCounter.h>
@@ -537,6 +539,11 @@ public:
     void sendStatistics(bool force) final
             REQUIRES(ThreadBase_ThreadLoop) EXCLUDES_ThreadBase_Mutex;
 
+                // deliver the fast thread cycle percentiles since the last call to mediametrics,
+                // at most every kFastThreadLatencyLogPeriodNs unless force is true.
+                // Call only from threadLoop().
+    void logFastThreadLatency(const FastThreadDumpState& dumpState, bool force);
+
     audio_utils::mutex& mutex() const final RETURN_CAPABILITY(audio_utils::ThreadBase_Mutex) {
         return mMutex;
     }
@@ -663,6 +670,79 @@ protected:
     virtual void dumpTracks_l(int fd __unused, const Vector<String16>& args __unused)
             REQUIRES(mutex()) {}
 
+    // DumpSnapshot is a fixed size copy of the thread state, captured by the thread
+    // itself in processConfigEvents_l() and before waiting for work, so that
+    // "dumpsys media.audio_flinger --snapshot" formats the thread state without taking
+    // the thread lock.
+    struct DumpSnapshot {
+        static constexpr size_t kMaxTracks = 32;
+        static constexpr size_t kMaxEffectChains = 16;
+
+        struct Stats {
+            int64_t n;
+            double mean;
+            double stdDev;
+            double min;
+            double max;
+        };
+        struct Track {
+            int id;
+            audio_session_t sessionId;
+            uid_t uid;
+            const char* state;  // static string from getTrackStateAsString()
+            uint32_t sampleRate;
+            audio_format_t format;
+            audio_channel_mask_t channelMask;
+            audio_port_handle_t portId;
+            bool active;
+            bool fast;
+        };
+        struct EffectChain {
+            audio_session_t sessionId;
+            size_t numberOfEffects;
+            int32_t trackCnt;
+            int32_t activeTrackCnt;
+        };
+
+        int64_t captureNs;
+        // captured before the thread waits for work, so dump() does not wake it up
+        bool waiting;
+        bool standby;
+        uint32_t sampleRate;
+        size_t frameCount;
+        audio_format_t halFormat;
+        audio_format_t format;
+        audio_channel_mask_t channelMask;
+        size_t frameSize;
+        Stats processTimeMs;
+        Stats ioJitterMs;
+        Stats latencyMs;
+        int64_t lastIoBeginNs;
+
+        // PlaybackThread only
+        bool playback;
+        float masterVolume;
+        bool masterMute;
+        int numWrites;
+        int numDelayedWrites;
+        int64_t framesWritten;
+        uint32_t underrunsPartial;
+        uint32_t underrunsEmpty;
+
+        // numTracks and numEffectChains may exceed the number of records kept.
+        size_t numTracks;
+        size_t numActiveTracks;
+        Track tracks[kMaxTracks];
+        size_t numEffectChains;
+        EffectChain effectChains[kMaxEffectChains];
+    };
+
+    // Fills the snapshot; overrides call the ThreadBase method, then add their own state.
+    virtual void captureDumpSnapshot_l(DumpSnapshot* snapshot) REQUIRES(mutex());
+    // Adds a track record to the snapshot, if there is room left.
+    static void addDumpSnapshotTrack(DumpSnapshot* snapshot,
+            const sp<IAfTrackBase>& track, bool active);
+
                 const type_t            mType;
 
                 // Used by parameters, config events, addTrack_l, exit
@@ -762,6 +842,12 @@ protected:
                 // Save the last count when we delivered statistics to mediametrics.
                 int64_t                 mLastRecordedTimestampVerifierN = 0;
                 int64_t                 mLastRecordedTimeNs = 0;  // BOOTTIME to include suspend.
+#ifdef FAST_THREAD_STATISTICS
+                // The fast thread statistics as of the last logFastThreadLatency().
+                FastThreadHistograms    mLoggedFastThreadHistograms;
+                uint32_t                mLoggedFastThreadUnderruns = 0;
+                int64_t                 mLoggedFastThreadLatencyNs = 0;
+#endif
 
                 bool                    mIsMsdDevice = false;
                 // A condition that must be evaluated by the thread loop has changed and
@@ -880,6 +966,20 @@ protected:
     private:
     void dumpBase_l(int fd, const Vector<String16>& args) REQUIRES(mutex());
     void dumpEffectChains_l(int fd, const Vector<String16>& args) REQUIRES(mutex());
+
+    // Captures a DumpSnapshot if one was requested or is older than kDumpSnapshotPeriodNs,
+    // and always when the thread is about to wait for work, as dump() does not wake it up.
+    void updateDumpSnapshot_l(bool waiting = false) REQUIRES(mutex());
+    // Formats the last DumpSnapshot, without the thread lock.
+    void dumpSnapshot(int fd);
+
+    static constexpr int64_t kDumpSnapshotPeriodNs = 1'000'000'000;
+    // How long dump() waits for the thread to capture a newer snapshot.
+    static constexpr int64_t kDumpSnapshotWaitNs = 50'000'000;
+
+    afutils::DoubleBufferedSnapshot<DumpSnapshot> mDumpSnapshot;
+    std::atomic<bool> mDumpSnapshotRequested = false;  // set by dump(), cleared by the thread
+    int64_t mLastDumpSnapshotNs GUARDED_BY(mutex()) = 0;
 };
 
 // --- PlaybackThread ---
@@ -983,6 +1083,7 @@ protected:
 
     void dumpInternals_l(int fd, const Vector<String16>& args) override REQUIRES(mutex());
     void dumpTracks_l(int fd, const Vector<String16>& args) final REQUIRES(mutex());
+    void captureDumpSnapshot_l(DumpSnapshot* snapshot) override REQUIRES(mutex());
 
 public:
 
@@ -1289,6 +1390,17 @@ protected:
     // Set to "true" to enable when data has already copied to sink
     bool mHasDataCopiedToSinkBuffer GUARDED_BY(ThreadBase_ThreadLoop) = false;
 
+    // Bounds for af.effect.parallel_workers, and for the number of chains processed by the
+    // workers in a cycle; any further chains are processed on the thread loop.
+    static constexpr int32_t kMaxEffectChainWorkers = 7;
+    static constexpr size_t kMaxEffectChainsIsolated = 32;
+    // Helper threads processing independent session effect chains concurrently, or null
+    // to process all chains on the thread loop. Only set for MIXER threads.
+    std::unique_ptr<AudioMixerWorkerPool> mEffectChainWorkerPool;
+    // The session chains processed by mEffectChainWorkerPool in the current cycle, in effect
+    // chain order. Capacity is reserved so that the thread loop does not allocate.
+    std::vector<IAfEffectChain*> mIsolatedEffectChains GUARDED_BY(ThreadBase_ThreadLoop);
+
     // Frame size aligned buffer used as input and output to all post processing effects
     // except the Spatializer in a SPATIALIZER thread. Non spatialized tracks are mixed into
     // this buffer so that post processing effects can be applied.
@@ -1344,6 +1456,14 @@ protected:
     // consider unification with MMapThread
     virtual void checkSilentMode_l() final REQUIRES(mutex());
 
+    // Processes the session effect chains that can be isolated from the mix, except the one for
+    // excludedSessionId, on mEffectChainWorkerPool and lists them in mIsolatedEffectChains.
+    // The caller must then call processJoin_l() instead of process_l() for those chains.
+    // The effect chain mutexes must be held.
+    void processIsolatedEffectChains_l(const Vector<sp<IAfEffectChain>>& effectChains,
+            audio_session_t excludedSessionId) REQUIRES(ThreadBase_ThreadLoop);
+    static void processIsolatedEffectChainsJob(void* cookie, size_t index);
+
     // Non-trivial for DUPLICATING only
     virtual void saveOutputTracks() REQUIRES(ThreadBase_ThreadLoop) {}
     virtual void clearOutputTracks() REQUIRES(ThreadBase_ThreadLoop) {}
@@ -1536,8 +1656,8 @@ public:
 
 protected:
                 // accessed by both binder threads and within threadLoop(), lock on mutex needed
-     uint32_t& fastTrackAvailMask_l() final REQUIRES(mutex()) { return mFastTrackAvailMask; }
-     uint32_t mFastTrackAvailMask;  // bit i set if fast track [i] is available
+     FastTrackMask& fastTrackAvailMask_l() final REQUIRES(mutex()) { return mFastTrackAvailMask; }
+     FastTrackMask mFastTrackAvailMask;  // i is set if fast track [i] is available
                 bool        mHwSupportsPause;
                 bool        mHwPaused;
                 bool        mFlushPending;
@@ -1672,6 +1792,9 @@ private:
                 //          mFastMixer->sq()    // for mutating and pushing state
     int32_t mFastMixerFutex GUARDED_BY(ThreadBase_ThreadLoop);  // for cold idle
     int64_t mIdleTimeOffsetUs GUARDED_BY(ThreadBase_ThreadLoop);
+    // fast tracks that stopped in prepareTracks_l() and need a deferred reset;
+    // a member so that its storage is reused on each cycle.
+    std::vector<sp<IAfTrack>> mFastTracksToReset GUARDED_BY(ThreadBase_ThreadLoop);
 
                 std::atomic_bool mMasterMono;
 public:
@@ -2122,6 +2245,7 @@ public:
 protected:
     void dumpInternals_l(int fd, const Vector<String16>& args) override REQUIRES(mutex());
     void dumpTracks_l(int fd, const Vector<String16>& args) override REQUIRES(mutex());
+    void captureDumpSnapshot_l(DumpSnapshot* snapshot) override REQUIRES(mutex());
 
 private:
             // Enter standby if not already in standby, and set mStandby flag
@@ -2334,6 +2458,7 @@ class MmapThread : public ThreadBase, public virtual IAfMmapThread
  protected:
     void dumpInternals_l(int fd, const Vector<String16>& args) override REQUIRES(mutex());
     void dumpTracks_l(int fd, const Vector<String16>& args) final REQUIRES(mutex());
+    void captureDumpSnapshot_l(DumpSnapshot* snapshot) override REQUIRES(mutex());
 
                 /**
                  * @brief mDeviceId  current device port unique identifier
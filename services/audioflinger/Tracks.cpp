@@ -821,15 +821,15 @@ Track::Track(
         // race with setSyncEvent(). However, if we call it, we cannot properly start
         // static fast tracks (SoundPool) immediately after stopping.
         //mAudioTrackServerProxy->framesReadyIsCalledByMultipleThreads();
-        ALOG_ASSERT(thread->fastTrackAvailMask_l() != 0);
-        const int i = __builtin_ctz(thread->fastTrackAvailMask_l());
+        ALOG_ASSERT(thread->fastTrackAvailMask_l().any());
+        const int i = thread->fastTrackAvailMask_l().lowest();
         ALOG_ASSERT(0 < i && i < (int)FastMixerState::sMaxFastTracks);
         // FIXME This is too eager.  We allocate a fast track index before the
         //       fast track becomes active.  Since fast tracks are a scarce resource,
         //       this means we are potentially denying other more important fast tracks from
         //       being created.  It would be better to allocate the index dynamically.
         mFastIndex = i;
-        thread->fastTrackAvailMask_l() &= ~(1 << i);
+        thread->fastTrackAvailMask_l().reset(i);
     }
 
     mServerLatencySupported = checkServerLatencySupported(format, flags);
@@ -1890,7 +1890,9 @@ void Track::signalClientFlag(int32_t flag)
     // FIXME should use proxy, and needs work
     audio_track_cblk_t* cblk = mCblk;
     android_atomic_or(flag, &cblk->mFlags);
-    android_atomic_release_store(0x40000000, &cblk->mFutex);
+    // Like ClientProxy::interrupt(), only sets the deferred wake, so that the client keeps
+    // CBLK_FUTEX_ADAPTIVE and CBLK_FUTEX_WAITER.
+    android_atomic_or(CBLK_FUTEX_WAKE, &cblk->mFutex);
     // client is not in server, so FUTEX_WAKE is needed instead of FUTEX_WAKE_PRIVATE
     (void) syscall(__NR_futex, &cblk->mFutex, FUTEX_WAKE, INT_MAX);
 }
@@ -2926,7 +2928,9 @@ void RecordTrack::invalidate()
     // FIXME should use proxy, and needs work
     audio_track_cblk_t* cblk = mCblk;
     android_atomic_or(CBLK_INVALID, &cblk->mFlags);
-    android_atomic_release_store(0x40000000, &cblk->mFutex);
+    // Like ClientProxy::interrupt(), only sets the deferred wake, so that the client keeps
+    // CBLK_FUTEX_ADAPTIVE and CBLK_FUTEX_WAITER.
+    android_atomic_or(CBLK_FUTEX_WAKE, &cblk->mFutex);
     // client is not in server, so FUTEX_WAKE is needed instead of FUTEX_WAKE_PRIVATE
     (void) syscall(__NR_futex, &cblk->mFutex, FUTEX_WAKE, INT_MAX);
 }
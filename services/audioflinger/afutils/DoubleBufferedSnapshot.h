@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace android::afutils {
+
+/**
+ * DoubleBufferedSnapshot publishes a trivially copyable T from a single writer
+ * thread to any number of reader threads, without locks.
+ *
+ * The writer fills the back buffer between beginWrite() and endWrite(), which
+ * makes it the published buffer. beginWrite() never waits: it returns nullptr
+ * when a reader is still copying the back buffer, and the writer skips that update.
+ *
+ * Readers copy the published buffer and never block the writer. A reader retries
+ * if the writer published in between, which is at most once per update.
+ */
+template <typename T>
+class DoubleBufferedSnapshot {
+    static_assert(std::is_trivially_copyable_v<T>);
+public:
+    /** Writer only. Returns the buffer to fill, or nullptr to skip this update. */
+    T* beginWrite() {
+        const int back = 1 - mPublished.load(std::memory_order_relaxed);
+        if (mReaders[back].load() != 0) return nullptr;
+        return &mBuffers[back];
+    }
+
+    /** Writer only, after a non-null beginWrite(). Publishes the filled buffer. */
+    void endWrite() {
+        mPublished.store(1 - mPublished.load(std::memory_order_relaxed));
+        mGeneration.fetch_add(1, std::memory_order_release);
+    }
+
+    /** Number of updates published. */
+    uint64_t generation() const { return mGeneration.load(std::memory_order_acquire); }
+
+    /** Copies the last published T to snapshot; returns false if none was published. */
+    bool read(T& snapshot) const {
+        if (generation() == 0) return false;
+        while (true) {
+            const int front = mPublished.load();
+            mReaders[front].fetch_add(1);
+            // The writer only fills the buffer which is not published, and
+            // does not start to fill it while a reader is counted on it.
+            if (mPublished.load() == front) {
+                snapshot = mBuffers[front];
+                mReaders[front].fetch_sub(1);
+                return true;
+            }
+            mReaders[front].fetch_sub(1);
+        }
+    }
+
+private:
+    T mBuffers[2]{};
+    std::atomic<int> mPublished = 0;
+    mutable std::atomic<int32_t> mReaders[2]{};
+    std::atomic<uint64_t> mGeneration = 0;
+};
+
+} // namespace android::afutils
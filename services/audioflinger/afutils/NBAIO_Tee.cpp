@@ -19,10 +19,12 @@
 
 #include <utils/Log.h>
 
+#include <condition_variable>
 #include <deque>
 #include <dirent.h>
 #include <future>
 #include <list>
+#include <thread>
 #include <vector>
 
 #include <audio_utils/format.h>
@@ -65,6 +67,7 @@ namespace android {
 static constexpr char DEFAULT_PREFIX[] = "aftee_";
 static constexpr char DEFAULT_DIRECTORY[] = "/data/misc/audioserver";
 static constexpr size_t DEFAULT_THREADPOOL_SIZE = 8;
+static constexpr size_t MAX_FLUSH_REQUESTS = 256;
 
 /** AudioFileHandler manages temporary audio wav files with a least recently created
     retention policy.
@@ -90,6 +93,22 @@ public:
         (void)setDirectory(directory);
     }
 
+    /** creates the audio file on the calling thread,
+        returns filename of created audio file, else empty string on failure. */
+    std::string createNow(
+            const std::function<ssize_t /* frames_read */
+                        (void * /* buffer */, size_t /* size_in_frames */)>& reader,
+            uint32_t sampleRate,
+            uint32_t channelCount,
+            audio_format_t format,
+            const std::string &suffix) {
+        std::string filename = generateFilename(suffix, format);
+        if (createInternal(reader, sampleRate, channelCount, format, filename) == NO_ERROR) {
+            return filename;
+        }
+        return "";
+    }
+
     /** returns filename of created audio file, else empty string on failure. */
     std::string create(
             const std::function<ssize_t /* frames_read */
@@ -185,13 +204,155 @@ private:
     std::deque<std::string> mFiles; // GUARDED_BY(mLock); // sorted list of files by creation time
 };
 
+static AudioFileHandler& getAudioFileHandler() {
+    // Singleton. Constructed thread-safe on first call, never destroyed.
+    [[clang::no_destroy]] static AudioFileHandler audioFileHandler(
+            DEFAULT_PREFIX, DEFAULT_DIRECTORY, DEFAULT_THREADPOOL_SIZE);
+    return audioFileHandler;
+}
+
+/** TeeFlusher saves the ring buffers frozen by the Tees in ring capture, one at a time,
+    on its own thread. */
+class TeeFlusher {
+public:
+    TeeFlusher() {
+        mRequests.reserve(MAX_FLUSH_REQUESTS);
+        std::thread(&TeeFlusher::threadLoop, this).detach();
+    }
+
+    /** queues a Tee to flush, without blocking or allocating.
+        returns false if the queue is full or busy. */
+    template <typename T>
+    bool request(T &&tee) {
+        {
+            std::unique_lock<std::mutex> l(mLock, std::try_to_lock);
+            if (!l.owns_lock() || mRequests.size() >= MAX_FLUSH_REQUESTS) return false;
+            mRequests.push_back(std::forward<T>(tee));
+        }
+        mCondition.notify_one();
+        return true;
+    }
+
+private:
+    void threadLoop() {
+        std::vector<std::shared_ptr<NBAIO_Tee::NBAIO_TeeImpl>> requests;
+        requests.reserve(MAX_FLUSH_REQUESTS);
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> l(mLock);
+                mCondition.wait(l, [this] { return !mRequests.empty(); });
+                requests.swap(mRequests);  // keeps the reserved capacity of both.
+            }
+            for (const auto &tee : requests) {
+                tee->flushRing();
+            }
+            requests.clear();
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<std::shared_ptr<NBAIO_Tee::NBAIO_TeeImpl>> mRequests; // GUARDED_BY(mLock)
+};
+
+static TeeFlusher& getTeeFlusher() {
+    // Singleton. Constructed thread-safe on first call, never destroyed, as its thread
+    // is detached.
+    [[clang::no_destroy]] static TeeFlusher teeFlusher;
+    return teeFlusher;
+}
+
+/* static */
+std::shared_ptr<NBAIO_Tee::NBAIO_TeeImpl::Rings> NBAIO_Tee::NBAIO_TeeImpl::makeRings(
+        const NBAIO_Format &format, size_t frames)
+{
+    if (!Format_isValid(format) || !audio_has_proportional_frames(format.mFormat)
+            || frames == 0) {
+        return nullptr;
+    }
+    (void)getTeeFlusher(); // start the flush thread, rather than on the first dump().
+    const size_t frameSize = Format_frameSize(format);
+    return std::shared_ptr<Rings>(
+            new Rings{TeeRingBuffer(frames, frameSize), TeeRingBuffer(frames, frameSize)});
+}
+
+void NBAIO_Tee::NBAIO_TeeImpl::triggerRing(int fd, const char *reason)
+{
+    if (!mDataReady.load()) return;
+    if (mFlushPending.exchange(true)) {
+        const uint32_t dropped = ++mDroppedDumps;
+        if (fd >= 0) {
+            dprintf(fd, "tee busy, %u dumps dropped\n", dropped);
+        }
+        return;
+    }
+    {
+        // no allocation: mFlushRings shares the ring buffers of mRings.
+        std::unique_lock<std::mutex> l(mLock, std::try_to_lock);
+        if (!l.owns_lock() || !getTeeFlusher().request(shared_from_this())) {
+            ++mDroppedDumps;
+            mFlushPending.store(false);
+            return;
+        }
+        // flushRing() takes mLock, so it only reads these after the switch below.
+        mFlushRings = mRings;
+        mFlushRing = mActiveRing.load();
+        mFlushFormat = mFormat;
+        strlcpy(mFlushReason, reason, sizeof(mFlushReason));
+        mDataReady.store(false);
+        // the other ring buffer was cleared by its last flush.
+        mActiveRing.store(mFlushRing ^ 1);
+    }
+    if (fd >= 0) {
+        dprintf(fd, "tee queued %s\n", mFlushReason);
+    }
+}
+
+void NBAIO_Tee::NBAIO_TeeImpl::flushRing()
+{
+    std::string suffix;
+    NBAIO_Format format;
+    std::shared_ptr<Rings> rings;
+    int index;
+    {
+        const std::lock_guard<std::mutex> _l(mLock);
+        suffix = mId + mFlushReason;
+        format = mFlushFormat;
+        rings = std::move(mFlushRings);
+        index = mFlushRing;
+    }
+
+    // a write() that started before the ring buffers were switched may be ongoing,
+    // wait for it to end.
+    const uint32_t sequence = mWriteSequence.load();
+    if (sequence & 1) {
+        while (mWriteSequence.load() == sequence) {
+            std::this_thread::yield();
+        }
+    }
+
+    TeeRingBuffer &ring = (*rings)[index];
+    size_t offset = 0;
+    const std::string filename = getAudioFileHandler().createNow(
+            [&ring, &offset] (void *buffer, size_t frames) {
+                const size_t read = ring.read(buffer, offset, frames);
+                offset += read;
+                return (ssize_t)read;
+            },
+            Format_sampleRate(format),
+            Format_channelCount(format),
+            format.mFormat,
+            suffix);
+    ALOGV("%s: %s", __func__, filename.c_str());
+    ring.clear();
+    mFlushPending.store(false);
+}
+
 /* static */
 void NBAIO_Tee::NBAIO_TeeImpl::dumpTee(
         int fd, const NBAIO_SinkSource &sinkSource, const std::string &suffix)
 {
-    // Singleton. Constructed thread-safe on first call, never destroyed.
-    static AudioFileHandler audioFileHandler(
-            DEFAULT_PREFIX, DEFAULT_DIRECTORY, DEFAULT_THREADPOOL_SIZE);
+    AudioFileHandler &audioFileHandler = getAudioFileHandler();
 
     auto &source = sinkSource.second;
     if (source.get() == nullptr) {
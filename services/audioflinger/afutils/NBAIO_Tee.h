@@ -20,6 +20,7 @@
 
 #ifdef TEE_SINK
 
+#include <array>
 #include <atomic>
 #include <mutex>
 #include <set>
@@ -28,8 +29,12 @@
 #include <cutils/properties.h>
 #include <media/nbaio/NBAIO.h>
 
+#include "TeeRingBuffer.h"
+
 namespace android {
 
+class TeeFlusher;
+
 /**
  * The NBAIO_Tee uses the NBAIO Pipe and PipeReader for nonblocking
  * data collection, for eventual dump to log files.
@@ -80,6 +85,17 @@ namespace android {
  * 2) The mechanism is on the AudioBufferProvider release() so large static Track
  *    playback may not show any Tee data depending on when it is released.
  * 3) When a track becomes inactive, the Thread will trigger a dump.
+ *
+ * Ring capture (TEE_FLAG_RING):
+ * 1) Intended to be left on, to capture rare glitches. Each Tee keeps the last
+ *    af.tee.ring_ms milliseconds (default 10 seconds) in one of two preallocated
+ *    TeeRingBuffers. write() copies into the active one, without allocating.
+ * 2) dump() is the trigger: it switches write() to the other ring buffer and queues the
+ *    frozen one to a single flush thread, which saves it to file. dump() does not allocate
+ *    or block; if the previous dump of the Tee is still being saved, or the queue is busy,
+ *    the dump is dropped and counted.
+ * 3) The flush thread polls its queue every FLUSH_POLL_MS, so a saved file is started
+ *    at most that long after the trigger even if the wakeup is missed.
  */
 
 class NBAIO_Tee {
@@ -92,6 +108,7 @@ public:
         TEE_FLAG_INPUT_THREAD = (1 << 0),  // treat as a Tee for input (Capture) Threads
         TEE_FLAG_OUTPUT_THREAD = (1 << 1), // treat as a Tee for output (Playback) Threads
         TEE_FLAG_TRACK = (1 << 2),         // treat as a Tee for tracks (Record and Playback)
+        TEE_FLAG_RING = (1 << 3),          // ring capture, saved to file only on dump()
     };
 
     NBAIO_Tee()
@@ -116,7 +133,10 @@ public:
      *              - TEE_FLAG_INPUT_THREAD to check af.tee if input thread logging set;
      *              - TEE_FLAG_OUTPUT_THREAD to check af.tee if output thread logging set;
      *              - TEE_FLAG_TRACK to check af.tee if track logging set.
-     * \param frames number of frames to open the NBAIO pipe (set to 0 to use default).
+     *              TEE_FLAG_RING may be added to any of these for ring capture, and is
+     *              added if set in af.tee.
+     * \param frames number of frames to open the NBAIO pipe, or of each ring buffer
+     *              (set to 0 to use default).
      *
      * \return
      *         - NO_ERROR on success (or format unchanged)
@@ -174,11 +194,12 @@ public:
     }
 
 private:
+    friend class TeeFlusher;
 
     /** The underlying implementation of the Tee - the lifetime is through
         a shared pointer so destruction of the NBAIO_Tee container may proceed
         even though dumping is occurring. */
-    class NBAIO_TeeImpl {
+    class NBAIO_TeeImpl : public std::enable_shared_from_this<NBAIO_TeeImpl> {
     public:
         status_t set(const NBAIO_Format &format, TEE_FLAG flags, size_t frames) {
             static const int teeConfig = property_get_bool("ro.debuggable", false)
@@ -198,16 +219,38 @@ private:
                 return PERMISSION_DENIED;
             }
 
+            if (teeConfig & TEE_FLAG_RING) {
+                flags = TEE_FLAG(flags | TEE_FLAG_RING);
+            }
+            const bool ring = (flags & TEE_FLAG_RING) != 0;
+
             // determine number of frames for Tee
             if (frames == 0) {
-                frames = (static_cast<long long>(DEFAULT_TEE_DURATION_MS) * format.mSampleRate)
-                            / MILLIS_PER_SECOND;
+                static const int ringDurationMs = property_get_int32(
+                        "af.tee.ring_ms", DEFAULT_RING_DURATION_MS);
+                frames = (static_cast<long long>(
+                                ring ? ringDurationMs : DEFAULT_TEE_DURATION_MS)
+                            * format.mSampleRate) / MILLIS_PER_SECOND;
             }
 
             // TODO: should we check minimum number of frames?
 
             // don't do anything if format and frames are the same.
-            if (Format_isEqual(format, mFormat) && frames == mFrames) {
+            if (Format_isEqual(format, mFormat) && frames == mFrames && ring == mRing) {
+                return NO_ERROR;
+            }
+
+            if (ring) {
+                auto rings = makeRings(format, frames);
+                if (rings == nullptr) return BAD_VALUE;
+                const std::lock_guard<std::mutex> _l(mLock);
+                mFlags = flags;
+                mFormat = format;
+                mFrames = frames;
+                mRings = std::move(rings);
+                mActiveRing.store(0);
+                mRing = true;
+                mEnabled.store(true);
                 return NO_ERROR;
             }
 
@@ -223,6 +266,7 @@ private:
                 mFormat = format; // could get this from the Sink.
                 mFrames = frames;
                 mSinkSource = std::move(sinksource);
+                mRing = false;
                 mEnabled.store(true);
                 return NO_ERROR;
             }
@@ -235,6 +279,10 @@ private:
         }
 
         void dump(int fd, const std::string &reason) {
+            if (mRing) {
+                triggerRing(fd, reason.c_str());
+                return;
+            }
             if (!mDataReady.exchange(false)) return;
             std::string suffix;
             NBAIO_SinkSource sinkSource;
@@ -248,10 +296,20 @@ private:
 
         void write(const void *buffer, size_t frameCount) {
             if (!mEnabled.load() || frameCount == 0) return;
-            (void)mSinkSource.first->write(buffer, frameCount);
+            if (mRing) {
+                // odd while writing, see flushRing().
+                mWriteSequence.fetch_add(1);
+                (*mRings)[mActiveRing.load()].write(buffer, frameCount);
+                mWriteSequence.fetch_add(1);
+            } else {
+                (void)mSinkSource.first->write(buffer, frameCount);
+            }
             mDataReady.store(true);
         }
 
+        /** saves the ring buffer frozen by dump(), called by the flush thread. */
+        void flushRing();
+
     private:
         // TRICKY: We need to keep the NBAIO_Sink and NBAIO_Source both alive at the same time
         // because PipeReader holds a naked reference (not a strong or weak pointer) to Pipe.
@@ -262,12 +320,35 @@ private:
         static NBAIO_SinkSource makeSinkSource(
                 const NBAIO_Format &format, size_t frames, bool *enabled);
 
+        // The two ring buffers of the ring capture, written alternately.
+        using Rings = std::array<TeeRingBuffer, 2>;
+
+        static std::shared_ptr<Rings> makeRings(const NBAIO_Format &format, size_t frames);
+
+        /** freezes the active ring buffer and queues it to the flush thread. */
+        void triggerRing(int fd, const char *reason);
+
         static constexpr size_t DEFAULT_TEE_DURATION_MS = 60'000;
+        static constexpr int DEFAULT_RING_DURATION_MS = 10'000;
+        static constexpr size_t MAX_REASON_LENGTH = 32;
 
         // atomic status checking
         std::atomic<bool> mEnabled{false};
         std::atomic<bool> mDataReady{false};
 
+        // ring capture; mRing and mRings only change in set().
+        bool mRing = false;
+        std::shared_ptr<Rings> mRings;
+        std::atomic<int> mActiveRing{0};          // index of the ring buffer written
+        std::atomic<uint32_t> mWriteSequence{0};  // incremented before and after each write
+        std::atomic<bool> mFlushPending{false};   // a frozen ring buffer is queued or saved
+        std::atomic<uint32_t> mDroppedDumps{0};
+        // set by triggerRing() before queueing, read by flushRing().
+        std::shared_ptr<Rings> mFlushRings;                      // GUARDED_BY(mLock)
+        int mFlushRing = 0;                                      // GUARDED_BY(mLock)
+        NBAIO_Format mFlushFormat = Format_Invalid;              // GUARDED_BY(mLock)
+        char mFlushReason[MAX_REASON_LENGTH] = {};               // GUARDED_BY(mLock)
+
         // locked dump information
         mutable std::mutex mLock;
         std::string mId;                                         // GUARDED_BY(mLock)
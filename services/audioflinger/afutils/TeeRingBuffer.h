@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace android {
+
+/**
+ * TeeRingBuffer keeps the last capacity() frames written to it, in memory
+ * allocated by the constructor.
+ *
+ * write() is O(1) per frame, never allocates and overwrites the oldest frames.
+ * It is not synchronized: the NBAIO_Tee ring capture only reads a TeeRingBuffer
+ * that is no longer written to.
+ */
+class TeeRingBuffer {
+public:
+    TeeRingBuffer(size_t capacityFrames, size_t frameSize)
+        : mCapacity(capacityFrames)
+        , mFrameSize(frameSize)
+        , mData(new uint8_t[capacityFrames * frameSize]) {}
+
+    size_t capacity() const { return mCapacity; }
+    size_t frameSize() const { return mFrameSize; }
+
+    /** number of frames written since construction or clear(). */
+    uint64_t framesWritten() const { return mFramesWritten; }
+
+    /** number of frames that can be read, the last ones written. */
+    size_t framesAvailable() const {
+        return (size_t)std::min<uint64_t>(mFramesWritten, mCapacity);
+    }
+
+    void write(const void *buffer, size_t frames) {
+        if (mCapacity == 0) return;
+        const uint8_t *src = static_cast<const uint8_t *>(buffer);
+        if (frames > mCapacity) {
+            // only the last mCapacity frames are kept.
+            src += (frames - mCapacity) * mFrameSize;
+            mFramesWritten += frames - mCapacity;
+            frames = mCapacity;
+        }
+        const size_t position = mFramesWritten % mCapacity;
+        const size_t first = std::min(frames, mCapacity - position);
+        memcpy(&mData[position * mFrameSize], src, first * mFrameSize);
+        memcpy(&mData[0], src + first * mFrameSize, (frames - first) * mFrameSize);
+        mFramesWritten += frames;
+    }
+
+    /**
+     * Reads up to frames frames, starting offset frames after the oldest available one.
+     * Returns the number of frames read.
+     */
+    size_t read(void *buffer, size_t offset, size_t frames) const {
+        const size_t available = framesAvailable();
+        if (offset >= available) return 0;
+        frames = std::min(frames, available - offset);
+        const size_t position = (mFramesWritten - available + offset) % mCapacity;
+        const size_t first = std::min(frames, mCapacity - position);
+        uint8_t *dst = static_cast<uint8_t *>(buffer);
+        memcpy(dst, &mData[position * mFrameSize], first * mFrameSize);
+        memcpy(dst + first * mFrameSize, &mData[0], (frames - first) * mFrameSize);
+        return frames;
+    }
+
+    void clear() { mFramesWritten = 0; }
+
+private:
+    const size_t mCapacity;
+    const size_t mFrameSize;
+    const std::unique_ptr<uint8_t[]> mData;
+    uint64_t mFramesWritten = 0;
+};
+
+} // namespace android
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "doublebufferedsnapshot_tests"
+
+#include "../DoubleBufferedSnapshot.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace android::afutils;
+
+namespace {
+
+// every field holds the same value, so a torn copy is detected.
+struct Snapshot {
+    int64_t values[64];
+};
+
+void fill(Snapshot* snapshot, int64_t value) {
+    for (auto& v : snapshot->values) v = value;
+}
+
+bool isConsistent(const Snapshot& snapshot) {
+    for (const auto v : snapshot.values) {
+        if (v != snapshot.values[0]) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(DoubleBufferedSnapshot, empty) {
+    DoubleBufferedSnapshot<Snapshot> buffer;
+    Snapshot snapshot;
+    EXPECT_EQ(0u, buffer.generation());
+    EXPECT_FALSE(buffer.read(snapshot));
+}
+
+TEST(DoubleBufferedSnapshot, readsLastPublished) {
+    DoubleBufferedSnapshot<Snapshot> buffer;
+    Snapshot snapshot;
+    for (int64_t i = 1; i <= 5; ++i) {
+        Snapshot* back = buffer.beginWrite();
+        ASSERT_NE(nullptr, back);
+        fill(back, i);
+        // not visible until endWrite().
+        if (i > 1) {
+            ASSERT_TRUE(buffer.read(snapshot));
+            EXPECT_EQ(i - 1, snapshot.values[0]);
+        }
+        buffer.endWrite();
+        EXPECT_EQ(uint64_t(i), buffer.generation());
+        ASSERT_TRUE(buffer.read(snapshot));
+        EXPECT_TRUE(isConsistent(snapshot));
+        EXPECT_EQ(i, snapshot.values[0]);
+    }
+}
+
+TEST(DoubleBufferedSnapshot, concurrentReaders) {
+    constexpr int64_t kUpdates = 200'000;
+    constexpr size_t kReaders = 4;
+    DoubleBufferedSnapshot<Snapshot> buffer;
+    std::atomic<bool> done = false;
+    std::atomic<size_t> torn = 0;
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < kReaders; ++i) {
+        readers.emplace_back([&] {
+            Snapshot snapshot;
+            int64_t last = 0;
+            while (!done) {
+                if (!buffer.read(snapshot)) continue;
+                // snapshots are consistent and never go back in time.
+                if (!isConsistent(snapshot) || snapshot.values[0] < last) ++torn;
+                last = snapshot.values[0];
+            }
+        });
+    }
+    int64_t skipped = 0;
+    for (int64_t i = 1; i <= kUpdates; ++i) {
+        Snapshot* back = buffer.beginWrite();
+        if (back == nullptr) {
+            ++skipped;
+            continue;
+        }
+        fill(back, i);
+        buffer.endWrite();
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+    EXPECT_EQ(0u, torn);
+    EXPECT_EQ(uint64_t(kUpdates - skipped), buffer.generation());
+}
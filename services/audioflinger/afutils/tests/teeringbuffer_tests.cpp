@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "teeringbuffer_tests"
+
+#include "../TeeRingBuffer.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Counts the allocations, to check that TeeRingBuffer::write() does not allocate.
+static std::atomic<size_t> gAllocations{0};
+
+void* operator new(size_t size) {
+    ++gAllocations;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kChannels = 2;
+constexpr size_t kFrameSize = kChannels * sizeof(int16_t);
+
+// frames numbered from first, both channels holding the frame number.
+std::vector<int16_t> makeFrames(size_t first, size_t count) {
+    std::vector<int16_t> frames(count * kChannels);
+    for (size_t i = 0; i < count; ++i) {
+        frames[i * kChannels] = frames[i * kChannels + 1] = int16_t(first + i);
+    }
+    return frames;
+}
+
+std::vector<int16_t> readAll(const TeeRingBuffer& ring, size_t framesPerRead) {
+    std::vector<int16_t> result(ring.framesAvailable() * kChannels);
+    size_t offset = 0;
+    while (size_t read = ring.read(&result[offset * kChannels], offset,
+            std::min(framesPerRead, ring.framesAvailable() - offset))) {
+        offset += read;
+    }
+    EXPECT_EQ(ring.framesAvailable(), offset);
+    return result;
+}
+
+TEST(TeeRingBufferTests, KeepsLastFrames) {
+    TeeRingBuffer ring(100 /* capacityFrames */, kFrameSize);
+    EXPECT_EQ(0u, ring.framesAvailable());
+
+    // partial fill
+    ring.write(makeFrames(0, 30).data(), 30);
+    EXPECT_EQ(30u, ring.framesAvailable());
+    EXPECT_EQ(makeFrames(0, 30), readAll(ring, 7));
+
+    // wrap, in writes of varying sizes
+    size_t written = 30;
+    for (size_t frames : {1, 64, 99, 3, 100, 17}) {
+        ring.write(makeFrames(written, frames).data(), frames);
+        written += frames;
+        const size_t available = std::min<size_t>(written, 100);
+        ASSERT_EQ(available, ring.framesAvailable());
+        EXPECT_EQ(makeFrames(written - available, available), readAll(ring, 13));
+    }
+    EXPECT_EQ(written, ring.framesWritten());
+
+    // a write larger than the capacity keeps its end
+    ring.write(makeFrames(written, 250).data(), 250);
+    written += 250;
+    EXPECT_EQ(makeFrames(written - 100, 100), readAll(ring, 100));
+
+    ring.clear();
+    EXPECT_EQ(0u, ring.framesAvailable());
+    EXPECT_EQ(0u, ring.read(makeFrames(0, 1).data(), 0, 1));
+}
+
+TEST(TeeRingBufferTests, WriteDoesNotAllocate) {
+    TeeRingBuffer ring(480 * 10 /* capacityFrames */, kFrameSize);
+    const std::vector<int16_t> frames = makeFrames(0, 480 * 3);
+
+    const size_t allocations = gAllocations;
+    for (int i = 0; i < 1000; ++i) {
+        ring.write(frames.data(), 480 - i % 7);
+    }
+    ring.write(frames.data(), frames.size() / kChannels);
+    EXPECT_EQ(allocations, gAllocations);
+}
+
+}  // namespace
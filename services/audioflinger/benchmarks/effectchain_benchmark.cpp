@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <string.h>
+#include <vector>
+
+#include <audio_utils/primitives.h>
+#include <benchmark/benchmark.h>
+#include <hardware/audio_effect.h>
+#include <log/log.h>
+#include <media/AudioMixerWorkerPool.h>
+#include <system/audio.h>
+
+using namespace android;
+
+extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+// NXP SW Virtualizer
+constexpr effect_uuid_t kEffectUuid =
+        {0x1d4033c0, 0x8557, 0x11df, 0x9f2d, {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}};
+
+// A mixer thread period of 20 ms at 48 kHz, stereo.
+constexpr size_t kFrameCount = 960;
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kSampleCount = kFrameCount * FCC_2;
+
+// The buffers of a session effect chain on a mixer thread, see PlaybackThread::addEffectChain_l().
+struct SessionChain {
+    effect_handle_t effect = nullptr;
+    std::vector<float> input;   // the session buffer the tracks are mixed into
+    std::vector<float> output;  // the chain copy of the mix, accumulated into by the effect
+};
+
+struct IsolatedCycle {
+    std::vector<SessionChain>* chains;
+    size_t stride;
+};
+
+static effect_handle_t createEffect(int32_t sessionId) {
+    effect_handle_t effectHandle = nullptr;
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(
+                &kEffectUuid, sessionId, 1 /* ioId */, &effectHandle);
+        status != 0) {
+        ALOGE("create_effect returned an error = %d", status);
+        return nullptr;
+    }
+
+    // as the last effect of a session chain, the effect accumulates into the chain output
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = AUDIO_CHANNEL_OUT_STEREO;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_ACCUMULATE;
+    config.inputCfg.mask = config.outputCfg.mask = EFFECT_CONFIG_ALL;
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)->command(effectHandle, EFFECT_CMD_SET_CONFIG,
+                sizeof(effect_config_t), &config, &replySize, &reply);
+        status != 0 || reply != 0) {
+        ALOGE("EFFECT_CMD_SET_CONFIG returned an error = %d, reply %d", status, reply);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+    if (int status = (*effectHandle)->command(effectHandle, EFFECT_CMD_ENABLE,
+                0, nullptr, &replySize, &reply);
+        status != 0 || reply != 0) {
+        ALOGE("EFFECT_CMD_ENABLE returned an error = %d, reply %d", status, reply);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+    return effectHandle;
+}
+
+static void processEffect(SessionChain& chain) {
+    audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = chain.input.data()};
+    audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = chain.output.data()};
+    (*chain.effect)->process(chain.effect, &inBuffer, &outBuffer);
+}
+
+// EffectChain::processIsolated_l(), on the thread loop and the workers.
+static void processIsolatedJob(void* cookie, size_t index) {
+    const auto cycle = static_cast<IsolatedCycle*>(cookie);
+    std::vector<SessionChain>& chains = *cycle->chains;
+    for (size_t i = index; i < chains.size(); i += cycle->stride) {
+        memset(chains[i].output.data(), 0, kSampleCount * sizeof(float));
+        processEffect(chains[i]);
+    }
+}
+
+/*
+ * Models the effect stage of PlaybackThread::threadLoop() with state.range(0) session chains of
+ * one Virtualizer each, and reports the wall clock time of a cycle.
+ * With 0 workers the chains are processed in sequence as by EffectChain::process_l(): the
+ * chain output is copied from the mix, accumulated into by the effect and copied back.
+ * Otherwise the chains are processed concurrently on an AudioMixerWorkerPool with
+ * state.range(1) helper threads, as set by af.effect.parallel_workers, then joined into the
+ * mix in chain order.
+ */
+static void BM_EffectChains(benchmark::State& state) {
+    const size_t chainCount = state.range(0);
+    const size_t workerCount = state.range(1);
+
+    std::vector<SessionChain> chains(chainCount);
+    for (size_t i = 0; i < chainCount; ++i) {
+        SessionChain& chain = chains[i];
+        chain.effect = createEffect(i + 1 /* sessionId */);
+        if (chain.effect == nullptr) {
+            state.SkipWithError("cannot create effect");
+            break;
+        }
+        chain.input.resize(kSampleCount);
+        chain.output.resize(kSampleCount);
+        for (size_t j = 0; j < kFrameCount; ++j) {
+            const float sample = 0.25f * sin(2. * M_PI * (200. + 100. * i) * j / kSampleRate);
+            chain.input[j * FCC_2] = chain.input[j * FCC_2 + 1] = sample;
+        }
+    }
+    std::vector<float> mix(kSampleCount);
+    std::unique_ptr<AudioMixerWorkerPool> pool;
+    if (workerCount > 0) {
+        pool = std::make_unique<AudioMixerWorkerPool>(workerCount, std::vector<int>{});
+    }
+    IsolatedCycle cycle{&chains, workerCount + 1};
+
+    // no iterations are run if an effect could not be created
+    for (auto _ : state) {
+        // tracks of the output mix session
+        std::fill(mix.begin(), mix.end(), 0.01f);
+        if (pool == nullptr) {
+            for (SessionChain& chain : chains) {
+                memcpy(chain.output.data(), mix.data(), kSampleCount * sizeof(float));
+                processEffect(chain);
+                memcpy(mix.data(), chain.output.data(), kSampleCount * sizeof(float));
+            }
+        } else {
+            pool->run(processIsolatedJob, &cycle);
+            for (const SessionChain& chain : chains) {
+                accumulate_float(mix.data(), chain.output.data(), kSampleCount);
+            }
+        }
+        benchmark::DoNotOptimize(mix.data());
+        benchmark::ClobberMemory();
+    }
+
+    for (const SessionChain& chain : chains) {
+        if (chain.effect != nullptr) {
+            AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(chain.effect);
+        }
+    }
+}
+
+static void EffectChainsArgs(benchmark::internal::Benchmark* b) {
+    for (int chains = 1; chains <= 8; ++chains) {
+        for (int workers : {0, 1, 3}) {
+            b->Args({chains, workers});
+        }
+    }
+}
+
+BENCHMARK(BM_EffectChains)
+    ->ArgNames({"chains", "workers"})
+    ->Apply(EffectChainsArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -39,7 +39,6 @@
 #include <audio_utils/channels.h>
 #include <audio_utils/format.h>
 #include <audio_utils/mono_blend.h>
-#include <cutils/bitops.h>
 #include <media/AudioMixer.h>
 #include "FastMixer.h"
 #include <afutils/TypedLogger.h>
@@ -60,7 +59,8 @@ static audio_channel_mask_t getChannelMaskFromCount(size_t count) {
 FastMixer::FastMixer(audio_io_handle_t parentIoHandle)
     : FastThread("cycle_ms", "load_us"),
     // mFastTrackNames
-    // mGenerations
+    mGenerations(FastMixerState::sMaxFastTracks),
+    mFastTracks(FastMixerState::sMaxFastTracks),
     // timestamp
     mThreadIoHandle(parentIoHandle)
 {
@@ -87,7 +87,17 @@ FastMixerStateQueue* FastMixer::sq()
 
 const FastThreadState *FastMixer::poll()
 {
-    return mSQ.poll();
+    const FastThreadState *next = mSQ.poll();
+    // Drain the track deltas after polling the state queue, so that a delta published before
+    // a state push is never applied later than that state.
+    if (mTrackDeltas.drain([this](const FastTrackDelta& delta) {
+            applyFastTrack(delta.mIndex, delta.mFastTrack);
+        }) > 0) {
+        FastMixerDumpState * const dumpState = (FastMixerDumpState *) mDumpState;
+        dumpState->mTrackMask = mTrackMask;
+        dumpState->mNumTracks = mTrackMask.count();
+    }
+    return next;
 }
 
 void FastMixer::setNBLogWriter(NBLog::Writer *logWriter __unused)
@@ -120,8 +130,7 @@ bool FastMixer::isSubClassCommand(FastThreadState::Command command)
 }
 
 void FastMixer::updateMixerTrack(int index, Reason reason) {
-    const FastMixerState * const current = (const FastMixerState *) mCurrent;
-    const FastTrack * const fastTrack = &current->mFastTracks[index];
+    const FastTrack * const fastTrack = &mFastTracks[index];
 
     // check and update generation
     if (reason == REASON_MODIFY && mGenerations[index] == fastTrack->mGeneration) {
@@ -190,6 +199,28 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
     }
 }
 
+void FastMixer::applyFastTrack(int index, const FastTrack& fastTrack)
+{
+    // Generations of a slot only increase, so an older or equal one is either a state that
+    // predates a track delta we already applied, or a delta repeated by a later state.
+    if ((int) ((unsigned) fastTrack.mGeneration - (unsigned) mGenerations[index]) <= 0) {
+        return;
+    }
+    const bool wasActive = mTrackMask.test(index);
+    mFastTracks[index] = fastTrack;
+    if (fastTrack.mBufferProvider == nullptr) {
+        if (wasActive) {
+            mTrackMask.reset(index);
+            updateMixerTrack(index, REASON_REMOVE);
+        } else {
+            mGenerations[index] = fastTrack.mGeneration;
+        }
+    } else {
+        mTrackMask.set(index);
+        updateMixerTrack(index, wasActive ? REASON_MODIFY : REASON_ADD);
+    }
+}
+
 void FastMixer::onStateChange()
 {
     const FastMixerState * const current = (const FastMixerState *) mCurrent;
@@ -203,8 +234,6 @@ void FastMixer::onStateChange()
 
     // handle state change here, but since we want to diff the state,
     // we're prepared for previous == &sInitial the first time through
-    unsigned previousTrackMask;
-
     // check for change in output HAL configuration
     const NBAIO_Format previousFormat = mFormat;
     if (current->mOutputSinkGen != mOutputSinkGen) {
@@ -276,52 +305,38 @@ void FastMixer::onStateChange()
             mWarmupNsMax = LONG_MAX;
         }
         mMixerBufferState = UNDEFINED;
-        // we need to reconfigure all active tracks
-        previousTrackMask = 0;
+        // we need to reconfigure all active tracks, starting with those we already had
+        mTrackMask.forEach([this](int i) { updateMixerTrack(i, REASON_ADD); });
         mFastTracksGen = current->mFastTracksGen - 1;
         dumpState->mFrameCount = frameCount;
 #ifdef TEE_SINK
         mTee.set(mFormat, NBAIO_Tee::TEE_FLAG_OUTPUT_THREAD);
         mTee.setId(std::string("_") + std::to_string(mThreadIoHandle) + "_F");
 #endif
-    } else {
-        previousTrackMask = previous->mTrackMask;
     }
 
-    // check for change in active track set
-    const unsigned currentTrackMask = current->mTrackMask;
-    dumpState->mTrackMask = currentTrackMask;
-    dumpState->mNumTracks = popcount(currentTrackMask);
+    // check for change in active track set.  We diff against mTrackMask rather than
+    // previous->mTrackMask, as track deltas may have been applied since the previous state.
+    // Both passes only visit active tracks, so they scale with the active set.
+    const FastTrackMask& currentTrackMask = current->mTrackMask;
     if (current->mFastTracksGen != mFastTracksGen) {
 
         // process removed tracks first to avoid running out of track names
-        unsigned removedTracks = previousTrackMask & ~currentTrackMask;
-        while (removedTracks != 0) {
-            const int i = __builtin_ctz(removedTracks);
-            removedTracks &= ~(1 << i);
-            updateMixerTrack(i, REASON_REMOVE);
+        (mTrackMask & ~currentTrackMask).forEach([this, current](int i) {
+            applyFastTrack(i, current->mFastTracks[i]);
             // don't reset track dump state, since other side is ignoring it
-        }
-
-        // now process added tracks
-        unsigned addedTracks = currentTrackMask & ~previousTrackMask;
-        while (addedTracks != 0) {
-            const int i = __builtin_ctz(addedTracks);
-            addedTracks &= ~(1 << i);
-            updateMixerTrack(i, REASON_ADD);
-        }
+        });
 
-        // finally process (potentially) modified tracks; these use the same slot
-        // but may have a different buffer provider or volume provider
-        unsigned modifiedTracks = currentTrackMask & previousTrackMask;
-        while (modifiedTracks != 0) {
-            const int i = __builtin_ctz(modifiedTracks);
-            modifiedTracks &= ~(1 << i);
-            updateMixerTrack(i, REASON_MODIFY);
-        }
+        // now process added and (potentially) modified tracks; modified tracks use the
+        // same slot but may have a different buffer provider or volume provider
+        currentTrackMask.forEach([this, current](int i) {
+            applyFastTrack(i, current->mFastTracks[i]);
+        });
 
         mFastTracksGen = current->mFastTracksGen;
     }
+    dumpState->mTrackMask = mTrackMask;
+    dumpState->mNumTracks = mTrackMask.count();
 }
 
 void FastMixer::onWork()
@@ -358,11 +373,11 @@ void FastMixer::onWork()
         bool anyEnabledTracks = false;
 
         // for each track, update volume and check for underrun
-        unsigned currentTrackMask = current->mTrackMask;
-        while (currentTrackMask != 0) {
-            const int i = __builtin_ctz(currentTrackMask);
-            currentTrackMask &= ~(1 << i);
-            const FastTrack* fastTrack = &current->mFastTracks[i];
+        FastTrackMask currentTrackMask = mTrackMask;
+        while (currentTrackMask.any()) {
+            const int i = currentTrackMask.lowest();
+            currentTrackMask.reset(i);
+            const FastTrack* fastTrack = &mFastTracks[i];
 
             const int64_t trackFramesWrittenButNotPresented =
                 mNativeFramesWrittenButNotPresented;
@@ -397,11 +412,14 @@ void FastMixer::onWork()
             // in the overall fast mix cycle being delayed.  Should use a non-blocking FIFO.
             const size_t framesReady = fastTrack->mBufferProvider->framesReady();
             if (ATRACE_ENABLED()) {
-                // I wish we had formatted trace names
+                // I wish we had formatted trace names; the index is in decimal
                 char traceName[16];
                 strcpy(traceName, "fRdy");
-                traceName[4] = i + (i < 10 ? '0' : 'A' - 10);
-                traceName[5] = '\0';
+                char *digit = &traceName[4];
+                if (i >= 100) *digit++ = '0' + i / 100;
+                if (i >= 10) *digit++ = '0' + i / 10 % 10;
+                *digit++ = '0' + i % 10;
+                *digit = '\0';
                 ATRACE_INT(traceName, framesReady);
             }
             FastTrackDump *ftDump = &dumpState->mTracks[i];
@@ -17,8 +17,10 @@
 #pragma once
 
 #include <atomic>
+#include <vector>
 #include <audio_utils/Balance.h>
 #include "FastThread.h"
+#include "StateDeltaLog.h"
 #include "StateQueue.h"
 #include "FastMixerState.h"
 #include "FastMixerDumpState.h"
@@ -29,6 +31,8 @@ namespace android {
 class AudioMixer;
 
 using FastMixerStateQueue = StateQueue<FastMixerState>;
+// Enough for every fast track to be removed and re-added between two fast mixer cycles.
+using FastTrackDeltaLog = StateDeltaLog<FastTrackDelta, 2 * FastMixerState::kMaxFastTracks>;
 
 class FastMixer : public FastThread {
 
@@ -39,6 +43,11 @@ public:
 
             FastMixerStateQueue* sq();
 
+            // Per-track changes published here are applied at the start of the next fast
+            // mixer cycle, independently of sq().  The same changes must also be made to the
+            // sq() state, which takes precedence once it carries a newer track generation.
+            FastTrackDeltaLog* trackDeltas() { return &mTrackDeltas; }
+
     virtual void setMasterMono(bool mono) { mMasterMono.store(mono); /* memory_order_seq_cst */ }
     virtual void setMasterBalance(float balance) { mMasterBalance.store(balance); }
     virtual float getMasterBalance() const { return mMasterBalance.load(); }
@@ -47,6 +56,7 @@ public:
     }
 private:
             FastMixerStateQueue mSQ;
+            FastTrackDeltaLog   mTrackDeltas;
 
     // callouts
     const FastThreadState *poll() override;
@@ -64,13 +74,19 @@ private:
     };
     // called when a fast track of index has been removed, added, or modified
     void updateMixerTrack(int index, Reason reason);
+    // replaces mFastTracks[index] and updates the mixer, if fastTrack is newer
+    void applyFastTrack(int index, const FastTrack& fastTrack);
 
     // FIXME these former local variables need comments
     static const FastMixerState sInitial;
 
     FastMixerState  mPreIdle;   // copy of state before we went into idle
-    int             mGenerations[FastMixerState::kMaxFastTracks]{};
-                                // last observed mFastTracks[i].mGeneration
+    // The track tables below have FastMixerState::sMaxFastTracks entries, allocated by the
+    // constructor so that the mixer thread never allocates for them.
+    std::vector<int> mGenerations;  // last observed mFastTracks[i].mGeneration
+    // The active tracks, merged from the most recent state and any track deltas since.
+    std::vector<FastTrack> mFastTracks;
+    FastTrackMask   mTrackMask;     // i is set if and only if mFastTracks[i] is active
     NBAIO_Sink*     mOutputSink = nullptr;
     int             mOutputSinkGen = 0;
     AudioMixer*     mMixer = nullptr;
@@ -22,7 +22,7 @@
 
 namespace android {
 
-FastMixerState::FastMixerState() : FastThreadState()
+FastMixerState::FastMixerState() : FastMixerStateFields()
 {
     const int ok = pthread_once(&sMaxFastTracksOnce, sMaxFastTracksInit);
     if (ok != 0) {
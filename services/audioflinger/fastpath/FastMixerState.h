@@ -17,6 +17,8 @@
 #pragma once
 
 #include <math.h>
+#include <algorithm>
+#include <string>
 #include <type_traits>
 
 #include <audio_utils/minifloat.h>
@@ -27,6 +29,7 @@
 #include <media/nblog/NBLog.h>
 #include <vibrator/ExternalVibrationUtils.h>
 #include "FastThreadState.h"
+#include "FastTrackMask.h"
 
 namespace android {
 
@@ -61,13 +64,46 @@ struct FastTrack {
 // No virtuals.
 static_assert(!std::is_polymorphic_v<FastTrack>);
 
+// Represents an incremental change of a single fast track, published while the fast mixer
+// is running without pushing a whole FastMixerState.  See FastMixer::trackDeltas().
+struct FastTrackDelta {
+    int         mIndex = -1;    // index in FastMixerState::mFastTracks
+    FastTrack   mFastTrack;     // new value, including the incremented mGeneration;
+                                // the track is removed if mFastTrack.mBufferProvider is nullptr
+};
+
+// The fields of FastMixerState other than mFastTracks, copied by a single assignment.
+struct FastMixerStateFields : FastThreadState {
+    int         mFastTracksGen = 0; // increment when any
+                                    // mFastTracks[i].mGeneration is incremented
+    FastTrackMask mTrackMask;       // i is set if and only if mFastTracks[i] is active
+    NBAIO_Sink* mOutputSink = nullptr; // HAL output device, must already be negotiated
+    int         mOutputSinkGen = 0; // increment when mOutputSink is assigned
+    size_t      mFrameCount = 0;    // number of frames per fast mix buffer
+    audio_channel_mask_t mSinkChannelMask; // If not AUDIO_CHANNEL_NONE, specifies sink channel
+                                           // mask when it cannot be directly calculated from
+                                           // channel count
+};
+
 // Represents a single state of the fast mixer
-struct FastMixerState : FastThreadState {
+struct FastMixerState : FastMixerStateFields {
     FastMixerState();
 
+    // StateQueue copies a whole state on every push.  Only the first sMaxFastTracks
+    // entries of mFastTracks can be used, so the copy skips the rest of the capacity.
+    // Add new fields to FastMixerStateFields, so that they are copied.
+    FastMixerState(const FastMixerState& other) : FastMixerStateFields(other) {
+        copyFastTracks(other);
+    }
+    FastMixerState& operator=(const FastMixerState& other) {
+        FastMixerStateFields::operator=(other);
+        copyFastTracks(other);
+        return *this;
+    }
+
     // These are the minimum, maximum, and default values for maximum number of fast tracks
     static constexpr unsigned kMinFastTracks = 2;
-    static constexpr unsigned kMaxFastTracks = 32;
+    static constexpr unsigned kMaxFastTracks = FastTrackMask::kCapacity;
     static constexpr unsigned kDefaultFastTracks = 8;
 
     static unsigned sMaxFastTracks;             // Configured maximum number of fast tracks
@@ -75,15 +111,6 @@ struct FastMixerState : FastThreadState {
 
     // all pointer fields use raw pointers; objects are owned and ref-counted by the normal mixer
     FastTrack   mFastTracks[kMaxFastTracks];
-    int         mFastTracksGen = 0; // increment when any
-                                    // mFastTracks[i].mGeneration is incremented
-    unsigned    mTrackMask = 0;     // bit i is set if and only if mFastTracks[i] is active
-    NBAIO_Sink* mOutputSink = nullptr; // HAL output device, must already be negotiated
-    int         mOutputSinkGen = 0; // increment when mOutputSink is assigned
-    size_t      mFrameCount = 0;    // number of frames per fast mix buffer
-    audio_channel_mask_t mSinkChannelMask; // If not AUDIO_CHANNEL_NONE, specifies sink channel
-                                           // mask when it cannot be directly calculated from
-                                           // channel count
 
     // Extends FastThreadState::Command
     static const Command
@@ -98,8 +125,17 @@ struct FastMixerState : FastThreadState {
     // initialize sMaxFastTracks
     static void sMaxFastTracksInit();
 
+private:
+    void copyFastTracks(const FastMixerState& other) {
+        std::copy(other.mFastTracks, other.mFastTracks + sMaxFastTracks, mFastTracks);
+    }
+
 };  // struct FastMixerState
 
+// Fields added to FastMixerState itself would not be copied, see FastMixerStateFields.
+static_assert(sizeof(FastMixerState) ==
+        sizeof(FastMixerStateFields) + sizeof(FastTrack) * FastMixerState::kMaxFastTracks);
+
 // No virtuals.
 static_assert(!std::is_polymorphic_v<FastMixerState>);
 
@@ -308,6 +308,12 @@ bool FastThread::threadLoop()
 #ifdef CPU_FREQUENCY_STATISTICS
                     mDumpState->mCpukHz[i] = kHz;
 #endif
+                    FastThreadHistograms& histograms = mDumpState->mHistograms;
+                    histograms.mCycleUs.add(monotonicNs / 1000);
+                    histograms.mLoadUs.add(loadNs / 1000);
+                    const int64_t jitterNs = (int64_t) monotonicNs - mPeriodNs;
+                    histograms.mJitterUs.add(
+                            (uint32_t) ((jitterNs < 0 ? -jitterNs : jitterNs) / 1000));
                     // this store #4 is not atomic with respect to stores #1, #2, #3 above, but
                     // the newest open & oldest closed halves are atomic with respect to each other
                     mDumpState->mBounds = mBounds;
@@ -19,6 +19,7 @@
 #include <type_traits>
 
 #include "Configuration.h"
+#include "FastThreadHistogram.h"
 #include "FastThreadState.h"
 
 namespace android {
@@ -61,6 +62,10 @@ struct FastThreadDumpState {
     uint32_t mCpukHz[kSamplingN];       // absolute CPU clock frequency in kHz, bits 0-3 are CPU#
 #endif
 
+    // Unlike the sample arrays above, these cover every warm cycle since construction,
+    // so that the normal thread can periodically report percentiles to mediametrics.
+    FastThreadHistograms mHistograms;
+
     // Increase sampling window after construction, must be a power of 2 <= kSamplingN
     void    increaseSamplingN(uint32_t samplingN);
 #endif
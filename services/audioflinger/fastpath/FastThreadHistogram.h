@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace android {
+
+// A cumulative log-linear histogram of per-cycle values such as a fast thread cycle time,
+// in the style of an HDR histogram: each power of 2 range is divided into kSubBuckets
+// buckets, so that any recorded value is known to within 1/kSubBuckets (about 6%).
+//
+// Like the rest of FastThreadDumpState, it is POD and is accessed without locks or barriers.
+// The fast thread is the only writer, and each count is a single naturally aligned word.
+// The counts are never reset; a reader keeps an earlier copy and subtracts it to get the
+// distribution of the values added in between.  A count that is incremented while a reader
+// copies the histogram is only attributed to the next interval.
+class FastThreadHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr unsigned kSubBuckets = 1 << kSubBucketBits;
+    // Values are clamped to kMaxValue; in microseconds this is about 4.2 seconds.
+    static constexpr unsigned kValueBits = 22;
+    static constexpr uint32_t kMaxValue = (1 << kValueBits) - 1;
+    static constexpr unsigned kBuckets = (kValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+    // Called by the fast thread only.
+    void add(uint32_t value) {
+        const unsigned bucket = bucketOf(value);
+        mCounts[bucket] = mCounts[bucket] + 1;
+    }
+
+    // Returns the histogram of the values added since earlier, which is a previous copy of
+    // this histogram.  Counts that wrapped around in between are still correct.
+    FastThreadHistogram operator-(const FastThreadHistogram& earlier) const {
+        FastThreadHistogram difference;
+        for (unsigned i = 0; i < kBuckets; ++i) {
+            difference.mCounts[i] = mCounts[i] - earlier.mCounts[i];
+        }
+        return difference;
+    }
+
+    uint64_t count() const {
+        uint64_t n = 0;
+        for (const uint32_t bucketCount : mCounts) {
+            n += bucketCount;
+        }
+        return n;
+    }
+
+    // Returns the highest value that is equivalent to the value at percentile [0, 100],
+    // so at most 1/kSubBuckets above the exact value, or 0 if the histogram is empty.
+    uint32_t percentile(double percent) const {
+        const uint64_t n = count();
+        if (n == 0) {
+            return 0;
+        }
+        // the nearest rank of the value, from 1 to n
+        uint64_t rank = (uint64_t) ceil(percent * 0.01 * n);
+        rank = rank < 1 ? 1 : rank > n ? n : rank;
+        uint64_t below = 0;
+        for (unsigned i = 0; i < kBuckets; ++i) {
+            below += mCounts[i];
+            if (below >= rank) {
+                return bucketHighest(i);
+            }
+        }
+        return kMaxValue;  // not reached
+    }
+
+    // Values below 2 * kSubBuckets each have their own bucket; above that, the bucket of a
+    // value is determined by its kSubBucketBits + 1 most significant bits.
+    static unsigned bucketOf(uint32_t value) {
+        if (value > kMaxValue) {
+            value = kMaxValue;
+        }
+        const int msb = value == 0 ? 0 : 31 - __builtin_clz(value);
+        const unsigned shift = msb > (int) kSubBucketBits ? msb - kSubBucketBits : 0;
+        return shift * kSubBuckets + (value >> shift);
+    }
+
+    // Returns the highest value in the bucket.
+    static uint32_t bucketHighest(unsigned bucket) {
+        if (bucket < 2 * kSubBuckets) {
+            return bucket;
+        }
+        const unsigned shift = bucket / kSubBuckets - 1;
+        const uint32_t mantissa = bucket - shift * kSubBuckets;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    uint32_t mCounts[kBuckets]{};
+};
+
+static_assert(std::is_trivially_copyable_v<FastThreadHistogram>);
+
+// The cumulative per-cycle statistics of a fast thread, in microseconds.
+struct FastThreadHistograms {
+    FastThreadHistogram mCycleUs;   // delta monotonic (wall clock) time
+    FastThreadHistogram mLoadUs;    // delta CPU load in time
+    FastThreadHistogram mJitterUs;  // absolute difference between the cycle time and the period
+
+    FastThreadHistograms operator-(const FastThreadHistograms& earlier) const {
+        return {mCycleUs - earlier.mCycleUs, mLoadUs - earlier.mLoadUs,
+                mJitterUs - earlier.mJitterUs};
+    }
+};
+
+}  // namespace android
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <type_traits>
+
+namespace android {
+
+// A set of fast track indices, for example the active tracks of a FastMixerState.
+// This replaces a 32-bit unsigned mask so that there can be more than 32 fast tracks.
+// It is POD so that it can be part of a FastMixerState and FastMixerDumpState.
+class FastTrackMask {
+public:
+    // Capacity of the fast track tables; FastMixerState::sMaxFastTracks may be smaller.
+    static constexpr unsigned kCapacity = 128;
+
+    // the set of indices [0, count)
+    static FastTrackMask first(unsigned count) {
+        FastTrackMask mask;
+        for (unsigned i = 0; i < kWords && count > 0; ++i) {
+            mask.mWords[i] = count >= kWordBits ? ~0ULL : (1ULL << count) - 1;
+            count -= count >= kWordBits ? kWordBits : count;
+        }
+        return mask;
+    }
+
+    bool test(unsigned i) const { return (mWords[i / kWordBits] >> (i % kWordBits)) & 1; }
+    void set(unsigned i) { mWords[i / kWordBits] |= 1ULL << (i % kWordBits); }
+    void reset(unsigned i) { mWords[i / kWordBits] &= ~(1ULL << (i % kWordBits)); }
+
+    bool any() const {
+        for (const uint64_t word : mWords) {
+            if (word != 0) return true;
+        }
+        return false;
+    }
+    bool none() const { return !any(); }
+
+    unsigned count() const {
+        unsigned n = 0;
+        for (const uint64_t word : mWords) {
+            n += __builtin_popcountll(word);
+        }
+        return n;
+    }
+
+    // returns the lowest index in the set, or -1 if empty
+    int lowest() const {
+        for (unsigned i = 0; i < kWords; ++i) {
+            if (mWords[i] != 0) return i * kWordBits + __builtin_ctzll(mWords[i]);
+        }
+        return -1;
+    }
+
+    // returns the highest index in the set, or -1 if empty
+    int highest() const {
+        for (unsigned i = kWords; i-- > 0; ) {
+            if (mWords[i] != 0) return i * kWordBits + kWordBits - 1 - __builtin_clzll(mWords[i]);
+        }
+        return -1;
+    }
+
+    // Calls f(int index) for each index in the set, in increasing order.
+    // The cost is proportional to the number of indices in the set, not the capacity.
+    template <typename F>
+    void forEach(F&& f) const {
+        for (unsigned i = 0; i < kWords; ++i) {
+            uint64_t word = mWords[i];
+            while (word != 0) {
+                const int bit = __builtin_ctzll(word);
+                word &= word - 1;
+                f(int(i * kWordBits + bit));
+            }
+        }
+    }
+
+    FastTrackMask& operator&=(const FastTrackMask& other) {
+        for (unsigned i = 0; i < kWords; ++i) mWords[i] &= other.mWords[i];
+        return *this;
+    }
+    FastTrackMask& operator|=(const FastTrackMask& other) {
+        for (unsigned i = 0; i < kWords; ++i) mWords[i] |= other.mWords[i];
+        return *this;
+    }
+    FastTrackMask operator&(const FastTrackMask& other) const {
+        FastTrackMask mask = *this;
+        return mask &= other;
+    }
+    FastTrackMask operator|(const FastTrackMask& other) const {
+        FastTrackMask mask = *this;
+        return mask |= other;
+    }
+    FastTrackMask operator~() const {
+        FastTrackMask mask;
+        for (unsigned i = 0; i < kWords; ++i) mask.mWords[i] = ~mWords[i];
+        return mask;
+    }
+    bool operator==(const FastTrackMask& other) const {
+        for (unsigned i = 0; i < kWords; ++i) {
+            if (mWords[i] != other.mWords[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const FastTrackMask& other) const { return !(*this == other); }
+
+    // hexadecimal representation like "%#x" of an unsigned mask, for logs and dumpsys
+    std::string toString() const {
+        std::string result;
+        char buffer[17];
+        for (unsigned i = kWords; i-- > 0; ) {
+            if (result.empty()) {
+                if (mWords[i] == 0 && i > 0) continue;
+                snprintf(buffer, sizeof(buffer), "%llx", (unsigned long long) mWords[i]);
+            } else {
+                snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long) mWords[i]);
+            }
+            result.append(buffer);
+        }
+        return result == "0" ? result : "0x" + result;
+    }
+
+private:
+    static constexpr unsigned kWordBits = 64;
+    static constexpr unsigned kWords = kCapacity / kWordBits;
+    static_assert(kCapacity % kWordBits == 0);
+
+    uint64_t mWords[kWords]{};
+};
+
+static_assert(std::is_trivially_copyable_v<FastTrackMask>);
+
+}   // namespace android
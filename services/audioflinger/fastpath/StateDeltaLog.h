@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// StateDeltaLog complements StateQueue for state that changes in small pieces.
+// StateQueue publishes a complete copy of the state on each push, has a single mutator,
+// and a push may have to wait for the observer to acknowledge the previous push.
+// StateDeltaLog instead publishes individual deltas (for example a single fast track being
+// added or removed) through a bounded lock-free log:
+//  - any number of mutator threads may push concurrently; push() never blocks,
+//    it returns false if the log is full and the caller must then fall back to a StateQueue push
+//  - a single observer drains all published deltas in publication order, typically once per
+//    cycle right after polling its StateQueue; drain() never blocks and never allocates
+//  - each push returns a sequence number, and a mutator can check or wait until the observer
+//    has applied the delta with that sequence number, the equivalent of BLOCK_UNTIL_ACKED
+// Deltas are copied by value, so like StateQueue states they should contain only POD and
+// raw pointers. A delta is not a replacement for the full state: the mutator is expected to
+// also update its StateQueue state, and the observer must tolerate seeing the same change
+// both as a delta and in a later state (e.g. by comparing per-item generation counts).
+//
+// The implementation is a bounded multi-producer single-consumer ring in which each slot
+// carries a sequence number that tells producers and the consumer whose turn it is.
+
+namespace android {
+
+template<typename T, size_t kCapacity>
+class StateDeltaLog final {
+    static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0,
+            "kCapacity must be a power of 2");
+
+public:
+    StateDeltaLog() {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    StateDeltaLog(const StateDeltaLog&) = delete;
+    StateDeltaLog& operator=(const StateDeltaLog&) = delete;
+
+    // Mutator APIs, may be called from any number of threads
+
+    // Publish a delta to the observer.
+    // Returns true on success, and if sequence is not nullptr sets *sequence to a non-zero
+    // sequence number that can be passed to isApplied() or waitUntilApplied().
+    // Returns false without blocking if the log is full.
+    bool push(const T& delta, uint64_t *sequence = nullptr) {
+        uint64_t position = mTail.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &mSlots[position & (kCapacity - 1)];
+            const uint64_t slotSequence = slot->mSequence.load(std::memory_order_acquire);
+            const int64_t diff = (int64_t) (slotSequence - position);
+            if (diff == 0) {
+                // slot is free for this position, try to claim it
+                if (mTail.compare_exchange_weak(position, position + 1,
+                        std::memory_order_relaxed)) {
+                    break;
+                }
+                // position was reloaded by the failed compare exchange
+            } else if (diff < 0) {
+                // slot still holds a delta from the previous lap: the log is full
+                mOverflows.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                // another mutator claimed this position first
+                position = mTail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->mDelta = delta;
+        slot->mSequence.store(position + 1, std::memory_order_release);
+        if (sequence != nullptr) {
+            *sequence = position + 1;
+        }
+        return true;
+    }
+
+    // Return whether the observer has applied the delta with the given sequence number,
+    // and therefore all deltas published before it by the same mutator.
+    bool isApplied(uint64_t sequence) const {
+        return mApplied.load(std::memory_order_acquire) >= sequence;
+    }
+
+    // Block until the observer has applied the delta with the given sequence number.
+    // Polls at the same interval as StateQueue::push(BLOCK_UNTIL_ACKED).
+    void waitUntilApplied(uint64_t sequence) const {
+        static const struct timespec req = {0, kWaitAppliedNs};
+        while (!isApplied(sequence)) {
+            nanosleep(&req, nullptr);
+        }
+    }
+
+    // Number of pushes that failed because the log was full, for dumpsys.
+    uint32_t overflows() const { return mOverflows.load(std::memory_order_relaxed); }
+
+    // Observer API, must only be called from a single thread
+
+    // Call apply(const T&) for each published delta in publication order, then acknowledge
+    // them all at once. Stops at the first position whose mutator has claimed it but not yet
+    // finished publishing; that delta and any after it are returned by the next drain().
+    // Returns the number of deltas applied.
+    template<typename F>
+    size_t drain(F&& apply) {
+        uint64_t position = mHead;
+        size_t count = 0;
+        for (;;) {
+            Slot *slot = &mSlots[position & (kCapacity - 1)];
+            if (slot->mSequence.load(std::memory_order_acquire) != position + 1) {
+                break;
+            }
+            apply(static_cast<const T&>(slot->mDelta));
+            // release the slot for the mutator one lap ahead
+            slot->mSequence.store(position + kCapacity, std::memory_order_release);
+            ++position;
+            ++count;
+        }
+        if (count > 0) {
+            mHead = position;
+            mApplied.store(position, std::memory_order_release);
+        }
+        return count;
+    }
+
+private:
+    static constexpr long kWaitAppliedNs = 3000000L;   // 3 ms, as PUSH_BLOCK_ACK_NS
+    static constexpr size_t kCacheLineSize = 64;
+
+    struct Slot {
+        std::atomic<uint64_t> mSequence;
+        T                     mDelta{};
+    };
+
+    Slot mSlots[kCapacity];
+
+    // written by mutators
+    alignas(kCacheLineSize) std::atomic<uint64_t> mTail{0};
+    std::atomic<uint32_t>   mOverflows{0};
+
+    // written by observer, read by mutators
+    alignas(kCacheLineSize) std::atomic<uint64_t> mApplied{0};
+
+    // only used by observer
+    alignas(kCacheLineSize) uint64_t mHead = 0;
+};
+
+}   // namespace android
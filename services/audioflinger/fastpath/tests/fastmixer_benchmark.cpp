@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include <audio_utils/clock.h>
+#include <audio_utils/minifloat.h>
+#include <benchmark/benchmark.h>
+#include <log/log.h>
+
+#include "../FastMixer.h"
+
+using namespace android;
+
+// A typical fast mixer period of 4 ms at 48 kHz.
+static constexpr size_t kFrameCount = 192;
+static constexpr unsigned kSampleRate = 48000;
+static constexpr int64_t kPeriodNs = kFrameCount * 1000000000LL / kSampleRate;
+// Cycles of statistics to collect per configuration, after warmup.
+static constexpr uint32_t kSamplingN = 1024;
+static constexpr useconds_t kWarmupUs = 500000;
+static constexpr useconds_t kMeasureUs = kSamplingN * kPeriodNs / 1000;
+
+// Stands in for the HAL output stream: write() blocks until the end of the current period,
+// so the fast mixer runs at its nominal cycle time.
+class PacedSink : public NBAIO_Sink {
+public:
+    PacedSink() : NBAIO_Sink(Format_from_SR_C(kSampleRate, FCC_2, AUDIO_FORMAT_PCM_FLOAT)) {
+        mNegotiated = true;
+    }
+
+    ssize_t write(const void * /* buffer */, size_t count) override {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const int64_t nowNs = audio_utils_ns_from_timespec(&now);
+        mDeadlineNs = std::max(mDeadlineNs + kPeriodNs, nowNs);
+        const struct timespec deadline = {
+            (time_t) (mDeadlineNs / 1000000000), (long) (mDeadlineNs % 1000000000)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+        mFramesWritten += count;
+        return count;
+    }
+
+private:
+    int64_t mDeadlineNs = 0;
+};
+
+// A fast track that loops over a short sine, at a fixed volume.
+class LoopingTrack : public ExtendedAudioBufferProvider, public VolumeProvider {
+public:
+    LoopingTrack(double frequency, float volume)
+        : mData(kLoopFrames * FCC_2)
+        , mVolumeLR(gain_minifloat_pack(gain_from_float(volume), gain_from_float(volume))) {
+        for (size_t i = 0; i < kLoopFrames; ++i) {
+            const float sample = sin(2. * M_PI * frequency * i / kSampleRate);
+            mData[i * FCC_2] = mData[i * FCC_2 + 1] = sample;
+        }
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, kLoopFrames - mPosition);
+        buffer->raw = &mData[mPosition * FCC_2];
+        return OK;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        mPosition = (mPosition + buffer->frameCount) % kLoopFrames;
+        mFramesReleased += buffer->frameCount;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+    size_t framesReady() const override { return kLoopFrames; }
+    int64_t framesReleased() const override { return mFramesReleased; }
+    gain_minifloat_packed_t getVolumeLR() const override { return mVolumeLR; }
+
+private:
+    static constexpr size_t kLoopFrames = kSampleRate / 10;
+    std::vector<float> mData;
+    const gain_minifloat_packed_t mVolumeLR;
+    size_t mPosition = 0;
+    int64_t mFramesReleased = 0;
+};
+
+/*
+ * Runs a FastMixer thread with state.range(0) active fast tracks, writing to a sink paced at
+ * the fast mixer period, and reports its per-cycle CPU time (the "load" of dumpsys) as the
+ * iteration time. The fast mixer normally runs at SCHED_FIFO, which requires AudioFlinger,
+ * so here it runs at the default priority; the CPU time is not affected by preemption.
+ */
+static void BM_FastMixerCycle(benchmark::State& state) {
+    const unsigned trackCount = state.range(0);
+    // Use the full table capacity regardless of ro.audio.max_fast_tracks.
+    pthread_once(&FastMixerState::sMaxFastTracksOnce, FastMixerState::sMaxFastTracksInit);
+    FastMixerState::sMaxFastTracks = FastMixerState::kMaxFastTracks;
+
+    std::vector<std::unique_ptr<LoopingTrack>> tracks;
+    for (unsigned i = 0; i < trackCount; ++i) {
+        tracks.push_back(std::make_unique<LoopingTrack>(200. + 10. * i, 1.f / trackCount));
+    }
+    const sp<PacedSink> sink = sp<PacedSink>::make();
+    const auto dumpState = std::make_unique<FastMixerDumpState>();
+    dumpState->increaseSamplingN(kSamplingN);
+
+    const sp<FastMixer> fastMixer = sp<FastMixer>::make(AUDIO_IO_HANDLE_NONE);
+    FastMixerStateQueue *sq = fastMixer->sq();
+    FastMixerState *fastMixerState = sq->begin();
+    for (unsigned i = 0; i < trackCount; ++i) {
+        FastTrack *fastTrack = &fastMixerState->mFastTracks[i];
+        fastTrack->mBufferProvider = tracks[i].get();
+        fastTrack->mVolumeProvider = tracks[i].get();
+        fastTrack->mChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+        fastTrack->mFormat = AUDIO_FORMAT_PCM_FLOAT;
+        fastTrack->mGeneration++;
+        fastMixerState->mTrackMask.set(i);
+    }
+    fastMixerState->mFastTracksGen++;
+    fastMixerState->mOutputSink = sink.get();
+    fastMixerState->mOutputSinkGen++;
+    fastMixerState->mFrameCount = kFrameCount;
+    fastMixerState->mSinkChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+    fastMixerState->mCommand = FastMixerState::MIX_WRITE;
+    fastMixerState->mDumpState = dumpState.get();
+    sq->end();
+    sq->push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+    fastMixer->run("FastMixer", PRIORITY_URGENT_AUDIO);
+
+    for (auto _ : state) {
+        usleep(kWarmupUs + kMeasureUs);
+    }
+
+    fastMixerState = sq->begin();
+    fastMixerState->mCommand = FastMixerState::EXIT;
+    sq->end();
+    sq->push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+    fastMixer->join();
+
+    // the fast mixer has exited, so the samples are stable
+    const uint32_t bounds = dumpState->mBounds;
+    const uint32_t newestOpen = bounds & 0xFFFF;
+    uint32_t oldestClosed = bounds >> 16;
+    const uint32_t n = std::min((newestOpen - oldestClosed) & 0xFFFF, kSamplingN);
+    oldestClosed = newestOpen - n;
+    if (n == 0) {
+        state.SkipWithError("fast mixer did not warm up");
+        return;
+    }
+    std::vector<double> loadUs;
+    double cycleUs = 0.;
+    for (uint32_t i = oldestClosed; i != newestOpen; ++i) {
+        const size_t index = i & (dumpState->mSamplingN - 1);
+        loadUs.push_back(dumpState->mLoadNs[index] * 1e-3);
+        cycleUs += dumpState->mMonotonicNs[index] * 1e-3;
+    }
+    std::sort(loadUs.begin(), loadUs.end());
+    double meanLoadUs = 0.;
+    for (const double load : loadUs) {
+        meanLoadUs += load;
+    }
+    meanLoadUs /= n;
+
+    state.SetIterationTime(meanLoadUs * 1e-6);
+    state.counters["load_us_median"] = loadUs[n / 2];
+    state.counters["load_us_p99"] = loadUs[std::min(n - 1, n * 99 / 100)];
+    state.counters["cycle_us_mean"] = cycleUs / n;
+    state.counters["underruns"] = dumpState->mUnderruns;
+}
+
+BENCHMARK(BM_FastMixerCycle)
+    ->ArgName("tracks")
+    ->Arg(32)
+    ->Arg(64)
+    ->Arg(FastMixerState::kMaxFastTracks)
+    ->Iterations(1)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "fastthreadhistogram_tests"
+
+#include "../FastThreadHistogram.h"
+
+#include <gtest/gtest.h>
+
+using namespace android;
+
+namespace {
+
+using Histogram = FastThreadHistogram;
+
+TEST(FastThreadHistogramTests, Buckets) {
+    // every value falls in a bucket whose range contains it, within the stated precision
+    unsigned lastBucket = 0;
+    for (uint32_t value = 0; value <= Histogram::kMaxValue; ++value) {
+        const unsigned bucket = Histogram::bucketOf(value);
+        ASSERT_LT(bucket, Histogram::kBuckets);
+        ASSERT_TRUE(bucket == lastBucket || bucket == lastBucket + 1) << value;
+        const uint32_t highest = Histogram::bucketHighest(bucket);
+        ASSERT_GE(highest, value);
+        ASSERT_LE(highest - value, value / Histogram::kSubBuckets) << value;
+        lastBucket = bucket;
+    }
+    EXPECT_EQ(Histogram::kBuckets - 1, lastBucket);
+    EXPECT_EQ(lastBucket, Histogram::bucketOf(UINT32_MAX));  // clamped
+}
+
+TEST(FastThreadHistogramTests, Percentiles) {
+    Histogram histogram;
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.percentile(50.));
+
+    for (uint32_t value = 1; value <= 1000; ++value) {
+        histogram.add(value);
+    }
+    EXPECT_EQ(1000u, histogram.count());
+    EXPECT_EQ(1u, histogram.percentile(0.));
+    EXPECT_EQ(Histogram::bucketHighest(Histogram::bucketOf(500)), histogram.percentile(50.));
+    EXPECT_EQ(Histogram::bucketHighest(Histogram::bucketOf(990)), histogram.percentile(99.));
+    EXPECT_EQ(Histogram::bucketHighest(Histogram::bucketOf(999)), histogram.percentile(99.9));
+    EXPECT_EQ(Histogram::bucketHighest(Histogram::bucketOf(1000)), histogram.percentile(100.));
+}
+
+TEST(FastThreadHistogramTests, Difference) {
+    FastThreadHistograms histograms;
+    for (int i = 0; i < 100; ++i) {
+        histograms.mCycleUs.add(4000);
+    }
+    const FastThreadHistograms earlier = histograms;
+    histograms.mCycleUs.add(40000);  // an underrun
+    histograms.mLoadUs.add(500);
+
+    const FastThreadHistograms recent = histograms - earlier;
+    EXPECT_EQ(1u, recent.mCycleUs.count());
+    EXPECT_EQ(Histogram::bucketHighest(Histogram::bucketOf(40000)),
+            recent.mCycleUs.percentile(50.));
+    EXPECT_EQ(1u, recent.mLoadUs.count());
+    EXPECT_EQ(0u, recent.mJitterUs.count());
+}
+
+}  // namespace
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "fasttrackmask_tests"
+
+#include "../FastTrackMask.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace android;
+
+namespace {
+
+constexpr unsigned kCapacity = FastTrackMask::kCapacity;
+
+std::vector<int> indices(const FastTrackMask& mask) {
+    std::vector<int> result;
+    mask.forEach([&](int i) { result.push_back(i); });
+    return result;
+}
+
+TEST(FastTrackMaskTests, Empty) {
+    const FastTrackMask mask;
+    EXPECT_TRUE(mask.none());
+    EXPECT_FALSE(mask.any());
+    EXPECT_EQ(0u, mask.count());
+    EXPECT_EQ(-1, mask.lowest());
+    EXPECT_EQ(-1, mask.highest());
+    EXPECT_TRUE(indices(mask).empty());
+    EXPECT_EQ("0", mask.toString());
+    EXPECT_EQ(mask, FastTrackMask::first(0));
+}
+
+TEST(FastTrackMaskTests, SetReset) {
+    FastTrackMask mask;
+    for (const unsigned i : {0u, 1u, 63u, 64u, 65u, kCapacity - 1}) {
+        EXPECT_FALSE(mask.test(i));
+        mask.set(i);
+        EXPECT_TRUE(mask.test(i));
+        mask.set(i);  // idempotent
+        EXPECT_TRUE(mask.test(i));
+    }
+    EXPECT_EQ(6u, mask.count());
+    EXPECT_EQ(0, mask.lowest());
+    EXPECT_EQ(int(kCapacity - 1), mask.highest());
+
+    for (const unsigned i : {0u, 63u, kCapacity - 1}) {
+        mask.reset(i);
+        EXPECT_FALSE(mask.test(i));
+        mask.reset(i);  // idempotent
+        EXPECT_FALSE(mask.test(i));
+    }
+    EXPECT_EQ((std::vector<int>{1, 64, 65}), indices(mask));
+    EXPECT_EQ(1, mask.lowest());
+    EXPECT_EQ(65, mask.highest());
+}
+
+TEST(FastTrackMaskTests, First) {
+    for (const unsigned count : {1u, 2u, 8u, 32u, 63u, 64u, 65u, 127u, kCapacity}) {
+        const FastTrackMask mask = FastTrackMask::first(count);
+        EXPECT_EQ(count, mask.count()) << count;
+        EXPECT_EQ(0, mask.lowest()) << count;
+        EXPECT_EQ(int(count - 1), mask.highest()) << count;
+        if (count < kCapacity) {
+            EXPECT_FALSE(mask.test(count)) << count;
+        }
+    }
+    // counts above the capacity saturate.
+    EXPECT_EQ(FastTrackMask::first(kCapacity), FastTrackMask::first(kCapacity + 1));
+    EXPECT_EQ(FastTrackMask::first(kCapacity), ~FastTrackMask());
+}
+
+TEST(FastTrackMaskTests, ForEachOrderAndBoundaries) {
+    FastTrackMask mask;
+    const std::vector<int> expected{0, 31, 32, 63, 64, 100, int(kCapacity - 1)};
+    for (auto it = expected.rbegin(); it != expected.rend(); ++it) {
+        mask.set(*it);
+    }
+    EXPECT_EQ(expected, indices(mask));
+
+    // all indices, across both words
+    EXPECT_EQ(kCapacity, indices(FastTrackMask::first(kCapacity)).size());
+}
+
+TEST(FastTrackMaskTests, Operators) {
+    const FastTrackMask low = FastTrackMask::first(64);
+    const FastTrackMask all = FastTrackMask::first(kCapacity);
+    const FastTrackMask high = all & ~low;
+    EXPECT_EQ(64u, high.count());
+    EXPECT_EQ(64, high.lowest());
+    EXPECT_TRUE((low & high).none());
+    EXPECT_EQ(all, low | high);
+    EXPECT_NE(low, high);
+
+    // available slot arithmetic as in PlaybackThread: all configured tracks but index 0.
+    FastTrackMask avail = FastTrackMask::first(8) & ~FastTrackMask::first(1);
+    EXPECT_EQ(1, avail.lowest());
+    EXPECT_EQ(7u, avail.count());
+    avail &= ~FastTrackMask::first(2);
+    EXPECT_EQ(2, avail.lowest());
+    avail |= FastTrackMask::first(2);
+    EXPECT_EQ(FastTrackMask::first(8), avail);
+}
+
+TEST(FastTrackMaskTests, ToString) {
+    EXPECT_EQ("0x1", FastTrackMask::first(1).toString());
+    EXPECT_EQ("0xff", FastTrackMask::first(8).toString());
+    EXPECT_EQ("0xffffffffffffffff", FastTrackMask::first(64).toString());
+    FastTrackMask mask;
+    mask.set(64);
+    EXPECT_EQ("0x10000000000000000", mask.toString());
+    mask.set(0);
+    EXPECT_EQ("0x10000000000000001", mask.toString());
+}
+
+} // namespace
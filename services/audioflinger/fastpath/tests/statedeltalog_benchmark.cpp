@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include "../FastMixer.h"
+
+using namespace android;
+
+/*
+ * Publishes a change of one fast track and observes it on the same thread, so that the
+ * StateQueue push never waits for an acknowledgement. This is the cost of the publication
+ * itself: StateQueue copies a whole FastMixerState, the delta log copies one FastTrack.
+ */
+static void BM_StateQueuePushPoll(benchmark::State& state) {
+    FastMixerStateQueue sq;
+    int generation = 0;
+    while (state.KeepRunning()) {
+        FastMixerState * const mutating = sq.begin();
+        mutating->mFastTracks[1].mGeneration = ++generation;
+        mutating->mFastTracksGen++;
+        sq.end();
+        sq.push(FastMixerStateQueue::BLOCK_NEVER);
+        benchmark::DoNotOptimize(sq.poll());
+    }
+}
+
+BENCHMARK(BM_StateQueuePushPoll);
+
+static void BM_TrackDeltaPushDrain(benchmark::State& state) {
+    FastTrackDeltaLog log;
+    FastTrackDelta delta;
+    delta.mIndex = 1;
+    while (state.KeepRunning()) {
+        ++delta.mFastTrack.mGeneration;
+        log.push(delta);
+        log.drain([](const FastTrackDelta& applied) {
+            benchmark::DoNotOptimize(applied.mFastTrack.mGeneration);
+        });
+    }
+}
+
+BENCHMARK(BM_TrackDeltaPushDrain);
+
+static FastTrackDeltaLog sLog;
+static std::atomic<bool> sObserverDone;
+static std::thread sObserver;
+
+/*
+ * Round trip latency from push() until the observer thread has applied the delta, with one or
+ * more concurrent mutator threads. The observer drains continuously, so this excludes the
+ * fast mixer period that a real delta waits for. Both sides yield while waiting so that this
+ * also runs on a single core.
+ */
+static void BM_TrackDeltaRoundTrip(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        sObserverDone = false;
+        sObserver = std::thread([] {
+            while (!sObserverDone.load(std::memory_order_relaxed)) {
+                sLog.drain([](const FastTrackDelta& applied) {
+                    benchmark::DoNotOptimize(applied.mFastTrack.mGeneration);
+                });
+                std::this_thread::yield();
+            }
+        });
+    }
+    FastTrackDelta delta;
+    delta.mIndex = state.thread_index();
+    while (state.KeepRunning()) {
+        ++delta.mFastTrack.mGeneration;
+        uint64_t sequence;
+        while (!sLog.push(delta, &sequence)) {
+            std::this_thread::yield();
+        }
+        while (!sLog.isApplied(sequence)) {
+            std::this_thread::yield();
+        }
+    }
+    if (state.thread_index() == 0) {
+        sObserverDone = true;
+        sObserver.join();
+    }
+}
+
+BENCHMARK(BM_TrackDeltaRoundTrip)->ThreadRange(1, 4)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "statedeltalog_tests"
+
+#include "../StateDeltaLog.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace android;
+
+namespace {
+
+// Like FastTrackDelta, but without the dependencies of FastMixerState.h.
+struct TrackDelta {
+    int mIndex = -1;
+    int mGeneration = 0;
+    bool mActive = false;
+};
+
+TEST(StateDeltaLogTests, Order) {
+    StateDeltaLog<TrackDelta, 8> log;
+    uint64_t sequence = 0;
+    uint64_t lastSequence = 0;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(log.push({i, i + 1, true}, &sequence));
+        EXPECT_GT(sequence, lastSequence);
+        EXPECT_FALSE(log.isApplied(sequence));
+        lastSequence = sequence;
+    }
+
+    std::vector<int> indices;
+    EXPECT_EQ(5u, log.drain([&](const TrackDelta& delta) { indices.push_back(delta.mIndex); }));
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), indices);
+    EXPECT_TRUE(log.isApplied(lastSequence));
+    log.waitUntilApplied(lastSequence);  // must not block
+
+    // nothing left
+    EXPECT_EQ(0u, log.drain([](const TrackDelta&) { FAIL(); }));
+}
+
+TEST(StateDeltaLogTests, Full) {
+    constexpr size_t kCapacity = 4;
+    StateDeltaLog<TrackDelta, kCapacity> log;
+    for (size_t lap = 0; lap < 3; ++lap) {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            ASSERT_TRUE(log.push({(int)i, (int)lap, true}));
+        }
+        EXPECT_FALSE(log.push({}));
+        EXPECT_EQ(lap + 1, log.overflows());
+
+        // draining frees the slots for the next lap
+        size_t count = 0;
+        EXPECT_EQ(kCapacity, log.drain([&](const TrackDelta& delta) {
+            EXPECT_EQ((int)count++, delta.mIndex);
+            EXPECT_EQ((int)lap, delta.mGeneration);
+        }));
+    }
+}
+
+// Several mutator threads add and remove tracks in their own slots while a single observer
+// applies the deltas, as MixerThread and FastMixer do. Removals wait until applied, as
+// MixerThread does before releasing the track.
+TEST(StateDeltaLogTests, ConcurrentTrackChurn) {
+    constexpr int kMutators = 4;
+    constexpr int kTracksPerMutator = 8;
+    constexpr int kTracks = kMutators * kTracksPerMutator;
+    constexpr int kChangesPerTrack = 2000;
+    StateDeltaLog<TrackDelta, 16> log;  // small, to exercise the full log case
+
+    struct ObservedTrack {
+        int mGeneration = 0;
+        bool mActive = false;
+    };
+    ObservedTrack observed[kTracks];
+    std::atomic<bool> done{false};
+    int outOfOrder = 0;
+    size_t applied = 0;
+
+    std::thread observer([&] {
+        const auto apply = [&](const TrackDelta& delta) {
+            ObservedTrack& track = observed[delta.mIndex];
+            // each slot has a single mutator, so its generations must be seen in order
+            if (delta.mGeneration != track.mGeneration + 1) {
+                ++outOfOrder;
+            }
+            track.mGeneration = delta.mGeneration;
+            track.mActive = delta.mActive;
+            ++applied;
+        };
+        while (!done.load()) {
+            log.drain(apply);
+            std::this_thread::yield();
+        }
+        log.drain(apply);
+    });
+
+    std::atomic<size_t> pushed{0};
+    std::vector<std::thread> mutators;
+    for (int m = 0; m < kMutators; ++m) {
+        mutators.emplace_back([&, m] {
+            int generations[kTracksPerMutator] = {};
+            for (int change = 0; change < kChangesPerTrack; ++change) {
+                for (int t = 0; t < kTracksPerMutator; ++t) {
+                    const int index = m * kTracksPerMutator + t;
+                    const bool active = (change & 1) == 0;
+                    const TrackDelta delta{index, ++generations[t], active};
+                    uint64_t sequence;
+                    while (!log.push(delta, &sequence)) {
+                        std::this_thread::yield();  // full, a real mutator pushes the state
+                    }
+                    pushed++;
+                    if (!active && (change & 0xff) == 1) {
+                        log.waitUntilApplied(sequence);
+                        EXPECT_EQ(delta.mGeneration, observed[index].mGeneration);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& mutator : mutators) {
+        mutator.join();
+    }
+    done.store(true);
+    observer.join();
+
+    EXPECT_EQ(0, outOfOrder);
+    EXPECT_EQ(pushed.load(), applied);
+    for (int i = 0; i < kTracks; ++i) {
+        EXPECT_EQ(kChangesPerTrack, observed[i].mGeneration) << "track " << i;
+        EXPECT_FALSE(observed[i].mActive) << "track " << i;
+    }
+}
+
+} // namespace
@@ -176,7 +176,7 @@ static auto& getIAudioPolicyServiceStatistics() {
 #define BINDER_METHOD_ENTRY(ENTRY) \
         {(Code)media::BnAudioPolicyService::TRANSACTION_##ENTRY, #ENTRY},
 
-    static mediautils::MethodStatistics<Code> methodStatistics{
+    static mediautils::ShardedMethodStatistics<Code> methodStatistics{
         IAUDIOPOLICYSERVICE_BINDER_METHOD_MACRO_LIST
         METHOD_STATISTICS_BINDER_CODE_NAMES(Code)
     };
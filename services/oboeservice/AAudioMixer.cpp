@@ -21,8 +21,15 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include <cstring>
+#include <initializer_list>
 #include <utils/Trace.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "AAudioMixer.h"
 
 #ifndef AAUDIO_MIXER_ATRACE_ENABLED
@@ -33,12 +40,160 @@ using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
 
+namespace {
+
+// Mix kernels: destination[i] += source[i] for numSamples samples.
+// Each sample is a single add in every kernel, so all of them give the same result.
+
+void accumulateScalar(float *destination, const float *source, int32_t numSamples) {
+    for (int32_t i = 0; i < numSamples; i++) {
+        destination[i] += source[i];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+void accumulateSse2(float *destination, const float *source, int32_t numSamples) {
+    int32_t i = 0;
+    for (; i + 16 <= numSamples; i += 16) {
+        const __m128 s0 = _mm_add_ps(_mm_loadu_ps(destination + i), _mm_loadu_ps(source + i));
+        const __m128 s1 = _mm_add_ps(_mm_loadu_ps(destination + i + 4),
+                _mm_loadu_ps(source + i + 4));
+        const __m128 s2 = _mm_add_ps(_mm_loadu_ps(destination + i + 8),
+                _mm_loadu_ps(source + i + 8));
+        const __m128 s3 = _mm_add_ps(_mm_loadu_ps(destination + i + 12),
+                _mm_loadu_ps(source + i + 12));
+        _mm_storeu_ps(destination + i, s0);
+        _mm_storeu_ps(destination + i + 4, s1);
+        _mm_storeu_ps(destination + i + 8, s2);
+        _mm_storeu_ps(destination + i + 12, s3);
+    }
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(destination + i,
+                _mm_add_ps(_mm_loadu_ps(destination + i), _mm_loadu_ps(source + i)));
+    }
+    accumulateScalar(destination + i, source + i, numSamples - i);
+}
+
+__attribute__((target("avx2")))
+void accumulateAvx2(float *destination, const float *source, int32_t numSamples) {
+    int32_t i = 0;
+    for (; i + 32 <= numSamples; i += 32) {
+        const __m256 s0 = _mm256_add_ps(_mm256_loadu_ps(destination + i),
+                _mm256_loadu_ps(source + i));
+        const __m256 s1 = _mm256_add_ps(_mm256_loadu_ps(destination + i + 8),
+                _mm256_loadu_ps(source + i + 8));
+        const __m256 s2 = _mm256_add_ps(_mm256_loadu_ps(destination + i + 16),
+                _mm256_loadu_ps(source + i + 16));
+        const __m256 s3 = _mm256_add_ps(_mm256_loadu_ps(destination + i + 24),
+                _mm256_loadu_ps(source + i + 24));
+        _mm256_storeu_ps(destination + i, s0);
+        _mm256_storeu_ps(destination + i + 8, s1);
+        _mm256_storeu_ps(destination + i + 16, s2);
+        _mm256_storeu_ps(destination + i + 24, s3);
+    }
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm256_storeu_ps(destination + i,
+                _mm256_add_ps(_mm256_loadu_ps(destination + i), _mm256_loadu_ps(source + i)));
+    }
+    accumulateScalar(destination + i, source + i, numSamples - i);
+}
+
+#elif defined(__aarch64__)
+
+void accumulateNeon(float *destination, const float *source, int32_t numSamples) {
+    int32_t i = 0;
+    for (; i + 16 <= numSamples; i += 16) {
+        const float32x4_t s0 = vaddq_f32(vld1q_f32(destination + i), vld1q_f32(source + i));
+        const float32x4_t s1 = vaddq_f32(vld1q_f32(destination + i + 4),
+                vld1q_f32(source + i + 4));
+        const float32x4_t s2 = vaddq_f32(vld1q_f32(destination + i + 8),
+                vld1q_f32(source + i + 8));
+        const float32x4_t s3 = vaddq_f32(vld1q_f32(destination + i + 12),
+                vld1q_f32(source + i + 12));
+        vst1q_f32(destination + i, s0);
+        vst1q_f32(destination + i + 4, s1);
+        vst1q_f32(destination + i + 8, s2);
+        vst1q_f32(destination + i + 12, s3);
+    }
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(destination + i, vaddq_f32(vld1q_f32(destination + i), vld1q_f32(source + i)));
+    }
+    accumulateScalar(destination + i, source + i, numSamples - i);
+}
+
+#endif
+
+} // namespace
+
+const char *AAudioMixer::toString(Isa isa) {
+    switch (isa) {
+        case Isa::SCALAR: return "scalar";
+        case Isa::SSE2: return "sse2";
+        case Isa::AVX2: return "avx2";
+        case Isa::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+bool AAudioMixer::isIsaSupported(Isa isa) {
+    switch (isa) {
+        case Isa::SCALAR:
+            return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case Isa::SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case Isa::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#elif defined(__aarch64__)
+        case Isa::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+AAudioMixer::Isa AAudioMixer::getBestIsa() {
+    static const Isa sIsa = [] {
+        for (const Isa isa : { Isa::AVX2, Isa::SSE2, Isa::NEON }) {
+            if (isIsaSupported(isa)) return isa;
+        }
+        return Isa::SCALAR;
+    }();
+    return sIsa;
+}
+
 void AAudioMixer::allocate(int32_t samplesPerFrame, int32_t framesPerBurst) {
     mSamplesPerFrame = samplesPerFrame;
     mFramesPerBurst = framesPerBurst;
     int32_t samplesPerBuffer = samplesPerFrame * framesPerBurst;
     mOutputBuffer = std::make_unique<float[]>(samplesPerBuffer);
     mBufferSizeInBytes = samplesPerBuffer * sizeof(float);
+    setIsa(getBestIsa());
+}
+
+void AAudioMixer::setIsa(Isa isa) {
+    switch (isa) {
+#if defined(__x86_64__) || defined(__i386__)
+        case Isa::SSE2:
+            mAccumulate = accumulateSse2;
+            break;
+        case Isa::AVX2:
+            mAccumulate = accumulateAvx2;
+            break;
+#elif defined(__aarch64__)
+        case Isa::NEON:
+            mAccumulate = accumulateNeon;
+            break;
+#endif
+        default:
+            mAccumulate = accumulateScalar;
+            break;
+    }
 }
 
 void AAudioMixer::clear() {
@@ -105,12 +260,13 @@ int32_t AAudioMixer::mix(
     return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
-    }
+void AAudioMixer::mix(const AAudioMixer &other) {
+    mAccumulate(mOutputBuffer.get(), other.mOutputBuffer.get(),
+            mFramesPerBurst * mSamplesPerFrame);
+}
+
+void AAudioMixer::mixPart(float *destination, const float *source, int32_t numFrames) {
+    mAccumulate(destination, source, numFrames * mSamplesPerFrame);
 }
 
 float *AAudioMixer::getOutputBuffer() {
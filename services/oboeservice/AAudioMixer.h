@@ -17,6 +17,7 @@
 #ifndef AAUDIO_AAUDIO_MIXER_H
 #define AAUDIO_AAUDIO_MIXER_H
 
+#include <memory>
 #include <stdint.h>
 
 #include <aaudio/AAudio.h>
@@ -24,10 +25,36 @@
 
 class AAudioMixer {
 public:
+    /**
+     * Instruction sets of the mix kernel.
+     * The mixer uses the widest one supported by the CPU, see getBestIsa().
+     */
+    enum class Isa {
+        SCALAR,
+        SSE2,  // x86, baseline
+        AVX2,  // x86, selected at runtime
+        NEON,  // arm64, baseline
+    };
+
+    static const char *toString(Isa isa);
+
+    /** @return true if the running CPU supports the instruction set */
+    static bool isIsaSupported(Isa isa);
+
+    /** @return the widest instruction set supported, computed once per process */
+    static Isa getBestIsa();
+
     AAudioMixer() = default;
 
+    /**
+     * Allocates the output buffer, and selects the mix kernel so that the
+     * CPU features are not detected on the mixer thread.
+     */
     void allocate(int32_t samplesPerFrame, int32_t framesPerBurst);
 
+    /** Overrides the instruction set selected by allocate(), for tests and benchmarks. */
+    void setIsa(Isa isa);
+
     void clear();
 
     /**
@@ -41,13 +68,22 @@ public:
                 const std::shared_ptr<android::FifoBuffer>& fifo,
                 bool allowUnderflow);
 
+    /**
+     * Mix the output of another mixer, which was allocated with the same format.
+     * Used to sum the partial mixes computed by helper threads.
+     */
+    void mix(const AAudioMixer &other);
+
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    using accumulate_t = void (*)(float *destination, const float *source, int32_t numSamples);
+
+    void mixPart(float *destination, const float *source, int32_t numFrames);
 
+    accumulate_t             mAccumulate = nullptr;
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
     int32_t  mFramesPerBurst = 0;
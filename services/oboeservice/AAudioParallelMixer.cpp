@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AAudioParallelMixer.h"
+
+using android::AudioMixerWorkerPool;
+
+void AAudioParallelMixer::allocate(int32_t samplesPerFrame, int32_t framesPerBurst,
+                                   int32_t workers) {
+    mWorkerPool.reset();
+    mWorkerMixers.clear();
+    if (workers <= 0) {
+        return;
+    }
+    mWorkerPool = std::make_unique<AudioMixerWorkerPool>(
+            workers, std::vector<int>{} /* cpus */);
+    mWorkerMixers.resize(workers);
+    for (auto& mixer : mWorkerMixers) {
+        mixer.allocate(samplesPerFrame, framesPerBurst);
+    }
+}
+
+void AAudioParallelMixer::mix(AAudioMixer &mixer, size_t clientCount,
+                              mix_client_t mixClient, void *cookie) {
+    mMixer = &mixer;
+    mClientCount = clientCount;
+    mMixClient = mixClient;
+    mCookie = cookie;
+    if (mWorkerPool == nullptr) {
+        mixClientsJob(this, 0);
+    } else {
+        mWorkerPool->run(mixClientsJob, this);
+        for (const auto& workerMixer : mWorkerMixers) {
+            mixer.mix(workerMixer);
+        }
+    }
+    mMixer = nullptr;
+}
+
+/* static */
+void AAudioParallelMixer::mixClientsJob(void *cookie, size_t index) {
+    auto *parallelMixer = static_cast<AAudioParallelMixer *>(cookie);
+    // Index 0 runs on the calling thread and mixes into the output mixer.
+    AAudioMixer &mixer = index == 0
+            ? *parallelMixer->mMixer : parallelMixer->mWorkerMixers[index - 1];
+    if (index != 0) {
+        mixer.clear();
+    }
+    const size_t stride = parallelMixer->mWorkerMixers.size() + 1;
+    for (size_t i = index; i < parallelMixer->mClientCount; i += stride) {
+        parallelMixer->mMixClient(parallelMixer->mCookie, mixer, i);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAUDIO_AAUDIO_PARALLEL_MIXER_H
+#define AAUDIO_AAUDIO_PARALLEL_MIXER_H
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#include <media/AudioMixerWorkerPool.h>
+
+#include "AAudioMixer.h"
+
+/**
+ * Mixes the clients of one burst on the calling thread and on the helper threads
+ * of an AudioMixerWorkerPool. Each helper thread mixes its clients into its own
+ * AAudioMixer, and the partial mixes are then summed into the output mixer.
+ */
+class AAudioParallelMixer {
+public:
+    /**
+     * Mixes one client into mixer. Called concurrently for different clients.
+     * @param cookie passed to mix()
+     * @param mixer to mix into
+     * @param client index of the client, from 0 to clientCount - 1
+     */
+    using mix_client_t = void (*)(void *cookie, AAudioMixer &mixer, size_t client);
+
+    AAudioParallelMixer() = default;
+
+    /**
+     * Creates the helper threads and allocates their mixers.
+     * @param workers number of helper threads, 0 to mix on the calling thread only
+     */
+    void allocate(int32_t samplesPerFrame, int32_t framesPerBurst, int32_t workers);
+
+    /** @return the number of helper threads */
+    size_t getWorkerCount() const { return mWorkerMixers.size(); }
+
+    /**
+     * Mixes clientCount clients into mixer, which was allocated with the same format.
+     * A static partition keeps each client on the same thread from one burst to the next:
+     * client i is mixed by the partition i % (getWorkerCount() + 1), and partition 0 runs on
+     * the calling thread and mixes into mixer directly.
+     * Not reentrant.
+     */
+    void mix(AAudioMixer &mixer, size_t clientCount, mix_client_t mixClient, void *cookie);
+
+private:
+    // AudioMixerWorkerPool job, mixes every (workers + 1)th client from index.
+    static void mixClientsJob(void *cookie, size_t index);
+
+    // Only valid during mix().
+    AAudioMixer  *mMixer = nullptr;
+    size_t        mClientCount = 0;
+    mix_client_t  mMixClient = nullptr;
+    void         *mCookie = nullptr;
+
+    std::unique_ptr<android::AudioMixerWorkerPool> mWorkerPool;
+    std::vector<AAudioMixer> mWorkerMixers;  // partial mix of each helper thread
+};
+
+#endif //AAUDIO_AAUDIO_PARALLEL_MIXER_H
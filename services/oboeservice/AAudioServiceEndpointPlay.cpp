@@ -36,6 +36,7 @@
 #include "AAudioServiceEndpointPlay.h"
 #include "AAudioServiceEndpointShared.h"
 #include "AAudioServiceStreamBase.h"
+#include "utility/AAudioUtilities.h"
 
 using namespace android;  // TODO just import names needed
 using namespace aaudio;   // TODO just import names needed
@@ -52,6 +53,11 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
         mMixer.allocate(getStreamInternal()->getSamplesPerFrame(),
                         getStreamInternal()->getFramesPerBurst());
 
+        mParallelMixer.allocate(getStreamInternal()->getSamplesPerFrame(),
+                                getStreamInternal()->getFramesPerBurst(),
+                                AAudioProperty_getMixerWorkers());
+        mMixerClients.reserve(kMinClientsForParallelMix * 4);
+
         int32_t burstsPerBuffer = AudioSystem::getAAudioMixerBurstCount();
         if (burstsPerBuffer == 0) {
             mLatencyTuningEnabled = true;
@@ -63,6 +69,57 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     return result;
 }
 
+void AAudioServiceEndpointPlay::mixClient(AAudioMixer &mixer, const MixerClient &client) {
+    AAudioServiceStreamShared *streamShared = client.stream;
+    int64_t clientFramesRead = 0;
+    {
+        // Lock the AudioFifo to protect against close.
+        std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
+        std::shared_ptr<SharedRingBuffer> audioDataQueue
+                = streamShared->getAudioDataQueue_l();
+        std::shared_ptr<FifoBuffer> fifo;
+        if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
+
+            // Determine offset between framePosition in client's stream
+            // vs the underlying MMAP stream.
+            clientFramesRead = fifo->getReadCounter();
+            // These two indices refer to the same frame.
+            int64_t positionOffset = mMmapFramesWritten - clientFramesRead;
+            streamShared->setTimestampPositionOffset(positionOffset);
+
+            int32_t framesMixed = mixer.mix(client.index, fifo, client.allowUnderflow);
+
+            if (streamShared->isFlowing()) {
+                // Consider it an underflow if we got less than a burst
+                // after the data started flowing.
+                bool underflowed = client.allowUnderflow
+                                   && framesMixed < mixer.getFramesPerBurst();
+                if (underflowed) {
+                    streamShared->incrementXRunCount();
+                }
+            } else if (framesMixed > 0) {
+                // Mark beginning of data flow after a start.
+                streamShared->setFlowing(true);
+            }
+            clientFramesRead = fifo->getReadCounter();
+        }
+    }
+
+    if (clientFramesRead > 0) {
+        // This timestamp represents the completion of data being read out of the
+        // client buffer. It is sent to the client and used in the timing model
+        // to decide when the client has room to write more data.
+        Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
+        streamShared->markTransferTime(timestamp);
+    }
+}
+
+/* static */
+void AAudioServiceEndpointPlay::mixClientJob(void *cookie, AAudioMixer &mixer, size_t client) {
+    auto *endpoint = static_cast<AAudioServiceEndpointPlay *>(cookie);
+    endpoint->mixClient(mixer, endpoint->mMixerClients[client]);
+}
+
 // Mix data from each application stream and write result to the shared MMAP stream.
 void *AAudioServiceEndpointPlay::callbackLoop() {
     ALOGD("%s() entering >>>>>>>>>>>>>>> MIXER", __func__);
@@ -76,11 +133,11 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
 
         { // brackets are for lock_guard
             int index = 0;
-            int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
+            mMmapFramesWritten = getStreamInternal()->getFramesWritten();
 
             std::lock_guard <std::mutex> lock(mLockStreams);
+            mMixerClients.clear();
             for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
                 if (clientStream->isSuspended()) {
@@ -95,51 +152,20 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                     continue; // this stream is not running so skip it.
                 }
 
-                sp<AAudioServiceStreamShared> streamShared =
-                        static_cast<AAudioServiceStreamShared *>(clientStream.get());
-
-                {
-                    // Lock the AudioFifo to protect against close.
-                    std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
-                    std::shared_ptr<SharedRingBuffer> audioDataQueue
-                            = streamShared->getAudioDataQueue_l();
-                    std::shared_ptr<FifoBuffer> fifo;
-                    if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
-
-                        // Determine offset between framePosition in client's stream
-                        // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
-                        // These two indices refer to the same frame.
-                        int64_t positionOffset = mmapFramesWritten - clientFramesRead;
-                        streamShared->setTimestampPositionOffset(positionOffset);
-
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
-
-                        if (streamShared->isFlowing()) {
-                            // Consider it an underflow if we got less than a burst
-                            // after the data started flowing.
-                            bool underflowed = allowUnderflow
-                                               && framesMixed < mMixer.getFramesPerBurst();
-                            if (underflowed) {
-                                streamShared->incrementXRunCount();
-                            }
-                        } else if (framesMixed > 0) {
-                            // Mark beginning of data flow after a start.
-                            streamShared->setFlowing(true);
-                        }
-                        clientFramesRead = fifo->getReadCounter();
-                    }
-                }
+                mMixerClients.push_back({
+                        static_cast<AAudioServiceStreamShared *>(clientStream.get()),
+                        allowUnderflow, index++});
+            }
 
-                if (clientFramesRead > 0) {
-                    // This timestamp represents the completion of data being read out of the
-                    // client buffer. It is sent to the client and used in the timing model
-                    // to decide when the client has room to write more data.
-                    Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
-                    streamShared->markTransferTime(timestamp);
+            if (mParallelMixer.getWorkerCount() > 0
+                    && mMixerClients.size() >= kMinClientsForParallelMix) {
+                // Each helper thread mixes its clients into its own buffer,
+                // which are then summed into mMixer.
+                mParallelMixer.mix(mMixer, mMixerClients.size(), mixClientJob, this);
+            } else {
+                for (const auto& client : mMixerClients) {
+                    mixClient(mMixer, client);
                 }
-
-                index++; // just used for labelling tracks in systrace
             }
         }
 
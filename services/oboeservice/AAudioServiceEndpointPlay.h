@@ -28,6 +28,7 @@
 #include "AAudioServiceStreamShared.h"
 #include "AAudioServiceStreamMMAP.h"
 #include "AAudioMixer.h"
+#include "AAudioParallelMixer.h"
 #include "AAudioService.h"
 
 namespace aaudio {
@@ -44,8 +45,28 @@ public:
     void *callbackLoop() override;
 
 private:
+    // A client stream to mix in the current burst.
+    struct MixerClient {
+        AAudioServiceStreamShared *stream;  // held by mRegisteredStreams while mixing
+        bool allowUnderflow;
+        int index;  // just used for labelling tracks in systrace
+    };
+
+    // Clients are mixed on helper threads when there are at least this many.
+    static constexpr size_t kMinClientsForParallelMix = 8;
+
+    void mixClient(AAudioMixer &mixer, const MixerClient &client);
+
+    // AAudioParallelMixer callback, mixes mMixerClients[client].
+    static void mixClientJob(void *cookie, AAudioMixer &mixer, size_t client);
+
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
     AAudioMixer              mMixer;    //
+
+    // Only accessed by callbackLoop() and the helper threads it runs.
+    std::vector<MixerClient> mMixerClients;
+    int64_t                  mMmapFramesWritten = 0;
+    AAudioParallelMixer      mParallelMixer;
 };
 
 } /* namespace aaudio */
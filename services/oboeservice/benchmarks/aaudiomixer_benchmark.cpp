@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fifo/FifoBuffer.h>
+
+#include "AAudioMixer.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+
+namespace {
+
+constexpr int32_t kSamplesPerFrame = 2;
+constexpr int32_t kFramesPerBurst = 192;  // 4 ms at 48 kHz
+constexpr int32_t kBurstsPerFifo = 4;
+
+/*
+ * One burst of the shared MMAP endpoint: clears the mixer and mixes
+ * one burst from the FIFO of every client, as AAudioServiceEndpointPlay does.
+ * The FIFO write index is advanced without writing, so that only the mix is measured.
+ *
+ * Args: number of clients, instruction set.
+ */
+void BM_AAudioMixer(benchmark::State& state) {
+    const auto clients = static_cast<size_t>(state.range(0));
+    const auto isa = static_cast<AAudioMixer::Isa>(state.range(1));
+
+    AAudioMixer mixer;
+    mixer.allocate(kSamplesPerFrame, kFramesPerBurst);
+    mixer.setIsa(isa);
+
+    std::vector<std::shared_ptr<FifoBuffer>> fifos;
+    const std::vector<float> burst(kFramesPerBurst * kSamplesPerFrame, 0.01f);
+    for (size_t i = 0; i < clients; ++i) {
+        auto fifo = std::make_shared<FifoBufferAllocated>(
+                kSamplesPerFrame * sizeof(float), kFramesPerBurst * kBurstsPerFifo);
+        for (int32_t j = 0; j < kBurstsPerFifo; ++j) {
+            fifo->write(burst.data(), kFramesPerBurst);
+        }
+        fifos.push_back(std::move(fifo));
+    }
+
+    for (auto _ : state) {
+        mixer.clear();
+        for (size_t i = 0; i < clients; ++i) {
+            mixer.mix(i, fifos[i], true /* allowUnderflow */);
+            fifos[i]->advanceWriteIndex(kFramesPerBurst);
+        }
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(AAudioMixer::toString(isa));
+}
+
+void MixerArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"clients", "isa"});
+    for (const auto isa : { AAudioMixer::Isa::SCALAR, AAudioMixer::Isa::SSE2,
+            AAudioMixer::Isa::AVX2, AAudioMixer::Isa::NEON }) {
+        if (!AAudioMixer::isIsaSupported(isa)) continue;
+        for (int clients = 1; clients <= 32; clients *= 2) {
+            b->Args({clients, static_cast<int64_t>(isa)});
+        }
+    }
+}
+
+BENCHMARK(BM_AAudioMixer)->Apply(MixerArgs);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <fifo/FifoBuffer.h>
+#include <gtest/gtest.h>
+
+#include "AAudioMixer.h"
+#include "AAudioParallelMixer.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+
+namespace {
+
+constexpr int32_t kBurstsPerTest = 3;
+
+std::vector<float> randomSamples(size_t count, uint32_t seed) {
+    std::minstd_rand generator(seed);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<float> samples(count);
+    for (auto& sample : samples) {
+        sample = distribution(generator);
+    }
+    return samples;
+}
+
+// A client FIFO holding kBurstsPerTest bursts of samples. The capacity is not a multiple
+// of the burst, so that the later bursts are read in two parts, at unaligned addresses.
+std::shared_ptr<FifoBuffer> makeFifo(const std::vector<float>& samples,
+                                     int32_t samplesPerFrame) {
+    const auto frames = static_cast<int32_t>(samples.size() / samplesPerFrame);
+    auto fifo = std::make_shared<FifoBufferAllocated>(
+            samplesPerFrame * sizeof(float), frames + 3);
+    // Offsets the indices by 3 frames, then fills the FIFO.
+    std::vector<float> padding(3 * samplesPerFrame);
+    fifo->write(padding.data(), 3);
+    fifo->advanceReadIndex(3);
+    EXPECT_EQ(frames, fifo->write(samples.data(), frames));
+    return fifo;
+}
+
+void expectEqualBursts(const float *expected, const float *actual, int32_t numSamples) {
+    for (int32_t i = 0; i < numSamples; ++i) {
+        ASSERT_EQ(expected[i], actual[i]) << "sample " << i;
+    }
+}
+
+} // namespace
+
+class AAudioMixerKernelTest : public ::testing::TestWithParam<AAudioMixer::Isa> {};
+
+// Every kernel does one add per sample, so it must match the scalar kernel exactly,
+// for burst sizes that leave a tail after each of the unrolled and vector loops.
+TEST_P(AAudioMixerKernelTest, MatchesScalar) {
+    const AAudioMixer::Isa isa = GetParam();
+    if (!AAudioMixer::isIsaSupported(isa)) {
+        GTEST_SKIP() << AAudioMixer::toString(isa) << " is not supported";
+    }
+    for (const int32_t samplesPerFrame : { 1, 2 }) {
+        for (int32_t framesPerBurst = 1; framesPerBurst <= 67; ++framesPerBurst) {
+            SCOPED_TRACE(testing::Message() << "samplesPerFrame " << samplesPerFrame
+                    << " framesPerBurst " << framesPerBurst);
+            const int32_t samplesPerBurst = samplesPerFrame * framesPerBurst;
+            AAudioMixer expected;
+            expected.allocate(samplesPerFrame, framesPerBurst);
+            expected.setIsa(AAudioMixer::Isa::SCALAR);
+            AAudioMixer actual;
+            actual.allocate(samplesPerFrame, framesPerBurst);
+            actual.setIsa(isa);
+
+            std::vector<std::shared_ptr<FifoBuffer>> expectedFifos;
+            std::vector<std::shared_ptr<FifoBuffer>> actualFifos;
+            for (uint32_t client = 0; client < 3; ++client) {
+                const auto samples = randomSamples(samplesPerBurst * kBurstsPerTest,
+                        framesPerBurst * 3 + client);
+                expectedFifos.push_back(makeFifo(samples, samplesPerFrame));
+                actualFifos.push_back(makeFifo(samples, samplesPerFrame));
+            }
+
+            for (int32_t burst = 0; burst < kBurstsPerTest; ++burst) {
+                expected.clear();
+                actual.clear();
+                for (size_t client = 0; client < expectedFifos.size(); ++client) {
+                    EXPECT_EQ(framesPerBurst, expected.mix(client, expectedFifos[client],
+                            true /* allowUnderflow */));
+                    EXPECT_EQ(framesPerBurst, actual.mix(client, actualFifos[client],
+                            true /* allowUnderflow */));
+                }
+                ASSERT_NO_FATAL_FAILURE(expectEqualBursts(expected.getOutputBuffer(),
+                        actual.getOutputBuffer(), samplesPerBurst));
+            }
+
+            // The sum of partial mixes uses the same kernel.
+            expected.mix(expected);
+            actual.mix(actual);
+            ASSERT_NO_FATAL_FAILURE(expectEqualBursts(expected.getOutputBuffer(),
+                    actual.getOutputBuffer(), samplesPerBurst));
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AAudioMixer, AAudioMixerKernelTest,
+        ::testing::Values(AAudioMixer::Isa::SSE2, AAudioMixer::Isa::AVX2,
+                          AAudioMixer::Isa::NEON),
+        [](const testing::TestParamInfo<AAudioMixer::Isa>& info) {
+            return std::string(AAudioMixer::toString(info.param));
+        });
+
+namespace {
+
+constexpr int32_t kSamplesPerFrame = 2;
+constexpr int32_t kFramesPerBurst = 192;
+
+struct Clients {
+    std::vector<std::shared_ptr<FifoBuffer>> fifos;
+    std::vector<int> mixCounts;  // written by the thread mixing each client
+};
+
+void mixClient(void *cookie, AAudioMixer &mixer, size_t client) {
+    auto *clients = static_cast<Clients *>(cookie);
+    mixer.mix(client, clients->fifos[client], true /* allowUnderflow */);
+    clients->mixCounts[client]++;
+}
+
+} // namespace
+
+class AAudioParallelMixerTest
+        : public ::testing::TestWithParam<std::tuple<int32_t, size_t>> {};
+
+// The parallel mix adds the clients in another order, so it only matches the serial mix
+// within the float rounding error.
+TEST_P(AAudioParallelMixerTest, MatchesSerialMix) {
+    const auto [workers, clientCount] = GetParam();
+
+    AAudioMixer serialMixer;
+    serialMixer.allocate(kSamplesPerFrame, kFramesPerBurst);
+    AAudioMixer mixer;
+    mixer.allocate(kSamplesPerFrame, kFramesPerBurst);
+    AAudioParallelMixer parallelMixer;
+    parallelMixer.allocate(kSamplesPerFrame, kFramesPerBurst, workers);
+    ASSERT_EQ(static_cast<size_t>(workers), parallelMixer.getWorkerCount());
+
+    std::vector<std::shared_ptr<FifoBuffer>> serialFifos;
+    Clients clients;
+    for (size_t client = 0; client < clientCount; ++client) {
+        const auto samples = randomSamples(
+                kSamplesPerFrame * kFramesPerBurst * kBurstsPerTest, client);
+        serialFifos.push_back(makeFifo(samples, kSamplesPerFrame));
+        clients.fifos.push_back(makeFifo(samples, kSamplesPerFrame));
+    }
+    clients.mixCounts.resize(clientCount);
+
+    const float tolerance = 1e-6f * clientCount;
+    for (int32_t burst = 0; burst < kBurstsPerTest; ++burst) {
+        serialMixer.clear();
+        for (size_t client = 0; client < clientCount; ++client) {
+            serialMixer.mix(client, serialFifos[client], true /* allowUnderflow */);
+        }
+        mixer.clear();
+        parallelMixer.mix(mixer, clientCount, mixClient, &clients);
+
+        const float *expected = serialMixer.getOutputBuffer();
+        const float *actual = mixer.getOutputBuffer();
+        for (int32_t i = 0; i < kSamplesPerFrame * kFramesPerBurst; ++i) {
+            ASSERT_NEAR(expected[i], actual[i], tolerance) << "burst " << burst
+                    << " sample " << i;
+        }
+    }
+    for (size_t client = 0; client < clientCount; ++client) {
+        EXPECT_EQ(kBurstsPerTest, clients.mixCounts[client]) << "client " << client;
+        EXPECT_EQ(0, clients.fifos[client]->getFullFramesAvailable()) << "client " << client;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AAudioParallelMixer, AAudioParallelMixerTest,
+        ::testing::Combine(::testing::Values(0, 1, 3),
+                           ::testing::Values<size_t>(8, 9, 16, 33)));